@@ -46,7 +46,7 @@ typedef struct localctx_t {
 
 void param_update_callback(void * arg) {
     lpinstrument_t * instrument = (lpinstrument_t *)arg;
-    localctx_t * ctx = (localctx_t *)instrument->context;
+    localctx_t * ctx = (localctx_t *)astrid_instrument_get_context(instrument);
 
     // Respond to param update messages -- TODO: parse param args with PARAM_ consts
     syslog(LOG_DEBUG, "MSG: update | %s\n", instrument->msg.msg);
@@ -62,7 +62,7 @@ lpbuffer_t * renderer_callback(void * arg) {
     lpbuffer_t * out;
 
     lpinstrument_t * instrument = (lpinstrument_t *)arg;
-    localctx_t * ctx = (localctx_t *)instrument->context;
+    localctx_t * ctx = (localctx_t *)astrid_instrument_get_context(instrument);
 
     out = LPBuffer.cut(ctx->ringbuf, LPRand.randint(0, SR*20), LPRand.randint(SR, SR*10));
     LPFX.norm(out, LPRand.rand(0.26f, 0.5f));
@@ -76,7 +76,7 @@ void audio_callback(int channels, size_t blocksize, float ** input, float ** out
     lpfloat_t freqs[NUMFREQS];
     lpfloat_t sample, left, right, amp, pw, saturation, pan;
     lpinstrument_t * instrument = (lpinstrument_t *)arg;
-    localctx_t * ctx = (localctx_t *)instrument->context;
+    localctx_t * ctx = (localctx_t *)astrid_instrument_get_context(instrument);
 
     if(!instrument->is_running) return;
 
@@ -127,19 +127,19 @@ void audio_callback(int channels, size_t blocksize, float ** input, float ** out
         left = right = sample;
         pan_stereo_constant(pan, left, right, &left, &right);
 
-        output[0][i] += left;
-        output[1][i] += right;
+        // spread the stereo pair across however many outputs we have
+        for(c=0; c < channels; c++) {
+            output[c][i] += (c & 1) ? right : left;
+        }
     }
 }
 
-int main() {
-    lpinstrument_t * instrument;
-    
+localctx_t * create_localctx(void) {
     // create local context struct
     localctx_t * ctx = (localctx_t *)calloc(1, sizeof(localctx_t));
     if(ctx == NULL) {
         printf("Could not alloc ctx: (%d) %s\n", errno, strerror(errno));
-        exit(1);
+        return NULL;
     }
 
     // create env and ringbuf
@@ -162,18 +162,104 @@ int main() {
         ctx->oscs[i]->phase = 0.f;
     }
 
-    // Set the callbacks for streaming, async renders and param updates
-    if((instrument = astrid_instrument_start(NAME, CHANNELS, (void*)ctx, 
-                    audio_callback, renderer_callback, param_update_callback)) == NULL) {
-        fprintf(stderr, "Could not start instrument: (%d) %s\n", errno, strerror(errno));
-        exit(EXIT_FAILURE);
-    }
+    return ctx;
+}
 
+void init_params(lpinstrument_t * instrument, localctx_t * ctx) {
     /* now that LMDB is running, populate the initial freqs */
     for(int i=0; i < NUMFREQS; i++) {
         ctx->selected_freqs[i] = scale[LPRand.randint(0, NUMFREQS*2) % NUMFREQS] * 0.5f + LPRand.rand(0.f, 1.f);
     }
     astrid_instrument_set_param_float_list(instrument, PARAM_FREQS, ctx->selected_freqs, NUMFREQS);
+}
+
+void destroy_localctx(localctx_t * ctx) {
+    /* clean up local memory */
+    for(int o=0; o < NUMOSCS; o++) {
+        LPPulsarOsc.destroy(ctx->oscs[o]);
+        LPBuffer.destroy(ctx->curves[o]);
+    }
+
+    LPBuffer.destroy(ctx->ringbuf);
+    LPBuffer.destroy(ctx->env);
+
+    free(ctx);
+}
+
+#ifdef ASTRID_MODULE
+/* Exports for loading into astrid-host */
+const int astrid_module_channels = CHANNELS;
+
+void * astrid_module_create(lpinstrument_t * instrument) {
+    localctx_t * ctx;
+    if((ctx = create_localctx()) == NULL) return NULL;
+    init_params(instrument, ctx);
+    return (void *)ctx;
+}
+
+void astrid_module_destroy(void * ctx) {
+    if(ctx != NULL) destroy_localctx((localctx_t *)ctx);
+}
+
+void astrid_module_stream(int channels, size_t blocksize, float ** input, float ** output, void * instrument) {
+    audio_callback(channels, blocksize, input, output, instrument);
+}
+
+lpbuffer_t * astrid_module_renderer(void * instrument) {
+    return renderer_callback(instrument);
+}
+
+void astrid_module_updates(void * instrument) {
+    param_update_callback(instrument);
+}
+
+/* Carry the running state into a rebuilt pulsar.so on hot reload. 
+ * The old context is still playing during the crossfade, so it 
+ * is only read here. Both versions must share the localctx_t layout. */
+void * astrid_module_migrate(lpinstrument_t * instrument, void * old_ctx) {
+    localctx_t * prev = (localctx_t *)old_ctx;
+    localctx_t * ctx;
+
+    if((ctx = create_localctx()) == NULL) return NULL;
+
+    if(prev == NULL) {
+        init_params(instrument, ctx);
+        return (void *)ctx;
+    }
+
+    memcpy(ctx->ringbuf->data, prev->ringbuf->data, sizeof(lpfloat_t) * prev->ringbuf->length * prev->ringbuf->channels);
+    ctx->ringbuf->pos = prev->ringbuf->pos;
+    ctx->last = prev->last;
+
+    memcpy(ctx->env_phases, prev->env_phases, sizeof(ctx->env_phases));
+    memcpy(ctx->env_phaseincs, prev->env_phaseincs, sizeof(ctx->env_phaseincs));
+    memcpy(ctx->selected_freqs, prev->selected_freqs, sizeof(ctx->selected_freqs));
+
+    for(int i=0; i < NUMOSCS; i++) {
+        ctx->curves[i]->phase = prev->curves[i]->phase;
+        ctx->oscs[i]->phase = prev->oscs[i]->phase;
+        ctx->oscs[i]->wavetable_morph_freq = prev->oscs[i]->wavetable_morph_freq;
+    }
+
+    return (void *)ctx;
+}
+#else
+int main() {
+    lpinstrument_t * instrument;
+    localctx_t * ctx;
+
+    if((ctx = create_localctx()) == NULL) {
+        exit(1);
+    }
+
+    // Set the callbacks for streaming, async renders and param updates
+    if((instrument = astrid_instrument_start(NAME, astrid_get_channels(CHANNELS), (void*)ctx, 
+                    audio_callback, renderer_callback, param_update_callback)) == NULL) {
+        fprintf(stderr, "Could not start instrument: (%d) %s\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    init_params(instrument, ctx);
 
     /* twiddle thumbs until shutdown */
     while(instrument->is_running) {
@@ -186,17 +272,9 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    /* clean up local memory */
-    for(int o=0; o < NUMOSCS; o++) {
-        LPPulsarOsc.destroy(ctx->oscs[o]);
-        LPBuffer.destroy(ctx->curves[o]);
-    }
-
-    LPBuffer.destroy(ctx->ringbuf);
-    LPBuffer.destroy(ctx->env);
-
-    free(ctx);
+    destroy_localctx(ctx);
 
     printf("Done!\n");
     return 0;
 }
+#endif
@@ -0,0 +1,158 @@
+#include "astrid.h"
+#include "ugens.sine.h"
+#include "ugens.utils.h"
+
+#define NAME "ugengraph"
+
+#define SR 48000
+#define CHANNELS 2
+
+enum InstrumentParams {
+    PARAM_AMP,
+    PARAM_FREQ,
+    NUMPARAMS
+};
+
+enum GraphNodes {
+    NODE_LFO,
+    NODE_CARRIER,
+    NODE_AMP,
+    NUMNODES
+};
+
+/* The same compiled graph the python Graph builds, run
+ * a block at a time from the jack callback */
+typedef struct localctx_t {
+    lpugengraph_t * graph;
+    int nodes[NUMNODES];
+} localctx_t;
+
+void param_update_callback(void * arg) {
+    lpinstrument_t * instrument = (lpinstrument_t *)arg;
+
+    syslog(LOG_DEBUG, "MSG: update | %s\n", instrument->msg.msg);
+    astrid_instrument_set_param_float(instrument, PARAM_AMP, LPRand.rand(0.1f, 0.3f));
+    astrid_instrument_set_param_float(instrument, PARAM_FREQ, LPRand.rand(0.05f, 3.f));
+}
+
+void audio_callback(int channels, size_t blocksize, float ** input, float ** output, void * arg) {
+    size_t pos, i, n;
+    int c;
+    lpfloat_t amp, freq;
+    lpfloat_t * mix;
+    ugen_t * u;
+    lpinstrument_t * instrument = (lpinstrument_t *)arg;
+    localctx_t * ctx = (localctx_t *)astrid_instrument_get_context(instrument);
+
+    (void)input;
+
+    if(!instrument->is_running) return;
+
+    /* Params land on the ugens between blocks */
+    amp = astrid_instrument_get_param_float(instrument, PARAM_AMP, 0.2f);
+    freq = astrid_instrument_get_param_float(instrument, PARAM_FREQ, 0.5f);
+
+    u = ctx->graph->nodes[ctx->nodes[NODE_AMP]].u;
+    u->set_param(u, UMULTIN_B, (void *)&amp);
+    u = ctx->graph->nodes[ctx->nodes[NODE_LFO]].u;
+    u->set_param(u, USINEIN_FREQ, (void *)&freq);
+
+    for(pos=0; pos < blocksize; pos += n) {
+        n = blocksize - pos;
+        if(n > ctx->graph->blocksize) n = ctx->graph->blocksize;
+        if((mix = LPUgenGraph.process(ctx->graph, n)) == NULL) return;
+
+        for(i=0; i < n; i++) {
+            for(c=0; c < channels; c++) {
+                output[c][pos + i] += (float)mix[i];
+            }
+        }
+    }
+}
+
+localctx_t * create_localctx(void) {
+    localctx_t * ctx = (localctx_t *)calloc(1, sizeof(localctx_t));
+    if(ctx == NULL) {
+        printf("Could not alloc ctx: (%d) %s\n", errno, strerror(errno));
+        return NULL;
+    }
+
+    ctx->graph = LPUgenGraph.create(LPUGENGRAPH_BLOCKSIZE);
+
+    ctx->nodes[NODE_LFO] = LPUgenGraph.add_node(ctx->graph, create_sine_ugen());
+    ctx->nodes[NODE_CARRIER] = LPUgenGraph.add_node(ctx->graph, create_sine_ugen());
+    ctx->nodes[NODE_AMP] = LPUgenGraph.add_node(ctx->graph, create_mult_ugen());
+
+    /* The lfo sweeps the carrier between 110 and 330hz once a
+     * block, and the amp mult takes the instrument's amp param */
+    LPUgenGraph.connect(ctx->graph, ctx->nodes[NODE_LFO], USINEOUT_MAIN, ctx->nodes[NODE_CARRIER], USINEIN_FREQ, 110.f, 220.f, LPUGENGRAPH_RATE_BLOCK);
+    LPUgenGraph.connect(ctx->graph, ctx->nodes[NODE_CARRIER], USINEOUT_MAIN, ctx->nodes[NODE_AMP], UMULTIN_A, 1.f, 0.f, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(ctx->graph, ctx->nodes[NODE_AMP], UMULTOUT_MAIN, LPUGENGRAPH_OUTPUT, 0, 1.f, 0.f, LPUGENGRAPH_RATE_SAMPLE);
+
+    /* Sort and allocate now rather than in the callback */
+    if(LPUgenGraph.compile(ctx->graph) < 0) {
+        LPUgenGraph.destroy(ctx->graph);
+        free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void destroy_localctx(localctx_t * ctx) {
+    LPUgenGraph.destroy(ctx->graph);
+    free(ctx);
+}
+
+#ifdef ASTRID_MODULE
+/* Exports for loading into astrid-host */
+const int astrid_module_channels = CHANNELS;
+
+void * astrid_module_create(lpinstrument_t * instrument) {
+    (void)instrument;
+    return (void *)create_localctx();
+}
+
+void astrid_module_destroy(void * ctx) {
+    if(ctx != NULL) destroy_localctx((localctx_t *)ctx);
+}
+
+void astrid_module_stream(int channels, size_t blocksize, float ** input, float ** output, void * instrument) {
+    audio_callback(channels, blocksize, input, output, instrument);
+}
+
+void astrid_module_updates(void * instrument) {
+    param_update_callback(instrument);
+}
+#else
+int main() {
+    lpinstrument_t * instrument;
+    localctx_t * ctx;
+
+    if((ctx = create_localctx()) == NULL) {
+        exit(1);
+    }
+
+    /* Streams only: there is no async renderer */
+    if((instrument = astrid_instrument_start(NAME, astrid_get_channels(CHANNELS), (void*)ctx,
+                    audio_callback, NULL, param_update_callback)) == NULL) {
+        fprintf(stderr, "Could not start instrument: (%d) %s\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    /* twiddle thumbs until shutdown */
+    while(instrument->is_running) {
+        astrid_instrument_tick(instrument);
+    }
+
+    if(astrid_instrument_stop(instrument) < 0) {
+        fprintf(stderr, "There was a problem stopping the instrument. (%d) %s\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    destroy_localctx(ctx);
+
+    printf("Done!\n");
+    return 0;
+}
+#endif
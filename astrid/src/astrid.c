@@ -23,6 +23,14 @@ void lptimeit_since(struct timespec * start) {
 #ifdef LPSESSIONDB
 /* SESSION
  * DATABASE
+ *
+ * Voice lifecycle events are pushed onto a bounded 
+ * lock-free queue by the message threads and drained 
+ * by a single writer thread, which owns the only write 
+ * connection and commits each drained batch in one 
+ * transaction. Readers like astrid-voicestatus use 
+ * their own connections: in WAL mode they never block 
+ * the writer and always see the last committed batch.
  * ********/
 static int lpsessiondb_callback_debug(__attribute__((unused)) void * unused, int argc, char ** argv, char ** colname) {
     int i;
@@ -32,29 +40,41 @@ static int lpsessiondb_callback_debug(__attribute__((unused)) void * unused, int
     return 0;
 }
 
-static int __attribute__((unused)) lpsessiondb_callback_noop(__attribute__((unused)) void * unused, __attribute__((unused)) int argc, __attribute__((unused)) char ** argv, __attribute__((unused)) char ** colname) {
-    return 0;
-}
-
 int lpsessiondb_open_for_writing(sqlite3 ** db) {
-    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READWRITE, NULL) > 0) {
-        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, strerror(errno));
+    char * err = 0;
+
+    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, sqlite3_errmsg(*db));
+        return -1;
+    }
+
+    sqlite3_busy_timeout(*db, LPSESSIONDB_BUSY_TIMEOUT);
+
+    /* WAL lets readers keep reading while the writer commits, 
+     * and normal sync only fsyncs at checkpoints in WAL mode */
+    if(sqlite3_exec(*db, "pragma journal_mode=WAL; pragma synchronous=NORMAL;", lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not set sessiondb WAL mode. Error: %s\n", sqlite3_errmsg(*db));
+        sqlite3_free(err);
         return -1;
     }
+
     return 0;
 }
 
 int lpsessiondb_open_for_reading(sqlite3 ** db) {
-    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READONLY, NULL) > 0) {
-        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, strerror(errno));
+    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, sqlite3_errmsg(*db));
         return -1;
-}
+    }
+
+    sqlite3_busy_timeout(*db, LPSESSIONDB_BUSY_TIMEOUT);
+
     return 0;
 }
 
 int lpsessiondb_close(sqlite3 * db) {
-    if(sqlite3_close(db) < 0) {
-        syslog(LOG_ERR, "Could not close sql db. Error: %s\n", strerror(errno));
+    if(sqlite3_close(db) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not close sql db. Error: %s\n", sqlite3_errmsg(db));
         return -1;
     }
 
@@ -65,160 +85,328 @@ int lpsessiondb_create(sqlite3 ** db) {
     char * err = 0;
     char * sql = "create table voices \
                   (created integer, started integer, last_render integer, ended integer, \
-                   active integer, timestamp real, id integer, instrument_name text, \
+                   active integer, timestamp real, id integer primary key, instrument_name text, \
                    params text, render_count integer);";
 
     /* Remove any existing sessiondb */
     unlink(ASTRID_SESSIONDB_PATH);
 
     /* Create and open the database */
-    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) > 0) {
-        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, strerror(errno));
+    if(sqlite3_open_v2(ASTRID_SESSIONDB_PATH, db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not open db at path: %s. Error: %s\n", ASTRID_SESSIONDB_PATH, sqlite3_errmsg(*db));
         return -1;
     }
 
     /* Set up session schema */
     if(sqlite3_exec(*db, sql, lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
         syslog(LOG_ERR, "Could not exec sql statement: %s. Error: %s\n", sql, sqlite3_errmsg(*db));
+        sqlite3_free(err);
         return -1;
     }
 
     /* Set WAL mode */
     if(sqlite3_exec(*db, "pragma journal_mode=WAL;", lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
         syslog(LOG_ERR, "Could not set sessiondb WAL mode. Error: %s\n", sqlite3_errmsg(*db));
+        sqlite3_free(err);
         return -1;
     }
 
     return 0;
 }
 
-int lpsessiondb_insert_voice(lpmsg_t msg) {
-    sqlite3 * db;
-    char * err = 0;
-    char * sql;
-    size_t sqlsize;
+static long long lpsessiondb_now(void) {
     struct timespec ts;
-    long long now;
-
-    char * _sql = "insert into voices (created, started, last_render, ended, active, timestamp, \
-                   id, instrument_name, params, render_count) \
-                   values (%lld, NULL, NULL, NULL, 0, %f, %d, \"%s\", \"%s\", 0);";
-
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-    /* Prepare the sql unsafely */
-    sqlsize = snprintf(NULL, 0, _sql, now, msg.initiated, (int)msg.voice_id, msg.instrument_name, msg.msg)+1;
-    sql = calloc(1, sqlsize);
-    if(snprintf(sql, sqlsize, _sql, now, msg.initiated, (int)msg.voice_id, msg.instrument_name, msg.msg) < 0) {
-        syslog(LOG_ERR, "Could not concat sql for insert. Error: %s\n", strerror(errno));
-        return -1;
+/* Multi-producer enqueue on a bounded ring with per-slot 
+ * sequence numbers. Never blocks: if the writer has fallen 
+ * a full queue behind, the event is dropped and counted. */
+static int lpsessiondb_enqueue(lpsessiondb_writer_t * w, lpsessiondb_event_t * event) {
+    lpsessiondb_slot_t * slot;
+    size_t pos, seq;
+
+    pos = atomic_load_explicit(&w->head, memory_order_relaxed);
+    while(1) {
+        slot = &w->slots[pos & (LPSESSIONDB_QUEUE_SIZE-1)];
+        seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        if(seq == pos) {
+            if(atomic_compare_exchange_weak_explicit(&w->head, &pos, pos+1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if((ssize_t)(seq - pos) < 0) {
+            atomic_fetch_add_explicit(&w->dropped, 1, memory_order_relaxed);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&w->head, memory_order_relaxed);
+        }
     }
 
-    /* Open the sessiondb for writing */
-    lpsessiondb_open_for_writing(&db);
+    memcpy(&slot->event, event, sizeof(lpsessiondb_event_t));
+    atomic_store_explicit(&slot->sequence, pos+1, memory_order_release);
 
-    /* Insert the voice */
-    if(sqlite3_exec(db, sql, lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
-        syslog(LOG_ERR, "Could not exec sql statement: %s. Error: %s\n", sql, strerror(errno));
-        return -1;
-    }
+    sem_post(&w->pending);
 
-    return lpsessiondb_close(db);
+    return 0;
 }
 
-int lpsessiondb_mark_voice_active(sqlite3 * db, int voice_id) {
-    char * err = 0;
-    char * sql;
-    size_t sqlsize;
-    struct timespec ts;
-    long long now;
+/* Single consumer: only the writer thread calls this */
+static int lpsessiondb_dequeue(lpsessiondb_writer_t * w, lpsessiondb_event_t * event) {
+    lpsessiondb_slot_t * slot;
 
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    slot = &w->slots[w->tail & (LPSESSIONDB_QUEUE_SIZE-1)];
+    if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != w->tail+1) return 0;
 
-    /* Prepare the sql unsafely */
-    sqlsize = snprintf(NULL, 0, "update voices set active=1, started=%lld, last_render=%lld, render_count=1 where id=%d;", now, now, voice_id)+1;
-    sql = calloc(1, sqlsize);
-    if(snprintf(sql, sqlsize, "update voices set active=1, started=%lld, last_render=%lld, render_count=1 where id=%d;", now, now, voice_id) < 0) {
-        syslog(LOG_ERR, "Could not concat sql for update. Error: %s\n", strerror(errno));
-        return -1;
+    memcpy(event, &slot->event, sizeof(lpsessiondb_event_t));
+    atomic_store_explicit(&slot->sequence, w->tail + LPSESSIONDB_QUEUE_SIZE, memory_order_release);
+    w->tail += 1;
+
+    return 1;
+}
+
+static int lpsessiondb_write_event(lpsessiondb_writer_t * w, lpsessiondb_event_t * e) {
+    sqlite3_stmt * stmt;
+
+    switch(e->type) {
+        case LPSESSIONDB_INSERT_VOICE:
+            stmt = w->insert_voice;
+            sqlite3_bind_int64(stmt, 1, e->timestamp);
+            sqlite3_bind_double(stmt, 2, e->initiated);
+            sqlite3_bind_int64(stmt, 3, (sqlite3_int64)e->voice_id);
+            sqlite3_bind_text(stmt, 4, e->instrument_name, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, e->params, -1, SQLITE_STATIC);
+            break;
+
+        case LPSESSIONDB_MARK_ACTIVE:
+            stmt = w->mark_active;
+            sqlite3_bind_int64(stmt, 1, e->timestamp);
+            sqlite3_bind_int64(stmt, 2, (sqlite3_int64)e->voice_id);
+            break;
+
+        case LPSESSIONDB_RENDER_COUNT:
+            stmt = w->render_count;
+            sqlite3_bind_int64(stmt, 1, e->timestamp);
+            sqlite3_bind_int64(stmt, 2, (e->count == SIZE_MAX) ? 0 : (sqlite3_int64)e->count);
+            sqlite3_bind_int64(stmt, 3, (sqlite3_int64)e->voice_id);
+            break;
+
+        case LPSESSIONDB_MARK_STOPPED:
+            stmt = w->mark_stopped;
+            sqlite3_bind_int64(stmt, 1, e->timestamp);
+            if(e->count == SIZE_MAX) {
+                sqlite3_bind_null(stmt, 2);
+            } else {
+                sqlite3_bind_int64(stmt, 2, (sqlite3_int64)e->count);
+            }
+            sqlite3_bind_int64(stmt, 3, (sqlite3_int64)e->voice_id);
+            break;
+
+        default:
+            syslog(LOG_ERR, "lpsessiondb_write_event: unknown event type %d\n", e->type);
+            return -1;
     }
 
-    /* Mark the voice as active */
-    if(sqlite3_exec(db, sql, lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
-        syslog(LOG_ERR, "Could not exec sql statement: %s. Error: %s\n", sql, strerror(errno));
+    if(sqlite3_step(stmt) != SQLITE_DONE) {
+        syslog(LOG_ERR, "lpsessiondb_write_event Could not write event for voice %d. Error: %s\n", (int)e->voice_id, sqlite3_errmsg(w->db));
+        sqlite3_reset(stmt);
         return -1;
     }
 
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
     return 0;
 }
 
-int lpsessiondb_increment_voice_render_count(sqlite3 * db, int voice_id, size_t count) {
-    char * err = 0;
-    char * sql;
-    size_t sqlsize;
-    struct timespec ts;
-    long long now;
+static int lpsessiondb_write_batch(lpsessiondb_writer_t * w) {
+    lpsessiondb_event_t * event = &w->event;
+    int count = 0;
 
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    if(!lpsessiondb_dequeue(w, event)) return 0;
 
-    if(count == SIZE_MAX) {
-        count = 0;
+    if(sqlite3_step(w->begin) != SQLITE_DONE) {
+        syslog(LOG_ERR, "lpsessiondb_write_batch Could not begin transaction. Error: %s\n", sqlite3_errmsg(w->db));
     }
+    sqlite3_reset(w->begin);
 
-    sqlsize = snprintf(NULL, 0, "update voices set active=1, last_render=%lld, render_count=%ld where id=%d;", now, count, voice_id)+1;
-    if((sql = calloc(1, sqlsize)) == NULL) {
-        syslog(LOG_ERR, "lpsessiondb_increment_voice_render_count Could not alloc space for sql query. Error: (%d) %s\n", errno, strerror(errno));
-        return -1;
+    do {
+        lpsessiondb_write_event(w, event);
+        count += 1;
+    } while(count < LPSESSIONDB_BATCH_SIZE && lpsessiondb_dequeue(w, event));
+
+    if(sqlite3_step(w->commit) != SQLITE_DONE) {
+        syslog(LOG_ERR, "lpsessiondb_write_batch Could not commit transaction. Error: %s\n", sqlite3_errmsg(w->db));
     }
+    sqlite3_reset(w->commit);
 
-    if(snprintf(sql, sqlsize, "update voices set active=1, last_render=%lld, render_count=%ld where id=%d;", now, count, voice_id) < 0) {
-        syslog(LOG_ERR, "lpsessiondb_increment_voice_render_count Could not concat sql for update. Error: (%d) %s\n", errno, strerror(errno));
-        return -1;
+    return count;
+}
+
+static void * lpsessiondb_writer_thread(void * arg) {
+    lpsessiondb_writer_t * w = (lpsessiondb_writer_t *)arg;
+    int count;
+
+    while(1) {
+        if(sem_wait(&w->pending) < 0) {
+            if(errno == EINTR) continue;
+            syslog(LOG_ERR, "lpsessiondb_writer_thread Could not wait for events. Error: %s\n", strerror(errno));
+            break;
+        }
+
+        /* Each post is one event, so consume the posts for 
+         * everything written in the batch beyond the first */
+        count = lpsessiondb_write_batch(w);
+        while(count-- > 1) sem_trywait(&w->pending);
+
+        if(!w->is_running && atomic_load(&w->head) == w->tail) break;
     }
 
-    /* Mark the voice as active */
-    if(sqlite3_exec(db, sql, lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
-        syslog(LOG_ERR, "lpsessiondb_increment_voice_render_count Could not exec sql statement: %s. Error: (%d) %s\n", sql, errno, strerror(errno));
+    return NULL;
+}
+
+static int lpsessiondb_prepare(lpsessiondb_writer_t * w, const char * sql, sqlite3_stmt ** stmt) {
+    if(sqlite3_prepare_v2(w->db, sql, -1, stmt, NULL) != SQLITE_OK) {
+        syslog(LOG_ERR, "Could not prepare sessiondb statement: %s. Error: %s\n", sql, sqlite3_errmsg(w->db));
         return -1;
     }
-
     return 0;
 }
 
-int lpsessiondb_mark_voice_stopped(sqlite3 * db, int voice_id, size_t count) {
-    char * err = 0;
-    char * sql;
-    size_t sqlsize;
-    struct timespec ts;
-    long long now;
+lpsessiondb_writer_t * lpsessiondb_writer_start(void) {
+    lpsessiondb_writer_t * w;
+    size_t i;
 
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    if((w = (lpsessiondb_writer_t *)calloc(1, sizeof(lpsessiondb_writer_t))) == NULL) {
+        syslog(LOG_ERR, "Could not alloc sessiondb writer. Error: %s\n", strerror(errno));
+        return NULL;
+    }
 
-    /* Prepare the sql unsafely */
-    sqlsize = snprintf(NULL, 0, "update voices set active=0, ended=%lld, last_render=%lld, render_count=%ld where id=%d;", now, now, count, voice_id)+1;
-    if((sql = calloc(1, sqlsize)) == NULL) {
-        syslog(LOG_ERR, "lpsessiondb_mark_voice_stopped Could not alloc space for sql query. Error: (%d) %s\n", errno, strerror(errno));
-        return -1;
+    if((w->slots = (lpsessiondb_slot_t *)calloc(LPSESSIONDB_QUEUE_SIZE, sizeof(lpsessiondb_slot_t))) == NULL) {
+        syslog(LOG_ERR, "Could not alloc sessiondb queue. Error: %s\n", strerror(errno));
+        free(w);
+        return NULL;
     }
 
-    if(snprintf(sql, sqlsize, "update voices set active=0, ended=%lld, last_render=%lld, render_count=%ld where id=%d;", now, now, count, voice_id) < 0) {
-        syslog(LOG_ERR, "lpsessiondb_mark_voice_stopped Could not concat sql for update. Error: (%d) %s\n", errno, strerror(errno));
-        return -1;
+    for(i=0; i < LPSESSIONDB_QUEUE_SIZE; i++) {
+        atomic_init(&w->slots[i].sequence, i);
     }
+    atomic_init(&w->head, 0);
+    atomic_init(&w->dropped, 0);
+    w->tail = 0;
 
-    /* Mark the voice as stopped */
-    if(sqlite3_exec(db, sql, lpsessiondb_callback_debug, 0, &err) != SQLITE_OK) {
-        syslog(LOG_ERR, "lpsessiondb_mark_voice_stopped Could not exec sql statement: %s. Error: (%d) %s\n", sql, errno, strerror(errno));
-        return -1;
+    if(lpsessiondb_open_for_writing(&w->db) < 0) goto lpsessiondb_writer_start_error;
+
+    if(lpsessiondb_prepare(w, "begin;", &w->begin) < 0
+    || lpsessiondb_prepare(w, "commit;", &w->commit) < 0
+    || lpsessiondb_prepare(w, "insert into voices (created, started, last_render, ended, active, timestamp, id, instrument_name, params, render_count) values (?1, NULL, NULL, NULL, 0, ?2, ?3, ?4, ?5, 0);", &w->insert_voice) < 0
+    || lpsessiondb_prepare(w, "update voices set active=1, started=?1, last_render=?1, render_count=1 where id=?2;", &w->mark_active) < 0
+    || lpsessiondb_prepare(w, "update voices set active=1, last_render=?1, render_count=?2 where id=?3;", &w->render_count) < 0
+    || lpsessiondb_prepare(w, "update voices set active=0, ended=?1, last_render=?1, render_count=coalesce(?2, render_count) where id=?3;", &w->mark_stopped) < 0
+    ) goto lpsessiondb_writer_start_error;
+
+    if(sem_init(&w->pending, 0, 0) < 0) {
+        syslog(LOG_ERR, "Could not init sessiondb writer semaphore. Error: %s\n", strerror(errno));
+        goto lpsessiondb_writer_start_error;
+    }
+
+    w->is_running = 1;
+    if(pthread_create(&w->thread, NULL, lpsessiondb_writer_thread, (void*)w) != 0) {
+        syslog(LOG_ERR, "Could not start sessiondb writer thread. Error: %s\n", strerror(errno));
+        sem_destroy(&w->pending);
+        goto lpsessiondb_writer_start_error;
+    }
+
+    return w;
+
+lpsessiondb_writer_start_error:
+    sqlite3_finalize(w->begin);
+    sqlite3_finalize(w->commit);
+    sqlite3_finalize(w->insert_voice);
+    sqlite3_finalize(w->mark_active);
+    sqlite3_finalize(w->render_count);
+    sqlite3_finalize(w->mark_stopped);
+    if(w->db != NULL) lpsessiondb_close(w->db);
+    free(w->slots);
+    free(w);
+    return NULL;
+}
+
+/* Flushes everything still in the queue before closing */
+int lpsessiondb_writer_stop(lpsessiondb_writer_t * w) {
+    size_t dropped;
+
+    w->is_running = 0;
+    sem_post(&w->pending);
+
+    if(pthread_join(w->thread, NULL) != 0) {
+        syslog(LOG_ERR, "Could not join sessiondb writer thread. Error: %s\n", strerror(errno));
+    }
+
+    /* Anything that raced the shutdown post is written here */
+    while(lpsessiondb_write_batch(w) > 0);
+
+    if((dropped = atomic_load(&w->dropped)) > 0) {
+        syslog(LOG_WARNING, "sessiondb writer dropped %ld events\n", dropped);
     }
 
+    sem_destroy(&w->pending);
+    sqlite3_finalize(w->begin);
+    sqlite3_finalize(w->commit);
+    sqlite3_finalize(w->insert_voice);
+    sqlite3_finalize(w->mark_active);
+    sqlite3_finalize(w->render_count);
+    sqlite3_finalize(w->mark_stopped);
+
+    lpsessiondb_close(w->db);
+    free(w->slots);
+    free(w);
+
     return 0;
 }
 
+int lpsessiondb_insert_voice(lpsessiondb_writer_t * w, lpmsg_t * msg) {
+    lpsessiondb_event_t e;
+
+    e.type = LPSESSIONDB_INSERT_VOICE;
+    e.timestamp = lpsessiondb_now();
+    e.initiated = msg->initiated;
+    e.voice_id = msg->voice_id;
+    e.count = 0;
+    memcpy(e.instrument_name, msg->instrument_name, LPMAXNAME);
+    memcpy(e.params, msg->msg, LPMAXMSG);
+    e.instrument_name[LPMAXNAME-1] = '\0';
+    e.params[LPMAXMSG-1] = '\0';
+
+    return lpsessiondb_enqueue(w, &e);
+}
+
+static int lpsessiondb_enqueue_update(lpsessiondb_writer_t * w, int type, size_t voice_id, size_t count) {
+    lpsessiondb_event_t e;
+
+    e.type = type;
+    e.timestamp = lpsessiondb_now();
+    e.initiated = 0;
+    e.voice_id = voice_id;
+    e.count = count;
+    e.instrument_name[0] = '\0';
+    e.params[0] = '\0';
+
+    return lpsessiondb_enqueue(w, &e);
+}
+
+int lpsessiondb_mark_voice_active(lpsessiondb_writer_t * w, size_t voice_id) {
+    return lpsessiondb_enqueue_update(w, LPSESSIONDB_MARK_ACTIVE, voice_id, 1);
+}
+
+int lpsessiondb_increment_voice_render_count(lpsessiondb_writer_t * w, size_t voice_id, size_t count) {
+    return lpsessiondb_enqueue_update(w, LPSESSIONDB_RENDER_COUNT, voice_id, count);
+}
+
+/* A count of SIZE_MAX keeps the voice's render count as it is */
+int lpsessiondb_mark_voice_stopped(lpsessiondb_writer_t * w, size_t voice_id, size_t count) {
+    return lpsessiondb_enqueue_update(w, LPSESSIONDB_MARK_STOPPED, voice_id, count);
+}
+
 #endif
 
 /* SHARED MEMORY
@@ -1004,41 +1192,87 @@ int lpmidi_getnote(int device_id, int note) {
     return lpipc_getid(note_path);
 }
 
-/* MIDI STATUS IPC
+/* SERIAL CTL IPC
  * GETTERS & SETTERS
  * ****************/
+static lpserialctl_table_t * serial_ctltable = NULL;
+
+/* Maps the shared ctl table, creating it on first use. 
+ * The mapping is kept for the life of the process. */
+lpserialctl_table_t * lpserial_ctltable_open() {
+    int fd;
+    void * shmaddr;
+
+    if(serial_ctltable != NULL) return serial_ctltable;
+
+    if((fd = shm_open(ASTRID_SERIAL_CTLTABLE_PATH+4, O_CREAT | O_RDWR, LPIPC_PERMS)) < 0) {
+        syslog(LOG_ERR, "lpserial_ctltable_open Could not open shared memory segment. (%s) %s\n", ASTRID_SERIAL_CTLTABLE_PATH, strerror(errno));
+        return NULL;
+    }
+
+    /* Growing a new segment zero-fills it, an existing table keeps its values */
+    if(ftruncate(fd, sizeof(lpserialctl_table_t)) < 0) {
+        syslog(LOG_ERR, "lpserial_ctltable_open Could not truncate shared memory segment to size %ld. (%s) %s\n", sizeof(lpserialctl_table_t), ASTRID_SERIAL_CTLTABLE_PATH, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    if((shmaddr = mmap(NULL, sizeof(lpserialctl_table_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        syslog(LOG_ERR, "lpserial_ctltable_open Could not mmap shared memory segment. (%s) %s\n", ASTRID_SERIAL_CTLTABLE_PATH, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    close(fd);
+    serial_ctltable = (lpserialctl_table_t *)shmaddr;
+
+    return serial_ctltable;
+}
+
+/* CRC-16/CCITT-FALSE: easy to match in microcontroller firmware */
+uint16_t lpserial_crc16(const unsigned char * data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    size_t i;
+    int b;
+
+    for(i=0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for(b=0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
 int lpserial_setctl(int device_id, int param_id, size_t value) {
-    char * ctl_path;
-    size_t path_length;
+    lpserialctl_table_t * table;
 
-    path_length = snprintf(NULL, 0, ASTRID_SERIAL_CTLBASE_PATH, device_id, param_id) + 1;
-    ctl_path = (char *)calloc(1, path_length);
-    snprintf(ctl_path, path_length,  ASTRID_SERIAL_CTLBASE_PATH, device_id, param_id);
+    if(device_id < 0 || device_id >= ASTRID_SERIAL_MAXDEVICES || param_id < 0 || param_id >= ASTRID_SERIAL_MAXCTLS) {
+        syslog(LOG_ERR, "lpserial_setctl ctl %d on device %d is out of range\n", param_id, device_id);
+        return -1;
+    }
 
-    if(lpipc_setvalue(ctl_path, &value, sizeof(size_t)) < 0) {
-        syslog(LOG_ERR, "Could not store %ld for MIDI CC %d from device %d\n", value, param_id, device_id);
+    if((table = lpserial_ctltable_open()) == NULL) {
+        syslog(LOG_ERR, "Could not store %ld for serial ctl %d from device %d\n", value, param_id, device_id);
         return -1;
     }
 
-    free(ctl_path);
+    atomic_store_explicit(&table->values[device_id][param_id], value, memory_order_relaxed);
 
     return 0;
 }
 
 int lpserial_getctl(int device_id, int ctl, lpfloat_t * value) {
-    char ctl_path[50];
-    size_t path_length;
-    size_t ctl_value = 0;
-    void * ctl_valuep = &ctl_value;
-
-    path_length = snprintf(NULL, 0, ASTRID_SERIAL_CTLBASE_PATH, device_id, ctl) + 1;
-    snprintf(ctl_path, path_length,  ASTRID_SERIAL_CTLBASE_PATH, device_id, ctl);
+    lpserialctl_table_t * table;
 
-    if(lpipc_getvalue(ctl_path, &ctl_valuep)) {
-        return -1;        
+    if(device_id < 0 || device_id >= ASTRID_SERIAL_MAXDEVICES || ctl < 0 || ctl >= ASTRID_SERIAL_MAXCTLS) {
+        return -1;
     }
 
-    *value = (lpfloat_t)ctl_value / (lpfloat_t)SIZE_MAX;
+    if((table = lpserial_ctltable_open()) == NULL) return -1;
+
+    *value = (lpfloat_t)atomic_load_explicit(&table->values[device_id][ctl], memory_order_relaxed) / (lpfloat_t)SIZE_MAX;
 
     return 0;
 }
@@ -1260,6 +1494,21 @@ int lpmidi_trigger_notemap(int device_id, int note) {
     return 0;
 }
 
+/* The number of output channels for an instrument can be 
+ * chosen at start with the ASTRID_CHANNELS env variable */
+int astrid_get_channels(int default_channels) {
+    char * channels_env;
+    int channels;
+
+    if((channels_env = getenv("ASTRID_CHANNELS")) == NULL) return default_channels;
+    if((channels = atoi(channels_env)) <= 0) {
+        syslog(LOG_ERR, "Ignoring invalid ASTRID_CHANNELS value %s\n", channels_env);
+        return default_channels;
+    }
+
+    return channels;
+}
+
 /* VOICES
  * ******/
 #if 0
@@ -1510,12 +1759,13 @@ lpbuffer_t * deserialize_buffer(char * buffer_code, lpmsg_t * msg) {
     memcpy(&onset, str + offset, sizeof(size_t));
     offset += sizeof(size_t);
 
-    audio = calloc(1, audiosize);
+    audio = (lpfloat_t *)LPMemoryPool.alloc(1, audiosize);
     memcpy(audio, str + offset, audiosize);
     offset += audiosize;
 
     memcpy(msg, str + offset, sizeof(lpmsg_t));
     offset += sizeof(lpmsg_t);
+    LPMemoryPool.free(str);
 
     buf = (lpbuffer_t *)LPMemoryPool.alloc(1, sizeof(lpbuffer_t));
 
@@ -1796,6 +2046,9 @@ int parse_message_from_args(int argc, int arg_offset, char * argv[], lpmsg_t * m
     msg->count = 0;
     msg->voice_id = voice_id;
 
+    /* Pick up optional per-voice output routing from the params */
+    lproute_parse(msg->msg, &msg->route);
+
     return 0;
 }
 
@@ -1869,6 +2122,9 @@ int parse_message_from_cmdline(char * cmdline, lpmsg_t * msg) {
     msg->count = 0;
     msg->voice_id = voice_id;
 
+    /* Pick up optional per-voice output routing from the params */
+    lproute_parse(msg->msg, &msg->route);
+
     return 0;
 }
 
@@ -2105,6 +2361,13 @@ static inline void stop_playing(lpscheduler_t * s, lpevent_t * e) {
 
     current->next = NULL;
 
+#ifdef LPSESSIONDB
+    /* Enqueueing never blocks, so this is safe from the audio thread */
+    if(s->sessiondb != NULL && e->voice_id > 0) {
+        lpsessiondb_mark_voice_stopped(s->sessiondb, e->voice_id, SIZE_MAX);
+    }
+#endif
+
     /* Add to the tail of the garbage stack */
     if(s->nursery_head == NULL) {
         s->nursery_head = e;
@@ -2178,36 +2441,39 @@ static inline void scheduler_update(lpscheduler_t * s) {
     }
 }
 
-static inline void scheduler_mix_buffers(lpscheduler_t * s) {
-    lpevent_t * current;
-    lpfloat_t sample;
-    int bufc, c;
+static inline void scheduler_mix_event(lpscheduler_t * s, lpevent_t * e) {
+    lpfloat_t * frame;
+    uint32_t r;
+    int c;
 
-    if(s->playing_stack_head == NULL) {
+    if(e->buf == NULL || e->pos >= e->buf->length) return;
+    frame = e->buf->data + e->pos * e->buf->channels;
+
+    if(e->route.count == 0) {
         for(c=0; c < s->channels; c++) {
-            s->current_frame[c] = 0.f;
+            s->current_frame[c] += frame[c % e->buf->channels];
         }
         return;
     }
 
-    for(c=0; c < s->channels; c++) {
-        sample = 0.f;
+    for(r=0; r < e->route.count; r++) {
+        if(e->route.channels[r] >= s->channels) continue;
+        s->current_frame[e->route.channels[r]] += frame[r % e->buf->channels] * e->route.gains[r];
+    }
+}
 
-        current = s->playing_stack_head;
-        while(current->next != NULL) {
-            if(current->buf != NULL && current->pos < current->buf->length) {
-                bufc = c % current->buf->channels;
-                sample += current->buf->data[current->pos * current->buf->channels + bufc];
-            }
-            current = (lpevent_t *)current->next;
-        }
+static inline void scheduler_mix_buffers(lpscheduler_t * s) {
+    lpevent_t * current;
+    int c;
 
-        if(current->buf != NULL && current->pos < current->buf->length) {
-            bufc = c % current->buf->channels;
-            sample += current->buf->data[current->pos * current->buf->channels + bufc];
-        }
- 
-        s->current_frame[c] = sample;
+    for(c=0; c < s->channels; c++) {
+        s->current_frame[c] = 0.f;
+    }
+
+    current = s->playing_stack_head;
+    while(current != NULL) {
+        scheduler_mix_event(s, current);
+        current = (lpevent_t *)current->next;
     }
 }
 
@@ -2269,7 +2535,179 @@ void lpscheduler_tick(lpscheduler_t * s) {
     }
 }
 
+/* Gain-and-accumulate from an interleaved source into a planar 
+ * output port. The port side is processed LPMIX_VECSIZE frames 
+ * at a time with GCC vector types, with a scalar tail. */
+void lpmix_gain_accumulate(float * restrict out, const lpfloat_t * restrict src, size_t stride, float gain, size_t nframes) {
+    lpmixvec_t acc, in;
+    size_t i, j;
+
+    i = 0;
+    for(; i + LPMIX_VECSIZE <= nframes; i += LPMIX_VECSIZE) {
+        for(j=0; j < LPMIX_VECSIZE; j++) {
+            in[j] = (float)src[(i + j) * stride];
+        }
+        memcpy(&acc, out + i, sizeof(lpmixvec_t));
+        acc += in * gain;
+        memcpy(out + i, &acc, sizeof(lpmixvec_t));
+    }
+
+    for(; i < nframes; i++) {
+        out[i] += (float)src[i * stride] * gain;
+    }
+}
+
+/* Sum one planar port into another */
+void lpmix_accumulate(float * restrict out, const float * restrict in, size_t nframes) {
+    lpmixvec_t acc, v;
+    size_t i;
+
+    i = 0;
+    for(; i + LPMIX_VECSIZE <= nframes; i += LPMIX_VECSIZE) {
+        memcpy(&acc, out + i, sizeof(lpmixvec_t));
+        memcpy(&v, in + i, sizeof(lpmixvec_t));
+        acc += v;
+        memcpy(out + i, &acc, sizeof(lpmixvec_t));
+    }
+
+    for(; i < nframes; i++) {
+        out[i] += in[i];
+    }
+}
+
+/* Clamp a planar output port to -1..1, zeroing NaNs
+ * like lpzapgremlins so they never reach the device */
+void lpmix_clamp(float * restrict out, size_t nframes) {
+    lpmixvec_t v, lo, hi;
+    lpmixmask_t under, over, notnum;
+    size_t i;
+
+    lo = (lpmixvec_t){0} - 1.f;
+    hi = (lpmixvec_t){0} + 1.f;
+
+    i = 0;
+    for(; i + LPMIX_VECSIZE <= nframes; i += LPMIX_VECSIZE) {
+        memcpy(&v, out + i, sizeof(lpmixvec_t));
+        /* Comparisons give all-ones lanes, so select with bitmasks. 
+         * NaN compares false both ways and is only unequal to itself. */
+        notnum = v != v;
+        under = v < lo;
+        over = v > hi;
+        v = (lpmixvec_t)(((lpmixmask_t)v & ~(under | over | notnum)) | ((lpmixmask_t)lo & under) | ((lpmixmask_t)hi & over));
+        memcpy(out + i, &v, sizeof(lpmixvec_t));
+    }
+
+    for(; i < nframes; i++) {
+        out[i] = isnan(out[i]) ? 0.f : fmaxf(-1.f, fminf(out[i], 1.f));
+    }
+}
+
+/* Parse a route param of the form `route=<channel>:<gain>,<channel>:<gain>,...` 
+ * The gain may be omitted, and defaults to 1. Returns the number of entries. */
+int lproute_parse(char * params, lproute_t * route) {
+    char routestr[LPMAXMSG] = {0};
+    char *entry, *save=NULL;
+    char *gain;
+    char *start;
+    size_t length;
+
+    memset(route, 0, sizeof(lproute_t));
+
+    if(params == NULL) return 0;
+
+    /* Only match route= as a whole key, not the tail of reroute= etc */
+    start = params;
+    while((start = strstr(start, "route=")) != NULL) {
+        if(start == params || start[-1] == ' ' || start[-1] == '\n') break;
+        start += strlen("route=");
+    }
+    if(start == NULL) return 0;
+    start += strlen("route=");
+
+    length = strcspn(start, " \n");
+    if(length >= sizeof(routestr)) length = sizeof(routestr)-1;
+    memcpy(routestr, start, length);
+
+    entry = strtok_r(routestr, ",", &save);
+    while(entry != NULL && route->count < LPMAXROUTE) {
+        route->channels[route->count] = (uint16_t)atoi(entry);
+        route->gains[route->count] = ((gain = strchr(entry, ':')) != NULL) ? (float)atof(gain+1) : 1.f;
+        route->count += 1;
+        entry = strtok_r(NULL, ",", &save);
+    }
+
+    return (int)route->count;
+}
+
+/* Mix a block of playing buffers directly into planar output ports, 
+ * accumulating on top of whatever is already in the ports. 
+ * Buffers may start partway through the block at their onset. */
+void lpscheduler_tick_block(lpscheduler_t * s, float ** output, int channels, size_t nframes) {
+    lpevent_t * current;
+    lpevent_t * next;
+    size_t offset, length, block_end;
+    lpfloat_t * src;
+    uint32_t r;
+    int c;
+
+    block_end = s->ticks + nframes;
+
+    /* Start buffers with onsets inside this block */
+    current = s->waiting_queue_head;
+    while(current != NULL) {
+        next = (lpevent_t *)current->next;
+        if(current->onset < block_end) start_playing(s, current);
+        current = next;
+    }
+
+    current = s->playing_stack_head;
+    while(current != NULL) {
+        next = (lpevent_t *)current->next;
+
+        if(current->buf != NULL) {
+            offset = (current->onset > s->ticks) ? current->onset - s->ticks : 0;
+            length = current->buf->length - current->pos;
+            if(length > nframes - offset) length = nframes - offset;
+            src = current->buf->data + current->pos * current->buf->channels;
+
+            if(current->route.count == 0) {
+                for(c=0; c < channels; c++) {
+                    lpmix_gain_accumulate(output[c] + offset, src + (c % current->buf->channels), current->buf->channels, 1.f, length);
+                }
+            } else {
+                for(r=0; r < current->route.count; r++) {
+                    if(current->route.channels[r] >= channels) continue;
+                    lpmix_gain_accumulate(output[current->route.channels[r]] + offset, src + (r % current->buf->channels), current->buf->channels, current->route.gains[r], length);
+                }
+            }
+
+            current->pos += length;
+        }
+
+        if(current->buf == NULL || current->pos >= current->buf->length) {
+            stop_playing(s, current);
+        }
+
+        current = next;
+    }
+
+    s->ticks = block_end;
+    if(s->realtime == 1) {
+        scheduler_get_now(s->now);
+    } else {
+        scheduler_increment_timespec_by_ns(s->now, s->tick_ns * nframes);
+    }
+}
+
 void scheduler_schedule_event(lpscheduler_t * s, lpbuffer_t * buf, size_t onset_delay) {
+    scheduler_schedule_routed_event(s, buf, onset_delay, NULL);
+}
+
+void scheduler_schedule_routed_event(lpscheduler_t * s, lpbuffer_t * buf, size_t onset_delay, lproute_t * route) {
+    scheduler_schedule_voice_event(s, buf, onset_delay, route, 0);
+}
+
+void scheduler_schedule_voice_event(lpscheduler_t * s, lpbuffer_t * buf, size_t onset_delay, lproute_t * route, size_t voice_id) {
     lpevent_t * e;
 
     if(s->nursery_head != NULL) {
@@ -2287,6 +2725,13 @@ void scheduler_schedule_event(lpscheduler_t * s, lpbuffer_t * buf, size_t onset_
     e->buf = buf;
     e->pos = 0;
     e->onset = s->ticks + onset_delay;
+    e->voice_id = voice_id;
+
+    if(route != NULL) {
+        memcpy(&e->route, route, sizeof(lproute_t));
+    } else {
+        memset(&e->route, 0, sizeof(lproute_t));
+    }
 
     syslog(LOG_INFO, "scheduler got buffer with onset %d\n", (int)e->onset);
     syslog(LOG_INFO, "scheduler got buffer value 1000 %f\n", (float)buf->data[1000]);
@@ -2392,54 +2837,131 @@ int send_serial_message(lpmsg_t msg) {
     return 0;
 }
 
-int astrid_instrument_jack_callback(jack_nframes_t nframes, void * arg) {
-    lpinstrument_t * instrument = (lpinstrument_t *)arg;
-    float * output_channels[instrument->channels];
-    float * input_channels[instrument->channels];
+/* The module whose stream callback is running on this thread, 
+ * so both versions of a module see their own context during a 
+ * crossfade without anyone rewriting instrument->context */
+static _Thread_local lpmodule_t * astrid_streaming_module = NULL;
+
+/* Returns the context of the module currently streaming on this 
+ * thread from inside a stream callback, or the instrument's 
+ * context from the message thread */
+void * astrid_instrument_get_context(lpinstrument_t * instrument) {
+    if(astrid_streaming_module != NULL) return astrid_streaming_module->context;
+    return instrument->context;
+}
+
+static void astrid_instrument_stream_module(lpinstrument_t * instrument, lpmodule_t * module, size_t blocksize, float ** input_channels, float ** output_channels) {
+    if(module == NULL || module->stream == NULL) return;
+    astrid_streaming_module = module;
+    module->stream(instrument->channels, blocksize, input_channels, output_channels, (void *)instrument);
+    astrid_streaming_module = NULL;
+}
+
+/* Runs the outgoing and incoming module streams side by side 
+ * and mixes a linear crossfade between them into the output */
+static void astrid_instrument_crossfade_block(lpinstrument_t * instrument, size_t blocksize, float ** input_channels, float ** output_channels) {
+    lpmodule_t * prev = instrument->fading_module;
+    lpmodule_t * next = instrument->playing_module;
+    float * old_channels[instrument->channels];
+    float * new_channels[instrument->channels];
+    float gain;
     size_t i;
     int c;
 
-    if(!instrument->is_running) return 0;
-
-    if(!instrument->has_been_initialized) {
-        syslog(LOG_DEBUG, "Seeding the random number generator from the audio callback. %s\n", instrument->name);
-        LPRand.preseed();
-        instrument->has_been_initialized = 1;
-        // TODO could run the before callback here maybe, 
-        // or is there a reason to have mainthread-before AND audiothread-before?
+    for(c=0; c < instrument->channels; c++) {
+        old_channels[c] = instrument->xfade_old + c * ASTRID_RELOAD_MAXBLOCKSIZE;
+        new_channels[c] = instrument->xfade_new + c * ASTRID_RELOAD_MAXBLOCKSIZE;
+        memset(old_channels[c], 0, blocksize * sizeof(float));
+        memset(new_channels[c], 0, blocksize * sizeof(float));
     }
 
-    for(c=0; c < instrument->channels; c++) {
-        input_channels[c] = (float *)jack_port_get_buffer(instrument->inports[c], nframes);
-        output_channels[c] = (float *)jack_port_get_buffer(instrument->outports[c], nframes);
-        memset(output_channels[c], 0, nframes * sizeof(float));
+    astrid_instrument_stream_module(instrument, prev, blocksize, input_channels, old_channels);
+    astrid_instrument_stream_module(instrument, next, blocksize, input_channels, new_channels);
+
+    for(i=0; i < blocksize; i++) {
+        gain = (float)(instrument->xfade_pos + i) / (float)instrument->xfade_length;
+        if(gain > 1.f) gain = 1.f;
+        for(c=0; c < instrument->channels; c++) {
+            output_channels[c][i] += old_channels[c][i] * (1.f - gain) + new_channels[c][i] * gain;
+        }
+    }
+
+    instrument->xfade_pos += blocksize;
+}
+
+/* Render one block of an instrument into planar output buffers: 
+ * async renders from the mixer first, then the stream callback. 
+ * Shared by the per-instrument JACK callback and astrid-host. */
+void astrid_instrument_process_block(lpinstrument_t * instrument, size_t blocksize, float ** input_channels, float ** output_channels) {
+    lpmodule_t * next, * retired;
+    int c;
+
+    if(!instrument->has_been_initialized) {
+        syslog(LOG_DEBUG, "Seeding the random number generator from the audio callback. %s\n", instrument->name);
+        LPRand.preseed();
+        instrument->has_been_initialized = 1;
+        // TODO could run the before callback here maybe, 
+        // or is there a reason to have mainthread-before AND audiothread-before?
+    }
+
+    for(c=0; c < instrument->channels; c++) {
+        memset(output_channels[c], 0, blocksize * sizeof(float));
     }
 
+    /* Take a hot reloaded module at the block boundary */
+    if(instrument->fading_module == NULL 
+    && (next = atomic_exchange_explicit(&instrument->pending_module, NULL, memory_order_acq_rel)) != NULL) {
+        instrument->fading_module = instrument->playing_module;
+        instrument->playing_module = next;
+        instrument->xfade_pos = 0;
+    }
 
     /* mix in async renders */
     if(instrument->async_mixer != NULL) {
-        for(i=0; i < (size_t)nframes; i++) {
-            lpscheduler_tick(instrument->async_mixer);
-            for(c=0; c < instrument->channels; c++) {
-                output_channels[c][i] += instrument->async_mixer->current_frame[c];
-            }
+        lpscheduler_tick_block(instrument->async_mixer, output_channels, instrument->channels, blocksize);
+    }
+
+    if(instrument->fading_module != NULL 
+    && instrument->xfade_pos < instrument->xfade_length 
+    && blocksize <= ASTRID_RELOAD_MAXBLOCKSIZE) {
+        astrid_instrument_crossfade_block(instrument, blocksize, input_channels, output_channels);
+    } else {
+        astrid_instrument_stream_module(instrument, instrument->playing_module, blocksize, input_channels, output_channels);
+    }
+
+    /* Hand the old module back to the message thread to be closed. 
+     * This is the audio thread's acknowledgement that it is done with 
+     * the old code: its last stream call has returned, and it is never 
+     * called again. If the message thread hasn't collected the last 
+     * one yet, try again next block. Blocks too big for the crossfade 
+     * scratch space just swap. */
+    if(instrument->fading_module != NULL 
+    && (instrument->xfade_pos >= instrument->xfade_length || blocksize > ASTRID_RELOAD_MAXBLOCKSIZE)) {
+        retired = NULL;
+        if(atomic_compare_exchange_strong_explicit(&instrument->retired_module, &retired, instrument->fading_module, memory_order_release, memory_order_relaxed)) {
+            instrument->fading_module = NULL;
         }
     }
+}
 
-    if(instrument->stream != NULL) {
-        instrument->stream(
-            instrument->channels, 
-            (size_t)nframes, 
-            input_channels, output_channels, 
-            (void *)instrument
-        );
+int astrid_instrument_jack_callback(jack_nframes_t nframes, void * arg) {
+    lpinstrument_t * instrument = (lpinstrument_t *)arg;
+    float * output_channels[instrument->channels];
+    float * input_channels[instrument->channels];
+    int c;
+
+    if(!instrument->is_running) return 0;
+
+    for(c=0; c < instrument->channels; c++) {
+        input_channels[c] = (float *)jack_port_get_buffer(instrument->inports[c], nframes);
+        output_channels[c] = (float *)jack_port_get_buffer(instrument->outports[c], nframes);
     }
 
+    astrid_instrument_process_block(instrument, (size_t)nframes, input_channels, output_channels);
+
     /* clamp output */
     for(c=0; c < instrument->channels; c++) {
-        for(i=0; i < (size_t)nframes; i++) {
-            output_channels[c][i] = fmax(-1.f, fmin(output_channels[c][i], 1.f));
-        }
+        lpmix_clamp(output_channels[c], (size_t)nframes);
     }
 
     return 0;
@@ -2588,12 +3110,33 @@ int relay_message_to_seq(lpinstrument_t * instrument) {
     return 0;
 }
 
+/* Log a rendered voice to the session db. The first render 
+ * of a voice inserts it, later renders bump its count. */
+static void astrid_instrument_log_render(lpinstrument_t * instrument, lpmsg_t * msg) {
+#ifdef LPSESSIONDB
+    if(instrument->sessiondb == NULL || msg->voice_id == 0) return;
+
+    if(msg->count == 0) {
+        lpsessiondb_insert_voice(instrument->sessiondb, msg);
+        lpsessiondb_mark_voice_active(instrument->sessiondb, msg->voice_id);
+    } else {
+        lpsessiondb_increment_voice_render_count(instrument->sessiondb, msg->voice_id, msg->count+1);
+    }
+#else
+    (void)instrument;
+    (void)msg;
+#endif
+}
+
 void * instrument_message_thread(void * arg) {
     lpmsg_t bufmsg = {0}; // the message serialized along with the async buffer...
     lpbuffer_t * buf; // async renders: FIXME, do renders in a thread if possible... or fork out early for the python interpreter maybe?
     double processing_time_so_far, onset_delay_in_seconds, now=0;
     lpinstrument_t * instrument = (lpinstrument_t *)arg;
     int is_scheduled = 0;
+    char load_params[LPMAXMSG];
+    char * module_path, * token, * save;
+    size_t token_length;
 
     instrument->is_waiting = 1;
     while(instrument->is_running) {
@@ -2651,7 +3194,8 @@ void * instrument_message_thread(void * arg) {
                     syslog(LOG_ERR, "DAC could not deserialize buffer. Error: (%d) %s\n", errno, strerror(errno));
                     continue;
                 }
-                scheduler_schedule_event(instrument->async_mixer, buf, 0);
+                astrid_instrument_log_render(instrument, &bufmsg);
+                scheduler_schedule_voice_event(instrument->async_mixer, buf, 0, &bufmsg.route, bufmsg.voice_id);
                 break;
 
             case LPMSG_UPDATE:
@@ -2691,14 +3235,33 @@ void * instrument_message_thread(void * arg) {
                     syslog(LOG_INFO, "msg.onset_delay %ld\n", instrument->msg.onset_delay);
 
                     /* Schedule the buffer for playback */
-                    scheduler_schedule_event(instrument->async_mixer, buf, 0);
+                    astrid_instrument_log_render(instrument, &instrument->msg);
+                    scheduler_schedule_voice_event(instrument->async_mixer, buf, 0, &instrument->msg.route, instrument->msg.voice_id);
                 }
                 break;
 
             case LPMSG_LOAD:
-                // it would be interesting to explore live reloading of C modules
-                // in the tradition of CLIVE, but at the moment only python handles these
+                // C modules are reloaded in place, in the tradition of CLIVE. 
+                // A message param ending in .so loads that module instead, 
+                // otherwise the current module is reopened from its path.
+                // Python instruments handle their own reloads from the relay.
                 syslog(LOG_DEBUG, "C MSG: load\n");
+                module_path = NULL;
+                memcpy(load_params, instrument->msg.msg, LPMAXMSG);
+                load_params[LPMAXMSG-1] = '\0';
+                for(token = strtok_r(load_params, " ", &save); token != NULL; token = strtok_r(NULL, " ", &save)) {
+                    token_length = strlen(token);
+                    if(token_length > 3 && strcmp(token + token_length - 3, ".so") == 0) {
+                        module_path = token;
+                        break;
+                    }
+                }
+
+                if(module_path == NULL && (instrument->module == NULL || instrument->module->handle == NULL)) break;
+
+                if(astrid_instrument_reload(instrument, module_path) < 0) {
+                    syslog(LOG_ERR, "%s Could not reload instrument module\n", instrument->name);
+                }
                 break;
 
             case LPMSG_TRIGGER:
@@ -2745,7 +3308,31 @@ int astrid_instrument_seq_start(lpinstrument_t * instrument) {
     return 0;
 }
 
-lpinstrument_t * astrid_instrument_start(
+static int astrid_install_shutdown_handlers(const char * name, volatile int * is_running) {
+    struct sigaction shutdown_action;
+
+    /* Set shutdown signal handlers */
+    shutdown_action.sa_handler = handle_instrument_shutdown;
+    sigemptyset(&shutdown_action.sa_mask);
+    shutdown_action.sa_flags = SA_RESTART; /* Prevent open, read, write etc from EINTR */
+    astrid_instrument_is_running = is_running;
+
+    if(sigaction(SIGINT, &shutdown_action, NULL) == -1) {
+        syslog(LOG_ERR, "%s Could not init SIGINT signal handler. Error: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    if(sigaction(SIGTERM, &shutdown_action, NULL) == -1) {
+        syslog(LOG_ERR, "%s Could not init SIGTERM signal handler. Error: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Set up everything an instrument needs except for audio I/O: 
+ * the async mixer, message q names and the LMDB session. */
+lpinstrument_t * astrid_instrument_create(
     const char * name, 
     int channels, 
     void * ctx,
@@ -2754,13 +3341,6 @@ lpinstrument_t * astrid_instrument_start(
     void (*updates)(void * instrument)
 ) {
     lpinstrument_t * instrument;
-    struct sigaction shutdown_action;
-    jack_status_t jack_status;
-    jack_options_t jack_options = JackNullOption;
-    const char ** ports;
-    char outport_name[50];
-    char inport_name[50];
-    int c = 0;
 
     instrument = (lpinstrument_t *)LPMemoryPool.alloc(1, sizeof(lpinstrument_t));
     memset(instrument, 0, sizeof(lpinstrument_t));
@@ -2775,25 +3355,16 @@ lpinstrument_t * astrid_instrument_start(
     instrument->renderer = renderer;
     instrument->updates = updates;
 
-    openlog(name, LOG_PID, LOG_USER);
-
-    /* Seed the random number generator */
-    LPRand.preseed();
-
-    /* Set shutdown signal handlers */
-    shutdown_action.sa_handler = handle_instrument_shutdown;
-    sigemptyset(&shutdown_action.sa_mask);
-    shutdown_action.sa_flags = SA_RESTART; /* Prevent open, read, write etc from EINTR */
-    astrid_instrument_is_running = &instrument->is_running;
-
-    if(sigaction(SIGINT, &shutdown_action, NULL) == -1) {
-        syslog(LOG_ERR, "%s Could not init SIGINT signal handler. Error: %s\n", name, strerror(errno));
-        exit(1);
+    /* Every instrument streams through a module, so a hot reload 
+     * always has an old version to fade from */
+    if((instrument->module = astrid_module_wrap(ctx, stream, renderer, updates)) == NULL) {
+        LPMemoryPool.free(instrument);
+        return NULL;
     }
+    instrument->playing_module = instrument->module;
 
-    if(sigaction(SIGTERM, &shutdown_action, NULL) == -1) {
-        syslog(LOG_ERR, "%s Could not init SIGTERM signal handler. Error: %s\n", name, strerror(errno));
-        exit(1);
+    if(LPTableCache.share(ASTRID_TABLECACHE_PREFIX) < 0) {
+        syslog(LOG_WARNING, "%s: could not share the table cache, tables will be built per process\n", name);
     }
 
     /* init scheduler
@@ -2814,6 +3385,72 @@ lpinstrument_t * astrid_instrument_start(
     /* Open the LMDB session */
     astrid_instrument_session_open(instrument);
 
+    return instrument;
+}
+
+int astrid_instrument_start_message_threads(lpinstrument_t * instrument) {
+    // Ready for some messages now! Open the message queue and start up the seq threads...
+    if((instrument->msgq = astrid_msgq_open(instrument->qname)) == (mqd_t) -1) {
+        syslog(LOG_CRIT, "Could not open msgq for instrument %s. Error: %s\n", instrument->name, strerror(errno));
+        return -1;
+    }
+    syslog(LOG_DEBUG, "Opened message queue for %s with fd %d\n", instrument->name, instrument->msgq);
+    if((instrument->exmsgq = astrid_msgq_open(instrument->external_relay_name)) == (mqd_t) -1) {
+        syslog(LOG_CRIT, "Could not open external message relay for instrument %s. Error: %s\n", instrument->name, strerror(errno));
+        return -1;
+    }
+    syslog(LOG_DEBUG, "Opened message relay queue for %s with fd %d\n", instrument->name, instrument->exmsgq);
+
+    // Write the instrument name into msg structs
+    snprintf(instrument->msg.instrument_name, strlen(instrument->name)+1, instrument->name);
+    snprintf(instrument->cmd.instrument_name, strlen(instrument->name)+1, instrument->name);
+
+    // Start the message sequencer
+    if(astrid_instrument_seq_start(instrument) < 0) {
+        syslog(LOG_CRIT, "Could not start message sequence threads for instrument %s. Error: %s\n", instrument->name, strerror(errno));
+        return -1;
+    }
+
+    /* Start message feed thread */
+    if(pthread_create(&instrument->message_feed_thread, NULL, instrument_message_thread, (void*)instrument) != 0) {
+        syslog(LOG_ERR, "Could not initialize instrument message thread. Error: %s\n", strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+lpinstrument_t * astrid_instrument_start(
+    const char * name, 
+    int channels, 
+    void * ctx,
+    void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument),
+    lpbuffer_t * (*renderer)(void * instrument),
+    void (*updates)(void * instrument)
+) {
+    lpinstrument_t * instrument;
+    jack_status_t jack_status;
+    jack_options_t jack_options = JackNullOption;
+    const char ** ports;
+    char outport_name[50];
+    char inport_name[50];
+    int c = 0;
+
+    openlog(name, LOG_PID, LOG_USER);
+
+    /* Seed the random number generator */
+    LPRand.preseed();
+
+    if((instrument = astrid_instrument_create(name, channels, ctx, stream, renderer, updates)) == NULL) {
+        syslog(LOG_ERR, "%s Could not create instrument\n", name);
+        closelog();
+        return NULL;
+    }
+
+    if(astrid_install_shutdown_handlers(name, &instrument->is_running) < 0) {
+        exit(1);
+    }
+
     /* Set up JACK */
     instrument->inports = (jack_port_t **)calloc(channels, sizeof(jack_port_t *));
     instrument->outports = (jack_port_t **)calloc(channels, sizeof(jack_port_t *));
@@ -2892,31 +3529,7 @@ lpinstrument_t * astrid_instrument_start(
     syslog(LOG_INFO, "%s is running...\n", name);
 
 
-    // Ready for some messages now! Open the message queue and start up the seq threads...
-    if((instrument->msgq = astrid_msgq_open(instrument->qname)) == (mqd_t) -1) {
-        syslog(LOG_CRIT, "Could not open msgq for instrument %s. Error: %s\n", instrument->name, strerror(errno));
-        return NULL;
-    }
-    syslog(LOG_DEBUG, "Opened message queue for %s with fd %d\n", instrument->name, instrument->msgq);
-    if((instrument->exmsgq = astrid_msgq_open(instrument->external_relay_name)) == (mqd_t) -1) {
-        syslog(LOG_CRIT, "Could not open external message relay for instrument %s. Error: %s\n", instrument->name, strerror(errno));
-        return NULL;
-    }
-    syslog(LOG_DEBUG, "Opened message relay queue for %s with fd %d\n", instrument->name, instrument->exmsgq);
-
-    // Write the instrument name into msg structs
-    snprintf(instrument->msg.instrument_name, strlen(instrument->name)+1, instrument->name);
-    snprintf(instrument->cmd.instrument_name, strlen(instrument->name)+1, instrument->name);
-
-    // Start the message sequencer
-    if(astrid_instrument_seq_start(instrument) < 0) {
-        syslog(LOG_CRIT, "Could not start message sequence threads for instrument %s. Error: %s\n", instrument->name, strerror(errno));
-        return NULL;
-    }
-
-    /* Start message feed thread */
-    if(pthread_create(&instrument->message_feed_thread, NULL, instrument_message_thread, (void*)instrument) != 0) {
-        syslog(LOG_ERR, "Could not initialize instrument message thread. Error: %s\n", strerror(errno));
+    if(astrid_instrument_start_message_threads(instrument) < 0) {
         return NULL;
     }
 
@@ -2932,6 +3545,32 @@ astrid_instrument_shutdown_with_error:
     return NULL;
 }
 
+/* Close every module the instrument still holds, each once: 
+ * the message thread's, the audio thread's, and any caught 
+ * mid-reload. Only safe once the audio thread has stopped. */
+static void astrid_instrument_close_modules(lpinstrument_t * instrument) {
+    lpmodule_t * modules[5];
+    int i, j;
+
+    modules[0] = instrument->module;
+    modules[1] = instrument->playing_module;
+    modules[2] = instrument->fading_module;
+    modules[3] = atomic_exchange_explicit(&instrument->retired_module, NULL, memory_order_acq_rel);
+    modules[4] = atomic_exchange_explicit(&instrument->pending_module, NULL, memory_order_acq_rel);
+
+    for(i=0; i < 5; i++) {
+        if(modules[i] == NULL) continue;
+        for(j=0; j < i; j++) {
+            if(modules[j] == modules[i]) break;
+        }
+        if(j == i) astrid_module_close(modules[i]);
+    }
+
+    instrument->module = NULL;
+    instrument->playing_module = NULL;
+    instrument->fading_module = NULL;
+}
+
 int astrid_instrument_stop(lpinstrument_t * instrument) {
     int c, ret;
 
@@ -2965,86 +3604,825 @@ int astrid_instrument_stop(lpinstrument_t * instrument) {
     syslog(LOG_DEBUG, "Closing instrument message queue...\n");
     if(instrument->msgq != (mqd_t) -1) astrid_msgq_close(instrument->msgq);
 
-    syslog(LOG_DEBUG, "Stopping JACK...\n");
-    for(c=0; c < instrument->channels; c++) {
-        jack_port_unregister(instrument->jack_client, instrument->outports[c]);
-        jack_port_unregister(instrument->jack_client, instrument->inports[c]);
-    }
+    /* Instruments running inside astrid-host share the host's JACK client */
+    if(instrument->jack_client != NULL) {
+        syslog(LOG_DEBUG, "Stopping JACK...\n");
+        for(c=0; c < instrument->channels; c++) {
+            jack_port_unregister(instrument->jack_client, instrument->outports[c]);
+            jack_port_unregister(instrument->jack_client, instrument->inports[c]);
+        }
 
-    jack_client_close(instrument->jack_client);
+        jack_client_close(instrument->jack_client);
+    }
 
     syslog(LOG_DEBUG, "Closing lmdb session...\n");
     astrid_instrument_session_close(instrument);
 
     if(instrument->async_mixer != NULL) scheduler_destroy(instrument->async_mixer);
 
+    /* Nothing is streaming anymore, so every module still 
+     * in flight from a reload can be closed along with it */
+    astrid_instrument_close_modules(instrument);
+    free(instrument->xfade_old);
+    free(instrument->xfade_new);
+
     syslog(LOG_DEBUG, "All done, see ya later!\n");
-    closelog();
+    if(instrument->jack_client != NULL) closelog();
     return 0;
 }
 
-int astrid_instrument_get_or_create_datadir(const char * name, char * dbpath) {
-    int ret;
-    char astrid_data_path[PATH_MAX];
-    char xdg_data_home[PATH_MAX];
-    char * user_home;
-    char * _xdg_data_home = getenv("XDG_DATA_HOME");
-    char * default_data_dir = ".local/share";
-    char * instrument_subdir = "astrid_instruments";
-
-    if(_xdg_data_home == NULL) {
-        user_home = getenv("HOME");
-        ret = snprintf(xdg_data_home, PATH_MAX, "%s/%s", user_home, default_data_dir);
-        if(ret < 0) {
-            syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", default_data_dir, errno, strerror(errno));
-            return -1;
-        }
-
-    } else {
-        memcpy(xdg_data_home, _xdg_data_home, PATH_MAX);
+/* HOT RELOADING
+ *
+ * C instruments built as shared modules can be 
+ * swapped for a rebuilt version while they play. 
+ * The new module is opened and its state migrated 
+ * here on the message thread, then the audio thread 
+ * takes it at the next block boundary and crossfades 
+ * from the old version before handing it back.
+ * *******************/
+lpmodule_t * astrid_module_open(const char * path) {
+    lpmodule_t * module;
+    char copy_path[] = "/tmp/astrid-module-XXXXXX.so";
+    char block[8192];
+    ssize_t bytesread;
+    int src, dst;
+
+    if((module = (lpmodule_t *)calloc(1, sizeof(lpmodule_t))) == NULL) {
+        syslog(LOG_ERR, "astrid_module_open Could not alloc module for %s. Error: %s\n", path, strerror(errno));
+        return NULL;
     }
 
-    if(access(xdg_data_home, F_OK) != 0) {
-        /* create the xdg data home dir */
-        if(mkdir(xdg_data_home, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
-            syslog(LOG_ERR, "session data path (%s) mkdir: (%d) %s\n", xdg_data_home, errno, strerror(errno));
-            return -1;
-        }
+    snprintf(module->path, PATH_MAX, "%s", path);
+
+    /* dlopen hands back the already loaded image for a path it has 
+     * seen before, so every version is loaded from a private copy */
+    if((src = open(path, O_RDONLY)) < 0) {
+        syslog(LOG_ERR, "astrid_module_open Could not open %s. Error: %s\n", path, strerror(errno));
+        free(module);
+        return NULL;
     }
 
-    ret = snprintf(astrid_data_path, PATH_MAX, "%s/%s", xdg_data_home, instrument_subdir);
-    if(ret < 0) {
-        syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", astrid_data_path, errno, strerror(errno));
-        return -1;
+    if((dst = mkstemps(copy_path, 3)) < 0) {
+        syslog(LOG_ERR, "astrid_module_open Could not create module copy for %s. Error: %s\n", path, strerror(errno));
+        close(src);
+        free(module);
+        return NULL;
     }
 
-    if(access(astrid_data_path, F_OK) != 0) {
-        /* create the astrid data path */
-        if(mkdir(astrid_data_path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
-            syslog(LOG_ERR, "astrid data path (%s) mkdir: (%d) %s\n", astrid_data_path, errno, strerror(errno));
-            return -1;
+    while((bytesread = read(src, block, sizeof(block))) > 0) {
+        if(write(dst, block, bytesread) != bytesread) {
+            bytesread = -1;
+            break;
         }
     }
 
-    ret = snprintf(dbpath, PATH_MAX, "%s/%s", astrid_data_path, name);
-    if(ret < 0) {
-        syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", astrid_data_path, errno, strerror(errno));
-        return -1;
+    close(src);
+    close(dst);
+
+    if(bytesread < 0) {
+        syslog(LOG_ERR, "astrid_module_open Could not copy %s. Error: %s\n", path, strerror(errno));
+        unlink(copy_path);
+        free(module);
+        return NULL;
     }
 
-    if(access(dbpath, F_OK) != 0) {
-        /* create the data dir */
-        if(mkdir(dbpath, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
-            syslog(LOG_ERR, "session data path (%s) mkdir: (%d) %s\n", dbpath, errno, strerror(errno));
-            return -1;
-        }
+    module->handle = dlopen(copy_path, RTLD_NOW | RTLD_LOCAL);
+    unlink(copy_path);
+
+    if(module->handle == NULL) {
+        syslog(LOG_ERR, "astrid_module_open Could not load instrument module %s. Error: %s\n", path, dlerror());
+        free(module);
+        return NULL;
     }
 
-    return 0;
-}
+    /* Function pointers are assigned through void ** as POSIX suggests for dlsym */
+    *(void **)(&module->create) = dlsym(module->handle, ASTRID_MODULE_CREATE_SYMBOL);
+    *(void **)(&module->destroy) = dlsym(module->handle, ASTRID_MODULE_DESTROY_SYMBOL);
+    *(void **)(&module->migrate) = dlsym(module->handle, ASTRID_MODULE_MIGRATE_SYMBOL);
+    *(void **)(&module->stream) = dlsym(module->handle, ASTRID_MODULE_STREAM_SYMBOL);
+    *(void **)(&module->renderer) = dlsym(module->handle, ASTRID_MODULE_RENDERER_SYMBOL);
+    *(void **)(&module->updates) = dlsym(module->handle, ASTRID_MODULE_UPDATES_SYMBOL);
 
-int astrid_instrument_session_open(lpinstrument_t * instrument) {
-    int rc;
+    return module;
+}
+
+/* Wrap the callbacks of an instrument started as a program. 
+ * The context belongs to the program, so the wrapper has no 
+ * destroy and closing it never frees the context. */
+lpmodule_t * astrid_module_wrap(
+    void * ctx,
+    void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument),
+    lpbuffer_t * (*renderer)(void * instrument),
+    void (*updates)(void * instrument)
+) {
+    lpmodule_t * module;
+
+    if((module = (lpmodule_t *)calloc(1, sizeof(lpmodule_t))) == NULL) {
+        syslog(LOG_ERR, "astrid_module_wrap Could not alloc module wrapper. Error: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    module->context = ctx;
+    module->stream = stream;
+    module->renderer = renderer;
+    module->updates = updates;
+
+    return module;
+}
+
+void astrid_module_close(lpmodule_t * module) {
+    if(module->destroy != NULL) module->destroy(module->context);
+    if(module->handle != NULL) dlclose(module->handle);
+    free(module);
+}
+
+/* Reload the instrument from the module at path, or from 
+ * its current module's path if path is NULL. Waits for the 
+ * crossfade to finish so the old version can be closed, up 
+ * to ASTRID_RELOAD_TIMEOUT_SECONDS. Must not be called from 
+ * the audio thread. 
+ *
+ * A module is only ever closed once the audio thread has 
+ * handed it back, or never played it. If the audio thread 
+ * is late, the old version is left for a later reload or 
+ * astrid_instrument_stop to close. */
+int astrid_instrument_reload(lpinstrument_t * instrument, const char * path) {
+    lpmodule_t * next, * current, * retired, * stale;
+    char module_path[PATH_MAX];
+    struct timespec start, now;
+
+    current = instrument->module;
+
+    if(path == NULL) {
+        if(current->handle == NULL) {
+            syslog(LOG_ERR, "%s has no module to reload\n", instrument->name);
+            return -1;
+        }
+        path = current->path;
+    }
+
+    snprintf(module_path, PATH_MAX, "%s", path);
+
+    if(instrument->xfade_old == NULL) {
+        instrument->xfade_old = (float *)calloc(instrument->channels * ASTRID_RELOAD_MAXBLOCKSIZE, sizeof(float));
+        instrument->xfade_new = (float *)calloc(instrument->channels * ASTRID_RELOAD_MAXBLOCKSIZE, sizeof(float));
+        if(instrument->xfade_old == NULL || instrument->xfade_new == NULL) {
+            syslog(LOG_ERR, "%s Could not alloc crossfade blocks. Error: %s\n", instrument->name, strerror(errno));
+            return -1;
+        }
+
+        /* Set once, before the audio thread ever reads it */
+        instrument->xfade_length = (size_t)(((instrument->samplerate > 0) ? instrument->samplerate : ASTRID_SAMPLERATE) * ASTRID_RELOAD_XFADE_SECONDS);
+    }
+
+    /* Close anything handed back since a reload that timed out */
+    if((retired = atomic_exchange_explicit(&instrument->retired_module, NULL, memory_order_acq_rel)) != NULL) {
+        astrid_module_close(retired);
+    }
+
+    if((next = astrid_module_open(module_path)) == NULL) return -1;
+
+    /* Build the new state while the old version keeps playing */
+    if(next->migrate != NULL) {
+        next->context = next->migrate(instrument, current->context);
+    } else if(next->create != NULL) {
+        next->context = next->create(instrument);
+    }
+
+    /* A reload the audio thread never took is replaced. It never 
+     * played, so it can be closed once nothing here points at it. */
+    stale = atomic_exchange_explicit(&instrument->pending_module, next, memory_order_acq_rel);
+
+    instrument->module = next;
+    instrument->context = next->context;
+    instrument->renderer = next->renderer;
+    instrument->updates = next->updates;
+
+    if(stale != NULL) astrid_module_close(stale);
+
+    /* Wait for the audio thread to finish the fade and hand the old version back */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while((retired = atomic_exchange_explicit(&instrument->retired_module, NULL, memory_order_acq_rel)) == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if(now.tv_sec - start.tv_sec >= ASTRID_RELOAD_TIMEOUT_SECONDS) {
+            syslog(LOG_WARNING, "%s Reloaded instrument from %s, but the audio thread has not finished the crossfade. The old version will be closed later.\n", instrument->name, module_path);
+            return 0;
+        }
+        usleep((useconds_t)1000);
+    }
+
+    astrid_module_close(retired);
+
+    syslog(LOG_INFO, "%s Reloaded instrument from %s\n", instrument->name, module_path);
+
+    return 0;
+}
+
+/* ASTRID HOST
+ *
+ * Runs many instruments inside one process 
+ * with a single JACK client. Instruments are 
+ * processed in dependency order every period, 
+ * and instruments with no dependencies between 
+ * them may be spread across a small worker pool. 
+ * *******************/
+lphost_t * astrid_host_create(const char * name, int channels, int num_workers) {
+    lphost_t * host;
+
+    host = (lphost_t *)LPMemoryPool.alloc(1, sizeof(lphost_t));
+    memset(host, 0, sizeof(lphost_t));
+
+    host->name = name;
+    host->channels = channels;
+    host->num_workers = (num_workers > ASTRID_HOST_MAXWORKERS) ? ASTRID_HOST_MAXWORKERS : num_workers;
+    if(host->num_workers < 0) host->num_workers = 0;
+
+    openlog(name, LOG_PID, LOG_USER);
+
+    /* Seed the random number generator */
+    LPRand.preseed();
+
+    if(astrid_install_shutdown_handlers(name, &host->is_running) < 0) {
+        return NULL;
+    }
+
+    return host;
+}
+
+static int astrid_host_find_slot(lphost_t * host, const char * name) {
+    int i;
+    for(i=0; i < host->num_slots; i++) {
+        if(strcmp(host->slots[i].instrument->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+int astrid_host_add_instrument(
+    lphost_t * host,
+    const char * name, 
+    int channels, 
+    void * ctx,
+    void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument),
+    lpbuffer_t * (*renderer)(void * instrument),
+    void (*updates)(void * instrument)
+) {
+    lphost_slot_t * slot;
+
+    if(host->num_slots >= ASTRID_HOST_MAXINSTRUMENTS) {
+        syslog(LOG_ERR, "%s Could not add instrument %s: too many instruments\n", host->name, name);
+        return -1;
+    }
+
+    if(astrid_host_find_slot(host, name) >= 0) {
+        syslog(LOG_ERR, "%s Could not add instrument %s: name is already in use\n", host->name, name);
+        return -1;
+    }
+
+    slot = &host->slots[host->num_slots];
+    if((slot->instrument = astrid_instrument_create(name, channels, ctx, stream, renderer, updates)) == NULL) {
+        syslog(LOG_ERR, "%s Could not create instrument %s\n", host->name, name);
+        return -1;
+    }
+
+    host->num_slots += 1;
+    return host->num_slots - 1;
+}
+
+/* Load a C instrument compiled as a shared module, or 
+ * add a proxy for a python instrument if module_path is NULL. 
+ *
+ * Proxies have no stream callback: the python renderer 
+ * attaches to the proxy's message queues by name and its 
+ * renders are mixed in through the proxy's async mixer. */
+int astrid_host_load_instrument(lphost_t * host, const char * name, const char * module_path) {
+    lpmodule_t * module;
+    lpinstrument_t * instrument;
+    int index;
+    int * channels;
+
+    if(module_path == NULL) {
+        return astrid_host_add_instrument(host, name, host->channels, NULL, NULL, NULL, NULL);
+    }
+
+    if((module = astrid_module_open(module_path)) == NULL) {
+        syslog(LOG_ERR, "%s Could not load instrument module %s\n", host->name, module_path);
+        return -1;
+    }
+
+    channels = (int *)dlsym(module->handle, ASTRID_MODULE_CHANNELS_SYMBOL);
+
+    if((index = astrid_host_add_instrument(host, name, (channels != NULL) ? *channels : host->channels, NULL, module->stream, module->renderer, module->updates)) < 0) {
+        astrid_module_close(module);
+        return -1;
+    }
+
+    /* Nothing is streaming yet, so swap out the wrapper made by create */
+    instrument = host->slots[index].instrument;
+    astrid_module_close(instrument->module);
+    instrument->module = module;
+    instrument->playing_module = module;
+
+    /* The LMDB session is open at this point, so modules may set initial params */
+    if(module->create != NULL) module->context = module->create(instrument);
+    instrument->context = module->context;
+
+    syslog(LOG_INFO, "%s Loaded instrument %s from %s\n", host->name, name, module_path);
+
+    return index;
+}
+
+/* Route the output of src into the input of dst. 
+ * dst will always be processed after src, and src 
+ * is no longer mixed directly into the main bus. */
+int astrid_host_route(lphost_t * host, const char * src_name, const char * dst_name) {
+    int src, dst;
+    lphost_slot_t * slot;
+
+    if((src = astrid_host_find_slot(host, src_name)) < 0 || (dst = astrid_host_find_slot(host, dst_name)) < 0) {
+        syslog(LOG_ERR, "%s Could not route %s to %s: unknown instrument\n", host->name, src_name, dst_name);
+        return -1;
+    }
+
+    if(src == dst) {
+        syslog(LOG_ERR, "%s Could not route %s into itself\n", host->name, src_name);
+        return -1;
+    }
+
+    slot = &host->slots[dst];
+    if(slot->num_sources >= ASTRID_HOST_MAXINSTRUMENTS) {
+        syslog(LOG_ERR, "%s Could not route %s to %s: too many sources\n", host->name, src_name, dst_name);
+        return -1;
+    }
+
+    slot->sources[slot->num_sources] = src;
+    slot->num_sources += 1;
+    host->slots[src].is_routed = 1;
+
+    return 0;
+}
+
+/* Sort the slots into levels with Kahn's algorithm. Every 
+ * instrument in a level only depends on earlier levels. */
+static int astrid_host_sort(lphost_t * host) {
+    int indegree[ASTRID_HOST_MAXINSTRUMENTS] = {0};
+    int placed[ASTRID_HOST_MAXINSTRUMENTS] = {0};
+    int i, s, count, level_start;
+
+    for(i=0; i < host->num_slots; i++) {
+        indegree[i] = host->slots[i].num_sources;
+    }
+
+    count = 0;
+    host->num_levels = 0;
+    while(count < host->num_slots) {
+        level_start = count;
+        for(i=0; i < host->num_slots; i++) {
+            if(placed[i] || indegree[i] > 0) continue;
+            host->order[count] = i;
+            count += 1;
+        }
+
+        if(count == level_start) {
+            syslog(LOG_ERR, "%s Could not order instruments: routing has a cycle\n", host->name);
+            return -1;
+        }
+
+        host->level_offsets[host->num_levels] = level_start;
+        host->num_levels += 1;
+
+        /* Release the dependents of this level */
+        for(i=level_start; i < count; i++) {
+            placed[host->order[i]] = 1;
+        }
+
+        for(i=0; i < host->num_slots; i++) {
+            if(placed[i]) continue;
+            indegree[i] = 0;
+            for(s=0; s < host->slots[i].num_sources; s++) {
+                if(!placed[host->slots[i].sources[s]]) indegree[i] += 1;
+            }
+        }
+    }
+
+    host->level_offsets[host->num_levels] = count;
+
+    return 0;
+}
+
+static int astrid_host_alloc_blocks(lphost_t * host, size_t blocksize) {
+    lphost_slot_t * slot;
+    int i, c;
+
+    for(i=0; i < host->num_slots; i++) {
+        slot = &host->slots[i];
+
+        free(slot->input_block);
+        free(slot->output_block);
+
+        slot->input_block = (float *)calloc(blocksize * slot->instrument->channels, sizeof(float));
+        slot->output_block = (float *)calloc(blocksize * slot->instrument->channels, sizeof(float));
+        if(slot->inputs == NULL) slot->inputs = (float **)calloc(slot->instrument->channels, sizeof(float *));
+        if(slot->outputs == NULL) slot->outputs = (float **)calloc(slot->instrument->channels, sizeof(float *));
+
+        if(slot->input_block == NULL || slot->output_block == NULL || slot->inputs == NULL || slot->outputs == NULL) {
+            syslog(LOG_ERR, "%s Could not allocate blocks for %s. Error: %s\n", host->name, slot->instrument->name, strerror(errno));
+            return -1;
+        }
+
+        for(c=0; c < slot->instrument->channels; c++) {
+            slot->outputs[c] = slot->output_block + c * blocksize;
+        }
+    }
+
+    host->blocksize = blocksize;
+
+    return 0;
+}
+
+static void astrid_host_process_slot(lphost_t * host, int index, size_t nframes) {
+    lphost_slot_t * src;
+    lphost_slot_t * slot = &host->slots[index];
+    size_t i;
+    int c, s;
+
+    if(slot->num_sources == 0) {
+        /* Unrouted instruments read from the host inputs */
+        for(c=0; c < slot->instrument->channels; c++) {
+            slot->inputs[c] = host->capture[c % host->channels];
+        }
+    } else {
+        /* Sources are all in earlier levels, so their outputs are ready */
+        for(c=0; c < slot->instrument->channels; c++) {
+            slot->inputs[c] = slot->input_block + c * host->blocksize;
+            memset(slot->inputs[c], 0, nframes * sizeof(float));
+            for(s=0; s < slot->num_sources; s++) {
+                src = &host->slots[slot->sources[s]];
+                for(i=0; i < nframes; i++) {
+                    slot->inputs[c][i] += src->outputs[c % src->instrument->channels][i];
+                }
+            }
+        }
+    }
+
+    astrid_instrument_process_block(slot->instrument, nframes, slot->inputs, slot->outputs);
+}
+
+static void astrid_host_run_jobs(lphost_t * host) {
+    int job;
+    while((job = atomic_fetch_add(&host->next_job, 1)) < host->job_end) {
+        astrid_host_process_slot(host, host->order[job], host->job_nframes);
+    }
+}
+
+static void * astrid_host_worker_thread(void * arg) {
+    lphost_t * host = (lphost_t *)arg;
+
+    while(1) {
+        if(sem_wait(&host->work_ready) < 0) {
+            if(errno == EINTR) continue;
+            syslog(LOG_ERR, "%s worker could not wait for work. Error: %s\n", host->name, strerror(errno));
+            break;
+        }
+
+        if(!host->workers_running) break;
+
+        astrid_host_run_jobs(host);
+
+        sem_post(&host->work_done);
+    }
+
+    return NULL;
+}
+
+/* Only once nothing will hand the workers jobs anymore */
+static void astrid_host_stop_workers(lphost_t * host) {
+    int w;
+
+    if(!host->workers_running) return;
+
+    host->workers_running = 0;
+    for(w=0; w < host->num_workers; w++) sem_post(&host->work_ready);
+    for(w=0; w < host->num_workers; w++) pthread_join(host->workers[w], NULL);
+    sem_destroy(&host->work_ready);
+    sem_destroy(&host->work_done);
+}
+
+int astrid_host_buffer_size_callback(jack_nframes_t nframes, void * arg) {
+    lphost_t * host = (lphost_t *)arg;
+    if((size_t)nframes <= host->blocksize) return 0;
+    return astrid_host_alloc_blocks(host, (size_t)nframes);
+}
+
+int astrid_host_jack_callback(jack_nframes_t nframes, void * arg) {
+    lphost_t * host = (lphost_t *)arg;
+    lphost_slot_t * slot;
+    float * output_channels[host->channels];
+    int level, job, start, end, w, c;
+
+    /* JACK plays whatever is left in the ports, so they 
+     * are cleared even when there is nothing to render */
+    for(c=0; c < host->channels; c++) {
+        host->capture[c] = (float *)jack_port_get_buffer(host->inports[c], nframes);
+        output_channels[c] = (float *)jack_port_get_buffer(host->outports[c], nframes);
+        memset(output_channels[c], 0, nframes * sizeof(float));
+    }
+
+    if(!host->is_running || (size_t)nframes > host->blocksize) return 0;
+
+    for(level=0; level < host->num_levels; level++) {
+        start = host->level_offsets[level];
+        end = host->level_offsets[level+1];
+
+        if(host->num_workers > 0 && end - start > 1) {
+            host->job_nframes = (size_t)nframes;
+            host->job_end = end;
+            atomic_store(&host->next_job, start);
+
+            for(w=0; w < host->num_workers; w++) sem_post(&host->work_ready);
+
+            /* The JACK thread takes jobs too, then waits for the stragglers */
+            astrid_host_run_jobs(host);
+
+            for(w=0; w < host->num_workers; w++) {
+                while(sem_wait(&host->work_done) < 0 && errno == EINTR);
+            }
+        } else {
+            for(job=start; job < end; job++) {
+                astrid_host_process_slot(host, host->order[job], (size_t)nframes);
+            }
+        }
+    }
+
+    /* Sum into the bus in slot order, so the mix 
+     * doesn't depend on which worker ran which instrument */
+    for(job=0; job < host->num_slots; job++) {
+        slot = &host->slots[job];
+        if(slot->is_routed) continue;
+        for(c=0; c < slot->instrument->channels; c++) {
+            lpmix_accumulate(output_channels[c % host->channels], slot->outputs[c], (size_t)nframes);
+        }
+    }
+
+    /* clamp output */
+    for(c=0; c < host->channels; c++) {
+        lpmix_clamp(output_channels[c], (size_t)nframes);
+    }
+
+    return 0;
+}
+
+int astrid_host_start(lphost_t * host) {
+    jack_status_t jack_status;
+    jack_options_t jack_options = JackNullOption;
+    const char ** ports;
+    char outport_name[50];
+    char inport_name[50];
+    int c, i, w;
+
+    if(astrid_host_sort(host) < 0) return -1;
+
+    syslog(LOG_INFO, "%s hosting %d instruments in %d levels with %d workers\n", host->name, host->num_slots, host->num_levels, host->num_workers);
+
+    /* Set up JACK */
+    host->capture = (float **)calloc(host->channels, sizeof(float *));
+    host->inports = (jack_port_t **)calloc(host->channels, sizeof(jack_port_t *));
+    host->outports = (jack_port_t **)calloc(host->channels, sizeof(jack_port_t *));
+    if((host->jack_client = jack_client_open(host->name, jack_options, &jack_status, NULL)) == NULL) {
+        syslog(LOG_ERR, "%s Could not open jack client. Status: %2.0x\n", host->name, jack_status);
+        return -1;
+    }
+
+    host->samplerate = (lpfloat_t)jack_get_sample_rate(host->jack_client);
+    if(astrid_host_alloc_blocks(host, (size_t)jack_get_buffer_size(host->jack_client)) < 0) {
+        goto astrid_host_shutdown_with_error;
+    }
+
+    jack_set_process_callback(host->jack_client, astrid_host_jack_callback, (void *)host);
+    jack_set_buffer_size_callback(host->jack_client, astrid_host_buffer_size_callback, (void *)host);
+
+    for(c=0; c < host->channels; c++) {
+        snprintf(outport_name, sizeof(outport_name), "out%d", c);
+        host->outports[c] = jack_port_register(host->jack_client, outport_name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+
+        snprintf(inport_name, sizeof(inport_name), "in%d", c);
+        host->inports[c] = jack_port_register(host->jack_client, inport_name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+
+        if(host->outports[c] == NULL || host->inports[c] == NULL) {
+            syslog(LOG_ERR, "No more JACK ports available, shutting down...\n");
+            goto astrid_host_shutdown_with_error;
+        }
+    }
+
+    /* Start the worker pool before the first period */
+    if(sem_init(&host->work_ready, 0, 0) < 0 || sem_init(&host->work_done, 0, 0) < 0) {
+        syslog(LOG_ERR, "%s Could not init worker semaphores. Error: %s\n", host->name, strerror(errno));
+        goto astrid_host_shutdown_with_error;
+    }
+
+    host->workers_running = 1;
+    for(w=0; w < host->num_workers; w++) {
+        if(pthread_create(&host->workers[w], NULL, astrid_host_worker_thread, (void*)host) != 0) {
+            syslog(LOG_ERR, "%s Could not start worker thread. Error: %s\n", host->name, strerror(errno));
+            host->num_workers = w;
+            break;
+        }
+    }
+
+    for(i=0; i < host->num_slots; i++) {
+        host->slots[i].instrument->samplerate = host->samplerate;
+        host->slots[i].instrument->is_running = 1;
+    }
+
+    host->is_running = 1;
+
+    if(jack_activate(host->jack_client) != 0) {
+        syslog(LOG_ERR, "%s Could not activate JACK client, shutting down...\n", host->name);
+        goto astrid_host_shutdown_with_error;
+    }
+
+    /* connect ports */
+    if((ports = jack_get_ports(host->jack_client, NULL, NULL, JackPortIsPhysical|JackPortIsOutput)) != NULL) {
+        for(c=0; c < host->channels && ports[c] != NULL; c++) {
+            if(jack_connect(host->jack_client, ports[c], jack_port_name(host->inports[c]))) {
+                syslog(LOG_ERR, "%s cannot connect input ports\n", host->name);
+            }
+        }
+        free(ports);
+    }
+
+    if((ports = jack_get_ports(host->jack_client, NULL, NULL, JackPortIsPhysical|JackPortIsInput)) != NULL) {
+        for(c=0; c < host->channels && ports[c] != NULL; c++) {
+            if(jack_connect(host->jack_client, jack_port_name(host->outports[c]), ports[c])) {
+                syslog(LOG_ERR, "%s cannot connect output ports\n", host->name);
+            }
+        }
+        free(ports);
+    }
+
+    for(i=0; i < host->num_slots; i++) {
+        if(astrid_instrument_start_message_threads(host->slots[i].instrument) < 0) {
+            syslog(LOG_ERR, "%s Could not start message threads for %s\n", host->name, host->slots[i].instrument->name);
+            goto astrid_host_shutdown_with_error;
+        }
+    }
+
+    /* setup linenoise repl */
+    linenoiseHistoryLoad("history.txt");
+
+    syslog(LOG_INFO, "%s is running...\n", host->name);
+
+    return 0;
+
+astrid_host_shutdown_with_error:
+    host->is_running = 0;
+    jack_deactivate(host->jack_client);
+    astrid_host_stop_workers(host);
+    jack_client_close(host->jack_client);
+    host->jack_client = NULL;
+    return -1;
+}
+
+/* Console commands are prefixed with the name of 
+ * the instrument they are for: `<instrument> p foo=bar` */
+int astrid_host_tick(lphost_t * host) {
+    char * line;
+    char * cmdline;
+    size_t namelength;
+
+    if(host->is_running == 0) return 0;
+
+    line = linenoise("^_- ");
+    if(line == NULL) return 0;
+
+    if((cmdline = strchr(line, ' ')) == NULL || (namelength = cmdline - line) >= LPMAXNAME) {
+        syslog(LOG_ERR, "Could not parse instrument name from cmdline %s\n", line);
+        free(line);
+        return -1;
+    }
+
+    memset(host->cmd.instrument_name, 0, LPMAXNAME);
+    memcpy(host->cmd.instrument_name, line, namelength);
+
+    if(parse_message_from_cmdline(cmdline + 1, &host->cmd) < 0) {
+        syslog(LOG_ERR, "Could not parse message from cmdline %s\n", line);
+        free(line);
+        return -1;
+    }
+
+    if(host->cmd.type == LPMSG_SERIAL) {
+        if(send_serial_message(host->cmd) < 0) {
+            syslog(LOG_ERR, "Could not send serial message...\n");
+        }
+    } else if(send_play_message(host->cmd) < 0) {
+        syslog(LOG_ERR, "Could not send play message...\n");
+    }
+
+    free(line);
+    return 0;
+}
+
+int astrid_host_stop(lphost_t * host) {
+    lphost_slot_t * slot;
+    int i, c;
+
+    syslog(LOG_INFO, "%s host shutting down and cleaning up...\n", host->name);
+    host->is_running = 0;
+
+    if(host->jack_client != NULL) {
+        jack_deactivate(host->jack_client);
+        for(c=0; c < host->channels; c++) {
+            jack_port_unregister(host->jack_client, host->outports[c]);
+            jack_port_unregister(host->jack_client, host->inports[c]);
+        }
+        jack_client_close(host->jack_client);
+    }
+
+    /* The JACK thread is gone, so nobody is waiting on the workers */
+    astrid_host_stop_workers(host);
+
+    for(i=0; i < host->num_slots; i++) {
+        slot = &host->slots[i];
+        astrid_instrument_stop(slot->instrument);
+
+        free(slot->inputs);
+        free(slot->outputs);
+        free(slot->input_block);
+        free(slot->output_block);
+        LPMemoryPool.free(slot->instrument);
+    }
+
+    free(host->capture);
+    free(host->inports);
+    free(host->outports);
+
+    syslog(LOG_DEBUG, "All done, see ya later!\n");
+    closelog();
+    LPMemoryPool.free(host);
+    return 0;
+}
+
+int astrid_instrument_get_or_create_datadir(const char * name, char * dbpath) {
+    int ret;
+    char astrid_data_path[PATH_MAX];
+    char xdg_data_home[PATH_MAX];
+    char * user_home;
+    char * _xdg_data_home = getenv("XDG_DATA_HOME");
+    char * default_data_dir = ".local/share";
+    char * instrument_subdir = "astrid_instruments";
+
+    if(_xdg_data_home == NULL) {
+        user_home = getenv("HOME");
+        ret = snprintf(xdg_data_home, PATH_MAX, "%s/%s", user_home, default_data_dir);
+        if(ret < 0) {
+            syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", default_data_dir, errno, strerror(errno));
+            return -1;
+        }
+
+    } else {
+        memcpy(xdg_data_home, _xdg_data_home, PATH_MAX);
+    }
+
+    if(access(xdg_data_home, F_OK) != 0) {
+        /* create the xdg data home dir */
+        if(mkdir(xdg_data_home, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
+            syslog(LOG_ERR, "session data path (%s) mkdir: (%d) %s\n", xdg_data_home, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    ret = snprintf(astrid_data_path, PATH_MAX, "%s/%s", xdg_data_home, instrument_subdir);
+    if(ret < 0) {
+        syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", astrid_data_path, errno, strerror(errno));
+        return -1;
+    }
+
+    if(access(astrid_data_path, F_OK) != 0) {
+        /* create the astrid data path */
+        if(mkdir(astrid_data_path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
+            syslog(LOG_ERR, "astrid data path (%s) mkdir: (%d) %s\n", astrid_data_path, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    ret = snprintf(dbpath, PATH_MAX, "%s/%s", astrid_data_path, name);
+    if(ret < 0) {
+        syslog(LOG_ERR, "astrid data path (%s) snprintf: (%d) %s\n", astrid_data_path, errno, strerror(errno));
+        return -1;
+    }
+
+    if(access(dbpath, F_OK) != 0) {
+        /* create the data dir */
+        if(mkdir(dbpath, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
+            syslog(LOG_ERR, "session data path (%s) mkdir: (%d) %s\n", dbpath, errno, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int astrid_instrument_session_open(lpinstrument_t * instrument) {
+    int rc;
 
     if(astrid_instrument_get_or_create_datadir(instrument->name, instrument->datapath) < 0) {
         syslog(LOG_ERR, "session data path (%s) mkdir: (%d) %s\n", instrument->datapath, errno, strerror(errno));
@@ -3097,10 +4475,31 @@ int astrid_instrument_session_open(lpinstrument_t * instrument) {
 	mdb_txn_reset(instrument->dbtxn_read);
 	mdb_txn_commit(instrument->dbtxn_write);
 
+#ifdef LPSESSIONDB
+    /* Voice events are written in batches from the writer thread. 
+     * A session without a db still plays, it just isn't logged. */
+    if((instrument->sessiondb = lpsessiondb_writer_start()) == NULL) {
+        syslog(LOG_WARNING, "%s: could not start the session db writer, voices will not be logged\n", instrument->name);
+    } else if(instrument->async_mixer != NULL) {
+        instrument->async_mixer->sessiondb = instrument->sessiondb;
+    }
+#endif
+
 	return 0;
 }
 
+/* Audio must already be stopped: the scheduler logs voices 
+ * that finish playing from the audio thread. */
 int astrid_instrument_session_close(lpinstrument_t * instrument) {
+#ifdef LPSESSIONDB
+    if(instrument->sessiondb != NULL) {
+        syslog(LOG_DEBUG, "Flushing session db writer...\n");
+        if(instrument->async_mixer != NULL) instrument->async_mixer->sessiondb = NULL;
+        lpsessiondb_writer_stop(instrument->sessiondb);
+        instrument->sessiondb = NULL;
+    }
+#endif
+
     syslog(LOG_DEBUG, "Closing LMDB session...\n");
 	mdb_dbi_close(instrument->dbenv, instrument->dbi);
 	mdb_env_close(instrument->dbenv);
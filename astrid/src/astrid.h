@@ -2,6 +2,7 @@
 #define LPASTRID_H
 
 #include <stdatomic.h>
+#include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <mqueue.h>
@@ -41,11 +42,38 @@
 
 #define ASTRID_MQ_MAXMSG 10
 
+/* Frames per vector in the planar mixing kernels */
+#define LPMIX_VECSIZE 8
+typedef float lpmixvec_t __attribute__((vector_size(LPMIX_VECSIZE * sizeof(float))));
+typedef int32_t lpmixmask_t __attribute__((vector_size(LPMIX_VECSIZE * sizeof(int32_t))));
+
+#define ASTRID_HOST_MAXINSTRUMENTS 64
+#define ASTRID_HOST_MAXWORKERS 16
+
+/* Symbols exported by C instruments built 
+ * as shared modules for astrid-host */
+#define ASTRID_MODULE_CHANNELS_SYMBOL "astrid_module_channels"
+#define ASTRID_MODULE_CREATE_SYMBOL "astrid_module_create"
+#define ASTRID_MODULE_DESTROY_SYMBOL "astrid_module_destroy"
+#define ASTRID_MODULE_STREAM_SYMBOL "astrid_module_stream"
+#define ASTRID_MODULE_RENDERER_SYMBOL "astrid_module_renderer"
+#define ASTRID_MODULE_UPDATES_SYMBOL "astrid_module_updates"
+#define ASTRID_MODULE_MIGRATE_SYMBOL "astrid_module_migrate"
+
+/* Hot reloads crossfade from the old module to the new one */
+#define ASTRID_RELOAD_XFADE_SECONDS 0.05
+#define ASTRID_RELOAD_MAXBLOCKSIZE 8192
+#define ASTRID_RELOAD_TIMEOUT_SECONDS 2
+
 /* queue paths */
 #define LPPLAYQ "/astridq"
 #define ASTRID_MSGQ_PATH "/astrid-msgq"
 #define LPMAXQNAME (12 + 1 + LPMAXNAME)
 
+/* Every astrid process maps the same generated wavetables 
+ * and windows from shared memory named with this prefix */
+#define ASTRID_TABLECACHE_PREFIX "astrid-tables"
+
 #define ASTRID_SESSIONDB_PATH "/tmp/astrid_session.db"
 #define ASTRID_MIDI_TRIGGERQ_PATH "/tmp/astrid-miditriggerq"
 #define ASTRID_MIDI_CCBASE_PATH "/tmp/astrid-mididevice%d-cc%d"
@@ -53,7 +81,22 @@
 #define ASTRID_MIDIMAP_NOTEBASE_PATH "/tmp/astrid-midimap-device%d-note%d"
 #define ASTRID_IPC_IDBASE_PATH "/tmp/astrid-idfile-%s"
 
-#define ASTRID_SERIAL_CTLBASE_PATH "/tmp/astrid-serialdevice%d-ctl%d"
+#define ASTRID_SERIAL_CTLTABLE_PATH "/tmp/astrid-serial-ctltable"
+#define ASTRID_SERIAL_MAXDEVICES 16
+#define ASTRID_SERIAL_MAXCTLS 256
+#define ASTRID_SERIAL_MAXTTYS 16
+#define ASTRID_SERIAL_READBUFSIZE 4096
+
+/* Binary serial frames:
+ *     sync (0xA5) | length | type | payload[length] | crc16 lo | crc16 hi
+ * The CRC is CRC-16/CCITT-FALSE over length, type and payload.
+ * CTL payloads are repeated (ctl u8, value u16 little endian) pairs,
+ * MSG payloads are a text play message without the trailing newline.
+ * Anything else on the wire is read as newline-terminated text messages. */
+#define ASTRID_SERIAL_SYNC 0xA5
+#define ASTRID_SERIAL_FRAME_CTL 0x01
+#define ASTRID_SERIAL_FRAME_MSG 0x02
+#define ASTRID_SERIAL_FRAME_OVERHEAD 5
 
 #define LPKEY_MAXLENGTH 4096
 
@@ -134,6 +177,8 @@ typedef struct lpevent_t {
     lpmsg_t msg;
     size_t callback_onset;
     int callback_fired;
+    lproute_t route;
+    size_t voice_id; // 0 for buffers that aren't voices
 } lpevent_t;
 
 typedef struct lpscheduler_t {
@@ -151,6 +196,9 @@ typedef struct lpscheduler_t {
     lpevent_t * waiting_queue_head;
     lpevent_t * playing_stack_head;
     lpevent_t * nursery_head;
+
+    // Voices are marked stopped here when they finish playing, if set
+    struct lpsessiondb_writer_t * sessiondb;
 } lpscheduler_t;
 
 typedef struct lpinstrument_t {
@@ -168,6 +216,9 @@ typedef struct lpinstrument_t {
     MDB_txn * dbtxn_read;
     MDB_txn * dbtxn_write;
 
+    // Session db voice log, only written when built with LPSESSIONDB
+    struct lpsessiondb_writer_t * sessiondb;
+
     // the XDG config dir where LMDB sessions live
     char datapath[PATH_MAX]; 
 
@@ -208,11 +259,120 @@ typedef struct lpinstrument_t {
 
     // Shutdown signal handler (SIGTERM & SIGKILL)
     void (*shutdown)(int sig);
+
+    // The module the message thread runs renderer and updates 
+    // from. Instruments started as programs get a wrapper module 
+    // around their callbacks, so this is never NULL.
+    struct lpmodule_t * module;
+
+    // The module the audio thread streams from. Only the audio 
+    // thread touches this once audio is running.
+    struct lpmodule_t * playing_module;
+
+    // Hot reload handoff: the message thread publishes the 
+    // next module, the audio thread takes it at a block boundary 
+    // and hands the old one back after its last stream call, 
+    // once the crossfade is done
+    _Atomic(struct lpmodule_t *) pending_module;
+    _Atomic(struct lpmodule_t *) retired_module;
+    struct lpmodule_t * fading_module;
+    size_t xfade_pos;
+    size_t xfade_length;
+    float * xfade_old;
+    float * xfade_new;
 } lpinstrument_t;
 
+/* A C instrument built as a shared module. 
+ *
+ * Modules export the astrid_module_* symbols. When a module is 
+ * hot reloaded, the optional astrid_module_migrate hook builds 
+ * the new context from the old one. The old version keeps 
+ * playing from its context during the crossfade, so migrate 
+ * must only read it; the old module's destroy frees it after. 
+ *
+ * Both versions run during the crossfade, so callbacks should 
+ * find their state with astrid_instrument_get_context rather 
+ * than reading instrument->context directly. */
+typedef struct lpmodule_t {
+    void * handle;
+    char path[PATH_MAX];
+    void * context;
+
+    void * (*create)(lpinstrument_t * instrument);
+    void (*destroy)(void * ctx);
+    void * (*migrate)(lpinstrument_t * instrument, void * old_ctx);
+    void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument);
+    lpbuffer_t * (*renderer)(void * instrument);
+    void (*updates)(void * instrument);
+} lpmodule_t;
+
+/* An instrument running inside astrid-host. 
+ * The host owns the JACK client, so slots only 
+ * carry the planar blocks passed to the stream 
+ * callback and the routing between instruments. */
+typedef struct lphost_slot_t {
+    lpinstrument_t * instrument;
+
+    float ** inputs;
+    float ** outputs;
+    float * input_block;
+    float * output_block;
+
+    // Instruments whose output feeds this instrument's input
+    int sources[ASTRID_HOST_MAXINSTRUMENTS];
+    int num_sources;
+
+    // 1 if this instrument's output is routed into 
+    // another instrument instead of the main bus
+    int is_routed;
+} lphost_slot_t;
+
+typedef struct lphost_t {
+    const char * name;
+    int channels;
+    volatile int is_running;
+    lpfloat_t samplerate;
+    size_t blocksize;
+
+    lphost_slot_t slots[ASTRID_HOST_MAXINSTRUMENTS];
+    int num_slots;
+
+    // Slot indexes in dependency order, grouped into 
+    // levels of instruments that may run in parallel
+    int order[ASTRID_HOST_MAXINSTRUMENTS];
+    int level_offsets[ASTRID_HOST_MAXINSTRUMENTS+1];
+    int num_levels;
+
+    // Worker pool for spreading a level across threads
+    int num_workers;
+    volatile int workers_running;
+    pthread_t workers[ASTRID_HOST_MAXWORKERS];
+    sem_t work_ready;
+    sem_t work_done;
+    atomic_int next_job;
+    int job_end;
+    size_t job_nframes;
+
+    // Jack refs
+    float ** capture;
+    jack_port_t ** inports;
+    jack_port_t ** outports;
+    jack_client_t * jack_client;
+
+    lpmsg_t cmd;
+} lphost_t;
+
 
 void scheduler_schedule_event(lpscheduler_t * s, lpbuffer_t * buf, size_t delay);
+void scheduler_schedule_routed_event(lpscheduler_t * s, lpbuffer_t * buf, size_t delay, lproute_t * route);
+void scheduler_schedule_voice_event(lpscheduler_t * s, lpbuffer_t * buf, size_t delay, lproute_t * route, size_t voice_id);
 void lpscheduler_tick(lpscheduler_t * s);
+void lpscheduler_tick_block(lpscheduler_t * s, float ** output, int channels, size_t nframes);
+
+void lpmix_gain_accumulate(float * restrict out, const lpfloat_t * restrict src, size_t stride, float gain, size_t nframes);
+void lpmix_accumulate(float * restrict out, const float * restrict in, size_t nframes);
+void lpmix_clamp(float * restrict out, size_t nframes);
+int lproute_parse(char * params, lproute_t * route);
 lpscheduler_t * scheduler_create(int, int, lpfloat_t);
 void scheduler_destroy(lpscheduler_t * s);
 int lpscheduler_get_now_seconds(double * now);
@@ -264,6 +424,7 @@ int parse_message_from_args(int argc, int arg_offset, char * argv[], lpmsg_t * m
 int parse_message_from_cmdline(char * cmdline, lpmsg_t * msg);
 
 ssize_t astrid_get_voice_id();
+int astrid_get_channels(int default_channels);
 
 int send_message(char * qname, lpmsg_t msg);
 int send_serial_message(lpmsg_t msg);
@@ -294,6 +455,14 @@ int lpmidi_remove_msg_from_notemap(int device_id, int note, int index);
 int lpmidi_print_notemap(int device_id, int note);
 int lpmidi_trigger_notemap(int device_id, int note);
 
+/* Serial ctl values live in one shared table, written 
+ * lock-free by the serial listener and read by renderers */
+typedef struct lpserialctl_table_t {
+    atomic_size_t values[ASTRID_SERIAL_MAXDEVICES][ASTRID_SERIAL_MAXCTLS];
+} lpserialctl_table_t;
+
+lpserialctl_table_t * lpserial_ctltable_open();
+uint16_t lpserial_crc16(const unsigned char * data, size_t length);
 int lpserial_setctl(int device_id, int param_id, size_t value);
 int lpserial_getctl(int device_id, int ctl, lpfloat_t * value);
 
@@ -326,6 +495,22 @@ void lptimeit_since(struct timespec * start);
 
 lpinstrument_t * astrid_instrument_start(const char * name, int channels, void * ctx, void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument), lpbuffer_t * (*renderer)(void * instrument), void (*updates)(void * instrument));
 int astrid_instrument_stop(lpinstrument_t * instrument);
+lpinstrument_t * astrid_instrument_create(const char * name, int channels, void * ctx, void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument), lpbuffer_t * (*renderer)(void * instrument), void (*updates)(void * instrument));
+int astrid_instrument_start_message_threads(lpinstrument_t * instrument);
+void astrid_instrument_process_block(lpinstrument_t * instrument, size_t blocksize, float ** input, float ** output);
+lpmodule_t * astrid_module_open(const char * path);
+lpmodule_t * astrid_module_wrap(void * ctx, void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument), lpbuffer_t * (*renderer)(void * instrument), void (*updates)(void * instrument));
+void astrid_module_close(lpmodule_t * module);
+int astrid_instrument_reload(lpinstrument_t * instrument, const char * path);
+void * astrid_instrument_get_context(lpinstrument_t * instrument);
+
+lphost_t * astrid_host_create(const char * name, int channels, int num_workers);
+int astrid_host_add_instrument(lphost_t * host, const char * name, int channels, void * ctx, void (*stream)(int channels, size_t blocksize, float ** input, float ** output, void * instrument), lpbuffer_t * (*renderer)(void * instrument), void (*updates)(void * instrument));
+int astrid_host_load_instrument(lphost_t * host, const char * name, const char * module_path);
+int astrid_host_route(lphost_t * host, const char * src_name, const char * dst_name);
+int astrid_host_start(lphost_t * host);
+int astrid_host_tick(lphost_t * host);
+int astrid_host_stop(lphost_t * host);
 
 void astrid_instrument_set_param_float(lpinstrument_t * instrument, int param_index, lpfloat_t value);
 lpfloat_t astrid_instrument_get_param_float(lpinstrument_t * instrument, int param_index, lpfloat_t default_value);
@@ -344,14 +529,67 @@ size_t lpdecode_with_prefix(char * encoded);
 
 #ifdef LPSESSIONDB
 #include <sqlite3.h>
+
+/* Must be a power of two */
+#define LPSESSIONDB_QUEUE_SIZE 1024
+#define LPSESSIONDB_BATCH_SIZE 256
+#define LPSESSIONDB_BUSY_TIMEOUT 1000
+
+enum LPSessionDBEvents {
+    LPSESSIONDB_INSERT_VOICE,
+    LPSESSIONDB_MARK_ACTIVE,
+    LPSESSIONDB_RENDER_COUNT,
+    LPSESSIONDB_MARK_STOPPED
+};
+
+typedef struct lpsessiondb_event_t {
+    int type;
+    long long timestamp;
+    double initiated;
+    size_t voice_id;
+    size_t count;
+    char instrument_name[LPMAXNAME];
+    char params[LPMAXMSG];
+} lpsessiondb_event_t;
+
+typedef struct lpsessiondb_slot_t {
+    atomic_size_t sequence;
+    lpsessiondb_event_t event;
+} lpsessiondb_slot_t;
+
+typedef struct lpsessiondb_writer_t {
+    sqlite3 * db;
+    sqlite3_stmt * begin;
+    sqlite3_stmt * commit;
+    sqlite3_stmt * insert_voice;
+    sqlite3_stmt * mark_active;
+    sqlite3_stmt * render_count;
+    sqlite3_stmt * mark_stopped;
+
+    // Bounded MPSC queue of voice events
+    lpsessiondb_slot_t * slots;
+    atomic_size_t head;
+    size_t tail;
+    atomic_size_t dropped;
+    sem_t pending;
+
+    // Scratch event owned by the writer thread
+    lpsessiondb_event_t event;
+
+    volatile int is_running;
+    pthread_t thread;
+} lpsessiondb_writer_t;
+
 int lpsessiondb_create(sqlite3 ** db);
 int lpsessiondb_open_for_writing(sqlite3 ** db);
 int lpsessiondb_open_for_reading(sqlite3 ** db);
 int lpsessiondb_close(sqlite3 * db);
-int lpsessiondb_insert_voice(lpmsg_t msg);
-int lpsessiondb_mark_voice_active(sqlite3 * db, int voice_id);
-int lpsessiondb_increment_voice_render_count(sqlite3 * db, int voice_id, size_t count);
-int lpsessiondb_mark_voice_stopped(sqlite3 * db, int voice_id, size_t count);
+lpsessiondb_writer_t * lpsessiondb_writer_start(void);
+int lpsessiondb_writer_stop(lpsessiondb_writer_t * w);
+int lpsessiondb_insert_voice(lpsessiondb_writer_t * w, lpmsg_t * msg);
+int lpsessiondb_mark_voice_active(lpsessiondb_writer_t * w, size_t voice_id);
+int lpsessiondb_increment_voice_render_count(lpsessiondb_writer_t * w, size_t voice_id, size_t count);
+int lpsessiondb_mark_voice_stopped(lpsessiondb_writer_t * w, size_t voice_id, size_t count);
 #endif
 
 
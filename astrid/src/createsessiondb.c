@@ -1,6 +1,12 @@
 #include "astrid.h"
 
 int main() {
-    lpsessiondb_create();
-    return 0;
+    sqlite3 * db;
+
+    if(lpsessiondb_create(&db) < 0) {
+        fprintf(stderr, "Could not create session db\n");
+        return 1;
+    }
+
+    return lpsessiondb_close(db);
 }
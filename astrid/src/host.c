@@ -0,0 +1,102 @@
+#include "astrid.h"
+
+#define NAME "astrid-host"
+
+/* Run many instruments in one process with a single JACK client.
+ *
+ * Usage:
+ *     astrid-host [-c channels] [-w workers] [-r src:dst ...] name[=module.so] ...
+ *
+ * Instruments given as name=path are C instruments built as 
+ * shared modules, and bare names are proxies for python instruments. 
+ * -r routes the output of src into the input of dst. */
+
+static void usage(void) {
+    fprintf(stderr, "Usage: %s [-c channels] [-w workers] [-r src:dst ...] name[=module.so] ...\n", NAME);
+}
+
+int main(int argc, char * argv[]) {
+    lphost_t * host;
+    char * routes[ASTRID_HOST_MAXINSTRUMENTS];
+    char * module_path;
+    char * dst;
+    int num_routes = 0;
+    int channels = astrid_get_channels(ASTRID_CHANNELS);
+    int workers = 0;
+    int opt, i;
+
+    while((opt = getopt(argc, argv, "c:w:r:")) != -1) {
+        switch(opt) {
+            case 'c':
+                channels = atoi(optarg);
+                break;
+            case 'w':
+                workers = atoi(optarg);
+                break;
+            case 'r':
+                if(num_routes >= ASTRID_HOST_MAXINSTRUMENTS) {
+                    fprintf(stderr, "Too many routes\n");
+                    exit(EXIT_FAILURE);
+                }
+                routes[num_routes++] = optarg;
+                break;
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if(optind >= argc || channels <= 0) {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if((host = astrid_host_create(NAME, channels, workers)) == NULL) {
+        fprintf(stderr, "Could not create host: (%d) %s\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for(i=optind; i < argc; i++) {
+        if((module_path = strchr(argv[i], '=')) != NULL) {
+            *module_path = '\0';
+            module_path += 1;
+        }
+
+        if(astrid_host_load_instrument(host, argv[i], module_path) < 0) {
+            fprintf(stderr, "Could not load instrument %s\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for(i=0; i < num_routes; i++) {
+        if((dst = strchr(routes[i], ':')) == NULL) {
+            usage();
+            exit(EXIT_FAILURE);
+        }
+
+        *dst = '\0';
+        if(astrid_host_route(host, routes[i], dst + 1) < 0) {
+            fprintf(stderr, "Could not route %s to %s\n", routes[i], dst + 1);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(astrid_host_start(host) < 0) {
+        fprintf(stderr, "Could not start host: (%d) %s\n", errno, strerror(errno));
+        astrid_host_stop(host);
+        exit(EXIT_FAILURE);
+    }
+
+    /* twiddle thumbs until shutdown */
+    while(host->is_running) {
+        astrid_host_tick(host);
+    }
+
+    if(astrid_host_stop(host) < 0) {
+        fprintf(stderr, "There was a problem stopping the host. (%d) %s\n", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Done!\n");
+    return 0;
+}
@@ -1,7 +1,20 @@
+#include <sys/epoll.h>
 #include "astrid.h"
 
-#define MSGBUFFER_SIZE 100
+/* Maps 16 bit frame values onto the full size_t range 
+ * lpserial_getctl normalizes against: 0xFFFF -> SIZE_MAX */
+#define CTL_VALUE_SCALE (SIZE_MAX / 0xFFFF)
 
+typedef struct lptty_t {
+    int fd;
+    int device_id;
+    char * path;
+    unsigned char buf[ASTRID_SERIAL_READBUFSIZE];
+    size_t length;
+    size_t frames;
+    size_t crc_errors;
+    size_t overflows;
+} lptty_t;
 
 static volatile int serial_listener_is_running = 1;
 
@@ -9,25 +22,204 @@ void handle_shutdown(__attribute__((unused)) int sig) {
     serial_listener_is_running = 0;
 }
 
+static speed_t baud_to_speed(int baud) {
+    switch(baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 500000: return B500000;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default: return B0;
+    }
+}
 
-int main(int argc, char * argv[]) {
-    int tty;
-    ssize_t bytesread;
-    char * tty_path, * token, * tokencache;
+static int tty_open(lptty_t * tty, speed_t speed) {
     struct termios options;
+
+    if((tty->fd = open(tty->path, O_RDONLY | O_NOCTTY | O_NONBLOCK)) < 0) {
+        syslog(LOG_ERR, "Problem connecting to TTY %s. Error: %s\n", tty->path, strerror(errno));
+        return -1;
+    }
+
+    /* Raw mode: frames are binary and text lines are split here, not by the line discipline */
+    if(tcgetattr(tty->fd, &options) < 0) {
+        syslog(LOG_ERR, "Could not get attributes for TTY %s. Error: %s\n", tty->path, strerror(errno));
+        close(tty->fd);
+        return -1;
+    }
+
+    cfmakeraw(&options);
+    cfsetispeed(&options, speed);
+    options.c_cflag |= (CLOCAL | CREAD);
+
+    if(tcsetattr(tty->fd, TCSANOW, &options) < 0) {
+        syslog(LOG_ERR, "Could not set attributes for TTY %s. Error: %s\n", tty->path, strerror(errno));
+        close(tty->fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void handle_text(lptty_t * tty, char * line) {
     lpmsg_t msg = {0};
-    char msgstr[MSGBUFFER_SIZE];
-    char * fakeargv[LPMAXMSG+1];
 
+    if(line[0] == '\0') return;
+
+    if(parse_message_from_cmdline(line, &msg) < 0) {
+        syslog(LOG_ERR, "astrid-seriallistener: Could not parse message from %s\n", tty->path);
+        return;
+    }
+
+    if(send_play_message(msg) < 0) {
+        syslog(LOG_ERR, "astrid-seriallistener: Could not send play message from %s\n", tty->path);
+    }
+}
+
+static void handle_frame(lptty_t * tty, unsigned char type, unsigned char * payload, size_t length) {
+    char line[UINT8_MAX+1];
+    size_t i;
+
+    switch(type) {
+        case ASTRID_SERIAL_FRAME_CTL:
+            for(i=0; i+3 <= length; i += 3) {
+                lpserial_setctl(tty->device_id, payload[i], (size_t)(payload[i+1] | (payload[i+2] << 8)) * CTL_VALUE_SCALE);
+            }
+            break;
+
+        case ASTRID_SERIAL_FRAME_MSG:
+            memcpy(line, payload, length);
+            line[length] = '\0';
+            handle_text(tty, line);
+            break;
+
+        default:
+            syslog(LOG_WARNING, "astrid-seriallistener: Unknown frame type %d from %s\n", type, tty->path);
+            break;
+    }
+}
+
+/* Consumes every complete frame or text line in the buffer 
+ * and leaves any partial one at the front for the next read */
+static void tty_parse(lptty_t * tty) {
+    unsigned char * b = tty->buf;
+    unsigned char * end;
+    size_t pos = 0, framesize, linesize;
+    uint16_t crc;
+
+    while(pos < tty->length) {
+        if(b[pos] == ASTRID_SERIAL_SYNC) {
+            if(tty->length - pos < 2) break;
+
+            framesize = b[pos+1] + ASTRID_SERIAL_FRAME_OVERHEAD;
+            if(tty->length - pos < framesize) break;
+
+            crc = b[pos+framesize-2] | (b[pos+framesize-1] << 8);
+            if(crc != lpserial_crc16(&b[pos+1], framesize-3)) {
+                /* Not a real frame, resync on the next byte */
+                tty->crc_errors += 1;
+                pos += 1;
+                continue;
+            }
+
+            handle_frame(tty, b[pos+2], &b[pos+3], b[pos+1]);
+            tty->frames += 1;
+            pos += framesize;
+            continue;
+        }
+
+        if(b[pos] == '\n' || b[pos] == '\r' || b[pos] == '\0') {
+            pos += 1;
+            continue;
+        }
+
+        /* Text line: runs to a newline, or to a sync byte which can't appear in text */
+        end = &b[pos];
+        while(end < &b[tty->length] && *end != '\n' && *end != '\r' && *end != ASTRID_SERIAL_SYNC) end++;
+
+        if(end == &b[tty->length]) break;
+
+        linesize = end - &b[pos];
+        if(*end == ASTRID_SERIAL_SYNC) {
+            syslog(LOG_WARNING, "astrid-seriallistener: Dropping %ld bytes of unterminated text from %s\n", linesize, tty->path);
+        } else {
+            *end = '\0';
+            handle_text(tty, (char *)&b[pos]);
+        }
+        pos += linesize;
+    }
+
+    if(pos == 0 && tty->length == ASTRID_SERIAL_READBUFSIZE) {
+        /* Nothing parseable in a full buffer: drop it all */
+        tty->overflows += 1;
+        pos = tty->length;
+    }
+
+    memmove(b, &b[pos], tty->length - pos);
+    tty->length -= pos;
+}
+
+static int tty_read(lptty_t * tty) {
+    ssize_t bytesread;
+
+    while(1) {
+        bytesread = read(tty->fd, &tty->buf[tty->length], ASTRID_SERIAL_READBUFSIZE - tty->length);
+        if(bytesread < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            if(errno == EINTR) continue;
+            syslog(LOG_ERR, "astrid-seriallistener: Could not read from %s. Error: %s\n", tty->path, strerror(errno));
+            return -1;
+        }
+
+        if(bytesread == 0) return -1;
+
+        tty->length += bytesread;
+        tty_parse(tty);
+    }
+}
+
+static void tty_close(int epfd, lptty_t * tty) {
+    syslog(LOG_INFO, "astrid-seriallistener: Closing %s after %ld frames (%ld crc errors, %ld overflows)\n", tty->path, tty->frames, tty->crc_errors, tty->overflows);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, tty->fd, NULL);
+    close(tty->fd);
+    tty->fd = -1;
+}
+
+int main(int argc, char * argv[]) {
+    int c, i, n, epfd, num_ttys=0, num_open=0, baud=1000000;
+    char * sep;
+    speed_t speed;
+    lptty_t * tty;
+    lptty_t ttys[ASTRID_SERIAL_MAXTTYS] = {0};
+    struct epoll_event ev, events[ASTRID_SERIAL_MAXTTYS];
 
     openlog("astrid-seriallistener", LOG_PID, LOG_USER);
 
-    if(argc != 2) {
-        printf("Usage: %s </dev/ttyUSB0> (%d)\n", argv[0], argc);
+    while((c = getopt(argc, argv, "b:")) != -1) {
+        switch(c) {
+            case 'b':
+                baud = atoi(optarg);
+                break;
+            default:
+                break;
+        }
     }
 
-    tty_path = argv[1];
+    if(optind >= argc) {
+        printf("Usage: %s [-b baud] </dev/ttyUSB0[=device_id]> [/dev/ttyACM0[=device_id] ...]\n", argv[0]);
+        return 1;
+    }
 
+    if((speed = baud_to_speed(baud)) == B0) {
+        fprintf(stderr, "Unsupported baud rate %d\n", baud);
+        return 1;
+    }
 
     /* setup signal handlers */
     struct sigaction shutdown_action;
@@ -46,65 +238,82 @@ int main(int argc, char * argv[]) {
         syslog(LOG_ERR, "Could not init SIGTERM signal handler\n");
         exit(1);
     }
- 
-    printf("Opening tty...\n");
-    /* open tty */
-    tty = open(tty_path, O_RDONLY | O_NOCTTY);
-    if(tty < 0) {
-        syslog(LOG_ERR, "Problem connecting to TTY\n");
+
+    /* Map the ctl table before any data arrives */
+    if(lpserial_ctltable_open() == NULL) {
+        fprintf(stderr, "Could not open serial ctl table\n");
         exit(1);
     }
 
-    printf("Setting baud rate...\n");
-    /* set baud rate */
-    tcgetattr(tty, &options);
-    cfsetispeed(&options, B1000000);
-    tcsetattr(tty, TCSANOW, &options);
+    if((epfd = epoll_create1(0)) < 0) {
+        syslog(LOG_ERR, "Could not create epoll instance. Error: %s\n", strerror(errno));
+        exit(1);
+    }
 
-    printf("Waiting for messages...\n");
+    for(i=optind; i < argc && num_ttys < ASTRID_SERIAL_MAXTTYS; i++) {
+        tty = &ttys[num_ttys];
+        tty->path = argv[i];
+        tty->device_id = num_ttys;
 
-    while(serial_listener_is_running) {
-        printf("Reading messages...\n");
-        bytesread = read(tty, &msgstr, MSGBUFFER_SIZE);
-        printf("serial listener read %ld bytes on device %s...\n", bytesread, tty_path);
-        printf("msgstr: %s (char1: %u)\n", msgstr, msgstr[0]);
+        if((sep = strchr(argv[i], '=')) != NULL) {
+            *sep = '\0';
+            tty->device_id = atoi(sep+1);
+        }
 
-        if(bytesread <= 1) {
-            memset(msgstr, 0, MSGBUFFER_SIZE);
-            continue;
+        if(tty->device_id < 0 || tty->device_id >= ASTRID_SERIAL_MAXDEVICES) {
+            fprintf(stderr, "Device id %d for %s is out of range\n", tty->device_id, tty->path);
+            exit(1);
         }
 
-        printf("Converting to argv format\n");
-        int i = 0;
-        fakeargv[0] = strtok_r(msgstr, " ", &tokencache);
+        if(tty_open(tty, speed) < 0) {
+            fprintf(stderr, "Could not open %s\n", tty->path);
+            exit(1);
+        }
 
-        for(i=1; ; i++) {
-            token = strtok_r(NULL, " ", &tokencache);
-            fakeargv[i] = token;
-            if(token == NULL) break;
+        ev.events = EPOLLIN;
+        ev.data.ptr = tty;
+        if(epoll_ctl(epfd, EPOLL_CTL_ADD, tty->fd, &ev) < 0) {
+            syslog(LOG_ERR, "Could not watch %s. Error: %s\n", tty->path, strerror(errno));
+            exit(1);
         }
 
-        /* -1 offset to skip the usual program name 0 index in real argv */
-        if(parse_message_from_args(i, -1, fakeargv, &msg) < 0) {
-            fprintf(stderr, "astrid-msg: Could not parse message from args\n");
-            return 1;
+        num_ttys += 1;
+        num_open += 1;
+    }
+
+    while(serial_listener_is_running && num_open > 0) {
+        /* Wake up periodically to notice shutdown signals */
+        if((n = epoll_wait(epfd, events, ASTRID_SERIAL_MAXTTYS, 100)) < 0) {
+            if(errno == EINTR) continue;
+            syslog(LOG_ERR, "epoll_wait failed. Error: %s\n", strerror(errno));
+            break;
         }
 
-        memset(msgstr, 0, MSGBUFFER_SIZE);
+        for(i=0; i < n; i++) {
+            tty = (lptty_t *)events[i].data.ptr;
 
-        printf("message:\t%s\n", msg.instrument_name);
-        printf("\t%d (msg.voice_id)\n", (int)msg.voice_id);
-        printf("\t%d (msg.type)\n", (int)msg.type);
+            if(events[i].events & EPOLLIN) {
+                if(tty_read(tty) < 0) {
+                    tty_close(epfd, tty);
+                    num_open -= 1;
+                    continue;
+                }
+            }
 
-        if(send_play_message(msg) < 0) {
-            fprintf(stderr, "astrid-msg: Could not send play message...\n");
-            return 1;
+            /* Unplugged device or closed PTY master */
+            if(events[i].events & (EPOLLHUP | EPOLLERR)) {
+                tty_close(epfd, tty);
+                num_open -= 1;
+            }
         }
     }
 
-    close(tty);
+    for(i=0; i < num_ttys; i++) {
+        if(ttys[i].fd >= 0) tty_close(epfd, &ttys[i]);
+    }
+
+    close(epfd);
+    closelog();
 
     return 0;
 }
-
-
@@ -16,13 +16,14 @@ lpfloat_t logistic(lpfloat_t low, lpfloat_t high) {
 
 int main() {
     lpfloat_t freqdrift, minfreq, maxfreq, basefreq;
-    lpfloat_t a, ampdrift, sample, pos;
-    size_t i, c, p, length;
+    lpfloat_t ampdrift, pos;
+    lpfloat_t block[LPOSC_BLOCKSIZE];
+    size_t i, j, c, p, n, length;
     lpbuffer_t * out;
 
     lpbuffer_t * freq[PARTIALS];
     lpbuffer_t * amp[PARTIALS];
-    lpsineosc_t * osc[PARTIALS];
+    lpsinebank_t * bank;
 
     /* LPRand is used internally for window selection.
      * Every call to LPWindow.create("rnd", BS) invokes 
@@ -38,6 +39,8 @@ int main() {
     length = 10 * SR;
     basefreq = 60.f;
 
+    bank = LPSineBank.create(PARTIALS, SR);
+
     /* Make an LFO table to use as a frequency curve for the osc */
     for(i=0; i < PARTIALS; i++) {
         freq[i] = LPWindow.create(WIN_RND, BS);
@@ -48,29 +51,34 @@ int main() {
         amp[i] = LPWindow.create(WIN_RND, BS);
         LPBuffer.scale(amp[i], 0, 1, 0.f, LPRand.rand(ampdrift * 0.1, ampdrift));
 
-        osc[i] = LPSineOsc.create();
-        osc[i]->phase = LPRand.rand(0.f, 1.f); /* scramble phase */
-        osc[i]->samplerate = SR;
-        osc[i]->freq = freq[i]->data[0];
+        LPSineBank.set_phase(bank, i, LPRand.rand(0.f, 1.f)); /* scramble phase */
     }
 
+    /* The bank renders every partial at once, so the 
+     * freq and amp curves are followed block by block */
     out = LPBuffer.create(length, CHANNELS, SR);
-    for(i=0; i < length; i++) {
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
         pos = (lpfloat_t)i/length;
         for(p=0; p < PARTIALS; p++) {
-            osc[p]->freq = LPInterpolation.linear_pos(freq[p], pos);
-            a = LPInterpolation.linear_pos(amp[p], pos);
-            sample = LPSineOsc.process(osc[p]) * a;
+            LPSineBank.set_partial(bank, p, 
+                LPInterpolation.linear_pos(freq[p], pos), 
+                LPInterpolation.linear_pos(amp[p], pos)
+            );
+        }
+
+        LPSineBank.process_block(bank, block, n);
+        for(j=0; j < n; j++) {
             for(c=0; c < CHANNELS; c++) {
-                out->data[i * CHANNELS + c] += sample;
+                out->data[(i+j) * CHANNELS + c] = block[j];
             }
         }
     }
 
     LPSoundFile.write("renders/additive-synthesis-out.wav", out);
 
+    LPSineBank.destroy(bank);
     for(p=0; p < PARTIALS; p++) {
-        LPSineOsc.destroy(osc[p]);
         LPBuffer.destroy(freq[p]);
         LPBuffer.destroy(amp[p]);
     }
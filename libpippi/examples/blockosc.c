@@ -0,0 +1,114 @@
+#include "pippi.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define BLOCKSIZE 256
+#define NUMBLOCKS 1000
+
+/* Render each oscillator with process_block and check it 
+ * against the same oscillator stepped through process() */
+static int check(const char * name, lpfloat_t * block, lpfloat_t * reference, size_t length) {
+    lpfloat_t diff, maxdiff = 0;
+    size_t i;
+
+    for(i=0; i < length; i++) {
+        diff = fabs(block[i] - reference[i]);
+        if(diff > maxdiff) maxdiff = diff;
+    }
+
+    printf("%-8s max diff %g\n", name, maxdiff);
+    return maxdiff > 1e-6;
+}
+
+int main() {
+    lpfloat_t block[BLOCKSIZE], reference[BLOCKSIZE], freqs[BLOCKSIZE], amps[BLOCKSIZE];
+    lpfloat_t blockout[BLOCKSIZE * NUMBLOCKS], refout[BLOCKSIZE * NUMBLOCKS];
+    size_t i, b, c, length;
+    int failed = 0;
+    lpbuffer_t * out, * wt;
+    lpsineosc_t * sine_a, * sine_b;
+    lpphasorosc_t * phasor_a, * phasor_b;
+    lptukeyosc_t * tukey_a, * tukey_b;
+    lptableosc_t * table_a, * table_b;
+
+    length = BLOCKSIZE * NUMBLOCKS;
+
+    sine_a = LPSineOsc.create();
+    sine_b = LPSineOsc.create();
+    phasor_a = LPPhasorOsc.create();
+    phasor_b = LPPhasorOsc.create();
+    tukey_a = LPTukeyOsc.create();
+    tukey_b = LPTukeyOsc.create();
+    wt = LPWavetable.create(WT_SINE, 4096);
+    table_a = LPTableOsc.create(wt);
+    table_b = LPTableOsc.create(wt);
+
+    /* Sine with a freq sweep and amp curve, one block at a time */
+    for(b=0; b < NUMBLOCKS; b++) {
+        for(i=0; i < BLOCKSIZE; i++) {
+            freqs[i] = 80.f + (b * BLOCKSIZE + i) * 0.01f;
+            amps[i] = 0.2f;
+        }
+
+        LPSineOsc.process_block(sine_a, block, BLOCKSIZE, freqs, amps);
+        for(i=0; i < BLOCKSIZE; i++) {
+            sine_b->freq = freqs[i];
+            reference[i] = LPSineOsc.process(sine_b) * amps[i];
+        }
+
+        memcpy(&blockout[b * BLOCKSIZE], block, sizeof(block));
+        memcpy(&refout[b * BLOCKSIZE], reference, sizeof(reference));
+    }
+    failed |= check("sine", blockout, refout, length);
+
+    /* The others at a constant freq */
+    phasor_a->freq = phasor_b->freq = 3.f;
+    tukey_a->freq = tukey_b->freq = 110.f;
+    table_a->freq = table_b->freq = 220.f;
+
+    for(b=0; b < NUMBLOCKS; b++) {
+        LPPhasorOsc.process_block(phasor_a, &blockout[b * BLOCKSIZE], BLOCKSIZE, NULL, NULL);
+        for(i=0; i < BLOCKSIZE; i++) refout[b * BLOCKSIZE + i] = LPPhasorOsc.process(phasor_b);
+    }
+    failed |= check("phasor", blockout, refout, length);
+
+    for(b=0; b < NUMBLOCKS; b++) {
+        LPTukeyOsc.process_block(tukey_a, &blockout[b * BLOCKSIZE], BLOCKSIZE, NULL, NULL);
+        for(i=0; i < BLOCKSIZE; i++) refout[b * BLOCKSIZE + i] = LPTukeyOsc.process(tukey_b);
+    }
+    failed |= check("tukey", blockout, refout, length);
+
+    for(b=0; b < NUMBLOCKS; b++) {
+        LPTableOsc.process_block(table_a, &blockout[b * BLOCKSIZE], BLOCKSIZE, NULL, NULL);
+        for(i=0; i < BLOCKSIZE; i++) refout[b * BLOCKSIZE + i] = LPTableOsc.process(table_b);
+    }
+    failed |= check("table", blockout, refout, length);
+
+    /* Write the sine sweep out like the other osc examples */
+    sine_a->phase = 0.f;
+    out = LPBuffer.create(length, CHANNELS, SR);
+    for(b=0; b < NUMBLOCKS; b++) {
+        for(i=0; i < BLOCKSIZE; i++) freqs[i] = 80.f + (b * BLOCKSIZE + i) * 0.01f;
+        LPSineOsc.process_block(sine_a, block, BLOCKSIZE, freqs, NULL);
+        for(i=0; i < BLOCKSIZE; i++) {
+            for(c=0; c < CHANNELS; c++) {
+                out->data[(b * BLOCKSIZE + i) * CHANNELS + c] = block[i] * 0.2f;
+            }
+        }
+    }
+
+    LPSoundFile.write("renders/blockosc-out.wav", out);
+
+    LPSineOsc.destroy(sine_a);
+    LPSineOsc.destroy(sine_b);
+    LPPhasorOsc.destroy(phasor_a);
+    LPPhasorOsc.destroy(phasor_b);
+    LPTukeyOsc.destroy(tukey_a);
+    LPTukeyOsc.destroy(tukey_b);
+    LPTableOsc.destroy(table_a);
+    LPTableOsc.destroy(table_b);
+    LPBuffer.destroy(wt);
+    LPBuffer.destroy(out);
+
+    return failed;
+}
@@ -0,0 +1,120 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define LENGTH 48001
+#define NUMRUNS 20
+
+/* Run the buffer ops through every kernel implementation
+ * this CPU supports and check the results against the
+ * scalar reference kernels, with a rough timing for each */
+
+static lpfloat_t run_ops(lpbuffer_t * out, lpbuffer_t * src, lpbuffer_t * mono, lpbuffer_t * quad, lpbuffer_t * env, lpbuffer_t * pos) {
+    lpbuffer_t * mixed;
+    lpfloat_t mag;
+
+    LPBuffer.copy(src, out);
+
+    /* Same shape, mono to stereo broadcast and
+     * a strided 4 -> 2 channel mapping */
+    LPBuffer.multiply(out, src);
+    LPBuffer.add(out, mono);
+    LPBuffer.subtract(out, quad);
+    LPBuffer.divide(out, mono);
+
+    LPBuffer.multiply_scalar(out, 0.5f);
+    LPBuffer.add_scalar(out, 0.1f);
+    LPBuffer.subtract_scalar(out, 0.2f);
+    LPBuffer.divide_scalar(out, 3.f);
+
+    LPBuffer.scale(out, -1.f, 1.f, 0.f, 2.f);
+    LPBuffer.clip(out, -1.f, 1.f);
+    LPBuffer.env(out, env);
+    LPBuffer.pan(out, pos, PANMETHOD_CONSTANT);
+    LPBuffer.dub(out, src, 0);
+
+    mixed = LPBuffer.mix(out, mono);
+    LPBuffer.copy(mixed, out);
+    LPBuffer.destroy(mixed);
+
+    LPFX.norm(out, 0.8f);
+    mag = LPBuffer.mag(out);
+
+    return mag;
+}
+
+static void fill_noise(lpbuffer_t * buf, int zeros) {
+    size_t i;
+    for(i=0; i < buf->length * buf->channels; i++) {
+        buf->data[i] = LPRand.rand(-1.f, 1.f);
+        /* Some exact zeros to exercise divide by zero */
+        if(zeros && i % 97 == 0) buf->data[i] = 0.f;
+    }
+}
+
+int main() {
+    const char * tiers[] = { "sse2", "avx2", "avx512", "neon" };
+    lpbuffer_t * src, * mono, * quad, * env, * pos, * reference, * out;
+    lpfloat_t refmag, mag, diff, maxdiff;
+    clock_t start;
+    double elapsed;
+    size_t i, t;
+    int r, failed = 0;
+
+    LPRand.seed(1);
+
+    src = LPBuffer.create(LENGTH, 2, SR);
+    mono = LPBuffer.create(LENGTH, 1, SR);
+    quad = LPBuffer.create(LENGTH, 4, SR);
+    env = LPWindow.create(WIN_HANN, 4096);
+    pos = LPWindow.create(WIN_SINE, 4096);
+    reference = LPBuffer.create(LENGTH, 2, SR);
+    out = LPBuffer.create(LENGTH, 2, SR);
+
+    fill_noise(src, 0);
+    fill_noise(mono, 1);
+    fill_noise(quad, 0);
+
+    LPKernels.select("scalar");
+    refmag = run_ops(reference, src, mono, quad, env, pos);
+
+    start = clock();
+    for(r=0; r < NUMRUNS; r++) run_ops(out, src, mono, quad, env, pos);
+    elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%-8s %8.3f ms per run\n", "scalar", elapsed * 1000 / NUMRUNS);
+
+    for(t=0; t < sizeof(tiers) / sizeof(tiers[0]); t++) {
+        if(LPKernels.select(tiers[t]) < 0) {
+            printf("%-8s not supported on this CPU\n", tiers[t]);
+            continue;
+        }
+
+        mag = run_ops(out, src, mono, quad, env, pos);
+
+        maxdiff = fabs(mag - refmag);
+        for(i=0; i < LENGTH * 2; i++) {
+            diff = fabs(out->data[i] - reference->data[i]);
+            if(diff > maxdiff) maxdiff = diff;
+        }
+
+        start = clock();
+        for(r=0; r < NUMRUNS; r++) run_ops(out, src, mono, quad, env, pos);
+        elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%-8s %8.3f ms per run, max diff %g\n", LPKernels.name, elapsed * 1000 / NUMRUNS, (double)maxdiff);
+        failed |= maxdiff > 1e-6f;
+    }
+
+    LPKernels.select(NULL);
+    printf("default  %s\n", LPKernels.name);
+
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(mono);
+    LPBuffer.destroy(quad);
+    LPBuffer.destroy(env);
+    LPBuffer.destroy(pos);
+    LPBuffer.destroy(reference);
+    LPBuffer.destroy(out);
+
+    return failed;
+}
@@ -0,0 +1,159 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define NUMGRAINS 2000
+#define GRAINLENGTH 4410
+
+/* Check views against the copying LPBuffer versions,
+ * and the read only functions that take either, then
+ * run a cut, env, dub grain loop both ways and compare
+ * the time */
+
+static lpfloat_t maxdiff(lpbuffer_t * a, lpbuffer_t * b) {
+    lpfloat_t diff, out = 0;
+    size_t i;
+
+    if(a->length != b->length || a->channels != b->channels) return 1;
+    for(i=0; i < a->length * a->channels; i++) {
+        diff = fabs(a->data[i] - b->data[i]);
+        if(diff > out) out = diff;
+    }
+    return out;
+}
+
+static int check(const char * name, lpbufferview_t * view, lpbuffer_t * expected) {
+    lpbuffer_t * out;
+    lpfloat_t diff;
+
+    out = LPBufferView.materialize(view);
+    diff = maxdiff(out, expected);
+    printf("%s: %d frames, max diff %g\n", name, (int)out->length, (double)diff);
+    LPBuffer.destroy(out);
+
+    return diff > 0;
+}
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main() {
+    lpbuffer_t * src, * cut, * rev, * padded, * env, * copied, * viewed;
+    lpbufferview_t * whole, * view, * view2;
+    double copytime, viewtime;
+    size_t i, start, pos;
+    clock_t t;
+    int failed = 0;
+
+    LPRand.seed(3);
+
+    src = LPBuffer.create(SR, 2, SR);
+    for(i=0; i < src->length * 2; i++) src->data[i] = LPRand.rand(-1.f, 1.f);
+    whole = LPBufferView.create(src);
+
+    cut = LPBuffer.cut(src, 1000, 2000);
+    view = LPBufferView.cut(whole, 1000, 2000);
+    failed |= check("cut", view, cut);
+
+    rev = LPBuffer.reverse(cut);
+    view2 = LPBufferView.reverse(view);
+    failed |= check("reverse of cut", view2, rev);
+    LPBufferView.destroy(view2);
+
+    padded = LPBuffer.pad(cut, 100, 50);
+    view2 = LPBufferView.pad(view, 100, 50);
+    failed |= check("pad of cut", view2, padded);
+    LPBuffer.destroy(padded);
+
+    /* Reversing the padded view and cutting it back
+     * out of its padding gets the reversed cut again */
+    LPBufferView.destroy(view);
+    view = LPBufferView.reverse(view2);
+    LPBufferView.destroy(view2);
+    view2 = LPBufferView.cut(view, 50, 2000);
+    failed |= check("cut of reversed pad", view2, rev);
+    LPBufferView.destroy(view2);
+    LPBufferView.destroy(view);
+    LPBuffer.destroy(rev);
+
+    /* One channel of the cut */
+    view = LPBufferView.cut(whole, 1000, 2000);
+    view2 = LPBufferView.channel(view, 1);
+    for(i=0; i < cut->length; i++) {
+        failed |= LPBufferView.read(view2, i, 0) != cut->data[i * 2 + 1];
+    }
+    failed |= view2->channels != 1;
+    LPBufferView.destroy(view2);
+
+    /* Read only functions see the same frames through a
+     * view as through the copy */
+    view2 = LPBufferView.reverse(view);
+    failed |= LPBufferView.min(view2) != LPBuffer.min(cut) || LPBufferView.max(view2) != LPBuffer.max(cut);
+    failed |= LPBufferView.mag(view2) != LPBuffer.mag(cut);
+    rev = LPBuffer.reverse(cut);
+    for(i=0; i < 100; i++) {
+        failed |= LPFX.read_skewed_samples(1.f, LPBufferView.samples(view2, 1), i * 17.5f, 0.3f) != LPFX.read_skewed_samples(1.f, LPBuffer.samples(rev, 1), i * 17.5f, 0.3f);
+    }
+    printf("read only: %s\n", failed ? "MISMATCH" : "ok");
+    LPBufferView.destroy(view2);
+    LPBuffer.destroy(rev);
+
+    /* Reading off the end is silent */
+    view2 = LPBufferView.cut(whole, SR - 10, 20);
+    failed |= LPBufferView.read(view2, 9, 1) != src->data[SR * 2 - 1];
+    failed |= LPBufferView.read(view2, 10, 0) != 0;
+    failed |= LPBufferView.mag(view2) > LPBuffer.mag(src);
+
+    /* The view keeps the buffer alive after its owner
+     * is done with it */
+    LPBufferView.destroy(whole);
+    LPBuffer.destroy(src);
+    failed |= LPBufferView.read(view, 0, 0) != cut->data[0];
+    failed |= src->refcount != 2;
+    LPBufferView.destroy(view2);
+    LPBufferView.destroy(view);
+    LPBuffer.destroy(cut);
+
+    /* A grain cloud: cut, env, dub against one pass views */
+    src = LPBuffer.create(SR * 5, 2, SR);
+    for(i=0; i < src->length * 2; i++) src->data[i] = LPRand.rand(-1.f, 1.f);
+    env = LPWindow.create(WIN_HANN, 4096);
+    copied = LPBuffer.create(SR * 5, 2, SR);
+    viewed = LPBuffer.create(SR * 5, 2, SR);
+    whole = LPBufferView.create(src);
+
+    LPRand.seed(5);
+    t = clock();
+    for(i=0; i < NUMGRAINS; i++) {
+        start = LPRand.randint(0, src->length - GRAINLENGTH);
+        pos = LPRand.randint(0, copied->length - GRAINLENGTH);
+        cut = LPBuffer.cut(src, start, GRAINLENGTH);
+        LPBuffer.env(cut, env);
+        LPBuffer.dub(copied, cut, pos);
+        LPBuffer.destroy(cut);
+    }
+    copytime = elapsed(t);
+
+    LPRand.seed(5);
+    t = clock();
+    for(i=0; i < NUMGRAINS; i++) {
+        start = LPRand.randint(0, src->length - GRAINLENGTH);
+        pos = LPRand.randint(0, viewed->length - GRAINLENGTH);
+        view = LPBufferView.cut(whole, start, GRAINLENGTH);
+        LPBufferView.dub(viewed, view, env, pos);
+        LPBufferView.destroy(view);
+    }
+    viewtime = elapsed(t);
+
+    printf("grains: copied %.1f ms, views %.1f ms, max diff %g\n", copytime * 1000, viewtime * 1000, (double)maxdiff(copied, viewed));
+    failed |= maxdiff(copied, viewed) > 1e-6;
+
+    LPBufferView.destroy(whole);
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(env);
+    LPBuffer.destroy(copied);
+    LPBuffer.destroy(viewed);
+
+    return failed;
+}
@@ -0,0 +1,134 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define STREAMBLOCK 100
+
+/* Check LPConvolver against the direct convolution
+ * in LPFX.convolve, offline and streaming with a true
+ * stereo impulse, then time both with a 10 second
+ * impulse */
+
+static double db(double err) {
+    return 20 * log10(err + 1e-30);
+}
+
+static lpbuffer_t * noise(size_t length, int channels, lpfloat_t decay) {
+    lpbuffer_t * buf;
+    size_t i;
+    int c;
+
+    buf = LPBuffer.create(length, channels, SR);
+    for(i=0; i < length; i++) {
+        for(c=0; c < channels; c++) {
+            buf->data[i * channels + c] = LPRand.rand(-1.f, 1.f) * expf(-decay * (float)i / length);
+        }
+    }
+    return buf;
+}
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main() {
+    lpbuffer_t * src, * impulse, * direct, * partitioned, * matrix;
+    lpconvolver_t * conv;
+    lpfloat_t in[STREAMBLOCK * 2], out[STREAMBLOCK * 2];
+    lpfloat_t maxerr, err, expected;
+    double directtime, convtime;
+    clock_t start;
+    size_t i, j, pos, n, length;
+    int c, o, failed = 0;
+
+    LPRand.seed(7);
+
+    /* Offline, against LPFX.convolve */
+    src = noise(SR / 2, 2, 0.f);
+    impulse = noise(SR / 4, 2, 5.f);
+
+    direct = LPBuffer.create(src->length + impulse->length + 1, 2, SR);
+    LPFX.convolve(src, impulse, direct);
+    partitioned = LPConvolver.convolve(src, impulse);
+
+    maxerr = 0;
+    for(i=0; i < direct->length * 2; i++) {
+        err = fabs(direct->data[i] - partitioned->data[i]);
+        if(err > maxerr) maxerr = err;
+    }
+    printf("offline max error %.1f dB\n", db(maxerr));
+    failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -200 : -90);
+
+    LPBuffer.destroy(direct);
+    LPBuffer.destroy(partitioned);
+    LPBuffer.destroy(impulse);
+
+    /* Streaming in odd sized blocks with a true stereo
+     * (2x2) impulse and non-uniform partitions */
+    impulse = noise(SR / 4, 4, 5.f);
+    length = src->length + impulse->length;
+    conv = LPConvolver.create(impulse, 2, 2, 64, 4096);
+
+    matrix = LPBuffer.create(length + 64, 2, SR);
+    for(pos=0; pos < length + 64; pos += n) {
+        n = length + 64 - pos;
+        if(n > STREAMBLOCK) n = STREAMBLOCK;
+        for(i=0; i < n; i++) {
+            for(c=0; c < 2; c++) {
+                in[i * 2 + c] = (pos + i < src->length) ? src->data[(pos + i) * 2 + c] : 0.f;
+            }
+        }
+        LPConvolver.process_block(conv, in, out, n);
+        memcpy(matrix->data + pos * 2, out, sizeof(lpfloat_t) * n * 2);
+    }
+
+    /* Spot check output frames against the direct sum,
+     * 64 frames of latency later */
+    maxerr = 0;
+    for(i=0; i < length; i += 997) {
+        for(o=0; o < 2; o++) {
+            expected = 0.f;
+            for(c=0; c < 2; c++) {
+                for(j=0; j < impulse->length && j <= i; j++) {
+                    if(i - j >= src->length) continue;
+                    expected += src->data[(i - j) * 2 + c] * impulse->data[j * 4 + c * 2 + o];
+                }
+            }
+            err = fabs(matrix->data[(i + 64) * 2 + o] - expected);
+            if(err > maxerr) maxerr = err;
+        }
+    }
+    printf("streaming true stereo max error %.1f dB over %d stages\n", db(maxerr), (int)conv->numstages);
+    failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -200 : -60);
+
+    LPConvolver.destroy(conv);
+    LPBuffer.destroy(matrix);
+    LPBuffer.destroy(impulse);
+    LPBuffer.destroy(src);
+
+    /* A 10 second impulse: the direct convolution only
+     * gets 20ms of input, so compare the time per second
+     * of input */
+    impulse = noise(SR * 10, 2, 5.f);
+    src = noise(SR / 50, 2, 0.f);
+
+    direct = LPBuffer.create(src->length + impulse->length + 1, 2, SR);
+    start = clock();
+    LPFX.convolve(src, impulse, direct);
+    directtime = elapsed(start) * 50;
+    LPBuffer.destroy(direct);
+    LPBuffer.destroy(src);
+
+    src = noise(SR * 10, 2, 0.f);
+    start = clock();
+    partitioned = LPConvolver.convolve(src, impulse);
+    convtime = elapsed(start) / 10;
+    LPBuffer.destroy(partitioned);
+
+    printf("10 second impulse, per second of input: LPFX.convolve %.2f s, LPConvolver %.4f s (%.0fx)\n", directtime, convtime, directtime / convtime);
+
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(impulse);
+
+    return failed;
+}
@@ -0,0 +1,110 @@
+#include <time.h>
+#include "pippi.h"
+
+#define MAXLENGTH 8192
+#define TIMEDLENGTH 4096
+#define NUMRUNS 2000
+
+/* Check LPFFT against a direct DFT for every power
+ * of two length up to MAXLENGTH, check the round trip,
+ * check LPSpectral.convolve against direct convolution
+ * and time a forward/inverse pair */
+
+static lpfloat_t in[MAXLENGTH], out[MAXLENGTH];
+static lpfloat_t real[MAXLENGTH/2+1], imag[MAXLENGTH/2+1];
+
+static double db(double err) {
+    return 20 * log10(err + 1e-30);
+}
+
+int main() {
+    lpbuffer_t * src, * impulse, * conv, * reference;
+    lpfft_t * fft;
+    long double sumre, sumim, angle;
+    double err, maxerr, t;
+    size_t length, i, j, k;
+    clock_t start;
+    int c, failed = 0;
+
+    LPRand.seed(3);
+
+    for(length=2; length <= MAXLENGTH; length *= 2) {
+        fft = LPFFT.create(length);
+        for(i=0; i < length; i++) in[i] = LPRand.rand(-1.f, 1.f);
+
+        LPFFT.forward(fft, in, real, imag);
+
+        /* Relative to sqrt(length), the expected bin magnitude of noise */
+        maxerr = 0;
+        for(k=0; k <= length/2; k++) {
+            sumre = sumim = 0;
+            for(i=0; i < length; i++) {
+                angle = -2.0L * PI * (long double)((i * k) % length) / length;
+                sumre += in[i] * cosl(angle);
+                sumim += in[i] * sinl(angle);
+            }
+            err = fabs((double)(real[k] - sumre)) + fabs((double)(imag[k] - sumim));
+            if(err > maxerr) maxerr = err;
+        }
+        maxerr /= sqrt((double)length);
+
+        LPFFT.inverse(fft, real, imag, out);
+        err = 0;
+        for(i=0; i < length; i++) {
+            if(fabs(out[i] - in[i]) > err) err = fabs(out[i] - in[i]);
+        }
+
+        printf("%5d forward error %.1f dB, round trip error %.1f dB\n", (int)length, db(maxerr), db(err));
+        failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -250 : -110);
+        failed |= db(err) > (sizeof(lpfloat_t) == sizeof(double) ? -250 : -110);
+
+        LPFFT.destroy(fft);
+    }
+
+    /* Stereo source with a mono impulse, against direct convolution */
+    src = LPBuffer.create(3000, 2, 48000);
+    impulse = LPBuffer.create(500, 1, 48000);
+    for(i=0; i < src->length * 2; i++) src->data[i] = LPRand.rand(-1.f, 1.f);
+    for(i=0; i < impulse->length; i++) impulse->data[i] = LPRand.rand(-1.f, 1.f);
+
+    conv = LPSpectral.convolve(src, impulse);
+
+    /* convolve normalizes to the peak of src, so do the same to the reference */
+    reference = LPBuffer.create(conv->length, 2, 48000);
+    for(c=0; c < 2; c++) {
+        for(i=0; i < src->length + impulse->length - 1; i++) {
+            sumre = 0;
+            for(j=0; j < impulse->length && j <= i; j++) {
+                if(i - j < src->length) sumre += src->data[(i - j) * 2 + c] * impulse->data[j];
+            }
+            reference->data[i * 2 + c] = (lpfloat_t)sumre;
+        }
+    }
+    LPFX.norm(reference, LPBuffer.mag(src));
+
+    maxerr = 0;
+    for(i=0; i < conv->length * 2; i++) {
+        err = fabs(conv->data[i] - reference->data[i]);
+        if(err > maxerr) maxerr = err;
+    }
+    printf("convolve error %.1f dB\n", db(maxerr));
+    failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -250 : -110);
+
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(impulse);
+    LPBuffer.destroy(conv);
+    LPBuffer.destroy(reference);
+
+    fft = LPFFT.create(TIMEDLENGTH);
+    for(i=0; i < TIMEDLENGTH; i++) in[i] = LPRand.rand(-1.f, 1.f);
+    start = clock();
+    for(i=0; i < NUMRUNS; i++) {
+        LPFFT.forward(fft, in, real, imag);
+        LPFFT.inverse(fft, real, imag, in);
+    }
+    t = (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / NUMRUNS;
+    printf("%d point forward + inverse: %.2f us\n", TIMEDLENGTH, t);
+    LPFFT.destroy(fft);
+
+    return failed;
+}
@@ -19,7 +19,7 @@ int main() {
     window_type = WIN_HANN;
 
     out = LPBuffer.create(length, CHANNELS, SR);
-    formation = LPFormation.create(window_type, numlayers, grainlength, length, CHANNELS, SR, NULL);
+    formation = LPFormation.create(window_type, numlayers, grainlength, length, CHANNELS, SR, NULL, 0);
 
     /* Render a sine tone and fill the ringbuffer with it, 
      * to simulate a live input. */
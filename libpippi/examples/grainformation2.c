@@ -33,7 +33,7 @@ int main() {
     out = LPBuffer.create(length, CHANNELS, SR);
     snd = LPSoundFile.read("../tests/sounds/living.wav");
 
-    formation = LPFormation.create(window_type, 1, SR/20.f, length, CHANNELS, SR, NULL);
+    formation = LPFormation.create(window_type, 1, SR/20.f, length, CHANNELS, SR, NULL, 0);
     formation->speed = 1.f;
 
     /*
@@ -29,7 +29,7 @@ int main() {
     out = LPBuffer.create(length, CHANNELS, SR);
     snd = LPSoundFile.read("../tests/sounds/living.wav");
 
-    formation = LPFormation.create(window_type, 1, SR/4.f, length, CHANNELS, SR, win);
+    formation = LPFormation.create(window_type, 1, SR/4.f, length, CHANNELS, SR, win, 0);
     formation->speed = 1.f;
 
     cutoffs = LPShapeOsc.multi(4, WT_COS, WT_TRI, WT_SINE, WT_SINE);
@@ -0,0 +1,113 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define SECONDS 2
+#define BLOCKSIZE 256
+#define MAXGRAINS 6000
+
+/* A cloud of ~5,000 overlapping grains rendered in blocks,
+ * checking that block and frame at a time renders agree
+ * and printing how much faster than realtime it runs.
+ * First check when grains start: numlayers of them on
+ * the first frame and every graininterval frames after,
+ * each playing for grainlength frames. */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Grains playing after frame i, with 3 layers of 1000
+ * frame grains every 100 frames */
+static int expected_grains(size_t i) {
+    size_t onset;
+    int count = 0;
+
+    for(onset=0; onset <= i; onset += 100) {
+        if(onset + 999 > i) count += 3;
+    }
+
+    return count;
+}
+
+static lpformation_t * cloud(lpbuffer_t * src) {
+    lpformation_t * formation;
+
+    /* 50 grains every 480 frames, each 1 second long */
+    formation = LPFormation.create(WIN_HANN, 50, SR, src->length, CHANNELS, SR, NULL, MAXGRAINS);
+    formation->graininterval = SR / 100;
+    formation->spread = 1.f;
+    formation->amp = 0.002f;
+    LPRingBuffer.write(formation->rb, src);
+
+    return formation;
+}
+
+int main() {
+    lpbuffer_t * src, * out, * framed;
+    lpformation_t * formation;
+    lpfloat_t diff, maxdiff;
+    size_t i, length, pos, n;
+    int maxactive, failed = 0;
+    double rendertime;
+    clock_t start;
+
+    length = SECONDS * SR;
+
+    formation = LPFormation.create(WIN_HANN, 3, 1000, 4096, CHANNELS, SR, NULL, 0);
+    formation->graininterval = 100;
+    for(i=0; i < 2500; i++) {
+        LPFormation.process(formation);
+        failed |= formation->num_active_grains != expected_grains(i);
+    }
+    printf("onsets: %s, %d grains at once\n", failed ? "FAILED" : "ok", formation->num_active_grains);
+    LPFormation.destroy(formation);
+
+    src = LPSoundFile.read("../docs/tutorials/renders/001-guitar-unaltered.flac");
+    out = LPBuffer.create(length, CHANNELS, SR);
+    framed = LPBuffer.create(length, CHANNELS, SR);
+
+    LPRand.seed(7);
+    formation = cloud(src);
+    maxactive = 0;
+    start = clock();
+    for(pos=0; pos < length; pos += n) {
+        n = length - pos;
+        if(n > BLOCKSIZE) n = BLOCKSIZE;
+        LPFormation.process_block(formation, out->data + pos * CHANNELS, n);
+        if(formation->num_active_grains > maxactive) maxactive = formation->num_active_grains;
+    }
+    rendertime = elapsed(start);
+    LPFormation.destroy(formation);
+
+    LPRand.seed(7);
+    formation = cloud(src);
+    for(i=0; i < length; i++) {
+        LPFormation.process(formation);
+        memcpy(framed->data + i * CHANNELS, formation->current_frame->data, sizeof(lpfloat_t) * CHANNELS);
+    }
+    LPFormation.destroy(formation);
+
+    maxdiff = 0;
+    for(i=0; i < length * CHANNELS; i++) {
+        diff = fabs(out->data[i] - framed->data[i]);
+        if(diff > maxdiff) maxdiff = diff;
+    }
+
+    printf("%d grains at once, max diff %g\n", maxactive, (double)maxdiff);
+    printf("%d seconds rendered in %.2f seconds, %.1fx realtime\n", SECONDS, rendertime, SECONDS / rendertime);
+
+    failed |= maxactive < 5000 || maxactive > MAXGRAINS;
+    /* Grains are mixed in a different order in blocks */
+    failed |= maxdiff > (sizeof(lpfloat_t) == sizeof(double) ? 1e-9 : 1e-4);
+    failed |= LPBuffer.mag(out) == 0;
+
+    LPSoundFile.write("renders/grainformation_dense-out.wav", out);
+
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(out);
+    LPBuffer.destroy(framed);
+
+    return failed;
+}
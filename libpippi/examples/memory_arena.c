@@ -0,0 +1,144 @@
+/**
+ * This example builds on memory_pool.c and shows how the
+ * static memory pool behaves over a long run with a fixed
+ * memory budget:
+ *
+ *  - buffers created and destroyed over and over reuse
+ *    the same blocks, so the high water mark stays put
+ *  - short lived temporaries can be created inside an
+ *    arena scope and dropped all at once
+ *  - worker threads can allocate and free concurrently
+ *  - when the budget runs out alloc returns NULL and
+ *    the failure is counted instead of exiting
+ *
+ * Like memory_pool.c, build it with LP_STATIC:
+ *
+ *     gcc ... -DLP_STATIC ... -lpthread
+ * */
+#include <pthread.h>
+#include "pippicore.h"
+#include "oscs.sine.h"
+
+#define BS 1024
+#define SR 48000
+#define CHANNELS 2
+#define POOLSIZE 16777216 /* 16MB for the primary pool */
+#define ARENASIZE 1048576 /* 1MB for the scratch arena */
+#define NUMROUNDS 1000
+#define NUMTHREADS 4
+
+unsigned char pool[POOLSIZE];
+unsigned char arena_pool[ARENASIZE];
+
+/* Render a block of sine into out, using a temporary
+ * buffer for the frequency curve which is never freed
+ * explicitly: it lives in the arena scope. */
+static void render_block(lpmemorypool_t * arena, lpsineosc_t * osc, lpbuffer_t * out) {
+    lpbuffer_t * freq_lfo;
+    size_t i, mark;
+    int c;
+    lpfloat_t sample;
+
+    mark = LPMemoryPool.scope_begin(arena);
+
+    freq_lfo = LPWindow.create(WIN_SINE, BS);
+    LPBuffer.scale(freq_lfo, 0.f, 1.f, 80.f, 800.f);
+
+    for(i=0; i < out->length; i++) {
+        osc->freq = LPInterpolation.linear_pos(freq_lfo, (lpfloat_t)i/out->length);
+        sample = LPSineOsc.process(osc) * 0.2f;
+        for(c=0; c < out->channels; c++) {
+            out->data[i * out->channels + c] = sample;
+        }
+    }
+
+    LPMemoryPool.scope_end(arena, mark);
+}
+
+/* Each worker creates and destroys buffers of
+ * varying sizes in the shared primary pool. */
+static void * worker(void * arg) {
+    lpbuffer_t * bufs[8];
+    size_t i, b, seed;
+
+    seed = (size_t)arg;
+
+    for(i=0; i < NUMROUNDS; i++) {
+        for(b=0; b < 8; b++) {
+            bufs[b] = LPBuffer.create(BS + ((seed + i + b) % 7) * 100, CHANNELS, SR);
+        }
+        for(b=0; b < 8; b++) {
+            LPBuffer.destroy(bufs[b]);
+        }
+    }
+
+    /* Hand any cached blocks back to the pool */
+    LPMemoryPool.thread_release();
+
+    return NULL;
+}
+
+static void print_stats(const char * label, lpmemorypool_stats_t stats) {
+    printf("%-10s live %8d  high water %8d  allocs %8d  frees %8d  failed %d\n",
+            label, (int)stats.live, (int)stats.highwater,
+            (int)stats.allocs, (int)stats.frees, (int)stats.failed);
+}
+
+int main() {
+    pthread_t threads[NUMTHREADS];
+    lpmemorypool_stats_t stats;
+    lpmemorypool_t * arena;
+    lpsineosc_t * osc;
+    lpbuffer_t * out;
+    size_t i, baseline, highwater;
+    void * big;
+    int failed = 0;
+
+    LPMemoryPool.init((unsigned char *)pool, POOLSIZE);
+    /* The arena's bookkeeping is itself allocated from the primary pool */
+    arena = LPMemoryPool.custom_init((unsigned char *)arena_pool, ARENASIZE);
+    baseline = LPMemoryPool.stats(NULL).live;
+
+    /* Create and destroy the same buffers many times:
+     * after the first round every block is reused. */
+    osc = LPSineOsc.create();
+    osc->samplerate = SR;
+    for(i=0; i < NUMROUNDS; i++) {
+        out = LPBuffer.create(BS, CHANNELS, SR);
+        render_block(arena, osc, out);
+        LPBuffer.destroy(out);
+        if(i == 0) highwater = LPMemoryPool.stats(NULL).highwater;
+    }
+    LPSineOsc.destroy(osc);
+
+    stats = LPMemoryPool.stats(NULL);
+    print_stats("primary", stats);
+    print_stats("arena", LPMemoryPool.stats(arena));
+    failed |= stats.highwater != highwater;
+    failed |= stats.live != baseline;
+    failed |= LPMemoryPool.stats(arena).live != 0;
+
+    /* The same churn from several threads at once */
+    for(i=0; i < NUMTHREADS; i++) {
+        pthread_create(&threads[i], NULL, worker, (void *)i);
+    }
+    for(i=0; i < NUMTHREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    stats = LPMemoryPool.stats(NULL);
+    print_stats("threads", stats);
+    failed |= stats.live != baseline;
+
+    /* Ask for more than the budget */
+    big = LPMemoryPool.alloc(1, POOLSIZE * 2);
+    stats = LPMemoryPool.stats(NULL);
+    print_stats("exhausted", stats);
+    failed |= big != NULL;
+    failed |= stats.failed != 1;
+
+    LPMemoryPool.free(arena);
+    failed |= LPMemoryPool.stats(NULL).live != 0;
+
+    return failed;
+}
@@ -58,6 +58,7 @@ int main() {
     lpbuffer_t * freq_lfo;
     lpbuffer_t * out;
     lpsineosc_t * osc;
+    lpmemorypool_stats_t stats;
 
     /* This is the final required step.
      * Pool.init() tells pippi about the
@@ -99,10 +100,15 @@ int main() {
 
     LPSoundFile.write("renders/memorypool-out.wav", out);
 
-    /* These are a no-op if the static allocator is enabled. */
+    /* Freed blocks go back to the pool's size class 
+     * free lists, so they can be reused by the next 
+     * allocation of a similar size. */
     LPSineOsc.destroy(osc);
     LPBuffer.destroy(out);
     LPBuffer.destroy(freq_lfo);
 
+    stats = LPMemoryPool.stats(NULL);
+    printf("Pool high water mark: %d bytes, %d bytes still live\n", (int)stats.highwater, (int)stats.live);
+
     return 0;
 }
@@ -0,0 +1,138 @@
+#include <time.h>
+#include "pippi.h"
+
+#define MAXEVENTS 4096
+#define INTERVAL 480.5
+
+/* Run the onset, envelope, peak and crossing followers
+ * over a recording one sample at a time and in blocks of
+ * an awkward size, check they agree, then compare the
+ * time each way */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* What the block forms fold the channels of a frame into */
+static lpfloat_t loudest(lpbuffer_t * src, size_t i) {
+    lpfloat_t out = 0;
+    int c;
+    for(c=0; c < src->channels; c++) out = lpfmax(out, fabs(src->data[i * src->channels + c]));
+    return out;
+}
+
+static lpfloat_t highest(lpbuffer_t * src, size_t i) {
+    lpfloat_t out = src->data[i * src->channels];
+    int c;
+    for(c=1; c < src->channels; c++) out = lpfmax(out, src->data[i * src->channels + c]);
+    return out;
+}
+
+/* Compare sparse event arrays and decimated value arrays */
+static int compare_events(const char * name, size_t * a, size_t na, size_t * b, size_t nb) {
+    size_t i;
+    int failed = na != nb;
+    for(i=0; i < na && i < nb; i++) failed |= a[i] != b[i];
+    printf("%s: %d per sample, %d in blocks%s\n", name, (int)na, (int)nb, failed ? " MISMATCH" : "");
+    return failed;
+}
+
+static int compare_values(const char * name, lpfloat_t * a, size_t na, lpfloat_t * b, size_t nb) {
+    size_t i;
+    int failed = na != nb;
+    for(i=0; i < na && i < nb; i++) failed |= a[i] != b[i];
+    printf("%s: %d per sample, %d in blocks%s\n", name, (int)na, (int)nb, failed ? " MISMATCH" : "");
+    return failed;
+}
+
+int main() {
+    size_t onsets[2][MAXEVENTS], crossings[2][MAXEVENTS];
+    lpfloat_t envs[2][MAXEVENTS], peaks[2][MAXEVENTS];
+    size_t numonsets[2] = {0}, numcrossings[2] = {0}, numenvs[2] = {0}, numpeaks[2] = {0};
+    lpcoyote_t * od;
+    lpenvelopefollower_t * env;
+    lppeakfollower_t * peak;
+    lpcrossingfollower_t * cross;
+    lpbuffer_t * src;
+    double sampletime, blocktime;
+    size_t i, pos, n;
+    clock_t start;
+    int lastflag, failed = 0;
+
+    src = LPSoundFile.read("../docs/tutorials/renders/002-a-hat-pattern.flac");
+
+    /* One sample at a time */
+    od = LPOnsetDetector.coyote_create(src->samplerate);
+    env = LPEnvelopeFollower.create(INTERVAL);
+    peak = LPPeakFollower.create(INTERVAL);
+    cross = LPCrossingFollower.create();
+
+    start = clock();
+    for(i=0; i < src->length; i++) {
+        if(LPOnsetDetector.coyote_process(od, loudest(src, i)) && numonsets[0] < MAXEVENTS) {
+            onsets[0][numonsets[0]++] = i;
+        }
+
+        LPEnvelopeFollower.process(env, loudest(src, i));
+        if(env->phase < 1 && numenvs[0] < MAXEVENTS) envs[0][numenvs[0]++] = env->value;
+
+        LPPeakFollower.process(peak, highest(src, i));
+        if(peak->change && numpeaks[0] < MAXEVENTS) peaks[0][numpeaks[0]++] = peak->value;
+
+        LPCrossingFollower.process(cross, src->data[i * src->channels]);
+        if(cross->ws_transition && numcrossings[0] < MAXEVENTS) crossings[0][numcrossings[0]++] = i;
+    }
+    sampletime = elapsed(start);
+    lastflag = cross->ws_transition;
+
+    LPOnsetDetector.coyote_destory(od);
+    LPEnvelopeFollower.destroy(env);
+    LPPeakFollower.destroy(peak);
+    LPCrossingFollower.destroy(cross);
+
+    /* In blocks */
+    od = LPOnsetDetector.coyote_create(src->samplerate);
+    env = LPEnvelopeFollower.create(INTERVAL);
+    peak = LPPeakFollower.create(INTERVAL);
+    cross = LPCrossingFollower.create();
+
+    start = clock();
+    for(pos=0; pos < src->length; pos += n) {
+        size_t found, j;
+
+        n = src->length - pos;
+        if(n > 1001) n = 1001;
+
+        found = LPOnsetDetector.coyote_process_block(od, src->data + pos * src->channels, src->channels, n, onsets[1] + numonsets[1], MAXEVENTS - numonsets[1]);
+        for(j=0; j < found; j++) onsets[1][numonsets[1] + j] += pos;
+        numonsets[1] += found;
+
+        numenvs[1] += LPEnvelopeFollower.process_block(env, src->data + pos * src->channels, src->channels, n, envs[1] + numenvs[1], MAXEVENTS - numenvs[1]);
+        numpeaks[1] += LPPeakFollower.process_block(peak, src->data + pos * src->channels, src->channels, n, peaks[1] + numpeaks[1], MAXEVENTS - numpeaks[1]);
+
+        found = LPCrossingFollower.process_block(cross, src->data + pos * src->channels, src->channels, 0, n, crossings[1] + numcrossings[1], MAXEVENTS - numcrossings[1]);
+        for(j=0; j < found; j++) crossings[1][numcrossings[1] + j] += pos;
+        numcrossings[1] += found;
+    }
+    blocktime = elapsed(start);
+
+    /* The last frame leaves the same flags behind */
+    failed |= cross->ws_transition != lastflag;
+
+    LPOnsetDetector.coyote_destory(od);
+    LPEnvelopeFollower.destroy(env);
+    LPPeakFollower.destroy(peak);
+    LPCrossingFollower.destroy(cross);
+
+    failed |= compare_events("onsets", onsets[0], numonsets[0], onsets[1], numonsets[1]);
+    failed |= compare_values("envelope", envs[0], numenvs[0], envs[1], numenvs[1]);
+    failed |= compare_values("peaks", peaks[0], numpeaks[0], peaks[1], numpeaks[1]);
+    failed |= compare_events("waveset transitions", crossings[0], numcrossings[0], crossings[1], numcrossings[1]);
+    failed |= numonsets[0] == 0 || numenvs[0] == 0;
+
+    printf("%.1f seconds of audio: per sample %.1f ms, blocks %.1f ms\n", (double)src->length / src->samplerate, sampletime * 1000, blocktime * 1000);
+
+    LPBuffer.destroy(src);
+
+    return failed;
+}
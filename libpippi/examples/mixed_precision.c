@@ -0,0 +1,41 @@
+#include "pippi.h"
+
+#define SR 48000
+#define LENGTH SR
+
+/* Links the float32 and double variants of libpippi
+ * into one program and checks they agree. The float32
+ * half lives in mixed_precision_f32.c */
+
+size_t render_sine_f32(float * out, size_t length, int samplerate, float freq);
+
+int main() {
+    float * single;
+    lpsineosc_t * osc;
+    lpfloat_t sample, diff, maxdiff = 0;
+    size_t i, singlesize;
+    int failed = 0;
+
+    single = (float *)LPMemoryPool.alloc(LENGTH, sizeof(float));
+    singlesize = render_sine_f32(single, LENGTH, SR, 220.f);
+
+    osc = LPSineOsc.create();
+    osc->samplerate = SR;
+    osc->freq = 220.f;
+
+    for(i=0; i < LENGTH; i++) {
+        sample = LPSineOsc.process(osc);
+        diff = fabs(sample - single[i]);
+        if(diff > maxdiff) maxdiff = diff;
+    }
+
+    printf("%d byte and %d byte samples: max diff %g\n", (int)singlesize, (int)sizeof(lpfloat_t), (double)maxdiff);
+    failed |= singlesize != sizeof(float) || sizeof(lpfloat_t) != sizeof(double);
+    /* The float32 phase drifts a little over a second */
+    failed |= maxdiff > 1e-2;
+
+    LPSineOsc.destroy(osc);
+    LPMemoryPool.free(single);
+
+    return failed;
+}
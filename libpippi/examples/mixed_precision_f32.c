@@ -0,0 +1,23 @@
+#include "pippi.h"
+
+/* Built with LP_FLOAT32: everything here is the single
+ * precision variant of libpippi, so only plain float
+ * pointers cross over to the double precision side in
+ * mixed_precision.c */
+
+size_t render_sine_f32(float * out, size_t length, int samplerate, float freq) {
+    lpsineosc_t * osc;
+    size_t i;
+
+    osc = LPSineOsc.create();
+    osc->samplerate = samplerate;
+    osc->freq = freq;
+
+    for(i=0; i < length; i++) {
+        out[i] = LPSineOsc.process(osc);
+    }
+
+    LPSineOsc.destroy(osc);
+
+    return sizeof(lpfloat_t);
+}
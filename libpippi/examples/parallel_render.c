@@ -0,0 +1,206 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define WORKERS 4
+#define NUMJOBS 1000
+
+/* Check that jobs run after the jobs they depend on,
+ * that parallel_for covers its range once, nested in
+ * a job too, and that workers get scratch space. Then
+ * check the parallel versions of convolve, resample,
+ * varispeed and formation renders come out the same
+ * as the serial ones, bit for bit. */
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static lpbuffer_t * noise(size_t length, int channels, lpfloat_t decay) {
+    lpbuffer_t * buf;
+    size_t i;
+    int c;
+
+    buf = LPBuffer.create(length, channels, SR);
+    for(i=0; i < length; i++) {
+        for(c=0; c < channels; c++) {
+            buf->data[i * channels + c] = LPRand.rand(-1.f, 1.f) * pow(1.f - (lpfloat_t)i / length, decay);
+        }
+    }
+    return buf;
+}
+
+static int compare(const char * name, lpbuffer_t * serial, lpbuffer_t * parallel, double serialtime, double paralleltime) {
+    int same;
+
+    same = serial != NULL && parallel != NULL && serial->length == parallel->length && serial->channels == parallel->channels
+        && memcmp(serial->data, parallel->data, sizeof(lpfloat_t) * serial->length * serial->channels) == 0;
+    printf("%s: %s, serial %.1f ms, parallel %.1f ms\n", name, same ? "identical" : "DIFFERENT", serialtime * 1000, paralleltime * 1000);
+
+    return !same;
+}
+
+/* Each job stamps the order it ran in */
+typedef struct stamp_t {
+    int * counter;
+    int order;
+} stamp_t;
+
+static void stamp(void * arg) {
+    stamp_t * s = (stamp_t *)arg;
+    s->order = __atomic_fetch_add(s->counter, 1, __ATOMIC_ACQ_REL);
+}
+
+static void count_range(void * arg, size_t start, size_t end) {
+    int * hits = (int *)arg;
+    size_t i;
+    for(i=start; i < end; i++) hits[i] += 1;
+}
+
+typedef struct nested_t {
+    lpjobs_t * jobs;
+    int * hits;
+    int worker;
+    int scratchok;
+} nested_t;
+
+/* A job which splits itself up and waits on the parts */
+static void nested(void * arg) {
+    nested_t * n = (nested_t *)arg;
+    lpfloat_t * scratch;
+
+    n->worker = LPJobs.worker();
+    scratch = (lpfloat_t *)LPJobs.scratch(4096, sizeof(lpfloat_t));
+    n->scratchok = scratch != NULL && scratch[4095] == 0;
+    LPJobs.parallel_for(n->jobs, 0, NUMJOBS, 7, count_range, n->hits);
+}
+
+static lpformation_t * formation(lpbuffer_t * src) {
+    lpformation_t * f;
+
+    f = LPFormation.create(WIN_HANN, 8, 4800, src->length, CHANNELS, SR, NULL, 256);
+    LPRingBuffer.write(f->rb, src);
+    f->grainlength_maxjitter = 2400;
+    f->grainlength_jitter = 0.5f;
+    f->spread = 0.8f;
+    f->speed = 1.5f;
+    f->graininterval = 700;
+
+    return f;
+}
+
+int main() {
+    lpjobs_t * jobs;
+    lpjob_t * tasks[4];
+    stamp_t stamps[4];
+    nested_t n;
+    lpbuffer_t * src, * impulse, * mono, * speed, * serial, * parallel;
+    lpformation_t * f;
+    double start, serialtime;
+    int i, counter, * hits, failed = 0;
+
+    jobs = LPJobs.create(WORKERS, 0);
+    if(jobs == NULL) return 1;
+
+    /* A diamond: 0 before 1 and 2, both before 3 */
+    counter = 0;
+    for(i=0; i < 4; i++) {
+        stamps[i].counter = &counter;
+        tasks[i] = LPJobs.task(stamp, &stamps[i]);
+    }
+    LPJobs.depend(tasks[1], tasks[0]);
+    LPJobs.depend(tasks[2], tasks[0]);
+    LPJobs.depend(tasks[3], tasks[1]);
+    LPJobs.depend(tasks[3], tasks[2]);
+    for(i=3; i >= 0; i--) LPJobs.submit(jobs, tasks[i]);
+    for(i=0; i < 4; i++) LPJobs.wait(jobs, tasks[i]);
+    failed |= stamps[0].order != 0 || stamps[3].order != 3;
+    printf("dependencies: ran in order %d %d %d %d\n", stamps[0].order, stamps[1].order, stamps[2].order, stamps[3].order);
+
+    /* Every index once, from here and from inside a job */
+    hits = (int *)LPMemoryPool.alloc(NUMJOBS, sizeof(int));
+    LPJobs.parallel_for(jobs, 0, NUMJOBS, 0, count_range, hits);
+
+    n.jobs = jobs;
+    n.hits = hits;
+    tasks[0] = LPJobs.task(nested, &n);
+    LPJobs.submit(jobs, tasks[0]);
+    LPJobs.wait(jobs, tasks[0]);
+
+    for(i=0; i < NUMJOBS; i++) failed |= hits[i] != 2;
+    failed |= n.worker < 0 || n.worker >= WORKERS || !n.scratchok;
+    failed |= LPJobs.worker() != -1 || LPJobs.scratch(1, 1) != NULL;
+    printf("parallel_for: %s, nested on worker %d\n", failed ? "FAILED" : "ok", n.worker);
+    LPMemoryPool.free(hits);
+
+    LPRand.seed(1);
+    src = noise(SR * 3, CHANNELS, 0);
+    impulse = noise(SR, CHANNELS, 4);
+    mono = noise(SR / 2, 1, 2);
+
+    start = now();
+    serial = LPConvolver.convolve(src, impulse);
+    serialtime = now() - start;
+    start = now();
+    parallel = LPConvolver.convolve_parallel(src, impulse, jobs);
+    failed |= compare("convolve", serial, parallel, serialtime, now() - start);
+    LPBuffer.destroy(serial);
+    LPBuffer.destroy(parallel);
+
+    serial = LPConvolver.convolve(src, mono);
+    parallel = LPConvolver.convolve_parallel(src, mono, jobs);
+    failed |= compare("convolve with a mono impulse", serial, parallel, 0, 0);
+    LPBuffer.destroy(serial);
+    LPBuffer.destroy(parallel);
+
+    start = now();
+    serial = LPResampler.resample(src, 48000.0 / 44100.0, LPRESAMPLER_BEST);
+    serialtime = now() - start;
+    start = now();
+    parallel = LPResampler.resample_parallel(src, 48000.0 / 44100.0, LPRESAMPLER_BEST, jobs);
+    failed |= compare("resample", serial, parallel, serialtime, now() - start);
+    LPBuffer.destroy(serial);
+    LPBuffer.destroy(parallel);
+
+    speed = LPWindow.create(WIN_SINE, 4096);
+    LPBuffer.scale(speed, 0, 1, 0.5f, 1.5f);
+    start = now();
+    serial = LPResampler.varispeed(src, speed, LPRESAMPLER_MEDIUM);
+    serialtime = now() - start;
+    start = now();
+    parallel = LPResampler.varispeed_parallel(src, speed, LPRESAMPLER_MEDIUM, jobs);
+    failed |= compare("varispeed", serial, parallel, serialtime, now() - start);
+    LPBuffer.destroy(serial);
+    LPBuffer.destroy(parallel);
+    LPBuffer.destroy(speed);
+
+    /* The same grains either way, jitter and all */
+    f = formation(src);
+    LPRand.seed(2);
+    start = now();
+    serial = LPFormation.render(f, SR * 3);
+    serialtime = now() - start;
+    LPFormation.destroy(f);
+
+    f = formation(src);
+    LPRand.seed(2);
+    start = now();
+    parallel = LPFormation.render_parallel(f, SR * 3, jobs);
+    failed |= compare("formation", serial, parallel, serialtime, now() - start);
+    failed |= LPBuffer.mag(parallel) == 0;
+    LPFormation.destroy(f);
+
+    LPSoundFile.write("renders/parallel_render-out.wav", parallel);
+
+    LPBuffer.destroy(serial);
+    LPBuffer.destroy(parallel);
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(impulse);
+    LPBuffer.destroy(mono);
+    LPJobs.destroy(jobs);
+
+    return failed;
+}
@@ -0,0 +1,168 @@
+#include <time.h>
+#include <pthread.h>
+#include "pippi.h"
+
+#define NUMTHREADS 4
+#define NUMDRAWS 1000
+#define NUMFILL 1000003
+#define NUMCHOICES 10
+
+/* Check that seeding LPRand repeats, that each thread
+ * gets its own stream of the default generator, that
+ * split and jump hand out the streams they should, and
+ * that the bulk fills have the right shape. Then compare
+ * drawing numbers one at a time with filling a buffer. */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+typedef struct worker_t {
+    lpfloat_t draws[NUMDRAWS];
+} worker_t;
+
+static void * draw(void * arg) {
+    worker_t * worker = (worker_t *)arg;
+    int i;
+    for(i=0; i < NUMDRAWS; i++) worker->draws[i] = LPRand.rand(0, 1);
+    return NULL;
+}
+
+/* The stream the default generator of the nth thread
+ * to draw after LPRand.seed(seed) should be on */
+static lprng_t * nth_stream(int seed, int n) {
+    lprng_t * rng;
+    rng = LPRand.create((uint64_t)seed);
+    while(n-- > 0) LPRand.jump(rng);
+    return rng;
+}
+
+int main() {
+    worker_t workers[NUMTHREADS];
+    pthread_t threads[NUMTHREADS];
+    lpfloat_t a[16], b[16], * out;
+    lpfloat_t mean, var, sum;
+    lprng_t * rng, * other, * child, * children[2];
+    size_t counts[NUMCHOICES] = {0};
+    int * choices, i, j, k, found, failed = 0;
+    double onetime, filltime;
+    clock_t start;
+
+    /* Seeding repeats */
+    LPRand.seed(3);
+    for(i=0; i < 16; i++) a[i] = LPRand.rand(0, 1);
+    LPRand.seed(3);
+    for(i=0; i < 16; i++) b[i] = LPRand.rand(0, 1);
+    for(i=0; i < 16; i++) failed |= a[i] != b[i];
+    printf("seed: %s\n", memcmp(a, b, sizeof(a)) == 0 ? "repeats" : "MISMATCH");
+
+    /* The seeding thread is on the first stream */
+    rng = nth_stream(3, 0);
+    for(i=0; i < 16; i++) failed |= a[i] != LPRand.uniform(rng, 0, 1);
+    LPRand.destroy(rng);
+
+    /* Every other thread is on one of the next ones */
+    LPRand.seed(5);
+    LPRand.rand(0, 1);
+    for(i=0; i < NUMTHREADS; i++) pthread_create(&threads[i], NULL, draw, &workers[i]);
+    for(i=0; i < NUMTHREADS; i++) pthread_join(threads[i], NULL);
+
+    for(k=1; k <= NUMTHREADS; k++) {
+        rng = nth_stream(5, k);
+        found = 0;
+        for(i=0; i < NUMTHREADS; i++) {
+            for(j=0; j < NUMDRAWS; j++) {
+                if(workers[i].draws[j] != LPRand.uniform(rng, 0, 1)) break;
+            }
+            found += j == NUMDRAWS;
+            LPRand.destroy(rng);
+            rng = nth_stream(5, k);
+        }
+        printf("threads: stream %d drawn by %d thread\n", k, found);
+        failed |= found != 1;
+        LPRand.destroy(rng);
+    }
+
+    /* Splitting hands out the stream it was on and jumps */
+    rng = LPRand.create(1);
+    children[0] = LPRand.split(rng);
+    children[1] = LPRand.split(rng);
+    for(i=0; i < 2; i++) {
+        child = nth_stream(1, i);
+        for(j=0; j < 100; j++) failed |= LPRand.next(children[i]) != LPRand.next(child);
+        LPRand.destroy(child);
+        LPRand.destroy(children[i]);
+    }
+    child = nth_stream(1, 2);
+    failed |= LPRand.next(rng) != LPRand.next(child);
+    LPRand.destroy(child);
+    LPRand.destroy(rng);
+
+    /* Fills repeat on the same seed, and stay in range */
+    out = (lpfloat_t *)LPMemoryPool.alloc(NUMFILL + 1, sizeof(lpfloat_t));
+    rng = LPRand.create(99);
+    other = LPRand.create(99);
+    for(i=1; i < 40; i += 3) {
+        LPRand.fill_uniform(rng, a, i % 16, -2, 3);
+        LPRand.fill_uniform(other, b, i % 16, -2, 3);
+        for(j=0; j < i % 16; j++) failed |= a[j] != b[j] || a[j] < -2 || a[j] >= 3;
+    }
+    LPRand.destroy(other);
+
+    out[NUMFILL] = 1234;
+    LPRand.fill_uniform(rng, out, NUMFILL, 0, 1);
+    sum = 0;
+    for(i=0; i < NUMFILL; i++) sum += out[i];
+    mean = sum / NUMFILL;
+    sum = 0;
+    for(i=0; i < NUMFILL; i++) sum += (out[i] - mean) * (out[i] - mean);
+    var = sum / NUMFILL;
+    printf("uniform: mean %.4f, variance %.4f\n", (double)mean, (double)var);
+    failed |= fabs(mean - 0.5) > 0.005 || fabs(var - 1.0/12) > 0.002;
+    failed |= out[NUMFILL] != 1234;
+
+    LPRand.fill_gaussian(rng, out, NUMFILL, 1, 2);
+    sum = 0;
+    for(i=0; i < NUMFILL; i++) sum += out[i];
+    mean = sum / NUMFILL;
+    sum = 0;
+    for(i=0; i < NUMFILL; i++) sum += (out[i] - mean) * (out[i] - mean);
+    var = sum / NUMFILL;
+    printf("gaussian: mean %.4f, stddev %.4f\n", (double)mean, sqrt((double)var));
+    failed |= fabs(mean - 1) > 0.01 || fabs(sqrt(var) - 2) > 0.01;
+    failed |= out[NUMFILL] != 1234;
+
+    /* The single draw gaussian has the same shape */
+    sum = 0;
+    for(i=0; i < 100001; i++) sum += LPRand.gaussian(rng, 0, 1);
+    failed |= fabs(sum / 100001) > 0.02;
+
+    choices = (int *)LPMemoryPool.alloc(NUMFILL, sizeof(int));
+    LPRand.fill_choice(rng, choices, NUMFILL, NUMCHOICES);
+    for(i=0; i < NUMFILL; i++) {
+        failed |= choices[i] < 0 || choices[i] >= NUMCHOICES;
+        if(choices[i] >= 0 && choices[i] < NUMCHOICES) counts[choices[i]] += 1;
+    }
+    printf("choice:");
+    for(i=0; i < NUMCHOICES; i++) {
+        printf(" %d", (int)counts[i]);
+        failed |= fabs((double)counts[i] / NUMFILL - 1.0 / NUMCHOICES) > 0.002;
+    }
+    printf("\n");
+
+    /* One at a time through rand_base against filling */
+    start = clock();
+    for(i=0; i < NUMFILL; i++) out[i] = LPRand.rand(0, 1);
+    onetime = elapsed(start);
+
+    start = clock();
+    LPRand.fill_uniform(rng, out, NUMFILL, 0, 1);
+    filltime = elapsed(start);
+    printf("%d numbers: one at a time %.1f ms, filled %.1f ms\n", NUMFILL, onetime * 1000, filltime * 1000);
+
+    LPRand.destroy(rng);
+    LPMemoryPool.free(out);
+    LPMemoryPool.free(choices);
+
+    return failed;
+}
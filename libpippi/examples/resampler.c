@@ -0,0 +1,203 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define EDGE 2000
+
+/* Measure how well each quality of LPResampler keeps a
+ * tone above the new nyquist from aliasing, and how
+ * close a tone in the passband comes out to the ideal
+ * one, on both the polyphase and the variable ratio
+ * paths. Check streaming in odd sized chunks against
+ * the offline conversion, then compare throughput with
+ * the linear interpolation in LPBuffer.resample. */
+
+static const char * names[] = { "fast", "medium", "best" };
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static lpbuffer_t * tone(lpfloat_t freq, int samplerate, size_t length, int channels) {
+    lpbuffer_t * out;
+    size_t i;
+    int c;
+
+    out = LPBuffer.create(length, channels, samplerate);
+    for(i=0; i < length; i++) {
+        for(c=0; c < channels; c++) {
+            out->data[i * channels + c] = sin(2 * M_PI * freq * i / samplerate + c);
+        }
+    }
+
+    return out;
+}
+
+static double todb(double rms) {
+    return 20 * log10(rms / sqrt(0.5) + 1e-30);
+}
+
+/* Level of whatever is left of a tone that should have
+ * been filtered out, away from the edges */
+static double residual_db(lpbuffer_t * buf) {
+    double sum = 0;
+    size_t i;
+
+    for(i=EDGE; i < buf->length - EDGE; i++) sum += buf->data[i * buf->channels] * buf->data[i * buf->channels];
+    return todb(sqrt(sum / (buf->length - EDGE * 2)));
+}
+
+/* Level of the difference from the tone at freq the
+ * input would have been if recorded at the new rate.
+ * Input frame i is at output frame i * ratio. */
+static double error_db(lpbuffer_t * buf, lpfloat_t freq, double ratio, int samplerate) {
+    double sum = 0, expected, diff;
+    size_t i;
+
+    for(i=EDGE; i < buf->length - EDGE; i++) {
+        expected = sin(2 * M_PI * freq * (i / ratio) / samplerate);
+        diff = buf->data[i * buf->channels] - expected;
+        sum += diff * diff;
+    }
+    return todb(sqrt(sum / (buf->length - EDGE * 2)));
+}
+
+static lpfloat_t maxdiff(lpbuffer_t * a, lpbuffer_t * b, size_t length) {
+    lpfloat_t diff, out = 0;
+    size_t i;
+
+    for(i=0; i < length * a->channels; i++) {
+        diff = fabs(a->data[i] - b->data[i]);
+        if(diff > out) out = diff;
+    }
+    return out;
+}
+
+int main() {
+    /* Expected rejection and passband error in dB. The
+     * float32 build runs out of precision on the best. */
+    double limits[] = { -55, -80, sizeof(lpfloat_t) == sizeof(double) ? -105 : -100 };
+    double ratios[] = { 44100.0 / 48000.0, 0.9187 };
+    const char * paths[] = { "polyphase", "variable" };
+    lpbuffer_t * high, * low, * stereo, * out, * offline, * streamed, * speed;
+    lpresampler_t * rs;
+    double db, t, ratio;
+    size_t pos, written, n, want, length;
+    int q, r, failed = 0;
+
+    high = tone(23000, SR, SR, 1);
+    low = tone(1000, SR, SR, 1);
+
+    for(r=0; r < 2; r++) {
+        /* As the resampler will see it: snapped to a 
+         * fraction, or rounded to lpfloat_t */
+        rs = LPResampler.create(ratios[r], 1, LPRESAMPLER_FAST);
+        ratio = (rs->bank != NULL) ? (double)rs->numphases / rs->step : (double)rs->ratio;
+        LPResampler.destroy(rs);
+
+        for(q=0; q < NUM_LPRESAMPLER_QUALITIES; q++) {
+            out = LPResampler.resample(high, ratio, q);
+            db = residual_db(out);
+            printf("%s %s: 23kHz at %.4f rejected by %.1f dB\n", paths[r], names[q], ratio, -db);
+            failed |= db > limits[q];
+            LPBuffer.destroy(out);
+
+            out = LPResampler.resample(low, ratio, q);
+            db = error_db(out, 1000, ratio, SR);
+            printf("%s %s: 1kHz error %.1f dB\n", paths[r], names[q], db);
+            failed |= db > limits[q];
+            LPBuffer.destroy(out);
+        }
+    }
+
+    out = LPBuffer.resample(high, (size_t)(high->length * ratios[0]));
+    printf("linear: 23kHz rejected by %.1f dB\n", -residual_db(out));
+    LPBuffer.destroy(out);
+
+    /* Upsampling keeps a 15kHz tone intact */
+    LPBuffer.destroy(low);
+    low = tone(15000, 44100, 44100, 1);
+    out = LPResampler.resample(low, 48000.0 / 44100.0, LPRESAMPLER_MEDIUM);
+    db = error_db(out, 15000, 48000.0 / 44100.0, 44100);
+    printf("44.1kHz to 48kHz: 15kHz error %.1f dB\n", db);
+    failed |= db > limits[LPRESAMPLER_MEDIUM];
+    LPBuffer.destroy(out);
+
+    /* Streaming in odd sized chunks gets the same frames */
+    stereo = tone(440, SR, SR / 2, 2);
+    for(r=0; r < 2; r++) {
+        offline = LPResampler.resample(stereo, ratios[r], LPRESAMPLER_MEDIUM);
+        streamed = LPBuffer.create(offline->length, 2, SR);
+        rs = LPResampler.create(ratios[r], 2, LPRESAMPLER_MEDIUM);
+        failed |= (rs->bank == NULL) != (r == 1);
+
+        LPRand.seed(r + 1);
+        pos = 0;
+        written = 0;
+        while(pos < stereo->length && written < offline->length) {
+            n = LPRand.randint(1, 700);
+            if(n > stereo->length - pos) n = stereo->length - pos;
+            want = LPRand.randint(1, 500);
+            if(want > offline->length - written) want = offline->length - written;
+            written += LPResampler.process(rs, stereo->data + pos * 2, &n, streamed->data + written * 2, want);
+            pos += n;
+        }
+
+        /* Take whatever is left in the history */
+        n = 0;
+        written += LPResampler.process(rs, stereo->data, &n, streamed->data + written * 2, offline->length - written);
+
+        printf("%s streaming: %d of %d frames, max diff %g\n", paths[r], (int)written, (int)offline->length, (double)maxdiff(offline, streamed, written));
+        failed |= maxdiff(offline, streamed, written) > 0;
+        failed |= written + rs->half + LPRESAMPLER_LANES < offline->length;
+
+        LPResampler.destroy(rs);
+        LPBuffer.destroy(offline);
+        LPBuffer.destroy(streamed);
+    }
+
+    /* A constant speed of 2 is the same as halving */
+    speed = LPParam.from_float(2.f);
+    offline = LPResampler.resample(stereo, 0.5, LPRESAMPLER_MEDIUM);
+    out = LPResampler.varispeed(stereo, speed, LPRESAMPLER_MEDIUM);
+    length = (out->length < offline->length) ? out->length : offline->length;
+    printf("varispeed at 2: %d frames, resampled %d frames, max diff %g\n", (int)out->length, (int)offline->length, (double)maxdiff(out, offline, length));
+    failed |= labs((long)out->length - (long)offline->length) > 1;
+    failed |= maxdiff(out, offline, length) > 0;
+    LPBuffer.destroy(out);
+    LPBuffer.destroy(offline);
+    LPBuffer.destroy(speed);
+
+    /* Sweeping from half speed to double speed */
+    speed = LPWindow.create(WIN_RSAW, 4096);
+    LPBuffer.scale(speed, 0, 1, 0.5f, 2.f);
+    out = LPResampler.varispeed(stereo, speed, LPRESAMPLER_FAST);
+    printf("varispeed sweep: %d frames from %d\n", (int)out->length, (int)stereo->length);
+    failed |= out->length < stereo->length / 2 || out->length > stereo->length * 2;
+    LPBuffer.destroy(out);
+    LPBuffer.destroy(speed);
+
+    /* Throughput on a 10 second stereo file */
+    LPBuffer.destroy(stereo);
+    stereo = tone(440, SR, SR * 10, 2);
+
+    t = clock();
+    out = LPBuffer.resample(stereo, (size_t)(stereo->length * ratios[0]));
+    printf("linear: %.1fx realtime\n", 10 / elapsed(t));
+    LPBuffer.destroy(out);
+
+    for(r=0; r < 2; r++) {
+        for(q=0; q < NUM_LPRESAMPLER_QUALITIES; q++) {
+            t = clock();
+            out = LPResampler.resample(stereo, ratios[r], q);
+            printf("%s %s: %.1fx realtime\n", paths[r], names[q], 10 / elapsed(t));
+            LPBuffer.destroy(out);
+        }
+    }
+
+    LPBuffer.destroy(stereo);
+    LPBuffer.destroy(high);
+    LPBuffer.destroy(low);
+
+    return failed;
+}
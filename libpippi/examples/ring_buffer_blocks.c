@@ -0,0 +1,245 @@
+#include <time.h>
+#include <pthread.h>
+#include "pippi.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define BLOCKSIZE 333
+#define HANDOFF 2000000
+
+/* Check the block ring buffer ops against a plain frame
+ * at a time ring, including writes across the wrap and
+ * longer than the ring, then fractional taps, then pass
+ * a counting signal between two threads through an SPSC
+ * ring and make sure it all arrives in order, and that
+ * formation grains only hear the latest pass written to
+ * a ring with room to spare. Finally
+ * compare the time to run a delay line through the ring
+ * a frame at a time and in blocks. */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static lpfloat_t ramp(size_t i, int c) {
+    return (lpfloat_t)(i % 9973) + c * 0.5f;
+}
+
+/* What the ring should hold, written a frame at a time */
+typedef struct reference_t {
+    lpfloat_t * data;
+    size_t length;
+    size_t pos;
+} reference_t;
+
+static void reference_write(reference_t * ref, lpbuffer_t * src, int dub) {
+    size_t i;
+    int c;
+    for(i=0; i < src->length; i++) {
+        for(c=0; c < CHANNELS; c++) {
+            if(dub) {
+                ref->data[ref->pos * CHANNELS + c] += src->data[i * src->channels + (c % src->channels)];
+            } else {
+                ref->data[ref->pos * CHANNELS + c] = src->data[i * src->channels + (c % src->channels)];
+            }
+        }
+        ref->pos = (ref->pos + 1) % ref->length;
+    }
+}
+
+static int compare(const char * name, lpbuffer_t * ringbuf, reference_t * ref) {
+    size_t i;
+    int failed = ringbuf->pos != ref->pos;
+    for(i=0; i < ref->length * CHANNELS; i++) failed |= ringbuf->data[i] != ref->data[i];
+    printf("%s: %s\n", name, failed ? "MISMATCH" : "ok");
+    return failed;
+}
+
+static lpbuffer_t * ramp_buffer(size_t length, int channels, size_t offset) {
+    lpbuffer_t * out;
+    size_t i;
+    int c;
+    out = LPBuffer.create(length, channels, SR);
+    for(i=0; i < length; i++) {
+        for(c=0; c < channels; c++) out->data[i * channels + c] = ramp(i + offset, c);
+    }
+    return out;
+}
+
+static void * produce(void * arg) {
+    lpspscring_t * ring = (lpspscring_t *)arg;
+    lpfloat_t block[BLOCKSIZE * CHANNELS];
+    size_t sent = 0, n, i, count;
+
+    while(sent < HANDOFF) {
+        count = HANDOFF - sent;
+        if(count > BLOCKSIZE) count = BLOCKSIZE;
+        for(i=0; i < count; i++) {
+            block[i * CHANNELS] = ramp(sent + i, 0);
+            block[i * CHANNELS + 1] = ramp(sent + i, 1);
+        }
+        n = 0;
+        while(n < count) n += LPSPSCRing.write(ring, block + n * CHANNELS, count - n);
+        sent += count;
+    }
+
+    return NULL;
+}
+
+int main() {
+    lpbuffer_t * ringbuf, * src, * mono, * out;
+    lpspscring_t * ring;
+    lpformation_t * formation;
+    reference_t ref;
+    lpfloat_t frame[CHANNELS], delays[BLOCKSIZE], block[BLOCKSIZE * CHANNELS];
+    lpfloat_t expected, diff, maxdiff;
+    pthread_t producer;
+    size_t i, received, n, pos;
+    int c, failed = 0;
+    double frametime, blocktime;
+    clock_t start;
+
+    /* 1000 frames asks for 1024 */
+    ringbuf = LPRingBuffer.create(1000, CHANNELS, SR);
+    printf("capacity %d for %d frames\n", (int)ringbuf->length, (int)ringbuf->range);
+    failed |= ringbuf->length != 1024 || ringbuf->range != 1000;
+
+    ref.length = ringbuf->length;
+    ref.pos = 0;
+    ref.data = (lpfloat_t *)LPMemoryPool.alloc(ref.length * CHANNELS, sizeof(lpfloat_t));
+
+    /* Writes and dubs of awkward lengths, one longer than the ring */
+    src = ramp_buffer(700, CHANNELS, 0);
+    LPRingBuffer.write(ringbuf, src);
+    reference_write(&ref, src, 0);
+    LPRingBuffer.write(ringbuf, src);
+    reference_write(&ref, src, 0);
+    failed |= compare("write across the wrap", ringbuf, &ref);
+
+    LPRingBuffer.dub(ringbuf, src);
+    reference_write(&ref, src, 1);
+    failed |= compare("dub across the wrap", ringbuf, &ref);
+    LPBuffer.destroy(src);
+
+    src = ramp_buffer(2500, CHANNELS, 17);
+    LPRingBuffer.dub(ringbuf, src);
+    reference_write(&ref, src, 1);
+    failed |= compare("dub longer than the ring", ringbuf, &ref);
+    LPBuffer.destroy(src);
+
+    mono = ramp_buffer(900, 1, 3);
+    LPRingBuffer.write(ringbuf, mono);
+    reference_write(&ref, mono, 0);
+    failed |= compare("mono into stereo", ringbuf, &ref);
+    LPBuffer.destroy(mono);
+
+    /* Reads come back from behind the write position */
+    out = LPRingBuffer.read(ringbuf, 600);
+    for(i=0; i < 600; i++) {
+        for(c=0; c < CHANNELS; c++) {
+            failed |= out->data[i * CHANNELS + c] != ref.data[((ref.pos + ref.length - 600 + i) % ref.length) * CHANNELS + c];
+        }
+    }
+    LPBuffer.destroy(out);
+
+    /* Taps: a ramp written a frame at a time reads back
+     * exactly at fractional delays */
+    for(i=0; i < 5000; i++) {
+        frame[0] = ramp(i, 0);
+        frame[1] = ramp(i, 1);
+        LPRingBuffer.writefrom(ringbuf, frame, 1, CHANNELS);
+    }
+    maxdiff = 0;
+    for(i=0; i < 100; i++) {
+        LPRingBuffer.tap(ringbuf, i * 9.25f, frame);
+        expected = ramp(4999, 0) - i * 9.25f;
+        diff = fabs(frame[0] - expected);
+        if(diff > maxdiff) maxdiff = diff;
+    }
+    printf("fractional taps: max diff %g\n", (double)maxdiff);
+    failed |= maxdiff > (sizeof(lpfloat_t) == sizeof(double) ? 1e-9 : 1e-3);
+
+    /* Block taps line up with the frames just written */
+    for(i=0; i < BLOCKSIZE; i++) {
+        block[i * CHANNELS] = ramp(5000 + i, 0);
+        block[i * CHANNELS + 1] = ramp(5000 + i, 1);
+        delays[i] = 2.5f;
+    }
+    LPRingBuffer.writefrom(ringbuf, block, BLOCKSIZE, CHANNELS);
+    LPRingBuffer.tapinto(ringbuf, delays, block, BLOCKSIZE);
+    maxdiff = 0;
+    for(i=0; i < BLOCKSIZE; i++) {
+        diff = fabs(block[i * CHANNELS + 1] - (ramp(5000 + i, 1) - 2.5f));
+        if(diff > maxdiff) maxdiff = diff;
+    }
+    printf("block taps: max diff %g\n", (double)maxdiff);
+    failed |= maxdiff > (sizeof(lpfloat_t) == sizeof(double) ? 1e-9 : 1e-3);
+    LPRingBuffer.destroy(ringbuf);
+    LPMemoryPool.free(ref.data);
+
+    /* Handing frames from one thread to another */
+    ring = LPSPSCRing.create(4096, CHANNELS, SR);
+    pthread_create(&producer, NULL, produce, ring);
+    received = 0;
+    while(received < HANDOFF) {
+        n = LPSPSCRing.read(ring, block, BLOCKSIZE);
+        for(i=0; i < n; i++) {
+            failed |= block[i * CHANNELS] != ramp(received + i, 0);
+            failed |= block[i * CHANNELS + 1] != ramp(received + i, 1);
+        }
+        received += n;
+    }
+    pthread_join(producer, NULL);
+    printf("spsc: %d frames handed over%s\n", (int)received, failed ? ", MISMATCH" : "");
+    failed |= LPSPSCRing.readable(ring) != 0 || LPSPSCRing.writable(ring) != 4096;
+    LPSPSCRing.destroy(ring);
+
+    /* A pass of ones, then one of silence over it: the grains 
+     * should hear only silence, not the ones the second pass 
+     * left in the spare 24 frames */
+    src = LPBuffer.create(1000, CHANNELS, SR);
+    for(i=0; i < src->length * CHANNELS; i++) src->data[i] = 1;
+    formation = LPFormation.create(WIN_HANN, 1, 500, 1000, CHANNELS, SR, NULL, 0);
+    LPRingBuffer.write(formation->rb, src);
+    out = LPFormation.render(formation, SR);
+    failed |= LPBuffer.mag(out) == 0;
+    LPBuffer.destroy(out);
+
+    memset(src->data, 0, sizeof(lpfloat_t) * src->length * CHANNELS);
+    LPRingBuffer.write(formation->rb, src);
+    out = LPFormation.render(formation, SR);
+    printf("formation over a second pass: mag %g\n", (double)LPBuffer.mag(out));
+    failed |= LPBuffer.mag(out) != 0;
+    LPBuffer.destroy(out);
+    LPBuffer.destroy(src);
+    LPFormation.destroy(formation);
+
+    /* A 10 second stereo delay line */
+    ringbuf = LPRingBuffer.create(SR, CHANNELS, SR);
+    start = clock();
+    for(i=0; i < SR * 10; i++) {
+        frame[0] = ramp(i, 0);
+        frame[1] = ramp(i, 1);
+        LPRingBuffer.writefrom(ringbuf, frame, 1, CHANNELS);
+        LPRingBuffer.tap(ringbuf, 12000.5f, frame);
+    }
+    frametime = elapsed(start);
+
+    for(i=0; i < BLOCKSIZE; i++) delays[i] = 12000.5f;
+    start = clock();
+    for(pos=0; pos < SR * 10; pos += n) {
+        n = SR * 10 - pos;
+        if(n > BLOCKSIZE) n = BLOCKSIZE;
+        for(i=0; i < n; i++) {
+            block[i * CHANNELS] = ramp(pos + i, 0);
+            block[i * CHANNELS + 1] = ramp(pos + i, 1);
+        }
+        LPRingBuffer.writefrom(ringbuf, block, n, CHANNELS);
+        LPRingBuffer.tapinto(ringbuf, delays, block, n);
+    }
+    blocktime = elapsed(start);
+    printf("10 second delay line: per frame %.1f ms, blocks %.1f ms\n", frametime * 1000, blocktime * 1000);
+    LPRingBuffer.destroy(ringbuf);
+
+    return failed;
+}
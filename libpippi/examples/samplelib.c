@@ -0,0 +1,62 @@
+#include <time.h>
+#include "pippi.h"
+
+/* Convert a FLAC file into a sample library file,
+ * map it and compare it with a normal decode, then
+ * compare the time to load it each way */
+
+#define LOADS 20
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main() {
+    const char * src = "../docs/tutorials/renders/001-guitar-unaltered.flac";
+    lpbuffer_t * decoded, * mapped;
+    double decodetime, maptime;
+    clock_t start;
+    size_t i;
+    int failed = 0;
+
+    decoded = LPSoundFile.read(src);
+
+    if(LPSampleLib.convert(src, "renders/samplelib-guitar.lps") < 0) return 1;
+    if((mapped = LPSampleLib.open("renders/samplelib-guitar.lps")) == NULL) return 1;
+
+    printf("mapped %d frames, %d channels at %d\n", (int)mapped->length, mapped->channels, mapped->samplerate);
+    failed |= mapped->length != decoded->length || mapped->channels != decoded->channels || mapped->samplerate != decoded->samplerate;
+    failed |= memcmp(mapped->data, decoded->data, sizeof(lpfloat_t) * decoded->length * decoded->channels) != 0;
+    failed |= LPSampleLib.verify(mapped) != 0;
+
+    /* Prefetch around an onset halfway in and play from it */
+    failed |= LPSampleLib.prefetch(mapped, mapped->length / 2, mapped->samplerate / 10) != 0;
+    failed |= LPSampleLib.prefetch(mapped, mapped->length - 10, mapped->samplerate) != 0;
+    mapped->pos = mapped->length / 2;
+    for(i=0; i < 100; i++) LPBuffer.play(mapped, 1.f);
+    LPSampleLib.close(mapped);
+
+    /* A buffer written directly round trips exactly */
+    failed |= LPSampleLib.write("renders/samplelib-direct.lps", decoded) != 0;
+    mapped = LPSampleLib.open("renders/samplelib-direct.lps");
+    failed |= mapped == NULL || LPBuffer.buffers_are_equal(mapped, decoded) == 0 || LPSampleLib.verify(mapped) != 0;
+    LPSampleLib.close(mapped);
+
+    /* Anything else is refused */
+    failed |= LPSampleLib.open(src) != NULL;
+    failed |= LPSampleLib.open("renders/does-not-exist.lps") != NULL;
+
+    start = clock();
+    for(i=0; i < LOADS; i++) LPBuffer.destroy(LPSoundFile.read(src));
+    decodetime = elapsed(start) / LOADS;
+
+    start = clock();
+    for(i=0; i < LOADS; i++) LPSampleLib.close(LPSampleLib.open("renders/samplelib-guitar.lps"));
+    maptime = elapsed(start) / LOADS;
+
+    printf("load time: decoded %.2f ms, mapped %.4f ms\n", decodetime * 1000, maptime * 1000);
+
+    LPBuffer.destroy(decoded);
+
+    return failed;
+}
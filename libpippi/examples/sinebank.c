@@ -0,0 +1,116 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define PARTIALS 200
+#define SECONDS 5
+#define NUMPHASES 1000000
+
+/* Check lpfastsin and LPSineBank against libm
+ * and time each way of rendering a bank of
+ * partials, per partial and per frame */
+
+static double db(double err) {
+    return 20 * log10(err + 1e-30);
+}
+
+static double elapsed_ns(clock_t start, size_t count) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / count;
+}
+
+int main() {
+    lpfloat_t freqs[PARTIALS], amps[PARTIALS], phases[PARTIALS];
+    lpfloat_t block[LPOSC_BLOCKSIZE];
+    lpsineosc_t * osc[PARTIALS];
+    lpsinebank_t * bank;
+    lpbuffer_t * out, * reference, * wt;
+    double phase, err, maxerr, t;
+    clock_t start;
+    size_t i, p, length;
+    int failed = 0;
+
+    LPRand.seed(5);
+    length = SECONDS * SR;
+
+    /* The polynomial alone, across a few cycles either side of zero */
+    maxerr = 0;
+    for(i=0; i <= NUMPHASES; i++) {
+        phase = -4.0 + 8.0 * i / NUMPHASES;
+        err = fabs((double)lpfastsin((lpfloat_t)phase) - sin(PI2 * (lpfloat_t)phase));
+        if(err > maxerr) maxerr = err;
+        err = fabs((double)lpfastcos((lpfloat_t)phase) - cos(PI2 * (lpfloat_t)phase));
+        if(err > maxerr) maxerr = err;
+    }
+    printf("lpfastsin max error %g (%.1f dB)\n", maxerr, db(maxerr));
+    failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -120 : -110);
+
+    /* Tables built with it */
+    wt = LPWavetable.create(WT_SINE, 4096);
+    maxerr = 0;
+    for(i=0; i < wt->length; i++) {
+        err = fabs(wt->data[i] - sin(PI2 * i / wt->length));
+        if(err > maxerr) maxerr = err;
+    }
+    printf("sine wavetable max error %g (%.1f dB)\n", maxerr, db(maxerr));
+    failed |= db(maxerr) > -120;
+
+    /* A bank of fixed partials against the same partials summed
+     * with libm, relative to the peak amplitude of the sum */
+    bank = LPSineBank.create(PARTIALS, SR);
+    for(p=0; p < PARTIALS; p++) {
+        freqs[p] = 55.f * (p+1) + LPRand.rand(-2.f, 2.f);
+        amps[p] = 1.f / PARTIALS;
+        phases[p] = LPRand.rand(0.f, 1.f);
+        LPSineBank.set_partial(bank, p, freqs[p], amps[p]);
+        LPSineBank.set_phase(bank, p, phases[p]);
+    }
+
+    start = clock();
+    out = LPSineBank.render(bank, length, 1);
+    t = elapsed_ns(start, length * PARTIALS);
+    printf("LPSineBank    %6.2f ns per partial per frame\n", t);
+
+    reference = LPBuffer.create(length, 1, SR);
+    start = clock();
+    for(p=0; p < PARTIALS; p++) {
+        for(i=0; i < length; i++) {
+            phase = phases[p] + (double)freqs[p] * i / SR;
+            reference->data[i] += amps[p] * sin(PI2 * (phase - floor(phase)));
+        }
+    }
+    t = elapsed_ns(start, length * PARTIALS);
+    printf("libm sin      %6.2f ns per partial per frame\n", t);
+
+    maxerr = 0;
+    for(i=0; i < length; i++) {
+        err = fabs(out->data[i] - reference->data[i]);
+        if(err > maxerr) maxerr = err;
+    }
+    printf("LPSineBank max error after %d seconds %g (%.1f dB)\n", SECONDS, maxerr, db(maxerr));
+    failed |= db(maxerr) > (sizeof(lpfloat_t) == sizeof(double) ? -100 : -50);
+
+    /* The same partials as individual sine oscs */
+    for(p=0; p < PARTIALS; p++) {
+        osc[p] = LPSineOsc.create();
+        osc[p]->freq = freqs[p];
+        osc[p]->phase = phases[p];
+        osc[p]->samplerate = SR;
+    }
+
+    start = clock();
+    for(i=0; i < length; i += LPOSC_BLOCKSIZE) {
+        for(p=0; p < PARTIALS; p++) {
+            LPSineOsc.process_block(osc[p], block, LPOSC_BLOCKSIZE, NULL, NULL);
+        }
+    }
+    t = elapsed_ns(start, length * PARTIALS);
+    printf("LPSineOsc     %6.2f ns per partial per frame\n", t);
+
+    for(p=0; p < PARTIALS; p++) LPSineOsc.destroy(osc[p]);
+    LPSineBank.destroy(bank);
+    LPBuffer.destroy(out);
+    LPBuffer.destroy(reference);
+    LPBuffer.destroy(wt);
+
+    return failed;
+}
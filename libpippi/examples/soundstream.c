@@ -0,0 +1,116 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define LENGTH (SR * 3)
+#define BLOCKSIZE 333
+
+/* Write a sine to WAV files at each bit depth a block
+ * at a time and read them back, then read a FLAC file
+ * with and without seeking and prefetching and check
+ * every way gives the same frames, underruns or not */
+
+static lpfloat_t maxdiff(lpfloat_t * a, lpfloat_t * b, size_t count) {
+    lpfloat_t diff, out = 0;
+    size_t i;
+    for(i=0; i < count; i++) {
+        diff = fabs(a[i] - b[i]);
+        if(diff > out) out = diff;
+    }
+    return out;
+}
+
+/* Read the whole stream in odd sized blocks. Reads
+ * from a prefetched stream come back short when the
+ * ring runs dry, so wait for it to refill and go on. */
+static size_t read_blocks(lpsoundstream_t * stream, lpbuffer_t * out) {
+    struct timespec ts = { 0, 1000000 };
+    size_t pos = 0, got, want;
+    int waits = 0;
+
+    while(pos < out->length && waits < 1000) {
+        want = (pos + BLOCKSIZE > out->length) ? out->length - pos : BLOCKSIZE;
+        got = LPSoundStream.read(stream, out->data + pos * out->channels, want);
+        pos += got;
+        if(got < want) nanosleep(&ts, NULL);
+        waits = (got == 0) ? waits + 1 : 0;
+    }
+    return pos;
+}
+
+int main() {
+    const int bitdepths[] = { 16, 24, 32 };
+    char path[64];
+    lpsoundstream_t * stream;
+    lpbuffer_t * src, * whole, * blocks, * section;
+    lpfloat_t diff, tolerance;
+    size_t i, pos, n, seekto;
+    int b, c, failed = 0;
+
+    src = LPBuffer.create(LENGTH, CHANNELS, SR);
+    for(i=0; i < LENGTH; i++) {
+        for(c=0; c < CHANNELS; c++) {
+            src->data[i * CHANNELS + c] = 0.9f * sin(PI2 * 220.f * (c+1) * i / SR);
+        }
+    }
+
+    for(b=0; b < 3; b++) {
+        snprintf(path, sizeof(path), "renders/soundstream-%d.wav", bitdepths[b]);
+        stream = LPSoundStream.create(path, CHANNELS, SR, bitdepths[b]);
+        for(pos=0; pos < LENGTH; pos += n) {
+            n = (LENGTH - pos < BLOCKSIZE) ? LENGTH - pos : BLOCKSIZE;
+            LPSoundStream.write(stream, src->data + pos * CHANNELS, n);
+        }
+        LPSoundStream.close(stream);
+
+        whole = LPSoundFile.read(path);
+        /* Rounding, plus dr_wav reads back with a scale of 2^(bits-1) */
+        tolerance = (bitdepths[b] == 16) ? 2.f / 32767 : (bitdepths[b] == 24) ? 2.f / 8388607 : 1e-7f;
+        diff = maxdiff(whole->data, src->data, LENGTH * CHANNELS);
+        printf("%d bit wav: %d frames, max error %g\n", bitdepths[b], (int)whole->length, (double)diff);
+        failed |= whole->length != LENGTH || diff > tolerance;
+        LPBuffer.destroy(whole);
+    }
+
+    /* FLAC, decoded all at once as the reference */
+    whole = LPSoundFile.read("../docs/tutorials/renders/001-guitar-unaltered.flac");
+    printf("flac: %d frames, %d channels at %d\n", (int)whole->length, whole->channels, whole->samplerate);
+
+    /* In blocks, through the prefetch thread */
+    stream = LPSoundStream.open("../docs/tutorials/renders/001-guitar-unaltered.flac");
+    blocks = LPBuffer.create(whole->length, whole->channels, whole->samplerate);
+    LPSoundStream.prefetch(stream, SR);
+    n = read_blocks(stream, blocks);
+    diff = maxdiff(whole->data, blocks->data, whole->length * whole->channels);
+    printf("flac prefetched in blocks: %d frames, max diff %g, %d underruns\n", (int)n, (double)diff, (int)stream->underruns);
+    failed |= n != whole->length || diff > 0;
+
+    /* Seek back into the middle and read a section */
+    seekto = whole->length / 3;
+    section = LPBuffer.create(SR, whole->channels, whole->samplerate);
+    failed |= LPSoundStream.seek(stream, seekto) != 0;
+    n = read_blocks(stream, section);
+    diff = maxdiff(whole->data + seekto * whole->channels, section->data, n * whole->channels);
+    printf("flac prefetched after seek: %d frames, max diff %g\n", (int)n, (double)diff);
+    failed |= n != SR || diff > 0;
+    LPSoundStream.close(stream);
+
+    /* The same without prefetching */
+    stream = LPSoundStream.open("../docs/tutorials/renders/001-guitar-unaltered.flac");
+    failed |= LPSoundStream.seek(stream, seekto) != 0;
+    n = read_blocks(stream, section);
+    diff = maxdiff(whole->data + seekto * whole->channels, section->data, n * whole->channels);
+    printf("flac after seek: %d frames, max diff %g\n", (int)n, (double)diff);
+    failed |= n != SR || diff > 0;
+    LPSoundStream.close(stream);
+
+    failed |= LPSoundStream.open("examples/does-not-exist.wav") != NULL;
+
+    LPBuffer.destroy(src);
+    LPBuffer.destroy(whole);
+    LPBuffer.destroy(blocks);
+    LPBuffer.destroy(section);
+
+    return failed;
+}
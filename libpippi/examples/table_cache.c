@@ -0,0 +1,193 @@
+#include <time.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "pippi.h"
+
+#define WTSIZE 4096
+#define NUMVOICES 200
+#define NUMCHILDREN 4
+#define NUMWORKERS 4
+
+/* Check that generated tables come out of the cache the
+ * same as they are generated, that lookups share one copy
+ * even from several threads at once, that the cache stays
+ * bounded and flush only drops what nobody holds. Then
+ * share the cache between processes through shared
+ * memory, and time building pulsar voices cold and warm. */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int same(lpfloat_t * a, lpfloat_t * b, size_t length) {
+    return memcmp(a, b, sizeof(lpfloat_t) * length) == 0;
+}
+
+/* Remove the segments shared under prefix */
+static void unlink_shared(const char * prefix) {
+    char name[NAME_MAX + 2];
+    struct dirent * entry;
+    DIR * dir;
+
+    if((dir = opendir("/dev/shm")) == NULL) return;
+    while((entry = readdir(dir)) != NULL) {
+        if(strncmp(entry->d_name, prefix, strlen(prefix)) != 0) continue;
+        snprintf(name, sizeof(name), "/%s", entry->d_name);
+        shm_unlink(name);
+    }
+    closedir(dir);
+}
+
+static int count_shared(const char * prefix) {
+    struct dirent * entry;
+    DIR * dir;
+    int count = 0;
+
+    if((dir = opendir("/dev/shm")) == NULL) return 0;
+    while((entry = readdir(dir)) != NULL) {
+        if(strncmp(entry->d_name, prefix, strlen(prefix)) == 0) count += 1;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void get_tables(void * arg, size_t start, size_t end) {
+    lpbuffer_t ** gotten = (lpbuffer_t **)arg;
+    size_t i;
+    for(i=start; i < end; i++) gotten[i] = LPTableCache.get(LPTABLE_WINDOW, WIN_HANN, WTSIZE);
+}
+
+int main() {
+    lpbuffer_t * a, * b, * table, * stack, * reference;
+    lppulsarosc_t * oscs[NUMVOICES];
+    lpbuffer_t * gotten[NUMVOICES];
+    lpjobs_t * jobs;
+    size_t onsets[3], lengths[3], count;
+    char prefix[LPTABLECACHE_PREFIXSIZE];
+    pid_t children[NUMCHILDREN];
+    double coldtime, warmtime;
+    clock_t start;
+    int i, status, failed = 0;
+
+    /* Private copies match the cached tables */
+    a = LPWavetable.create(WT_TRI, WTSIZE);
+    b = LPWavetable.create(WT_TRI, WTSIZE);
+    table = LPTableCache.get(LPTABLE_WAVETABLE, WT_TRI, WTSIZE);
+    failed |= a == table || !same(a->data, table->data, WTSIZE) || !same(a->data, b->data, WTSIZE);
+    stack = LPTableCache.get(LPTABLE_WAVETABLE, WT_TRI, WTSIZE);
+    failed |= stack != table;
+    LPBuffer.destroy(stack);
+    LPBuffer.destroy(table);
+    printf("wavetables: %s\n", failed ? "MISMATCH" : "ok");
+
+    /* Writing to a copy leaves the cache alone */
+    a->data[0] = 100;
+    LPBuffer.destroy(b);
+    b = LPWavetable.create(WT_TRI, WTSIZE);
+    failed |= b->data[0] == 100;
+    LPBuffer.destroy(a);
+    LPBuffer.destroy(b);
+
+    a = LPWindow.create(WIN_HANN, 1000);
+    table = LPTableCache.get(LPTABLE_WINDOW, WIN_HANN, 1000);
+    failed |= !same(a->data, table->data, 1000);
+    LPBuffer.destroy(a);
+
+    /* Stacks are laid out the same as the private ones */
+    reference = LPWavetable.create_stack(3, onsets, lengths, WT_SINE, 512, WT_SQUARE, 1024, WT_SAW, 300);
+    stack = LPTableCache.get_stack(LPTABLE_WAVETABLE, 3, onsets, lengths, WT_SINE, 512, WT_SQUARE, 1024, WT_SAW, 300);
+    failed |= stack->length != 1836 || onsets[2] != 1536 || lengths[2] != 300;
+    failed |= !same(stack->data, reference->data, stack->length);
+    a = LPTableCache.get_stack(LPTABLE_WAVETABLE, 3, onsets, lengths, WT_SINE, 512, WT_SQUARE, 1024, WT_SAW, 300);
+    failed |= a != stack;
+    LPBuffer.destroy(a);
+    LPBuffer.destroy(stack);
+    LPBuffer.destroy(reference);
+    printf("stacks: %s\n", failed ? "MISMATCH" : "ok");
+
+    /* Flush drops only what nobody else holds */
+    count = LPTableCache.count();
+    LPTableCache.flush();
+    printf("flush: %d tables down to %d\n", (int)count, (int)LPTableCache.count());
+    failed |= LPTableCache.count() != 1;
+    LPBuffer.destroy(table);
+    LPTableCache.flush();
+    failed |= LPTableCache.count() != 0;
+
+    /* Odd lengths aren't cached at all, and asking the cache
+     * for more lengths than it keeps evicts the oldest */
+    for(i=0; i < 100; i++) LPBuffer.destroy(LPWindow.create(WIN_SINE, 1001 + 2 * i));
+    failed |= LPTableCache.count() != 0;
+    for(i=0; i < LPTABLECACHE_MAXENTRIES * 2; i++) LPBuffer.destroy(LPTableCache.get(LPTABLE_WINDOW, WIN_SINE, 1000 + i));
+    printf("bounded: %d tables cached after %d lengths\n", (int)LPTableCache.count(), LPTABLECACHE_MAXENTRIES * 2);
+    failed |= LPTableCache.count() != LPTABLECACHE_MAXENTRIES;
+    LPTableCache.flush();
+
+    /* Threads asking at once all get the one table */
+    jobs = LPJobs.create(NUMWORKERS, 0);
+    LPJobs.parallel_for(jobs, 0, NUMVOICES, 1, get_tables, gotten);
+    LPJobs.destroy(jobs);
+    for(i=1; i < NUMVOICES; i++) failed |= gotten[i] == NULL || gotten[i] != gotten[0];
+    for(i=0; i < NUMVOICES; i++) LPBuffer.destroy(gotten[i]);
+    failed |= LPTableCache.count() != 1;
+    LPTableCache.flush();
+
+    /* Pulsar voices share their stacks */
+    start = clock();
+    oscs[0] = LPPulsarOsc.create(2, 2, WT_SINE, WTSIZE, WT_TRI2, WTSIZE, WIN_SINE, WTSIZE, WIN_HANN, WTSIZE);
+    coldtime = elapsed(start);
+
+    start = clock();
+    for(i=1; i < NUMVOICES; i++) {
+        oscs[i] = LPPulsarOsc.create(2, 2, WT_SINE, WTSIZE, WT_TRI2, WTSIZE, WIN_SINE, WTSIZE, WIN_HANN, WTSIZE);
+    }
+    warmtime = elapsed(start) / (NUMVOICES - 1);
+
+    for(i=1; i < NUMVOICES; i++) {
+        failed |= oscs[i]->wavetables != oscs[0]->wavetables || oscs[i]->windows != oscs[0]->windows;
+    }
+    printf("pulsar voice: first %.3f ms, then %.4f ms each\n", coldtime * 1000, warmtime * 1000);
+
+    for(i=0; i < NUMVOICES; i++) LPPulsarOsc.destroy(oscs[i]);
+    LPTableCache.flush();
+    failed |= LPTableCache.count() != 0;
+
+    /* Processes sharing a prefix all map one copy */
+    reference = LPWavetable.create(WT_SAW, WTSIZE);
+    LPTableCache.flush();
+
+    snprintf(prefix, sizeof(prefix), "lptablecache-%d", (int)getpid());
+    failed |= LPTableCache.share("no/slashes") != -1;
+    failed |= LPTableCache.share(prefix) != 0;
+
+    for(i=0; i < NUMCHILDREN; i++) {
+        if((children[i] = fork()) == 0) {
+            table = LPTableCache.get(LPTABLE_WAVETABLE, WT_SAW, WTSIZE);
+            stack = LPTableCache.get_stack(LPTABLE_WINDOW, 2, onsets, lengths, WIN_TRI, 2048, WIN_SINEIN, 100);
+            status = table == NULL || stack == NULL || !same(table->data, reference->data, WTSIZE);
+            _exit(status);
+        }
+    }
+
+    for(i=0; i < NUMCHILDREN; i++) {
+        waitpid(children[i], &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+
+    /* The segments are there, and this process maps them too */
+    printf("shared: %d segments for %d processes\n", count_shared(prefix), NUMCHILDREN);
+    failed |= count_shared(prefix) != 2;
+
+    table = LPTableCache.get(LPTABLE_WAVETABLE, WT_SAW, WTSIZE);
+    failed |= table == NULL || !same(table->data, reference->data, WTSIZE);
+    LPBuffer.destroy(table);
+    LPBuffer.destroy(reference);
+
+    LPTableCache.flush();
+    LPTableCache.share(NULL);
+    unlink_shared(prefix);
+
+    return failed;
+}
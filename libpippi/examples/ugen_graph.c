@@ -0,0 +1,177 @@
+#include <time.h>
+#include "pippi.h"
+#include "ugens.sine.h"
+#include "ugens.utils.h"
+
+#define SR 48000
+#define CHANNELS 2
+#define BLOCKSIZE 128
+#define SECONDS 10
+
+/* Build a small FM patch as a compiled ugen graph: an lfo
+ * modulating a sine's frequency at sample rate, and a slow
+ * sine scaling it at block rate through a mult. Check it
+ * against the same ugens run a frame at a time the way
+ * the old python graph did, check a ugen run through the
+ * frame at a time fallback matches its block form, that
+ * a feedback loop hears its source a block late, and that
+ * bad ports are refused. */
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static ugen_t * sine(lpfloat_t freq) {
+    ugen_t * u = create_sine_ugen();
+    u->set_param(u, USINEIN_FREQ, (void *)&freq);
+    return u;
+}
+
+/* Add the patch to a graph: without block forms if asked */
+static lpugengraph_t * patch(int noblocks) {
+    lpugengraph_t * graph;
+    ugen_t * u[4];
+    int i, n[4];
+
+    u[0] = sine(2);
+    u[1] = sine(440);
+    u[2] = sine(0.5);
+    u[3] = create_mult_ugen();
+
+    graph = LPUgenGraph.create(BLOCKSIZE);
+    /* Added out of order: compile sorts them */
+    for(i=3; i >= 0; i--) {
+        if(noblocks) u[i]->process_block = NULL;
+        n[i] = LPUgenGraph.add_node(graph, u[i]);
+    }
+
+    LPUgenGraph.connect(graph, n[0], USINEOUT_MAIN, n[1], USINEIN_FREQ, 100, 440, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, n[1], USINEOUT_MAIN, n[3], UMULTIN_A, 1, 0, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, n[2], USINEOUT_MAIN, n[3], UMULTIN_B, 0.5f, 0.5f, LPUGENGRAPH_RATE_BLOCK);
+    LPUgenGraph.connect(graph, n[3], UMULTOUT_MAIN, LPUGENGRAPH_OUTPUT, 0, 0.3f, 0, LPUGENGRAPH_RATE_SAMPLE);
+
+    return graph;
+}
+
+static int compare(const char * name, lpbuffer_t * a, lpbuffer_t * b) {
+    lpfloat_t diff, maxdiff = 0;
+    size_t i;
+
+    for(i=0; i < a->length * a->channels; i++) {
+        diff = fabs(a->data[i] - b->data[i]);
+        if(diff > maxdiff) maxdiff = diff;
+    }
+    printf("%s: max diff %g\n", name, (double)maxdiff);
+
+    return maxdiff > 0;
+}
+
+int main() {
+    lpbuffer_t * graphed, * framed, * fallback;
+    lpugengraph_t * graph;
+    ugen_t * u[4], * a, * b;
+    lpfloat_t value, sample;
+    size_t i, length;
+    double graphtime, frametime;
+    clock_t start;
+    int c, na, nb, failed = 0;
+
+    length = SR * SECONDS;
+    graphed = LPBuffer.create(length, CHANNELS, SR);
+    framed = LPBuffer.create(length, CHANNELS, SR);
+    fallback = LPBuffer.create(length, CHANNELS, SR);
+
+    graph = patch(0);
+    failed |= LPUgenGraph.compile(graph) < 0;
+    start = clock();
+    failed |= LPUgenGraph.render(graph, graphed->data, length, CHANNELS) < 0;
+    graphtime = elapsed(start);
+    LPUgenGraph.destroy(graph);
+
+    /* Every node and every connection a frame at a time */
+    u[0] = sine(2);
+    u[1] = sine(440);
+    u[2] = sine(0.5);
+    u[3] = create_mult_ugen();
+    start = clock();
+    for(i=0; i < length; i++) {
+        u[0]->process(u[0]);
+        value = u[0]->get_output(u[0], USINEOUT_MAIN) * 100 + 440;
+        u[1]->set_param(u[1], USINEIN_FREQ, (void *)&value);
+
+        u[1]->process(u[1]);
+        value = u[1]->get_output(u[1], USINEOUT_MAIN) * 1 + 0;
+        u[3]->set_param(u[3], UMULTIN_A, (void *)&value);
+
+        u[2]->process(u[2]);
+        if(i % BLOCKSIZE == 0) {
+            value = u[2]->get_output(u[2], USINEOUT_MAIN) * 0.5f + 0.5f;
+            u[3]->set_param(u[3], UMULTIN_B, (void *)&value);
+        }
+
+        u[3]->process(u[3]);
+        sample = u[3]->get_output(u[3], UMULTOUT_MAIN) * 0.3f + 0;
+        for(c=0; c < CHANNELS; c++) framed->data[i * CHANNELS + c] = sample;
+    }
+    frametime = elapsed(start);
+    for(c=0; c < 4; c++) u[c]->destroy(u[c]);
+
+    failed |= compare("graph against frame at a time", graphed, framed);
+
+    graph = patch(1);
+    failed |= LPUgenGraph.render(graph, fallback->data, length, CHANNELS) < 0;
+    LPUgenGraph.destroy(graph);
+    failed |= compare("block forms against the fallback", graphed, fallback);
+
+    printf("%d seconds: graph %.1f ms, frame at a time %.1f ms\n", SECONDS, graphtime * 1000, frametime * 1000);
+    failed |= LPBuffer.mag(graphed) == 0;
+    LPSoundFile.write("renders/ugen_graph-out.wav", graphed);
+
+    /* Refusals */
+    graph = LPUgenGraph.create(BLOCKSIZE);
+    a = sine(1);
+    b = sine(1);
+    na = LPUgenGraph.add_node(graph, a);
+    nb = LPUgenGraph.add_node(graph, b);
+    failed |= LPUgenGraph.connect(graph, na, USINE_NUMOUTPUTS, nb, USINEIN_FREQ, 1, 0, LPUGENGRAPH_RATE_SAMPLE) != -1;
+    failed |= LPUgenGraph.connect(graph, na, USINEOUT_MAIN, nb + 1, USINEIN_FREQ, 1, 0, LPUGENGRAPH_RATE_SAMPLE) != -1;
+    failed |= LPUgenGraph.connect(graph, na, USINEOUT_MAIN, nb, USINEIN_FREQ, 1, 0, LPUGENGRAPH_RATE_SAMPLE) != 0;
+    failed |= LPUgenGraph.compile(graph) != 0;
+    LPUgenGraph.destroy(graph);
+
+    /* Two sines modulating each other: the first one added
+     * reads the second a block late */
+    graph = LPUgenGraph.create(BLOCKSIZE);
+    na = LPUgenGraph.add_node(graph, sine(100));
+    nb = LPUgenGraph.add_node(graph, sine(100));
+    LPUgenGraph.connect(graph, na, USINEOUT_MAIN, nb, USINEIN_FREQ, 100, 200, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, nb, USINEOUT_MAIN, na, USINEIN_FREQ, 100, 200, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, nb, USINEOUT_MAIN, LPUGENGRAPH_OUTPUT, 0, 1, 0, LPUGENGRAPH_RATE_SAMPLE);
+    failed |= LPUgenGraph.compile(graph) != 0;
+    failed |= LPUgenGraph.render(graph, graphed->data, length, CHANNELS) < 0;
+    LPUgenGraph.destroy(graph);
+
+    a = sine(100);
+    b = sine(100);
+    for(i=0; i < length; i++) {
+        value = (i < BLOCKSIZE ? 0 : framed->data[(i - BLOCKSIZE) * CHANNELS]) * 100 + 200;
+        a->set_param(a, USINEIN_FREQ, (void *)&value);
+        a->process(a);
+        value = a->get_output(a, USINEOUT_MAIN) * 100 + 200;
+        b->set_param(b, USINEIN_FREQ, (void *)&value);
+        b->process(b);
+        sample = b->get_output(b, USINEOUT_MAIN);
+        for(c=0; c < CHANNELS; c++) framed->data[i * CHANNELS + c] = sample;
+    }
+    a->destroy(a);
+    b->destroy(b);
+
+    failed |= compare("feedback against frame at a time", graphed, framed);
+    failed |= LPBuffer.mag(graphed) == 0;
+
+    LPBuffer.destroy(graphed);
+    LPBuffer.destroy(framed);
+    LPBuffer.destroy(fallback);
+
+    return failed;
+}
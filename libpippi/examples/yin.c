@@ -0,0 +1,113 @@
+#include <time.h>
+#include "pippi.h"
+
+#define SR 48000
+#define SECONDS 2
+
+/* Check the FFT difference function against the direct
+ * O(tau_max^2) sum it replaced, then track synthetic
+ * tones and compare the time per second of audio */
+
+/* Not part of LPPitchTracker, but not static */
+void yin_difference_function(lpyin_t * yin);
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* The direct sum, over the same frame */
+static void direct_difference(lpfloat_t * x, lpfloat_t * d, int tau_max) {
+    lpfloat_t diff;
+    int j, tau;
+
+    for(tau=0; tau < tau_max; tau++) {
+        d[tau] = 0;
+        for(j=0; j < tau_max; j++) {
+            diff = x[j] - x[j + tau];
+            d[tau] += diff * diff;
+        }
+    }
+}
+
+/* A tone with a few harmonics so the first peak of
+ * the autocorrelation isn't the only candidate */
+static lpbuffer_t * tone(lpfloat_t freq, size_t length) {
+    lpbuffer_t * out;
+    size_t i;
+    int h;
+
+    out = LPBuffer.create(length, 1, SR);
+    for(i=0; i < length; i++) {
+        for(h=1; h <= 4; h++) {
+            out->data[i] += 0.5f / h * sin(PI2 * freq * h * i / SR);
+        }
+    }
+    return out;
+}
+
+int main() {
+    const lpfloat_t freqs[] = { 110.f, 220.f, 261.63f, 440.f, 987.77f, 3000.f };
+    lpfloat_t direct[1000], err, maxerr, scale, p, cents, maxcents;
+    lpbuffer_t * src;
+    lpyin_t * yin;
+    double fasttime, directtime;
+    clock_t start;
+    size_t i, f;
+    int tau, failed = 0;
+
+    /* The difference function of one frame both ways */
+    src = tone(220.f, SR);
+    yin = LPPitchTracker.yin_create(4096, SR);
+    LPPitchTracker.yin_process_block(yin, src->data, 4096);
+
+    yin_difference_function(yin);
+    direct_difference(yin->frame, direct, yin->tau_max);
+
+    maxerr = 0;
+    scale = 0;
+    for(tau=1; tau < yin->tau_max; tau++) {
+        err = fabs(yin->tmp->data[tau] - direct[tau]);
+        if(err > maxerr) maxerr = err;
+        if(direct[tau] > scale) scale = direct[tau];
+    }
+    printf("difference function max error %g of %g\n", (double)maxerr, (double)scale);
+    failed |= maxerr > scale * (sizeof(lpfloat_t) == sizeof(double) ? 1e-9 : 1e-4);
+
+    /* Time one analysis each way */
+    start = clock();
+    for(i=0; i < 100; i++) yin_difference_function(yin);
+    fasttime = elapsed(start) / 100;
+
+    start = clock();
+    for(i=0; i < 100; i++) direct_difference(yin->frame, direct, yin->tau_max);
+    directtime = elapsed(start) / 100;
+
+    printf("per analysis: fft %.1f us, direct %.1f us\n", fasttime * 1e6, directtime * 1e6);
+    printf("realtime cost per second at hops of %d: %.2f ms\n", yin->stepsize, fasttime * SR / yin->stepsize * 1000);
+
+    LPPitchTracker.yin_destroy(yin);
+    LPBuffer.destroy(src);
+
+    /* Track steady tones */
+    maxcents = 0;
+    for(f=0; f < sizeof(freqs) / sizeof(lpfloat_t); f++) {
+        src = tone(freqs[f], SR * SECONDS);
+        yin = LPPitchTracker.yin_create(4096, SR);
+        p = LPPitchTracker.yin_process_block(yin, src->data, src->length);
+        cents = fabs(1200 * log2(p / freqs[f]));
+        if(cents > maxcents) maxcents = cents;
+        printf("%8.2f hz tracked as %8.2f hz (%.2f cents)\n", (double)freqs[f], (double)p, (double)cents);
+        LPPitchTracker.yin_destroy(yin);
+        LPBuffer.destroy(src);
+    }
+    failed |= maxcents > 5;
+
+    /* Silence stays on the fallback */
+    src = LPBuffer.create(SR, 1, SR);
+    yin = LPPitchTracker.yin_create(4096, SR);
+    failed |= LPPitchTracker.yin_process_block(yin, src->data, src->length) != yin->fallback;
+    LPPitchTracker.yin_destroy(yin);
+    LPBuffer.destroy(src);
+
+    return failed;
+}
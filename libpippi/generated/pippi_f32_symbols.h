@@ -0,0 +1,409 @@
+/* Generated by scripts/build_library.sh: do not edit */
+#ifndef LP_F32_SYMBOLS_H
+#define LP_F32_SYMBOLS_H
+#define LPArray LPArray_f32
+#define LPBLNOsc LPBLNOsc_f32
+#define LPBuffer LPBuffer_f32
+#define LPBufferView LPBufferView_f32
+#define LPConvolver LPConvolver_f32
+#define LPCrossingFollower LPCrossingFollower_f32
+#define LPEnvelopeFollower LPEnvelopeFollower_f32
+#define LPFFT LPFFT_f32
+#define LPFX LPFX_f32
+#define LPFormation LPFormation_f32
+#define LPFractOsc LPFractOsc_f32
+#define LPHANN_WINDOW LPHANN_WINDOW_f32
+#define LPInterpolation LPInterpolation_f32
+#define LPJobs LPJobs_f32
+#define LPKernels LPKernels_f32
+#define LPMemoryPool LPMemoryPool_f32
+#define LPNode LPNode_f32
+#define LPOnsetDetector LPOnsetDetector_f32
+#define LPParam LPParam_f32
+#define LPPeakFollower LPPeakFollower_f32
+#define LPPhasorOsc LPPhasorOsc_f32
+#define LPPitchTracker LPPitchTracker_f32
+#define LPPulsarOsc LPPulsarOsc_f32
+#define LPRand LPRand_f32
+#define LPResampler LPResampler_f32
+#define LPRingBuffer LPRingBuffer_f32
+#define LPSPSCRing LPSPSCRing_f32
+#define LPSampleLib LPSampleLib_f32
+#define LPShapeOsc LPShapeOsc_f32
+#define LPSineBank LPSineBank_f32
+#define LPSineOsc LPSineOsc_f32
+#define LPSoftClip LPSoftClip_f32
+#define LPSoundFile LPSoundFile_f32
+#define LPSoundStream LPSoundStream_f32
+#define LPSpectral LPSpectral_f32
+#define LPTableCache LPTableCache_f32
+#define LPTableOsc LPTableOsc_f32
+#define LPTapeOsc LPTapeOsc_f32
+#define LPTukeyOsc LPTukeyOsc_f32
+#define LPUgenGraph LPUgenGraph_f32
+#define LPWavetable LPWavetable_f32
+#define LPWindow LPWindow_f32
+#define _sum_abs_frame _sum_abs_frame_f32
+#define add_buffers add_buffers_f32
+#define add_node_ugengraph add_node_ugengraph_f32
+#define buffers_are_close buffers_are_close_f32
+#define buffers_are_equal buffers_are_equal_f32
+#define burst_table_from_bytes burst_table_from_bytes_f32
+#define burst_table_from_file burst_table_from_file_f32
+#define clear_buffer clear_buffer_f32
+#define clip_buffer clip_buffer_f32
+#define close_samplelib close_samplelib_f32
+#define close_soundstream close_soundstream_f32
+#define compile_ugengraph compile_ugengraph_f32
+#define concat_buffers concat_buffers_f32
+#define connect_ugengraph connect_ugengraph_f32
+#define convert_samplelib convert_samplelib_f32
+#define convolve_convolver convolve_convolver_f32
+#define convolve_parallel_convolver convolve_parallel_convolver_f32
+#define convolve_spectral convolve_spectral_f32
+#define copy_buffer copy_buffer_f32
+#define copy_pixels_to_block copy_pixels_to_block_f32
+#define coyote_create coyote_create_f32
+#define coyote_destroy coyote_destroy_f32
+#define coyote_process coyote_process_f32
+#define coyote_process_block coyote_process_block_f32
+#define create_array create_array_f32
+#define create_array_from create_array_from_f32
+#define create_blnosc create_blnosc_f32
+#define create_buffer create_buffer_f32
+#define create_buffer_from_bytes create_buffer_from_bytes_f32
+#define create_buffer_from_float create_buffer_from_float_f32
+#define create_convolver create_convolver_f32
+#define create_fft create_fft_f32
+#define create_fractosc create_fractosc_f32
+#define create_jobs create_jobs_f32
+#define create_mult_ugen create_mult_ugen_f32
+#define create_phasorosc create_phasorosc_f32
+#define create_pulsar_ugen create_pulsar_ugen_f32
+#define create_pulsarosc create_pulsarosc_f32
+#define create_pulsarosc_wavetable_stack create_pulsarosc_wavetable_stack_f32
+#define create_pulsarosc_window_stack create_pulsarosc_window_stack_f32
+#define create_resampler create_resampler_f32
+#define create_sine_ugen create_sine_ugen_f32
+#define create_sinebank create_sinebank_f32
+#define create_sineosc create_sineosc_f32
+#define create_soundstream create_soundstream_f32
+#define create_tableosc create_tableosc_f32
+#define create_tape_ugen create_tape_ugen_f32
+#define create_tapeosc create_tapeosc_f32
+#define create_tukeyosc create_tukeyosc_f32
+#define create_ugengraph create_ugengraph_f32
+#define create_wavetable create_wavetable_f32
+#define create_wavetable_stack create_wavetable_stack_f32
+#define create_window create_window_f32
+#define create_window_stack create_window_stack_f32
+#define crossingfollower_create crossingfollower_create_f32
+#define crossingfollower_destroy crossingfollower_destroy_f32
+#define crossingfollower_process crossingfollower_process_f32
+#define crossingfollower_process_block crossingfollower_process_block_f32
+#define cut_buffer cut_buffer_f32
+#define cut_into_buffer cut_into_buffer_f32
+#define depend_jobs depend_jobs_f32
+#define destroy_array destroy_array_f32
+#define destroy_blnosc destroy_blnosc_f32
+#define destroy_buffer destroy_buffer_f32
+#define destroy_convolver destroy_convolver_f32
+#define destroy_fft destroy_fft_f32
+#define destroy_fractosc destroy_fractosc_f32
+#define destroy_jobs destroy_jobs_f32
+#define destroy_mult_ugen destroy_mult_ugen_f32
+#define destroy_phasorosc destroy_phasorosc_f32
+#define destroy_pulsar_ugen destroy_pulsar_ugen_f32
+#define destroy_pulsarosc destroy_pulsarosc_f32
+#define destroy_resampler destroy_resampler_f32
+#define destroy_sine_ugen destroy_sine_ugen_f32
+#define destroy_sinebank destroy_sinebank_f32
+#define destroy_sineosc destroy_sineosc_f32
+#define destroy_tableosc destroy_tableosc_f32
+#define destroy_tape_ugen destroy_tape_ugen_f32
+#define destroy_tapeosc destroy_tapeosc_f32
+#define destroy_tukeyosc destroy_tukeyosc_f32
+#define destroy_ugengraph destroy_ugengraph_f32
+#define destroy_wavetable destroy_wavetable_f32
+#define destroy_window destroy_window_f32
+#define divide_buffers divide_buffers_f32
+#define dub_buffer dub_buffer_f32
+#define dub_scalar dub_scalar_f32
+#define env_buffer env_buffer_f32
+#define envelopefollower_create envelopefollower_create_f32
+#define envelopefollower_destroy envelopefollower_destroy_f32
+#define envelopefollower_process envelopefollower_process_f32
+#define envelopefollower_process_block envelopefollower_process_block_f32
+#define extract_wavesets extract_wavesets_f32
+#define fill_buffer fill_buffer_f32
+#define formation_create formation_create_f32
+#define formation_destroy formation_destroy_f32
+#define formation_process formation_process_f32
+#define formation_process_block formation_process_block_f32
+#define formation_render formation_render_f32
+#define formation_render_parallel formation_render_parallel_f32
+#define forward_fft forward_fft_f32
+#define fx_convolve fx_convolve_f32
+#define fx_crush fx_crush_f32
+#define fx_lpf1 fx_lpf1_f32
+#define fx_norm fx_norm_f32
+#define get_grid_char get_grid_char_f32
+#define get_mult_ugen_output get_mult_ugen_output_f32
+#define get_pulsar_ugen_output get_pulsar_ugen_output_f32
+#define get_sine_ugen_output get_sine_ugen_output_f32
+#define get_stack_value get_stack_value_f32
+#define get_tape_ugen_output get_tape_ugen_output_f32
+#define interpolate_hermite interpolate_hermite_f32
+#define interpolate_hermite_pos interpolate_hermite_pos_f32
+#define interpolate_linear interpolate_linear_f32
+#define interpolate_linear_channel interpolate_linear_channel_f32
+#define interpolate_linear_pos interpolate_linear_pos_f32
+#define interpolate_linear_pos2 interpolate_linear_pos2_f32
+#define inverse_fft inverse_fft_f32
+#define kernel_ref_add kernel_ref_add_f32
+#define kernel_ref_add_scalar kernel_ref_add_scalar_f32
+#define kernel_ref_clip kernel_ref_clip_f32
+#define kernel_ref_divide kernel_ref_divide_f32
+#define kernel_ref_divide_scalar kernel_ref_divide_scalar_f32
+#define kernel_ref_mag kernel_ref_mag_f32
+#define kernel_ref_multiply kernel_ref_multiply_f32
+#define kernel_ref_multiply_scalar kernel_ref_multiply_scalar_f32
+#define kernel_ref_scale kernel_ref_scale_f32
+#define kernel_ref_subtract kernel_ref_subtract_f32
+#define kernel_ref_subtract_scalar kernel_ref_subtract_scalar_f32
+#define kernels_select kernels_select_f32
+#define lorenzX lorenzX_f32
+#define lorenzY lorenzY_f32
+#define lorenzZ lorenzZ_f32
+#define lpbuffer_create_stack lpbuffer_create_stack_f32
+#define lpfabs lpfabs_f32
+#define lpfastcos lpfastcos_f32
+#define lpfastsin lpfastsin_f32
+#define lpfastsin_block lpfastsin_block_f32
+#define lpfmax lpfmax_f32
+#define lpfmin lpfmin_f32
+#define lpfpow lpfpow_f32
+#define lpfxsoftclip_blsc_integrated_clip lpfxsoftclip_blsc_integrated_clip_f32
+#define lpfxsoftclip_create lpfxsoftclip_create_f32
+#define lpfxsoftclip_destroy lpfxsoftclip_destroy_f32
+#define lpfxsoftclip_process lpfxsoftclip_process_f32
+#define lpnode_connect lpnode_connect_f32
+#define lpnode_connect_signal lpnode_connect_signal_f32
+#define lpnode_create lpnode_create_f32
+#define lpnode_destroy lpnode_destroy_f32
+#define lpnode_process lpnode_process_f32
+#define lpnode_sineosc_process lpnode_sineosc_process_f32
+#define lpsv lpsv_f32
+#define lpsvf lpsvf_f32
+#define lptablecache_stack lptablecache_stack_f32
+#define lpwv lpwv_f32
+#define lpzapgremlins lpzapgremlins_f32
+#define mag_buffer mag_buffer_f32
+#define map_channels_jobs map_channels_jobs_f32
+#define max_buffer max_buffer_f32
+#define memorypool_alloc memorypool_alloc_f32
+#define memorypool_custom_alloc memorypool_custom_alloc_f32
+#define memorypool_custom_init memorypool_custom_init_f32
+#define memorypool_free memorypool_free_f32
+#define memorypool_init memorypool_init_f32
+#define memorypool_mark memorypool_mark_f32
+#define memorypool_reset memorypool_reset_f32
+#define memorypool_scope_begin memorypool_scope_begin_f32
+#define memorypool_scope_end memorypool_scope_end_f32
+#define memorypool_stats memorypool_stats_f32
+#define memorypool_thread_release memorypool_thread_release_f32
+#define min_buffer min_buffer_f32
+#define mix_buffers mix_buffers_f32
+#define multiply_buffer multiply_buffer_f32
+#define open_samplelib open_samplelib_f32
+#define open_soundstream open_soundstream_f32
+#define pad_buffer pad_buffer_f32
+#define pan_stereo_buffer pan_stereo_buffer_f32
+#define pan_stereo_constant pan_stereo_constant_f32
+#define pan_stereo_gogins pan_stereo_gogins_f32
+#define pan_stereo_linear pan_stereo_linear_f32
+#define pan_stereo_sine pan_stereo_sine_f32
+#define parallel_for_jobs parallel_for_jobs_f32
+#define param_create_from_float param_create_from_float_f32
+#define param_create_from_int param_create_from_int_f32
+#define param_fill_block param_fill_block_f32
+#define peakfollower_create peakfollower_create_f32
+#define peakfollower_destroy peakfollower_destroy_f32
+#define peakfollower_process peakfollower_process_f32
+#define peakfollower_process_block peakfollower_process_block_f32
+#define play_buffer play_buffer_f32
+#define plot_buffer plot_buffer_f32
+#define prefetch_samplelib prefetch_samplelib_f32
+#define prefetch_soundstream prefetch_soundstream_f32
+#define print_pixels print_pixels_f32
+#define process_blnosc process_blnosc_f32
+#define process_block_blnosc process_block_blnosc_f32
+#define process_block_convolver process_block_convolver_f32
+#define process_block_mult_ugen process_block_mult_ugen_f32
+#define process_block_phasorosc process_block_phasorosc_f32
+#define process_block_pulsarosc process_block_pulsarosc_f32
+#define process_block_sine_ugen process_block_sine_ugen_f32
+#define process_block_sinebank process_block_sinebank_f32
+#define process_block_sineosc process_block_sineosc_f32
+#define process_block_tableosc process_block_tableosc_f32
+#define process_block_tape_ugen process_block_tape_ugen_f32
+#define process_block_tapeosc process_block_tapeosc_f32
+#define process_block_tukeyosc process_block_tukeyosc_f32
+#define process_fractosc process_fractosc_f32
+#define process_mult_ugen process_mult_ugen_f32
+#define process_phasorosc process_phasorosc_f32
+#define process_pulsar_ugen process_pulsar_ugen_f32
+#define process_pulsarosc process_pulsarosc_f32
+#define process_resampler process_resampler_f32
+#define process_sine_ugen process_sine_ugen_f32
+#define process_sineosc process_sineosc_f32
+#define process_tableosc process_tableosc_f32
+#define process_tape_ugen process_tape_ugen_f32
+#define process_tapeosc process_tapeosc_f32
+#define process_tukeyosc process_tukeyosc_f32
+#define process_ugengraph process_ugengraph_f32
+#define rand_base_logistic rand_base_logistic_f32
+#define rand_base_lorenz rand_base_lorenz_f32
+#define rand_base_lorenzX rand_base_lorenzX_f32
+#define rand_base_lorenzY rand_base_lorenzY_f32
+#define rand_base_lorenzZ rand_base_lorenzZ_f32
+#define rand_base_stdlib rand_base_stdlib_f32
+#define rand_base_xoshiro rand_base_xoshiro_f32
+#define rand_choice rand_choice_f32
+#define rand_create rand_create_f32
+#define rand_destroy rand_destroy_f32
+#define rand_fill_choice rand_fill_choice_f32
+#define rand_fill_gaussian rand_fill_gaussian_f32
+#define rand_fill_uniform rand_fill_uniform_f32
+#define rand_gaussian rand_gaussian_f32
+#define rand_jump rand_jump_f32
+#define rand_next rand_next_f32
+#define rand_preseed rand_preseed_f32
+#define rand_rand rand_rand_f32
+#define rand_randbool rand_randbool_f32
+#define rand_randint rand_randint_f32
+#define rand_seed rand_seed_f32
+#define rand_seed_state rand_seed_state_f32
+#define rand_split rand_split_f32
+#define rand_thread_default rand_thread_default_f32
+#define rand_uniform rand_uniform_f32
+#define read_skewed_buffer read_skewed_buffer_f32
+#define read_skewed_samples read_skewed_samples_f32
+#define read_soundfile read_soundfile_f32
+#define read_soundstream read_soundstream_f32
+#define remix_buffer remix_buffer_f32
+#define remix_buffer_to_channels remix_buffer_to_channels_f32
+#define render_blnosc render_blnosc_f32
+#define render_fractosc render_fractosc_f32
+#define render_phasorosc render_phasorosc_f32
+#define render_sinebank render_sinebank_f32
+#define render_sineosc render_sineosc_f32
+#define render_tableosc render_tableosc_f32
+#define render_tapeosc render_tapeosc_f32
+#define render_tukeyosc render_tukeyosc_f32
+#define render_ugengraph render_ugengraph_f32
+#define repeat_buffer repeat_buffer_f32
+#define resample_buffer resample_buffer_f32
+#define resample_parallel_resampler resample_parallel_resampler_f32
+#define resample_resampler resample_resampler_f32
+#define reset_convolver reset_convolver_f32
+#define resize_buffer resize_buffer_f32
+#define reverse_buffer reverse_buffer_f32
+#define rewind_tapeosc rewind_tapeosc_f32
+#define ringbuffer_create ringbuffer_create_f32
+#define ringbuffer_destroy ringbuffer_destroy_f32
+#define ringbuffer_dub ringbuffer_dub_f32
+#define ringbuffer_fill ringbuffer_fill_f32
+#define ringbuffer_read ringbuffer_read_f32
+#define ringbuffer_readinto ringbuffer_readinto_f32
+#define ringbuffer_readone ringbuffer_readone_f32
+#define ringbuffer_tap ringbuffer_tap_f32
+#define ringbuffer_tapinto ringbuffer_tapinto_f32
+#define ringbuffer_write ringbuffer_write_f32
+#define ringbuffer_writefrom ringbuffer_writefrom_f32
+#define ringbuffer_writeone ringbuffer_writeone_f32
+#define samples_buffer samples_buffer_f32
+#define scalar_add_buffer scalar_add_buffer_f32
+#define scalar_divide_buffer scalar_divide_buffer_f32
+#define scalar_multiply_buffer scalar_multiply_buffer_f32
+#define scalar_subtract_buffer scalar_subtract_buffer_f32
+#define scale_buffer scale_buffer_f32
+#define scratch_jobs scratch_jobs_f32
+#define seek_soundstream seek_soundstream_f32
+#define set_mult_ugen_param set_mult_ugen_param_f32
+#define set_partial_sinebank set_partial_sinebank_f32
+#define set_phase_sinebank set_phase_sinebank_f32
+#define set_pulsar_ugen_param set_pulsar_ugen_param_f32
+#define set_ratio_resampler set_ratio_resampler_f32
+#define set_sine_ugen_param set_sine_ugen_param_f32
+#define set_tape_ugen_param set_tape_ugen_param_f32
+#define shapeosc_create shapeosc_create_f32
+#define shapeosc_destroy shapeosc_destroy_f32
+#define shapeosc_multicreate shapeosc_multicreate_f32
+#define shapeosc_multidestroy shapeosc_multidestroy_f32
+#define shapeosc_multiprocess shapeosc_multiprocess_f32
+#define shapeosc_process shapeosc_process_f32
+#define shapeosc_process_block shapeosc_process_block_f32
+#define size_fft size_fft_f32
+#define split2_buffer split2_buffer_f32
+#define spscring_create spscring_create_f32
+#define spscring_destroy spscring_destroy_f32
+#define spscring_read spscring_read_f32
+#define spscring_readable spscring_readable_f32
+#define spscring_writable spscring_writable_f32
+#define spscring_write spscring_write_f32
+#define submit_jobs submit_jobs_f32
+#define subtract_buffers subtract_buffers_f32
+#define tablecache_count tablecache_count_f32
+#define tablecache_flush tablecache_flush_f32
+#define tablecache_get tablecache_get_f32
+#define tablecache_get_stack tablecache_get_stack_f32
+#define tablecache_share tablecache_share_f32
+#define taper_buffer taper_buffer_f32
+#define task_jobs task_jobs_f32
+#define trim_buffer trim_buffer_f32
+#define varispeed_buffer varispeed_buffer_f32
+#define varispeed_parallel_resampler varispeed_parallel_resampler_f32
+#define varispeed_resampler varispeed_resampler_f32
+#define verify_samplelib verify_samplelib_f32
+#define view_channel view_channel_f32
+#define view_create view_create_f32
+#define view_cut view_cut_f32
+#define view_destroy view_destroy_f32
+#define view_dub view_dub_f32
+#define view_mag view_mag_f32
+#define view_materialize view_materialize_f32
+#define view_max view_max_f32
+#define view_min view_min_f32
+#define view_pad view_pad_f32
+#define view_read view_read_f32
+#define view_reverse view_reverse_f32
+#define view_samples view_samples_f32
+#define wait_jobs wait_jobs_f32
+#define wavetable_cosine wavetable_cosine_f32
+#define wavetable_rsaw wavetable_rsaw_f32
+#define wavetable_saw wavetable_saw_f32
+#define wavetable_sine wavetable_sine_f32
+#define wavetable_square wavetable_square_f32
+#define wavetable_tri wavetable_tri_f32
+#define wavetable_tri2 wavetable_tri2_f32
+#define window_cosine window_cosine_f32
+#define window_hanning window_hanning_f32
+#define window_phasor window_phasor_f32
+#define window_rsaw window_rsaw_f32
+#define window_sine window_sine_f32
+#define window_sinein window_sinein_f32
+#define window_sineout window_sineout_f32
+#define window_tri window_tri_f32
+#define worker_jobs worker_jobs_f32
+#define write_samplelib write_samplelib_f32
+#define write_soundfile write_soundfile_f32
+#define write_soundstream write_soundstream_f32
+#define yin_create yin_create_f32
+#define yin_cumulative_mean_normalized_difference_function yin_cumulative_mean_normalized_difference_function_f32
+#define yin_destroy yin_destroy_f32
+#define yin_difference_function yin_difference_function_f32
+#define yin_get_pitch yin_get_pitch_f32
+#define yin_process yin_process_f32
+#define yin_process_block yin_process_block_f32
+#endif
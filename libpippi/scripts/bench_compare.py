@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Compare a run of build/bench against a stored baseline:
+
+    python3 scripts/bench_compare.py baseline.json build/bench.json
+
+Prints the ratio of the new median ns per frame to the
+baseline for every bench, and exits with 1 if any of them
+are slower by more than the threshold (10% by default)
+or went missing. Numbers only mean something against a
+baseline taken on the same machine, pinned to the same cpu.
+"""
+import argparse
+import json
+import sys
+
+def load(path):
+    with open(path) as f:
+        run = json.load(f)
+    return run, {b['name']: b for b in run['benchmarks']}
+
+def main():
+    parser = argparse.ArgumentParser(description='Flag regressions against a libpippi bench baseline')
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    parser.add_argument('-t', '--threshold', type=float, default=10, help='percent slower to count as a regression')
+    args = parser.parse_args()
+
+    baserun, base = load(args.baseline)
+    currun, cur = load(args.current)
+
+    for key in ('float', 'kernels', 'frames'):
+        if baserun.get(key) != currun.get(key):
+            print('warning: %s differs, baseline %s and current %s' % (key, baserun.get(key), currun.get(key)))
+
+    limit = 1 + args.threshold / 100
+    regressions = []
+
+    print('%-24s %12s %12s %8s' % ('bench', 'baseline', 'current', 'ratio'))
+    for name, b in base.items():
+        if name not in cur:
+            print('%-24s %12.3f %12s %8s  MISSING' % (name, b['ns_per_frame'], '-', '-'))
+            regressions.append(name)
+            continue
+
+        ratio = cur[name]['ns_per_frame'] / b['ns_per_frame']
+        flag = ''
+        if ratio > limit:
+            flag = '  REGRESSION'
+            regressions.append(name)
+        elif ratio < 1 / limit:
+            flag = '  faster'
+
+        print('%-24s %12.3f %12.3f %8.2f%s' % (name, b['ns_per_frame'], cur[name]['ns_per_frame'], ratio, flag))
+
+    for name in cur:
+        if name not in base:
+            print('%-24s %12s %12.3f %8s  new' % (name, '-', cur[name]['ns_per_frame'], '-'))
+
+    if regressions:
+        print('\n%d of %d benches regressed more than %g%%: %s' % (len(regressions), len(base), args.threshold, ', '.join(regressions)))
+        return 1
+
+    print('\nNo regressions over %g%%' % args.threshold)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
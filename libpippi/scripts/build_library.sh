@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Builds lib/libpippi.a with the double precision and
+# single precision variants of libpippi side by side.
+#
+# The single precision objects are built from the same
+# sources with LP_FLOAT32, which includes the generated
+# header renaming every external symbol with an _f32
+# suffix. The header is regenerated here from the double
+# precision objects, so new symbols are picked up.
+#
+# Expects LPSOURCES and LPFLAGS from the Makefile.
+
+set -e
+
+mkdir -p lib/obj generated
+
+echo "Building double precision objects..."
+for src in $LPSOURCES; do
+    gcc $LPFLAGS -c "$src" -o "lib/obj/$(basename "$src" .c).o"
+done
+
+echo "Generating float32 symbol names..."
+{
+    echo "/* Generated by scripts/build_library.sh: do not edit */"
+    echo "#ifndef LP_F32_SYMBOLS_H"
+    echo "#define LP_F32_SYMBOLS_H"
+    for src in $LPSOURCES; do
+        nm -g --defined-only "lib/obj/$(basename "$src" .c).o" | awk '{ print $3 }'
+    done | sort -u | awk '{ printf "#define %s %s_f32\n", $1, $1 }'
+    echo "#endif"
+} > generated/pippi_f32_symbols.h
+
+echo "Building float32 objects..."
+for src in $LPSOURCES; do
+    gcc $LPFLAGS -DLP_FLOAT32 -c "$src" -o "lib/obj/$(basename "$src" .c).f32.o"
+done
+
+rm -f lib/libpippi.a
+ar rcs lib/libpippi.a lib/obj/*.o
+
+echo "Done!"
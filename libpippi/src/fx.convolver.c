@@ -0,0 +1,394 @@
+#include "fx.convolver.h"
+
+lpconvolver_t * create_convolver(lpbuffer_t * impulse, int inchannels, int outchannels, size_t blocksize, size_t maxblocksize);
+void process_block_convolver(lpconvolver_t * conv, lpfloat_t * in, lpfloat_t * out, size_t nframes);
+lpbuffer_t * convolve_convolver(lpbuffer_t * src, lpbuffer_t * impulse);
+lpbuffer_t * convolve_parallel_convolver(lpbuffer_t * src, lpbuffer_t * impulse, lpjobs_t * jobs);
+void reset_convolver(lpconvolver_t * conv);
+void destroy_convolver(lpconvolver_t * conv);
+
+const lpconvolver_factory_t LPConvolver = { create_convolver, process_block_convolver, convolve_convolver, convolve_parallel_convolver, reset_convolver, destroy_convolver };
+
+/* The impulse channel that carries input i to output o,
+ * which is also the index of its partition spectra,
+ * or -1 if nothing does */
+static int convolver_path(lpconvolver_t * conv, int i, int o) {
+    if(conv->numpaths == 1) return (i == o) ? 0 : -1;
+    if(conv->inchannels == conv->outchannels && conv->numpaths == conv->inchannels) return (i == o) ? i : -1;
+    return i * conv->outchannels + o;
+}
+
+static void convolver_stage_init(lpconvolver_t * conv, lpconvolverstage_t * stage, lpbuffer_t * impulse, size_t blocksize, size_t numparts, size_t offset) {
+    size_t p, i, pos, partsize;
+    int path;
+
+    stage->blocksize = blocksize;
+    stage->numparts = numparts;
+    stage->offset = offset;
+    stage->numbins = blocksize + 1;
+    stage->fill = 0;
+    stage->blocks = 0;
+    stage->fdlpos = 0;
+
+    partsize = numparts * stage->numbins;
+
+    stage->fft = LPFFT.create(blocksize * 2);
+    stage->input = (lpfloat_t *)LPMemoryPool.alloc(conv->inchannels * blocksize * 2, sizeof(lpfloat_t));
+    stage->irre = (lpfloat_t *)LPMemoryPool.alloc(conv->numpaths * partsize, sizeof(lpfloat_t));
+    stage->irim = (lpfloat_t *)LPMemoryPool.alloc(conv->numpaths * partsize, sizeof(lpfloat_t));
+    stage->fdlre = (lpfloat_t *)LPMemoryPool.alloc(conv->inchannels * partsize, sizeof(lpfloat_t));
+    stage->fdlim = (lpfloat_t *)LPMemoryPool.alloc(conv->inchannels * partsize, sizeof(lpfloat_t));
+    stage->accre = (lpfloat_t *)LPMemoryPool.alloc(stage->numbins, sizeof(lpfloat_t));
+    stage->accim = (lpfloat_t *)LPMemoryPool.alloc(stage->numbins, sizeof(lpfloat_t));
+    stage->block = (lpfloat_t *)LPMemoryPool.alloc(blocksize * 2, sizeof(lpfloat_t));
+
+    /* Each partition goes in the first half of a zero
+     * padded block, so the product with an input window
+     * of two blocks has one block of valid output. */
+    for(path=0; path < conv->numpaths; path++) {
+        for(p=0; p < numparts; p++) {
+            memset(stage->block, 0, sizeof(lpfloat_t) * blocksize * 2);
+            for(i=0; i < blocksize; i++) {
+                pos = offset + p * blocksize + i;
+                if(pos >= impulse->length) break;
+                stage->block[i] = impulse->data[pos * impulse->channels + path];
+            }
+
+            LPFFT.forward(stage->fft, stage->block,
+                stage->irre + path * partsize + p * stage->numbins,
+                stage->irim + path * partsize + p * stage->numbins
+            );
+        }
+    }
+}
+
+lpconvolver_t * create_convolver(lpbuffer_t * impulse, int inchannels, int outchannels, size_t blocksize, size_t maxblocksize) {
+    lpconvolver_t * conv;
+    size_t s, offset, remaining, stageblocksize, numparts, maxextent;
+
+    assert(blocksize >= 1 && (blocksize & (blocksize - 1)) == 0);
+    assert(impulse->channels == 1
+        || impulse->channels == inchannels * outchannels
+        || (impulse->channels == inchannels && inchannels == outchannels));
+    assert(impulse->channels > 1 || inchannels == outchannels);
+
+    if(maxblocksize < blocksize) maxblocksize = blocksize;
+
+    conv = (lpconvolver_t *)LPMemoryPool.alloc(1, sizeof(lpconvolver_t));
+    conv->inchannels = inchannels;
+    conv->outchannels = outchannels;
+    conv->numpaths = impulse->channels;
+    conv->blocksize = blocksize;
+    conv->length = impulse->length;
+
+    /* Count the stages: every stage but the last covers
+     * LPCONVOLVER_STAGEGROWTH-1 of its blocks, which puts
+     * the start of the next stage at least one of its
+     * blocks (less the latency) into the impulse. */
+    conv->numstages = 0;
+    remaining = impulse->length;
+    stageblocksize = blocksize;
+    while(remaining > 0) {
+        numparts = (remaining + stageblocksize - 1) / stageblocksize;
+        if(stageblocksize < maxblocksize && numparts > LPCONVOLVER_STAGEGROWTH - 1) {
+            numparts = LPCONVOLVER_STAGEGROWTH - 1;
+        }
+        remaining -= (numparts * stageblocksize < remaining) ? numparts * stageblocksize : remaining;
+        conv->numstages += 1;
+        stageblocksize *= LPCONVOLVER_STAGEGROWTH;
+        if(stageblocksize > maxblocksize) stageblocksize = maxblocksize;
+    }
+    if(conv->numstages == 0) conv->numstages = 1;
+
+    conv->stages = (lpconvolverstage_t *)LPMemoryPool.alloc(conv->numstages, sizeof(lpconvolverstage_t));
+
+    offset = 0;
+    maxextent = 0;
+    stageblocksize = blocksize;
+    for(s=0; s < conv->numstages; s++) {
+        remaining = (impulse->length > offset) ? impulse->length - offset : 0;
+        numparts = (remaining + stageblocksize - 1) / stageblocksize;
+        if(numparts == 0) numparts = 1;
+        if(s < conv->numstages - 1) numparts = LPCONVOLVER_STAGEGROWTH - 1;
+
+        assert(offset + blocksize >= stageblocksize);
+        convolver_stage_init(conv, &conv->stages[s], impulse, stageblocksize, numparts, offset);
+
+        if(offset + blocksize + stageblocksize > maxextent) maxextent = offset + blocksize + stageblocksize;
+        offset += numparts * stageblocksize;
+        stageblocksize *= LPCONVOLVER_STAGEGROWTH;
+        if(stageblocksize > maxblocksize) stageblocksize = maxblocksize;
+    }
+
+    conv->fill = 0;
+    conv->inblock = (lpfloat_t *)LPMemoryPool.alloc(inchannels * blocksize, sizeof(lpfloat_t));
+
+    conv->frame = 0;
+    conv->ringsize = LPFFT.size(maxextent + blocksize);
+    conv->ring = (lpfloat_t *)LPMemoryPool.alloc(outchannels * conv->ringsize, sizeof(lpfloat_t));
+
+    return conv;
+}
+
+/* A stage has a full block: add its spectrum to the
+ * delay line, sum the delay line against the impulse
+ * partitions for each output and add the result into
+ * the output ring, offset + latency frames later. */
+static void convolver_stage_process(lpconvolver_t * conv, lpconvolverstage_t * stage) {
+    lpfloat_t * window, * xre, * xim, * hre, * him, * accre, * accim;
+    size_t i, p, b, slot, partsize, numbins, blocksize, start, mask;
+    int c, o, path, active;
+
+    blocksize = stage->blocksize;
+    numbins = stage->numbins;
+    partsize = stage->numparts * numbins;
+    accre = stage->accre;
+    accim = stage->accim;
+
+    stage->fdlpos = (stage->fdlpos + 1) % stage->numparts;
+    for(c=0; c < conv->inchannels; c++) {
+        window = stage->input + c * blocksize * 2;
+        LPFFT.forward(stage->fft, window,
+            stage->fdlre + c * partsize + stage->fdlpos * numbins,
+            stage->fdlim + c * partsize + stage->fdlpos * numbins
+        );
+        memcpy(window, window + blocksize, sizeof(lpfloat_t) * blocksize);
+    }
+
+    mask = conv->ringsize - 1;
+    start = stage->blocks * blocksize + stage->offset + conv->blocksize;
+
+    for(o=0; o < conv->outchannels; o++) {
+        memset(accre, 0, sizeof(lpfloat_t) * numbins);
+        memset(accim, 0, sizeof(lpfloat_t) * numbins);
+        active = 0;
+
+        for(c=0; c < conv->inchannels; c++) {
+            path = convolver_path(conv, c, o);
+            if(path < 0) continue;
+            active = 1;
+
+            for(p=0; p < stage->numparts; p++) {
+                slot = (stage->fdlpos + stage->numparts - p) % stage->numparts;
+                xre = stage->fdlre + c * partsize + slot * numbins;
+                xim = stage->fdlim + c * partsize + slot * numbins;
+                hre = stage->irre + path * partsize + p * numbins;
+                him = stage->irim + path * partsize + p * numbins;
+
+                for(b=0; b < numbins; b++) {
+                    accre[b] += xre[b] * hre[b] - xim[b] * him[b];
+                    accim[b] += xre[b] * him[b] + xim[b] * hre[b];
+                }
+            }
+        }
+
+        if(!active) continue;
+
+        LPFFT.inverse(stage->fft, accre, accim, stage->block);
+        for(i=0; i < blocksize; i++) {
+            conv->ring[o * conv->ringsize + ((start + i) & mask)] += stage->block[blocksize + i];
+        }
+    }
+
+    stage->blocks += 1;
+}
+
+/* A full input block: pass it to every stage */
+static void convolver_block(lpconvolver_t * conv) {
+    lpconvolverstage_t * stage;
+    size_t s;
+    int c;
+
+    for(s=0; s < conv->numstages; s++) {
+        stage = &conv->stages[s];
+        for(c=0; c < conv->inchannels; c++) {
+            memcpy(stage->input + c * stage->blocksize * 2 + stage->blocksize + stage->fill,
+                conv->inblock + c * conv->blocksize,
+                sizeof(lpfloat_t) * conv->blocksize
+            );
+        }
+
+        stage->fill += conv->blocksize;
+        if(stage->fill == stage->blocksize) {
+            convolver_stage_process(conv, stage);
+            stage->fill = 0;
+        }
+    }
+}
+
+/* Interleaved in (inchannels) to interleaved out (outchannels).
+ * Any nframes works: the output is the convolution
+ * delayed by exactly blocksize frames. */
+void process_block_convolver(lpconvolver_t * conv, lpfloat_t * in, lpfloat_t * out, size_t nframes) {
+    size_t done, n, f, idx, mask;
+    int c;
+
+    mask = conv->ringsize - 1;
+
+    for(done=0; done < nframes; done += n) {
+        n = conv->blocksize - conv->fill;
+        if(n > nframes - done) n = nframes - done;
+
+        for(f=0; f < n; f++) {
+            for(c=0; c < conv->inchannels; c++) {
+                conv->inblock[c * conv->blocksize + conv->fill + f] = in[(done + f) * conv->inchannels + c];
+            }
+
+            idx = (conv->frame + f) & mask;
+            for(c=0; c < conv->outchannels; c++) {
+                out[(done + f) * conv->outchannels + c] = conv->ring[c * conv->ringsize + idx];
+                conv->ring[c * conv->ringsize + idx] = 0.f;
+            }
+        }
+
+        conv->fill += n;
+        conv->frame += n;
+
+        if(conv->fill == conv->blocksize) {
+            convolver_block(conv);
+            conv->fill = 0;
+        }
+    }
+}
+
+/* Run src through the impulse offline, without the
+ * normalization convolve does */
+static lpbuffer_t * convolver_render(lpbuffer_t * src, lpbuffer_t * impulse) {
+    lpconvolver_t * conv;
+    lpbuffer_t * out;
+    lpfloat_t * inblock, * outblock;
+    size_t length, blocksize, pos, n, f, frame;
+    int c;
+
+    length = src->length + impulse->length + 1;
+    out = LPBuffer.create(length, src->channels, src->samplerate);
+
+    blocksize = LPFFT.size(impulse->length);
+    if(blocksize > LPCONVOLVER_OFFLINE_BLOCKSIZE) blocksize = LPCONVOLVER_OFFLINE_BLOCKSIZE;
+
+    conv = create_convolver(impulse, src->channels, src->channels, blocksize, LPCONVOLVER_OFFLINE_MAXBLOCKSIZE);
+    inblock = (lpfloat_t *)LPMemoryPool.alloc(blocksize * src->channels, sizeof(lpfloat_t));
+    outblock = (lpfloat_t *)LPMemoryPool.alloc(blocksize * src->channels, sizeof(lpfloat_t));
+
+    for(pos=0; pos < length + blocksize; pos += n) {
+        n = length + blocksize - pos;
+        if(n > blocksize) n = blocksize;
+
+        for(f=0; f < n; f++) {
+            for(c=0; c < src->channels; c++) {
+                inblock[f * src->channels + c] = (pos + f < src->length) ? src->data[(pos + f) * src->channels + c] : 0.f;
+            }
+        }
+
+        process_block_convolver(conv, inblock, outblock, n);
+
+        for(f=0; f < n; f++) {
+            if(pos + f < blocksize) continue;
+            frame = pos + f - blocksize;
+            for(c=0; c < src->channels; c++) {
+                out->data[frame * src->channels + c] = outblock[f * src->channels + c];
+            }
+        }
+    }
+
+    LPMemoryPool.free(inblock);
+    LPMemoryPool.free(outblock);
+    destroy_convolver(conv);
+
+    return out;
+}
+
+/* Offline convolution with the same output as
+ * LPFX.convolve: src->length + impulse->length + 1
+ * frames, normalized to the peak of src. The impulse
+ * may also be mono. */
+lpbuffer_t * convolve_convolver(lpbuffer_t * src, lpbuffer_t * impulse) {
+    lpbuffer_t * out;
+
+    assert(impulse->channels == src->channels || impulse->channels == 1);
+
+    out = convolver_render(src, impulse);
+    LPFX.norm(out, LPBuffer.mag(src));
+
+    return out;
+}
+
+/* One channel of src through its own channel of the
+ * impulse. Each input only ever reaches the output of
+ * the same channel, so this is the same arithmetic as
+ * that channel gets in convolver_render. */
+static lpbuffer_t * convolver_render_channel(lpbuffer_t * channel, int c, void * arg) {
+    lpbuffer_t * impulse = (lpbuffer_t *)arg;
+    lpbuffer_t * mono, * out;
+    size_t i;
+
+    if(impulse->channels == 1) return convolver_render(channel, impulse);
+
+    mono = LPBuffer.create(impulse->length, 1, impulse->samplerate);
+    for(i=0; i < impulse->length; i++) {
+        mono->data[i] = impulse->data[i * impulse->channels + c];
+    }
+    out = convolver_render(channel, mono);
+    LPBuffer.destroy(mono);
+
+    return out;
+}
+
+/* convolve with the channels rendered in parallel on
+ * jobs. The output is identical to convolve's. */
+lpbuffer_t * convolve_parallel_convolver(lpbuffer_t * src, lpbuffer_t * impulse, lpjobs_t * jobs) {
+    lpbuffer_t * out;
+
+    assert(impulse->channels == src->channels || impulse->channels == 1);
+
+    if((out = LPJobs.map_channels(jobs, src, convolver_render_channel, impulse)) == NULL) return NULL;
+    LPFX.norm(out, LPBuffer.mag(src));
+
+    return out;
+}
+
+void reset_convolver(lpconvolver_t * conv) {
+    lpconvolverstage_t * stage;
+    size_t s, partsize;
+
+    for(s=0; s < conv->numstages; s++) {
+        stage = &conv->stages[s];
+        partsize = stage->numparts * stage->numbins;
+        memset(stage->input, 0, sizeof(lpfloat_t) * conv->inchannels * stage->blocksize * 2);
+        memset(stage->fdlre, 0, sizeof(lpfloat_t) * conv->inchannels * partsize);
+        memset(stage->fdlim, 0, sizeof(lpfloat_t) * conv->inchannels * partsize);
+        stage->fill = 0;
+        stage->blocks = 0;
+        stage->fdlpos = 0;
+    }
+
+    memset(conv->inblock, 0, sizeof(lpfloat_t) * conv->inchannels * conv->blocksize);
+    memset(conv->ring, 0, sizeof(lpfloat_t) * conv->outchannels * conv->ringsize);
+    conv->fill = 0;
+    conv->frame = 0;
+}
+
+void destroy_convolver(lpconvolver_t * conv) {
+    lpconvolverstage_t * stage;
+    size_t s;
+
+    if(conv == NULL) return;
+
+    for(s=0; s < conv->numstages; s++) {
+        stage = &conv->stages[s];
+        LPFFT.destroy(stage->fft);
+        LPMemoryPool.free(stage->input);
+        LPMemoryPool.free(stage->irre);
+        LPMemoryPool.free(stage->irim);
+        LPMemoryPool.free(stage->fdlre);
+        LPMemoryPool.free(stage->fdlim);
+        LPMemoryPool.free(stage->accre);
+        LPMemoryPool.free(stage->accim);
+        LPMemoryPool.free(stage->block);
+    }
+
+    LPMemoryPool.free(conv->stages);
+    LPMemoryPool.free(conv->inblock);
+    LPMemoryPool.free(conv->ring);
+    LPMemoryPool.free(conv);
+}
@@ -0,0 +1,99 @@
+#ifndef LP_FXCONVOLVER
+#define LP_FXCONVOLVER
+
+#include "pippicore.h"
+#include "jobs.h"
+#include "spectral.h"
+
+/* Each stage of a non-uniform partition uses blocks
+ * this many times larger than the stage before it */
+#define LPCONVOLVER_STAGEGROWTH 4
+
+/* Block sizes used by the offline convolve() */
+#define LPCONVOLVER_OFFLINE_BLOCKSIZE 1024
+#define LPCONVOLVER_OFFLINE_MAXBLOCKSIZE 32768
+
+/* Streaming partitioned convolution.
+ *
+ * The impulse is cut into partitions, and the spectrum
+ * of each partition is computed once, when the convolver
+ * is created. Input is collected into blocks, and the
+ * spectrum of every input block is kept in a frequency
+ * domain delay line, so each new block costs one forward
+ * FFT per input channel, a multiply-add per partition
+ * and one inverse FFT per output channel (overlap-save).
+ *
+ * With maxblocksize == blocksize every partition is one
+ * block long (uniform partitioning). With a larger
+ * maxblocksize, the first few partitions are blocksize
+ * long and later ones grow by LPCONVOLVER_STAGEGROWTH
+ * up to maxblocksize, which keeps long impulses cheap.
+ * Each stage only starts far enough into the impulse
+ * that its bigger blocks are done before their output
+ * is due, so latency is always blocksize frames. The
+ * bigger blocks are computed in one go when they fill,
+ * so they make periodic CPU spikes.
+ *
+ * Channels are routed by the shape of the impulse:
+ *
+ *  - a mono impulse is applied to every channel
+ *    (inchannels must equal outchannels)
+ *  - an impulse with inchannels channels is applied
+ *    channel to channel (inchannels must equal outchannels)
+ *  - an impulse with inchannels * outchannels channels is
+ *    a matrix: impulse channel i * outchannels + o carries
+ *    input i to output o. True stereo is the 2x2 case,
+ *    with channels LL, LR, RL, RR.
+ */
+typedef struct lpconvolverstage_t {
+    size_t blocksize;
+    size_t numparts;
+    size_t offset;      /* where this stage's part of the impulse starts */
+    size_t numbins;
+    size_t fill;        /* input frames gathered toward the next block */
+    size_t blocks;      /* blocks processed so far */
+    size_t fdlpos;      /* newest block in the delay line */
+
+    lpfft_t * fft;
+    lpfloat_t * input;  /* inchannels sliding windows of 2 blocks */
+    lpfloat_t * irre;   /* numpaths x numparts x numbins */
+    lpfloat_t * irim;
+    lpfloat_t * fdlre;  /* inchannels x numparts x numbins */
+    lpfloat_t * fdlim;
+    lpfloat_t * accre;  /* numbins */
+    lpfloat_t * accim;
+    lpfloat_t * block;  /* 2 blocks of time domain scratch */
+} lpconvolverstage_t;
+
+typedef struct lpconvolver_t {
+    int inchannels;
+    int outchannels;
+    int numpaths;
+    size_t blocksize;
+    size_t length;      /* of the impulse, in frames */
+
+    size_t numstages;
+    lpconvolverstage_t * stages;
+
+    size_t fill;
+    lpfloat_t * inblock;    /* inchannels x blocksize */
+
+    /* Output accumulates in a ring indexed by frame,
+     * so later stages can add into the future */
+    size_t ringsize;
+    size_t frame;
+    lpfloat_t * ring;       /* outchannels x ringsize */
+} lpconvolver_t;
+
+typedef struct lpconvolver_factory_t {
+    lpconvolver_t * (*create)(lpbuffer_t * impulse, int inchannels, int outchannels, size_t blocksize, size_t maxblocksize);
+    void (*process_block)(lpconvolver_t *, lpfloat_t * in, lpfloat_t * out, size_t nframes);
+    lpbuffer_t * (*convolve)(lpbuffer_t * src, lpbuffer_t * impulse);
+    lpbuffer_t * (*convolve_parallel)(lpbuffer_t * src, lpbuffer_t * impulse, lpjobs_t * jobs);
+    void (*reset)(lpconvolver_t *);
+    void (*destroy)(lpconvolver_t *);
+} lpconvolver_factory_t;
+
+extern const lpconvolver_factory_t LPConvolver;
+
+#endif
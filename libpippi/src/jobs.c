@@ -0,0 +1,474 @@
+#include <sched.h>
+#include <unistd.h>
+#include "jobs.h"
+
+lpjobs_t * create_jobs(int numworkers, size_t scratchsize);
+lpjob_t * task_jobs(void (*fn)(void * arg), void * arg);
+int depend_jobs(lpjob_t * job, lpjob_t * on);
+void submit_jobs(lpjobs_t * jobs, lpjob_t * job);
+void wait_jobs(lpjobs_t * jobs, lpjob_t * job);
+void parallel_for_jobs(lpjobs_t * jobs, size_t start, size_t end, size_t grain, void (*fn)(void * arg, size_t start, size_t end), void * arg);
+lpbuffer_t * map_channels_jobs(lpjobs_t * jobs, lpbuffer_t * buf, lpbuffer_t * (*fn)(lpbuffer_t * channel, int c, void * arg), void * arg);
+void * scratch_jobs(size_t itemcount, size_t itemsize);
+int worker_jobs(void);
+void destroy_jobs(lpjobs_t * jobs);
+
+const lpjobs_factory_t LPJobs = { create_jobs, task_jobs, depend_jobs, submit_jobs, wait_jobs, parallel_for_jobs, map_channels_jobs, scratch_jobs, worker_jobs, destroy_jobs };
+
+/* The worker the calling thread is, or NULL */
+static _Thread_local lpjobworker_t * jobs_current = NULL;
+
+static void jobs_lock(atomic_flag * lock) {
+    while(atomic_flag_test_and_set_explicit(lock, memory_order_acquire));
+}
+
+static void jobs_unlock(atomic_flag * lock) {
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+/* The calling thread's worker if it belongs to jobs */
+static lpjobworker_t * jobs_self(lpjobs_t * jobs) {
+    if(jobs_current != NULL && jobs_current->jobs == jobs) return jobs_current;
+    return NULL;
+}
+
+static void deque_init(lpjobdeque_t * dq) {
+    dq->capacity = 64;
+    dq->jobs = (lpjob_t **)LPMemoryPool.alloc(dq->capacity, sizeof(lpjob_t *));
+    dq->head = 0;
+    dq->tail = 0;
+    atomic_flag_clear(&dq->lock);
+}
+
+static void deque_push(lpjobdeque_t * dq, lpjob_t * job) {
+    lpjob_t ** grown;
+    size_t i, count;
+
+    jobs_lock(&dq->lock);
+    count = dq->tail - dq->head;
+    if(count == dq->capacity) {
+        grown = (lpjob_t **)LPMemoryPool.alloc(dq->capacity * 2, sizeof(lpjob_t *));
+        for(i=0; i < count; i++) grown[i] = dq->jobs[(dq->head + i) & (dq->capacity - 1)];
+        LPMemoryPool.free(dq->jobs);
+        dq->jobs = grown;
+        dq->capacity *= 2;
+        dq->head = 0;
+        dq->tail = count;
+    }
+    dq->jobs[dq->tail & (dq->capacity - 1)] = job;
+    dq->tail += 1;
+    jobs_unlock(&dq->lock);
+}
+
+/* The owner takes the newest job */
+static lpjob_t * deque_pop(lpjobdeque_t * dq) {
+    lpjob_t * job = NULL;
+
+    jobs_lock(&dq->lock);
+    if(dq->tail != dq->head) {
+        dq->tail -= 1;
+        job = dq->jobs[dq->tail & (dq->capacity - 1)];
+    }
+    jobs_unlock(&dq->lock);
+
+    return job;
+}
+
+/* Everyone else takes the oldest */
+static lpjob_t * deque_steal(lpjobdeque_t * dq) {
+    lpjob_t * job = NULL;
+
+    jobs_lock(&dq->lock);
+    if(dq->tail != dq->head) {
+        job = dq->jobs[dq->head & (dq->capacity - 1)];
+        dq->head += 1;
+    }
+    jobs_unlock(&dq->lock);
+
+    return job;
+}
+
+/* Jobs queued from a worker go on its own deque, and
+ * the rest are dealt out to the workers in turn */
+static void jobs_enqueue(lpjobs_t * jobs, lpjob_t * job) {
+    lpjobworker_t * self = jobs_self(jobs);
+    unsigned int w;
+
+    if(self == NULL) {
+        w = __atomic_fetch_add(&jobs->nextworker, 1, __ATOMIC_RELAXED) % jobs->numworkers;
+        self = &jobs->workers[w];
+    }
+    deque_push(&self->deque, job);
+    __atomic_fetch_add(&jobs->queued, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&jobs->lock);
+    pthread_cond_signal(&jobs->ready);
+    pthread_mutex_unlock(&jobs->lock);
+}
+
+/* Take a job from self's deque, or steal one from the
+ * other workers, starting with the next one along */
+static lpjob_t * jobs_find(lpjobs_t * jobs, lpjobworker_t * self) {
+    lpjob_t * job;
+    int i, start;
+
+    if(__atomic_load_n(&jobs->queued, __ATOMIC_ACQUIRE) == 0) return NULL;
+
+    job = deque_pop(&self->deque);
+    start = self->index + 1;
+    for(i=0; job == NULL && i < jobs->numworkers - 1; i++) {
+        job = deque_steal(&jobs->workers[(start + i) % jobs->numworkers].deque);
+    }
+
+    if(job != NULL) __atomic_fetch_sub(&jobs->queued, 1, __ATOMIC_RELAXED);
+    return job;
+}
+
+static void jobs_release(lpjob_t * job) {
+    if(__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+    LPMemoryPool.free(job->dependents);
+    LPMemoryPool.free(job);
+}
+
+/* Mark the job done, queue anything that was only
+ * waiting on it, and wake threads waiting outside */
+static void jobs_finish(lpjobs_t * jobs, lpjob_t * job) {
+    lpjob_t ** dependents;
+    int d, numdependents;
+
+    jobs_lock(&job->lock);
+    __atomic_store_n(&job->done, 1, __ATOMIC_RELEASE);
+    dependents = job->dependents;
+    numdependents = job->numdependents;
+    job->dependents = NULL;
+    job->numdependents = 0;
+    jobs_unlock(&job->lock);
+
+    for(d=0; d < numdependents; d++) {
+        if(__atomic_sub_fetch(&dependents[d]->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+            jobs_enqueue(jobs, dependents[d]);
+        }
+    }
+    LPMemoryPool.free(dependents);
+
+    pthread_mutex_lock(&jobs->lock);
+    pthread_cond_broadcast(&jobs->finished);
+    pthread_mutex_unlock(&jobs->lock);
+
+    jobs_release(job);
+}
+
+static void jobs_run(lpjobs_t * jobs, lpjobworker_t * self, lpjob_t * job) {
+    size_t mark;
+
+    /* Jobs run while waiting nest inside the job that
+     * waits, so the arena unwinds like a stack */
+    mark = LPMemoryPool.mark(self->arena);
+    job->fn(job->arg);
+    LPMemoryPool.reset(self->arena, mark);
+
+    jobs_finish(jobs, job);
+}
+
+static void * jobs_worker_thread(void * arg) {
+    lpjobworker_t * self = (lpjobworker_t *)arg;
+    lpjobs_t * jobs = self->jobs;
+    lpjob_t * job;
+    int stopping;
+
+    jobs_current = self;
+
+    while(1) {
+        if((job = jobs_find(jobs, self)) != NULL) {
+            jobs_run(jobs, self, job);
+            continue;
+        }
+
+        pthread_mutex_lock(&jobs->lock);
+        while(__atomic_load_n(&jobs->queued, __ATOMIC_ACQUIRE) == 0 && !jobs->stopping) {
+            pthread_cond_wait(&jobs->ready, &jobs->lock);
+        }
+        stopping = jobs->stopping && __atomic_load_n(&jobs->queued, __ATOMIC_ACQUIRE) == 0;
+        pthread_mutex_unlock(&jobs->lock);
+
+        if(stopping) break;
+    }
+
+    jobs_current = NULL;
+    LPMemoryPool.thread_release();
+
+    return NULL;
+}
+
+/* Stop and join the first numstarted workers, then
+ * free everything */
+static void jobs_shutdown(lpjobs_t * jobs, int numstarted) {
+    int w;
+
+    pthread_mutex_lock(&jobs->lock);
+    jobs->stopping = 1;
+    pthread_cond_broadcast(&jobs->ready);
+    pthread_mutex_unlock(&jobs->lock);
+
+    for(w=0; w < numstarted; w++) {
+        pthread_join(jobs->workers[w].thread, NULL);
+    }
+
+    for(w=0; w < jobs->numworkers; w++) {
+        LPMemoryPool.free(jobs->workers[w].deque.jobs);
+        LPMemoryPool.free(jobs->workers[w].arena);
+        LPMemoryPool.free(jobs->workers[w].scratch);
+    }
+
+    pthread_mutex_destroy(&jobs->lock);
+    pthread_cond_destroy(&jobs->ready);
+    pthread_cond_destroy(&jobs->finished);
+
+    LPMemoryPool.free(jobs->workers);
+    LPMemoryPool.free(jobs);
+}
+
+/* Start numworkers threads, or one per cpu if it's 0,
+ * each with scratchsize bytes of scratch space */
+lpjobs_t * create_jobs(int numworkers, size_t scratchsize) {
+    lpjobs_t * jobs;
+    lpjobworker_t * worker;
+    int w;
+
+    if(numworkers <= 0) numworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(numworkers < 1) numworkers = 1;
+    if(numworkers > LPJOBS_MAXWORKERS) numworkers = LPJOBS_MAXWORKERS;
+    if(scratchsize == 0) scratchsize = LPJOBS_SCRATCHSIZE;
+
+    jobs = (lpjobs_t *)LPMemoryPool.alloc(1, sizeof(lpjobs_t));
+    jobs->workers = (lpjobworker_t *)LPMemoryPool.alloc(numworkers, sizeof(lpjobworker_t));
+    jobs->numworkers = numworkers;
+    jobs->queued = 0;
+    jobs->nextworker = 0;
+    jobs->stopping = 0;
+
+    pthread_mutex_init(&jobs->lock, NULL);
+    pthread_cond_init(&jobs->ready, NULL);
+    pthread_cond_init(&jobs->finished, NULL);
+
+    for(w=0; w < numworkers; w++) {
+        worker = &jobs->workers[w];
+        worker->jobs = jobs;
+        worker->index = w;
+        deque_init(&worker->deque);
+        worker->scratch = (unsigned char *)LPMemoryPool.alloc(scratchsize, sizeof(unsigned char));
+        worker->arena = LPMemoryPool.custom_init(worker->scratch, scratchsize);
+    }
+
+    for(w=0; w < numworkers; w++) {
+        if(pthread_create(&jobs->workers[w].thread, NULL, jobs_worker_thread, &jobs->workers[w]) != 0) {
+            fprintf(stderr, "Error: could not start job worker %d. %s (%d)\n", w, strerror(errno), errno);
+            jobs_shutdown(jobs, w);
+            return NULL;
+        }
+    }
+
+    return jobs;
+}
+
+/* A new job which runs fn(arg) once it's submitted
+ * and everything it depends on has finished */
+lpjob_t * task_jobs(void (*fn)(void * arg), void * arg) {
+    lpjob_t * job;
+
+    job = (lpjob_t *)LPMemoryPool.alloc(1, sizeof(lpjob_t));
+    job->fn = fn;
+    job->arg = arg;
+    job->pending = 1;
+    job->refs = 2; /* one for the caller's wait, and one for the pool */
+    job->done = 0;
+    job->dependents = NULL;
+    job->numdependents = 0;
+    job->maxdependents = 0;
+    atomic_flag_clear(&job->lock);
+
+    return job;
+}
+
+/* Hold job back until on has finished. The job must
+ * not have been submitted yet, but on may have been,
+ * and may have already finished. */
+int depend_jobs(lpjob_t * job, lpjob_t * on) {
+    lpjob_t ** grown;
+
+    if(job == on) return -1;
+
+    jobs_lock(&on->lock);
+    if(!__atomic_load_n(&on->done, __ATOMIC_ACQUIRE)) {
+        if(on->numdependents >= on->maxdependents) {
+            on->maxdependents = (on->maxdependents > 0) ? on->maxdependents * 2 : 4;
+            grown = (lpjob_t **)LPMemoryPool.alloc(on->maxdependents, sizeof(lpjob_t *));
+            if(on->dependents != NULL) {
+                memcpy(grown, on->dependents, sizeof(lpjob_t *) * on->numdependents);
+                LPMemoryPool.free(on->dependents);
+            }
+            on->dependents = grown;
+        }
+        on->dependents[on->numdependents++] = job;
+        __atomic_fetch_add(&job->pending, 1, __ATOMIC_ACQ_REL);
+    }
+    jobs_unlock(&on->lock);
+
+    return 0;
+}
+
+void submit_jobs(lpjobs_t * jobs, lpjob_t * job) {
+    if(__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        jobs_enqueue(jobs, job);
+    }
+}
+
+/* Wait for job to finish and release it. Workers of
+ * this pool keep running other jobs while they wait. */
+void wait_jobs(lpjobs_t * jobs, lpjob_t * job) {
+    lpjobworker_t * self = jobs_self(jobs);
+    lpjob_t * other;
+
+    if(self != NULL) {
+        while(!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE)) {
+            if((other = jobs_find(jobs, self)) != NULL) {
+                jobs_run(jobs, self, other);
+            } else {
+                sched_yield();
+            }
+        }
+    } else {
+        pthread_mutex_lock(&jobs->lock);
+        while(!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&jobs->finished, &jobs->lock);
+        }
+        pthread_mutex_unlock(&jobs->lock);
+    }
+
+    jobs_release(job);
+}
+
+typedef struct jobs_range_t {
+    void (*fn)(void * arg, size_t start, size_t end);
+    void * arg;
+    size_t start;
+    size_t end;
+} jobs_range_t;
+
+static void jobs_range_run(void * arg) {
+    jobs_range_t * range = (jobs_range_t *)arg;
+    range->fn(range->arg, range->start, range->end);
+}
+
+/* Call fn over [start, end) in chunks of grain, or in
+ * about LPJOBS_CHUNKSPERWORKER chunks per worker if
+ * grain is 0, and return when every chunk is done */
+void parallel_for_jobs(lpjobs_t * jobs, size_t start, size_t end, size_t grain, void (*fn)(void * arg, size_t start, size_t end), void * arg) {
+    jobs_range_t * ranges;
+    lpjob_t ** tasks;
+    size_t i, numchunks;
+
+    if(end <= start) return;
+
+    if(grain == 0) grain = (end - start) / ((size_t)jobs->numworkers * LPJOBS_CHUNKSPERWORKER);
+    if(grain < 1) grain = 1;
+    numchunks = (end - start + grain - 1) / grain;
+
+    ranges = (jobs_range_t *)LPMemoryPool.alloc(numchunks, sizeof(jobs_range_t));
+    tasks = (lpjob_t **)LPMemoryPool.alloc(numchunks, sizeof(lpjob_t *));
+
+    for(i=0; i < numchunks; i++) {
+        ranges[i].fn = fn;
+        ranges[i].arg = arg;
+        ranges[i].start = start + i * grain;
+        ranges[i].end = (ranges[i].start + grain < end) ? ranges[i].start + grain : end;
+        tasks[i] = task_jobs(jobs_range_run, &ranges[i]);
+        submit_jobs(jobs, tasks[i]);
+    }
+
+    for(i=0; i < numchunks; i++) wait_jobs(jobs, tasks[i]);
+
+    LPMemoryPool.free(ranges);
+    LPMemoryPool.free(tasks);
+}
+
+typedef struct jobs_channels_t {
+    lpbuffer_t * buf;
+    lpbuffer_t ** results;
+    lpbuffer_t * (*fn)(lpbuffer_t * channel, int c, void * arg);
+    void * arg;
+} jobs_channels_t;
+
+static void jobs_channel_run(void * arg, size_t start, size_t end) {
+    jobs_channels_t * ctx = (jobs_channels_t *)arg;
+    lpbuffer_t * channel;
+    size_t c, i;
+
+    for(c=start; c < end; c++) {
+        channel = LPBuffer.create(ctx->buf->length, 1, ctx->buf->samplerate);
+        for(i=0; i < ctx->buf->length; i++) {
+            channel->data[i] = ctx->buf->data[i * ctx->buf->channels + c];
+        }
+        ctx->results[c] = ctx->fn(channel, (int)c, ctx->arg);
+        LPBuffer.destroy(channel);
+    }
+}
+
+/* Run fn over every channel of buf in parallel, and
+ * interleave the mono buffers it returns. They must
+ * all come back the same length. */
+lpbuffer_t * map_channels_jobs(lpjobs_t * jobs, lpbuffer_t * buf, lpbuffer_t * (*fn)(lpbuffer_t * channel, int c, void * arg), void * arg) {
+    jobs_channels_t ctx;
+    lpbuffer_t * out = NULL;
+    size_t i;
+    int c, ok;
+
+    ctx.buf = buf;
+    ctx.fn = fn;
+    ctx.arg = arg;
+    ctx.results = (lpbuffer_t **)LPMemoryPool.alloc(buf->channels, sizeof(lpbuffer_t *));
+
+    parallel_for_jobs(jobs, 0, buf->channels, 1, jobs_channel_run, &ctx);
+
+    ok = 1;
+    for(c=0; c < buf->channels; c++) {
+        if(ctx.results[c] == NULL || ctx.results[c]->channels != 1 || ctx.results[c]->length != ctx.results[0]->length) ok = 0;
+    }
+
+    if(ok) {
+        out = LPBuffer.create(ctx.results[0]->length, buf->channels, ctx.results[0]->samplerate);
+        for(c=0; c < buf->channels; c++) {
+            for(i=0; i < out->length; i++) {
+                out->data[i * buf->channels + c] = ctx.results[c]->data[i];
+            }
+        }
+    } else {
+        fprintf(stderr, "Error: map_channels needs mono buffers of the same length back from every channel\n");
+    }
+
+    for(c=0; c < buf->channels; c++) {
+        if(ctx.results[c] != NULL) LPBuffer.destroy(ctx.results[c]);
+    }
+    LPMemoryPool.free(ctx.results);
+
+    return out;
+}
+
+/* Scratch space for the job running on the calling
+ * worker, which is released when the job returns.
+ * NULL outside a worker, or if the arena is full. */
+void * scratch_jobs(size_t itemcount, size_t itemsize) {
+    if(jobs_current == NULL) return NULL;
+    return LPMemoryPool.custom_alloc(jobs_current->arena, itemcount, itemsize);
+}
+
+/* The index of the calling worker, or -1 outside one */
+int worker_jobs(void) {
+    return (jobs_current != NULL) ? jobs_current->index : -1;
+}
+
+/* Stop the workers once the queue runs dry. Anything
+ * still waiting on a dependency never runs. */
+void destroy_jobs(lpjobs_t * jobs) {
+    jobs_shutdown(jobs, jobs->numworkers);
+}
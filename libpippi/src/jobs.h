@@ -0,0 +1,115 @@
+#ifndef LP_JOBS_H
+#define LP_JOBS_H
+
+#include <pthread.h>
+#include "pippicore.h"
+
+/* Workers started when create is passed 0 is one per
+ * online cpu, up to this many */
+#define LPJOBS_MAXWORKERS 64
+
+/* Bytes of scratch space each worker gets when create
+ * is passed 0 for scratchsize */
+#define LPJOBS_SCRATCHSIZE (4 * 1024 * 1024)
+
+/* parallel_for with a grain of 0 splits its range
+ * into about this many chunks per worker */
+#define LPJOBS_CHUNKSPERWORKER 4
+
+/* A unit of work: fn is called with arg on one of the
+ * workers once every job it depends on has finished. */
+typedef struct lpjob_t {
+    void (*fn)(void * arg);
+    void * arg;
+
+    /* Jobs this one is waiting on, plus one until it's
+     * submitted. It is queued when this reaches 0. */
+    int pending;
+    int refs;
+    int done;
+
+    /* The jobs waiting on this one, guarded by lock */
+    struct lpjob_t ** dependents;
+    int numdependents;
+    int maxdependents;
+    atomic_flag lock;
+} lpjob_t;
+
+/* Each worker keeps a deque of queued jobs. The worker
+ * pushes and pops at the tail, so it works depth first
+ * through what it queued itself, and idle workers steal
+ * from the head, taking the oldest and usually largest
+ * jobs first. */
+typedef struct lpjobdeque_t {
+    lpjob_t ** jobs;
+    size_t capacity; /* a power of two */
+    size_t head;
+    size_t tail;
+    atomic_flag lock;
+} lpjobdeque_t;
+
+typedef struct lpjobworker_t {
+    struct lpjobs_t * jobs;
+    int index;
+    pthread_t thread;
+    lpjobdeque_t deque;
+
+    /* Scratch space for the job running on this worker.
+     * Whatever a job takes from it is released when the
+     * job returns. */
+    lpmemorypool_t * arena;
+    unsigned char * scratch;
+} lpjobworker_t;
+
+/* A fixed pool of worker threads.
+ *
+ * Jobs are made with task, wired together with depend,
+ * and handed to the pool with submit. Every job is
+ * waited on exactly once, which releases it.
+ *
+ * Waiting from one of the pool's own workers -- a job
+ * that splits itself up and waits on the parts -- runs
+ * other queued jobs in the meantime rather than holding
+ * up the worker. Any other thread sleeps until the job
+ * is done.
+ *
+ * parallel_for splits a range into chunks, runs them
+ * on the pool and returns when they're all done. The
+ * split only changes which thread does which part, so
+ * functions which write disjoint parts of their output
+ * get the same result as running over the whole range
+ * at once. map_channels does the same for a buffer's
+ * channels: fn is given each one as a mono buffer and
+ * returns a new one, and the results are interleaved
+ * into one buffer. */
+typedef struct lpjobs_t {
+    lpjobworker_t * workers;
+    int numworkers;
+
+    size_t queued;
+    unsigned int nextworker;
+    int stopping;
+
+    /* Idle workers sleep on ready, and threads outside
+     * the pool waiting on a job sleep on finished */
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t finished;
+} lpjobs_t;
+
+typedef struct lpjobs_factory_t {
+    lpjobs_t * (*create)(int numworkers, size_t scratchsize);
+    lpjob_t * (*task)(void (*fn)(void * arg), void * arg);
+    int (*depend)(lpjob_t * job, lpjob_t * on);
+    void (*submit)(lpjobs_t * jobs, lpjob_t * job);
+    void (*wait)(lpjobs_t * jobs, lpjob_t * job);
+    void (*parallel_for)(lpjobs_t * jobs, size_t start, size_t end, size_t grain, void (*fn)(void * arg, size_t start, size_t end), void * arg);
+    lpbuffer_t * (*map_channels)(lpjobs_t * jobs, lpbuffer_t * buf, lpbuffer_t * (*fn)(lpbuffer_t * channel, int c, void * arg), void * arg);
+    void * (*scratch)(size_t itemcount, size_t itemsize);
+    int (*worker)(void);
+    void (*destroy)(lpjobs_t * jobs);
+} lpjobs_factory_t;
+
+extern const lpjobs_factory_t LPJobs;
+
+#endif
@@ -1,45 +1,9 @@
 #include "microsound.h"
 
-void grain_process(lpgrain_t * g, lpbuffer_t * out) {
-    lpfloat_t sample, ipw, phase, window_phase;
-    int c;
+typedef lpfloat_t lpformation_vec_t __attribute__((vector_size(LPFORMATION_LANES * sizeof(lpfloat_t))));
+typedef int32_t lpformation_ivec_t __attribute__((vector_size(LPFORMATION_LANES * sizeof(int32_t))));
 
-    ipw = 1.f;
-    if(g->pulsewidth > 0) ipw = 1.0f/g->pulsewidth;
-
-    phase = g->phase * ipw + g->start;
-
-    window_phase = (g->phase / g->length)  * ipw;
-    while(window_phase >= 1.f) window_phase -= 1.f;
-    window_phase *= g->window->length;
-
-    if(ipw > 0.f && phase < g->buf->length - 1) {
-        for(c=0; c < g->buf->channels; c++) {
-            sample = LPInterpolation.linear_channel(g->buf, phase, c);
-            sample *= LPInterpolation.linear(g->window, window_phase);
-
-            if(g->pan != 0.5f) {
-                if((2-(c & 1)) == 1) { /* checks if c is odd */
-                    sample *= (1.f - g->pan);
-                } else {
-                    sample *= g->pan;
-                }
-            }
-
-            out->data[c] += sample * g->amp;
-        }
-    }
-
-    g->phase += g->speed;
-
-    if(g->phase >= g->length) {
-        /* recycle this grain, we're done with it now */
-        g->phase = 0;
-        g->in_use = 0; 
-    }
-}
-
-lpformation_t * formation_create(int window_type, int numlayers, size_t grainlength, size_t rblength, int channels, int samplerate, lpbuffer_t * user_window) {
+lpformation_t * formation_create(int window_type, int numlayers, size_t grainlength, size_t rblength, int channels, int samplerate, lpbuffer_t * user_window, int maxgrains) {
     lpformation_t * formation;
 
     formation = (lpformation_t *)LPMemoryPool.alloc(1, sizeof(lpformation_t));
@@ -49,6 +13,16 @@ lpformation_t * formation_create(int window_type, int numlayers, size_t grainlen
         formation->window = LPWindow.create(window_type, 4096);
     }
 
+    if(maxgrains <= 0) maxgrains = LPFORMATION_MAXGRAINS;
+    formation->maxgrains = maxgrains;
+    formation->grain_phase = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_speed = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_start = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_length = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_ipw = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_pan = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+    formation->grain_amp = (lpfloat_t *)LPMemoryPool.alloc(maxgrains, sizeof(lpfloat_t));
+
     formation->rb = LPRingBuffer.create(rblength, channels, samplerate);
     formation->grainlength = grainlength;
     formation->numlayers = numlayers;
@@ -67,124 +41,479 @@ lpformation_t * formation_create(int window_type, int numlayers, size_t grainlen
     formation->phase = 0.f;
     formation->phase_inc = 1.f / samplerate;
 
-    formation->onset_phase = 0.f;
-    formation->onset_phase_inc = 1.f / rblength;
+    /* Start the first layer of grains on the first frame */
+    formation->onset_elapsed = (size_t)-1;
 
     formation->graininterval = grainlength / 2;
 
     return formation;
 }
 
-void formation_process(lpformation_t * c) {
-    int i, g, gi, active_grains, activated_grains, requested_grains, new_grain;
+/* Formation params are taken as a snapshot and 
+ * copied into the new grain */
+static void formation_add_grain(lpformation_t * c) {
     size_t grainlength;
-    lpfloat_t pan;
-    int grain_indexes[LPFORMATION_MAXGRAINS];
+    int g;
+
+    if(c->num_active_grains >= c->maxgrains) return;
 
-    for(i=0; i < c->current_frame->channels; i++) {
-        c->current_frame->data[i] = 0.f;
+    if(c->grainlength_jitter > 0) {
+        grainlength = c->grainlength + (size_t)LPRand.rand(0, c->grainlength_jitter * c->grainlength_maxjitter);
+    } else {
+        grainlength = c->grainlength;
+    }
+    if(grainlength < 1) grainlength = 1;
+
+    g = c->num_active_grains;
+    c->grain_phase[g] = 0.f;
+    c->grain_speed[g] = c->speed;
+    c->grain_start[g] = (size_t)(c->rb->range * c->pos);
+    c->grain_length[g] = grainlength;
+    c->grain_ipw[g] = (c->pulsewidth > 0) ? 1.f / c->pulsewidth : 1.f;
+    c->grain_amp[g] = c->amp;
+
+    c->grain_pan[g] = c->pan;
+    if(c->spread > 0) {
+        c->grain_pan[g] = 0.5f + LPRand.rand(-.5f, 0.5f) * c->spread;
     }
 
-    /* calculate the grid phase */
+    c->num_active_grains += 1;
+}
 
-    /* if the grid phase has reset, add some grains to the stack 
-     * at this point, formation params are taken as a snapshot and 
-     * copied into the new grains.
-     * */
-    requested_grains = 0;
-    if(c->onset_phase >= 1.f) {
-        requested_grains = c->numlayers;
-    }
+static void formation_remove_grain(lpformation_t * c, int g) {
+    int last = --c->num_active_grains;
 
-    /* adding a grain to the stack: */
-    /* reset grain indexes, loop over to find active indexes, 
-     * use first open indexes for new grains */
-    active_grains = 0;
-    activated_grains = 0;
-    g = 0;
-    gi = 0;
+    c->grain_phase[g] = c->grain_phase[last];
+    c->grain_speed[g] = c->grain_speed[last];
+    c->grain_start[g] = c->grain_start[last];
+    c->grain_length[g] = c->grain_length[last];
+    c->grain_ipw[g] = c->grain_ipw[last];
+    c->grain_pan[g] = c->grain_pan[last];
+    c->grain_amp[g] = c->grain_amp[last];
+}
 
-    if(requested_grains == 0 && c->num_active_grains == 0) {
-        requested_grains += 1;
+/* Mix nframes of one grain into out, and return 1 if 
+ * the grain finished. With out NULL the grain is only 
+ * moved along. Grains read the last range frames written 
+ * to the ring, which may have more room than that, so 
+ * the source is always one pass of the input.
+ *
+ * The window and source reads are gathers, so rather 
+ * than looping over grains this loops over frames 
+ * within a grain, with its parameters held in registers. 
+ * Each run of frames is done in three passes: the phase 
+ * accumulation, which is serial, the split of the read 
+ * and window positions into whole frames and fractions, 
+ * in vectors of LPFORMATION_LANES, and then the reads 
+ * themselves, which need no bounds checks. Grains which 
+ * play backwards or repeat their window take a plain 
+ * frame at a time path. */
+static int formation_render_grain(lpformation_t * c, int g, lpfloat_t * restrict out, size_t nframes) {
+    lpfloat_t phases[LPFORMATION_BLOCKSIZE];
+    lpfloat_t readfracs[LPFORMATION_BLOCKSIZE];
+    lpfloat_t windowfracs[LPFORMATION_BLOCKSIZE];
+    int32_t readidx[LPFORMATION_BLOCKSIZE];
+    int32_t windowidx[LPFORMATION_BLOCKSIZE];
+    lpformation_vec_t vphase, vread, vwindow;
+    lpformation_ivec_t vidx;
+    lpfloat_t phase, speed, start, length, ipw, windowscale, windowlength, windowstep, readlimit;
+    lpfloat_t readpos, windowpos, wp, frac, env, gains[2];
+    lpfloat_t * restrict window = c->window->data;
+    lpfloat_t * restrict rb = c->rb->data;
+    lpfloat_t * frame, * next;
+    size_t i, k, m, n, base, boundry, at;
+    long idx, windowlimit;
+    int ch, channels, done, inside, forward;
+
+    channels = c->rb->channels;
+    windowlength = c->window->length;
+    windowlimit = c->window->length - 1;
+    readlimit = c->rb->range - 1;
+    boundry = c->rb->boundry;
+    base = c->rb->pos - c->rb->range;
+
+    phase = c->grain_phase[g];
+    speed = c->grain_speed[g];
+    start = c->grain_start[g];
+    length = c->grain_length[g];
+    ipw = c->grain_ipw[g];
+    windowscale = ipw / length;
+    windowstep = windowscale * windowlength;
+
+    /* With a pulsewidth of 1 or more the window plays 
+     * once, and moving forward both positions only grow */
+    forward = speed > 0 && ipw <= 1.f;
+
+    /* Even channels take pan, odd channels 1 - pan */
+    gains[0] = gains[1] = c->grain_amp[g];
+    if(c->grain_pan[g] != 0.5f) {
+        gains[0] *= c->grain_pan[g];
+        gains[1] *= 1.f - c->grain_pan[g];
     }
 
-    while(1) {
-        if(active_grains == 0 && requested_grains == 0) break;
-
-        new_grain = 0;
-        if(c->grains[g].in_use == 0 && activated_grains < requested_grains) {
-            if(c->grainlength_jitter > 0) {
-                grainlength = c->grainlength + (size_t)LPRand.rand(0, c->grainlength_jitter * c->grainlength_maxjitter);
-            } else {
-                grainlength = c->grainlength;
+    done = 0;
+    for(i=0; i < nframes && !done; i += n) {
+        n = nframes - i;
+        if(n > LPFORMATION_BLOCKSIZE) n = LPFORMATION_BLOCKSIZE;
+
+        for(k=0; k < n; k++) {
+            phases[k] = phase;
+            phase += speed;
+            if(phase >= length) {
+                n = k + 1;
+                done = 1;
+                break;
             }
+        }
 
-            /* add a new grain to the stack by reusing this one */
-            c->grains[g].in_use = 1;
-            c->grains[g].phase = 0;
+        if(out == NULL) continue;
 
-            c->grains[g].buf = c->rb;
-            c->grains[g].offset = c->offset / (lpfloat_t)c->rb->samplerate;
-            c->grains[g].pulsewidth = c->pulsewidth;
+        if(!forward) {
+            for(k=0; k < n; k++) {
+                readpos = phases[k] * ipw + start;
+                wp = phases[k] * windowscale;
+                windowpos = (wp - (long)wp) * windowlength;
 
-            c->grains[g].phase = 0.f;
-            c->grains[g].phase_offset = LPRand.rand(0.f, 1.f);
+                idx = (long)windowpos;
+                inside = readpos >= 0 && readpos < readlimit && idx >= 0 && idx < windowlimit;
+                if(!inside) continue;
 
-            c->grains[g].amp = c->amp;
+                frac = windowpos - idx;
+                env = (1.0f - frac) * window[idx] + frac * window[idx+1];
 
-            c->grains[g].window = c->window;
+                idx = (long)readpos;
+                frac = readpos - idx;
+                at = (base + idx) & boundry;
+                frame = rb + at * channels;
+                next = rb + ((at + 1) & boundry) * channels;
 
-            c->grains[g].skew = c->skew;
-            c->grains[g].speed = c->speed;
+                for(ch=0; ch < channels; ch++) {
+                    out[(i + k) * channels + ch] += ((1.0f - frac) * frame[ch] + frac * next[ch]) * env * gains[ch & 1];
+                }
+            }
+            continue;
+        }
 
-            c->grains[g].length = grainlength;
-            c->grains[g].range = grainlength;
-            c->grains[g].start = (size_t)(c->rb->length * c->pos);
+        /* The positions split into whole frames and fractions 
+         * LPFORMATION_LANES at a time, then the reads */
+        for(k=n; k % LPFORMATION_LANES; k++) phases[k] = phases[n-1];
+        for(k=0; k < n; k += LPFORMATION_LANES) {
+            memcpy(&vphase, phases + k, sizeof(lpformation_vec_t));
+            vread = vphase * ipw;
+            vwindow = vphase * windowstep;
+
+            vidx = __builtin_convertvector(vread, lpformation_ivec_t);
+            vread -= __builtin_convertvector(vidx, lpformation_vec_t);
+            memcpy(readidx + k, &vidx, sizeof(lpformation_ivec_t));
+            memcpy(readfracs + k, &vread, sizeof(lpformation_vec_t));
+
+            vidx = __builtin_convertvector(vwindow, lpformation_ivec_t);
+            vwindow -= __builtin_convertvector(vidx, lpformation_vec_t);
+            memcpy(windowidx + k, &vidx, sizeof(lpformation_ivec_t));
+            memcpy(windowfracs + k, &vwindow, sizeof(lpformation_vec_t));
+        }
 
-            c->grains[g].pan = c->pan;
-            if(c->spread > 0) {
-                pan = 0.5f + LPRand.rand(-.5f, 0.5f) * c->spread;
-                c->grains[g].pan = pan;
+        /* Only the last frames can run off the end of the 
+         * source or the window, so stop short of them */
+        m = n;
+        while(m > 0 && (start + readidx[m-1] >= readlimit || windowidx[m-1] >= windowlimit)) m--;
+
+        at = base + (size_t)start;
+        if(channels == 2) {
+            for(k=0; k < m; k++) {
+                env = (1.0f - windowfracs[k]) * window[windowidx[k]] + windowfracs[k] * window[windowidx[k]+1];
+                frame = rb + ((at + readidx[k]) & boundry) * 2;
+                next = rb + ((at + readidx[k] + 1) & boundry) * 2;
+                frac = readfracs[k];
+                out[(i + k) * 2] += ((1.0f - frac) * frame[0] + frac * next[0]) * env * gains[0];
+                out[(i + k) * 2 + 1] += ((1.0f - frac) * frame[1] + frac * next[1]) * env * gains[1];
             }
+            continue;
+        }
+
+        for(k=0; k < m; k++) {
+            env = (1.0f - windowfracs[k]) * window[windowidx[k]] + windowfracs[k] * window[windowidx[k]+1];
+            frame = rb + ((at + readidx[k]) & boundry) * channels;
+            next = rb + ((at + readidx[k] + 1) & boundry) * channels;
+            frac = readfracs[k];
+            for(ch=0; ch < channels; ch++) {
+                out[(i + k) * channels + ch] += ((1.0f - frac) * frame[ch] + frac * next[ch]) * env * gains[ch & 1];
+            }
+        }
+    }
+
+    c->grain_phase[g] = phase;
+
+    return done;
+}
+
+/* The grain renders render_parallel plans: each span 
+ * of frames between onsets and block edges, and the 
+ * state of every grain rendered across it, in the order 
+ * they were rendered in. The grains of span s run from 
+ * spanfirst[s] up to the next span's first. */
+typedef struct formation_plan_t {
+    size_t numspans;
+    size_t maxspans;
+    size_t * spanstart;
+    size_t * spanlength;
+    size_t * spanfirst;
+
+    size_t numgrains;
+    size_t maxgrains;
+    lpfloat_t * grain_phase;
+    lpfloat_t * grain_speed;
+    lpfloat_t * grain_start;
+    lpfloat_t * grain_length;
+    lpfloat_t * grain_ipw;
+    lpfloat_t * grain_pan;
+    lpfloat_t * grain_amp;
+} formation_plan_t;
+
+/* Grow an array of count items to capacity */
+static void * formation_grow(void * items, size_t count, size_t capacity, size_t itemsize) {
+    void * grown;
+
+    grown = LPMemoryPool.alloc(capacity, itemsize);
+    if(items != NULL) {
+        memcpy(grown, items, itemsize * count);
+        LPMemoryPool.free(items);
+    }
+
+    return grown;
+}
+
+static void formation_plan_span(formation_plan_t * plan, size_t start, size_t length) {
+    size_t capacity;
+
+    if(plan->numspans >= plan->maxspans) {
+        capacity = (plan->maxspans > 0) ? plan->maxspans * 2 : 64;
+        plan->spanstart = (size_t *)formation_grow(plan->spanstart, plan->numspans, capacity, sizeof(size_t));
+        plan->spanlength = (size_t *)formation_grow(plan->spanlength, plan->numspans, capacity, sizeof(size_t));
+        plan->spanfirst = (size_t *)formation_grow(plan->spanfirst, plan->numspans, capacity, sizeof(size_t));
+        plan->maxspans = capacity;
+    }
+
+    plan->spanstart[plan->numspans] = start;
+    plan->spanlength[plan->numspans] = length;
+    plan->spanfirst[plan->numspans] = plan->numgrains;
+    plan->numspans += 1;
+}
+
+static void formation_plan_grain(formation_plan_t * plan, lpformation_t * c, int g) {
+    size_t capacity, n;
+
+    if(plan->numgrains >= plan->maxgrains) {
+        capacity = (plan->maxgrains > 0) ? plan->maxgrains * 2 : 256;
+        n = plan->numgrains;
+        plan->grain_phase = (lpfloat_t *)formation_grow(plan->grain_phase, n, capacity, sizeof(lpfloat_t));
+        plan->grain_speed = (lpfloat_t *)formation_grow(plan->grain_speed, n, capacity, sizeof(lpfloat_t));
+        plan->grain_start = (lpfloat_t *)formation_grow(plan->grain_start, n, capacity, sizeof(lpfloat_t));
+        plan->grain_length = (lpfloat_t *)formation_grow(plan->grain_length, n, capacity, sizeof(lpfloat_t));
+        plan->grain_ipw = (lpfloat_t *)formation_grow(plan->grain_ipw, n, capacity, sizeof(lpfloat_t));
+        plan->grain_pan = (lpfloat_t *)formation_grow(plan->grain_pan, n, capacity, sizeof(lpfloat_t));
+        plan->grain_amp = (lpfloat_t *)formation_grow(plan->grain_amp, n, capacity, sizeof(lpfloat_t));
+        plan->maxgrains = capacity;
+    }
+
+    n = plan->numgrains++;
+    plan->grain_phase[n] = c->grain_phase[g];
+    plan->grain_speed[n] = c->grain_speed[g];
+    plan->grain_start[n] = c->grain_start[g];
+    plan->grain_length[n] = c->grain_length[g];
+    plan->grain_ipw[n] = c->grain_ipw[g];
+    plan->grain_pan[n] = c->grain_pan[g];
+    plan->grain_amp[n] = c->grain_amp[g];
+}
+
+static void formation_plan_destroy(formation_plan_t * plan) {
+    LPMemoryPool.free(plan->spanstart);
+    LPMemoryPool.free(plan->spanlength);
+    LPMemoryPool.free(plan->spanfirst);
+    LPMemoryPool.free(plan->grain_phase);
+    LPMemoryPool.free(plan->grain_speed);
+    LPMemoryPool.free(plan->grain_start);
+    LPMemoryPool.free(plan->grain_length);
+    LPMemoryPool.free(plan->grain_ipw);
+    LPMemoryPool.free(plan->grain_pan);
+    LPMemoryPool.free(plan->grain_amp);
+}
+
+/* Render nframes of interleaved output into out, or 
+ * with out NULL, add the grain renders to plan instead. 
+ * offset is where the block starts in the plan.
+ *
+ * The block is split at grain onsets, and every active 
+ * grain is rendered across each span in turn. */
+static void formation_run(lpformation_t * c, lpfloat_t * out, size_t nframes, formation_plan_t * plan, size_t offset) {
+    size_t i, j, l, graininterval;
+    int g, channels;
+
+    channels = c->rb->channels;
+    graininterval = (c->graininterval > 0) ? c->graininterval : 1;
+
+    if(out != NULL) memset(out, 0, sizeof(lpfloat_t) * nframes * channels);
+
+    i = 0;
+    while(i < nframes) {
+        /* Every graininterval frames start another layer of grains 
+         * at this point, formation params are taken as a snapshot and 
+         * copied into the new grains. Counting whole frames keeps 
+         * the onsets from drifting, and a shorter interval set 
+         * partway through takes effect right away. */
+        if(c->onset_elapsed >= graininterval) {
+            for(l=0; l < c->numlayers; l++) formation_add_grain(c);
+            c->onset_elapsed = 0;
+        }
+
+        /* Advance the internal phases to the next onset 
+         * or the end of the block */
+        j = i;
+        while(j < nframes) {
+            j += 1;
+
+            c->phase += c->phase_inc;
+            while(c->phase >= 1.f) c->phase -= 1.f;
+
+            c->pos += c->phase_inc;
+            while(c->pos >= 1.f) c->pos -= 1.f;
 
-            activated_grains += 1;
-            new_grain = 1;
+            c->onset_elapsed += 1;
+            if(c->onset_elapsed >= graininterval) break;
         }
 
-        if(c->grains[g].in_use == 1) {
-            grain_indexes[gi] = g;
-            gi += 1;
-            if(new_grain == 0) active_grains += 1;
+        if(plan != NULL) formation_plan_span(plan, offset + i, j - i);
+
+        /* recycle the grains we're done with by 
+         * moving the last grain into their place */
+        g = 0;
+        while(g < c->num_active_grains) {
+            if(plan != NULL) formation_plan_grain(plan, c, g);
+            if(formation_render_grain(c, g, (out != NULL) ? out + i * channels : NULL, j - i)) {
+                formation_remove_grain(c, g);
+            } else {
+                g += 1;
+            }
         }
 
-        g += 1;
-        if(g >= LPFORMATION_MAXGRAINS) g -= LPFORMATION_MAXGRAINS;
-        if(gi >= LPFORMATION_MAXGRAINS) break;
-        if(active_grains + activated_grains >= c->num_active_grains + requested_grains) break;
+        i = j;
     }
+}
+
+void formation_process_block(lpformation_t * c, lpfloat_t * out, size_t nframes) {
+    formation_run(c, out, nframes, NULL, 0);
+}
 
-    /* process all the active grains into the output buffer */
-    active_grains += activated_grains;
-    c->num_active_grains = active_grains;
-    for(gi=0; gi < active_grains; gi++) {
-        grain_process(&c->grains[grain_indexes[gi]], c->current_frame);
+/* Render length frames into a new buffer, a block of 
+ * LPFORMATION_RENDER_BLOCKSIZE at a time */
+lpbuffer_t * formation_render(lpformation_t * c, size_t length) {
+    lpbuffer_t * out;
+    size_t pos, n;
+
+    out = LPBuffer.create(length, c->rb->channels, c->rb->samplerate);
+    for(pos=0; pos < length; pos += n) {
+        n = length - pos;
+        if(n > LPFORMATION_RENDER_BLOCKSIZE) n = LPFORMATION_RENDER_BLOCKSIZE;
+        formation_process_block(c, out->data + pos * out->channels, n);
     }
 
-    /* increment the internal phases */
-    c->phase += c->phase_inc;
-    while(c->phase >= 1.f) c->phase -= 1.f;
+    return out;
+}
 
-    c->onset_phase += c->onset_phase_inc;
-    while(c->onset_phase >= 1.f) c->onset_phase -= 1.f;
+typedef struct formation_spans_t {
+    lpformation_t * formation;
+    formation_plan_t * plan;
+    lpbuffer_t * out;
+} formation_spans_t;
+
+/* Render the planned grains of spans start to end. 
+ * The grains are read from the plan through a copy 
+ * of the formation, so the workers share nothing but 
+ * the source and the window. */
+static void formation_render_spans(void * arg, size_t start, size_t end) {
+    formation_spans_t * ctx = (formation_spans_t *)arg;
+    formation_plan_t * plan = ctx->plan;
+    lpformation_t view;
+    size_t s, k, last;
+
+    view = *ctx->formation;
+    view.grain_phase = plan->grain_phase;
+    view.grain_speed = plan->grain_speed;
+    view.grain_start = plan->grain_start;
+    view.grain_length = plan->grain_length;
+    view.grain_ipw = plan->grain_ipw;
+    view.grain_pan = plan->grain_pan;
+    view.grain_amp = plan->grain_amp;
+
+    for(s=start; s < end; s++) {
+        last = (s + 1 < plan->numspans) ? plan->spanfirst[s + 1] : plan->numgrains;
+        for(k=plan->spanfirst[s]; k < last; k++) {
+            formation_render_grain(&view, (int)k, ctx->out->data + plan->spanstart[s] * ctx->out->channels, plan->spanlength[s]);
+        }
+    }
+}
+
+/* The same as render, split up by time between the 
+ * workers of jobs.
+ *
+ * Starting a worker partway in with an overlap to let 
+ * the grains build up wouldn't give the same grains: 
+ * which grains play, their random jitter and pans, and 
+ * the order they're summed in all depend on everything 
+ * before. So this thread steps through the formation 
+ * exactly as render would, planning the grain renders 
+ * without doing them, and the workers then render the 
+ * spans of the plan into their own parts of the output. 
+ * The planning is only the phase accumulation, which 
+ * render has to do serially anyway. */
+lpbuffer_t * formation_render_parallel(lpformation_t * c, size_t length, lpjobs_t * jobs) {
+    formation_plan_t plan;
+    formation_spans_t ctx;
+    lpbuffer_t * out;
+    size_t pos, n;
+
+    memset(&plan, 0, sizeof(formation_plan_t));
+    out = LPBuffer.create(length, c->rb->channels, c->rb->samplerate);
+
+    ctx.formation = c;
+    ctx.plan = &plan;
+    ctx.out = out;
+
+    pos = 0;
+    while(pos < length) {
+        plan.numspans = 0;
+        plan.numgrains = 0;
+        while(pos < length && plan.numgrains < LPFORMATION_PLANSIZE) {
+            n = length - pos;
+            if(n > LPFORMATION_RENDER_BLOCKSIZE) n = LPFORMATION_RENDER_BLOCKSIZE;
+            formation_run(c, NULL, n, &plan, pos);
+            pos += n;
+        }
+
+        LPJobs.parallel_for(jobs, 0, plan.numspans, 0, formation_render_spans, &ctx);
+    }
 
-    c->pos += c->phase_inc;
-    while(c->pos >= 1.f) c->pos -= 1.f;
+    formation_plan_destroy(&plan);
+
+    return out;
+}
+
+/* Render a single frame into current_frame */
+void formation_process(lpformation_t * c) {
+    formation_process_block(c, c->current_frame->data, 1);
 }
 
 void formation_destroy(lpformation_t * c) {
     LPBuffer.destroy(c->window);
     LPBuffer.destroy(c->rb);
     LPBuffer.destroy(c->current_frame);
+    LPMemoryPool.free(c->grain_phase);
+    LPMemoryPool.free(c->grain_speed);
+    LPMemoryPool.free(c->grain_start);
+    LPMemoryPool.free(c->grain_length);
+    LPMemoryPool.free(c->grain_ipw);
+    LPMemoryPool.free(c->grain_pan);
+    LPMemoryPool.free(c->grain_amp);
     LPMemoryPool.free(c);
 }
 
@@ -242,6 +571,6 @@ int extract_wavesets(
 }
 
 
-const lpformation_factory_t LPFormation = { formation_create, formation_process, formation_destroy };
+const lpformation_factory_t LPFormation = { formation_create, formation_process, formation_process_block, formation_render, formation_render_parallel, formation_destroy };
 
 
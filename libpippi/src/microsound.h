@@ -2,41 +2,49 @@
 #define LP_GRAINS_H
 
 #include "pippicore.h"
+#include "jobs.h"
 #include "oscs.tape.h"
 
+/* Used when create is passed 0 for maxgrains */
 #define LPFORMATION_MAXGRAINS 512
 
-typedef struct lpgrain_t {
-    size_t length;
-    int channels;
-    lpfloat_t pulsewidth; 
-
-    size_t range;
-    size_t start;
-    size_t offset;
+/* Frames of one grain rendered per pass, a multiple 
+ * of the lanes its positions are worked out in */
+#define LPFORMATION_BLOCKSIZE 64
+#define LPFORMATION_LANES 4
 
-    lpfloat_t phase_offset;
-    lpfloat_t phase;
-    lpfloat_t pan;
-    lpfloat_t amp;
-    lpfloat_t speed;
-    lpfloat_t skew; /* phase distortion on the grain window */
+/* Frames per process_block in render. Where blocks
+ * split the spans between onsets changes the order
+ * grains are summed in, so render_parallel follows it. */
+#define LPFORMATION_RENDER_BLOCKSIZE 256
 
-    int in_use;
-    int gate;
-
-    lpbuffer_t * buf;
-    lpbuffer_t * window;
-} lpgrain_t;
+/* render_parallel plans about this many grain renders
+ * at a time before handing them to the workers */
+#define LPFORMATION_PLANSIZE (1 << 16)
 
+/* The grains of a formation are kept as parallel arrays, 
+ * one entry per active grain. Grains 0 to num_active_grains 
+ * are playing: new grains are added at the end and a 
+ * finished grain is replaced by the last one, so every 
+ * pass over the grains is a loop over contiguous arrays 
+ * with no gaps to skip. */
 typedef struct lpformation_t {
-    lpgrain_t grains[LPFORMATION_MAXGRAINS];
+    int maxgrains;
     int num_active_grains;
+
+    lpfloat_t * grain_phase;
+    lpfloat_t * grain_speed;
+    lpfloat_t * grain_start;
+    lpfloat_t * grain_length;
+    lpfloat_t * grain_ipw; /* inverse of the pulsewidth */
+    lpfloat_t * grain_pan;
+    lpfloat_t * grain_amp;
+
     size_t numlayers;
     size_t grainlength;
     lpfloat_t grainlength_maxjitter;
     lpfloat_t grainlength_jitter; /* 0-1 proportional to grainlength_maxjitter */
-    size_t graininterval;
+    size_t graininterval; /* numlayers grains start every graininterval frames */
 
     lpfloat_t spread; /* pan spread */
     lpfloat_t speed;
@@ -51,8 +59,7 @@ typedef struct lpformation_t {
     lpfloat_t phase_inc;
     lpfloat_t pos; /* sample start position in source buffer: 0-1 */
 
-    lpfloat_t onset_phase;
-    lpfloat_t onset_phase_inc;
+    size_t onset_elapsed; /* frames since grains last started */
 
     lpbuffer_t * window;
     lpbuffer_t * current_frame;
@@ -60,8 +67,11 @@ typedef struct lpformation_t {
 } lpformation_t;
 
 typedef struct lpformation_factory_t {
-    lpformation_t * (*create)(int window_type, int numlayers, size_t grainlength, size_t rblength, int channels, int samplerate, lpbuffer_t * user_window);
+    lpformation_t * (*create)(int window_type, int numlayers, size_t grainlength, size_t rblength, int channels, int samplerate, lpbuffer_t * user_window, int maxgrains);
     void (*process)(lpformation_t *);
+    void (*process_block)(lpformation_t *, lpfloat_t * out, size_t nframes);
+    lpbuffer_t * (*render)(lpformation_t *, size_t length);
+    lpbuffer_t * (*render_parallel)(lpformation_t *, size_t length, lpjobs_t * jobs);
     void (*destroy)(lpformation_t *);
 } lpformation_factory_t;
 
@@ -12,18 +12,54 @@
  * https://github.com/earslap/SCPlugins
  */
 
+/* d(tau) = sum over j < W of (x[j] - x[j+tau])^2 with 
+ * W = tau_max, over the last 2 * tau_max samples x.
+ *
+ * Expanding the square gives e(0) + e(tau) - 2 r(tau), 
+ * where e(tau) is the energy of x[tau..tau+W) and r is 
+ * the cross correlation of x[0..W) with x. The energy 
+ * is kept as a running sum over tau, and r comes from 
+ * conj(FFT(x[0..W))) * FFT(x): the FFT is at least 
+ * 2 * tau_max long so no lag we need wraps around. */
 void yin_difference_function(lpyin_t * yin) {
-    int j, tau, pos;
-    lpfloat_t tmp, s1, s2;
-
-    pos = yin->block->pos - 1;
-    for(tau=1; tau < yin->tau_max; tau++) {
-        for(j=0; j < yin->tau_max; j++) {
-            s1 = yin->block->data[(pos + j) % yin->block->length];
-            s2 = yin->block->data[(pos + j + tau) % yin->block->length];
-            tmp = s1 - s2;
-            yin->tmp->data[tau] += tmp * tmp;
-        }
+    lpfloat_t * x, * d, e0, etau, re, im;
+    size_t i, half, start, length;
+    int tau, w;
+
+    x = yin->frame;
+    d = yin->tmp->data;
+    w = yin->tau_max;
+    half = yin->fft->length / 2;
+
+    /* Unroll the ring, oldest sample first */
+    length = yin->block->length;
+    start = (yin->block->pos + length - 2 * w) % length;
+    for(i=0; i < (size_t)(2 * w); i++) {
+        x[i] = yin->block->data[(start + i) % length];
+    }
+
+    memcpy(yin->window, x, sizeof(lpfloat_t) * w);
+    memset(yin->window + w, 0, sizeof(lpfloat_t) * (yin->fft->length - w));
+
+    LPFFT.forward(yin->fft, yin->window, yin->are, yin->aim);
+    LPFFT.forward(yin->fft, x, yin->bre, yin->bim);
+    for(i=0; i <= half; i++) {
+        re = yin->are[i] * yin->bre[i] + yin->aim[i] * yin->bim[i];
+        im = yin->are[i] * yin->bim[i] - yin->aim[i] * yin->bre[i];
+        yin->bre[i] = re;
+        yin->bim[i] = im;
+    }
+    LPFFT.inverse(yin->fft, yin->bre, yin->bim, yin->window);
+
+    e0 = 0;
+    for(i=0; i < (size_t)w; i++) e0 += x[i] * x[i];
+
+    etau = e0;
+    d[0] = 0;
+    for(tau=1; tau < w; tau++) {
+        etau += x[tau + w - 1] * x[tau + w - 1] - x[tau - 1] * x[tau - 1];
+        d[tau] = e0 + etau - 2 * yin->window[tau];
+        if(d[tau] < 0) d[tau] = 0;
     }
 }
 
@@ -32,23 +68,37 @@ void yin_cumulative_mean_normalized_difference_function(lpyin_t * yin) {
     int i;
 
     prev = 0;
+    yin->tmp->data[0] = 1;
     for(i=1; i < yin->tau_max; i++) {
         denominator = yin->tmp->data[i] + prev;
-        value = (yin->tmp->data[i] * i) / denominator;
+        value = (denominator > 0) ? (yin->tmp->data[i] * i) / denominator : 1;
         prev = denominator;
         yin->tmp->data[i] = value;
     }
 }
 
 lpfloat_t yin_get_pitch(lpyin_t * yin) {
+    lpfloat_t * d, s0, s1, s2, shift;
     int tau;
+
+    d = yin->tmp->data;
     tau = yin->tau_min;
     while (tau < yin->tau_max) {
-        if(yin->tmp->data[tau] < yin->threshold) {
-            while(tau + 1 < yin->tau_max && yin->tmp->data[tau + 1] < yin->tmp->data[tau]) {
+        if(d[tau] < yin->threshold) {
+            while(tau + 1 < yin->tau_max && d[tau + 1] < d[tau]) {
                 tau += 1;
             }
-            return (lpfloat_t)yin->samplerate / tau;
+
+            /* Parabolic interpolation between neighbouring lags */
+            shift = 0;
+            if(tau > 1 && tau + 1 < yin->tau_max) {
+                s0 = d[tau - 1];
+                s1 = d[tau];
+                s2 = d[tau + 1];
+                if(2 * s1 - s2 - s0 != 0) shift = (s2 - s0) / (2 * (2 * s1 - s2 - s0));
+            }
+
+            return (lpfloat_t)yin->samplerate / (tau + shift);
         }
         tau += 1;
     }
@@ -58,7 +108,6 @@ lpfloat_t yin_get_pitch(lpyin_t * yin) {
 }
 
 lpfloat_t yin_process(lpyin_t * yin, lpfloat_t sample) {
-    lpfloat_t p;
     yin->block->data[yin->block->pos] = sample;
     yin->block->pos += 1;
     yin->block->pos = yin->block->pos % yin->block->length;
@@ -66,19 +115,25 @@ lpfloat_t yin_process(lpyin_t * yin, lpfloat_t sample) {
     if(yin->elapsed >= yin->stepsize) {
         yin_difference_function(yin);
         yin_cumulative_mean_normalized_difference_function(yin);
-        p = yin_get_pitch(yin);
+        yin->last_pitch = yin_get_pitch(yin);
         yin->elapsed = 0;
-    } else {
-        p = yin->last_pitch;
     }
 
     yin->elapsed += 1;
-    return p;
+    return yin->last_pitch;
+}
+
+/* Returns the pitch as of the last sample in the block */
+lpfloat_t yin_process_block(lpyin_t * yin, lpfloat_t * in, size_t nframes) {
+    size_t i;
+    for(i=0; i < nframes; i++) yin_process(yin, in[i]);
+    return yin->last_pitch;
 }
 
 lpyin_t * yin_create(int blocksize, int samplerate) {
     lpfloat_t f0_max, f0_min;
     lpyin_t * yin;
+    size_t length, half;
 
     f0_max = 20000.f;
     f0_min = 100.f;
@@ -90,8 +145,21 @@ lpyin_t * yin_create(int blocksize, int samplerate) {
     yin->tau_min = (int)(samplerate / f0_max);
     yin->tau_max = (int)(samplerate / f0_min);
 
-    yin->block = LPBuffer.create(yin->blocksize, 1, samplerate);
+    /* The ring must hold a whole analysis frame */
+    length = (blocksize > 2 * yin->tau_max) ? blocksize : 2 * yin->tau_max;
+    yin->block = LPBuffer.create(length, 1, samplerate);
     yin->tmp = LPBuffer.create(yin->tau_max, 1, samplerate);
+
+    yin->fft = LPFFT.create(LPFFT.size(2 * yin->tau_max));
+    length = yin->fft->length;
+    half = length / 2;
+    yin->frame = (lpfloat_t *)LPMemoryPool.alloc(length, sizeof(lpfloat_t));
+    yin->window = (lpfloat_t *)LPMemoryPool.alloc(length, sizeof(lpfloat_t));
+    yin->are = (lpfloat_t *)LPMemoryPool.alloc(half + 1, sizeof(lpfloat_t));
+    yin->aim = (lpfloat_t *)LPMemoryPool.alloc(half + 1, sizeof(lpfloat_t));
+    yin->bre = (lpfloat_t *)LPMemoryPool.alloc(half + 1, sizeof(lpfloat_t));
+    yin->bim = (lpfloat_t *)LPMemoryPool.alloc(half + 1, sizeof(lpfloat_t));
+
     yin->fallback = 0.f; /* Fallback pitch in hz for output values before any pitch is detected */
     yin->last_pitch = yin->fallback;
     yin->threshold = 0.85f;
@@ -102,8 +170,15 @@ lpyin_t * yin_create(int blocksize, int samplerate) {
 }
 
 void yin_destroy(lpyin_t * yin) {
-    LPMemoryPool.free(yin->tmp);
-    LPMemoryPool.free(yin->block);
+    LPFFT.destroy(yin->fft);
+    LPMemoryPool.free(yin->frame);
+    LPMemoryPool.free(yin->window);
+    LPMemoryPool.free(yin->are);
+    LPMemoryPool.free(yin->aim);
+    LPMemoryPool.free(yin->bre);
+    LPMemoryPool.free(yin->bim);
+    LPBuffer.destroy(yin->tmp);
+    LPBuffer.destroy(yin->block);
     LPMemoryPool.free(yin);
 }
 
@@ -203,6 +278,118 @@ lpfloat_t coyote_process(lpcoyote_t * od, lpfloat_t sample) {
     return out;
 }
 
+/* The block form of coyote_process. The channels are 
+ * folded into one magnitude by taking the loudest, and 
+ * the frame offset of each onset in the block is written 
+ * to onsets. Returns the number of onsets found, at most 
+ * maxonsets -- any past that are dropped. 
+ *
+ * Only the rectifier can be vectorized: everything after 
+ * it is a chain of one pole filters. Keeping the state in 
+ * locals and computing the coefficients once per block is 
+ * still much faster than going through coyote_process. */
+size_t coyote_process_block(lpcoyote_t * od, lpfloat_t * in, int channels, size_t nframes, size_t * onsets, size_t maxonsets) {
+    lpfloat_t mag[LPMIR_BLOCKSIZE];
+    lpfloat_t prev, tracker_out, divi;
+    lpfloat_t fast_val, slow_val, avg_val;
+    lpfloat_t rise_coef, fall_coef, slow_lag_coef, fast_lag_coef;
+    lpfloat_t slow_lag_prev, fast_lag_prev, avg_lag_prev;
+    lpfloat_t current_avg, avg_trig, thresh, min_frames;
+    long current_index;
+    int e_time, gate, trig, c;
+    size_t i, j, n, count;
+
+    od->fall_coef = exp(od->log1 / (od->track_fall_time * od->samplerate));
+    od->slow_lag_coef = exp(od->log001 / (od->slow_lag_time * od->samplerate));
+    od->fast_lag_coef = exp(od->log001 / (od->fast_lag_time * od->samplerate));
+
+    rise_coef = od->rise_coef;
+    fall_coef = od->fall_coef;
+    slow_lag_coef = od->slow_lag_coef;
+    fast_lag_coef = od->fast_lag_coef;
+    thresh = od->thresh;
+    min_frames = od->samplerate * od->min_dur;
+
+    prev = od->prev_amp;
+    slow_lag_prev = od->slow_lag_prev;
+    fast_lag_prev = od->fast_lag_prev;
+    avg_lag_prev = od->avg_lag_prev;
+    current_avg = od->current_avg;
+    current_index = od->current_index;
+    avg_trig = od->avg_trig;
+    e_time = od->e_time;
+    gate = od->gate;
+
+    count = 0;
+    for(i=0; i < nframes; i += n) {
+        n = nframes - i;
+        if(n > LPMIR_BLOCKSIZE) n = LPMIR_BLOCKSIZE;
+
+        for(j=0; j < n; j++) {
+            mag[j] = fabs(in[(i+j) * channels]);
+        }
+
+        for(c=1; c < channels; c++) {
+            for(j=0; j < n; j++) {
+                mag[j] = lpfmax(mag[j], fabs(in[(i+j) * channels + c]));
+            }
+        }
+
+        for(j=0; j < n; j++) {
+            if(avg_trig) {
+                current_avg = 0.f;
+                current_index = 1;
+            }
+
+            tracker_out = mag[j];
+            if(tracker_out < prev) {
+                tracker_out = tracker_out + (prev - tracker_out) * fall_coef;
+            } else {
+                tracker_out = tracker_out + (prev - tracker_out) * rise_coef;
+            }
+
+            divi = ((current_avg - tracker_out) / current_index);
+            current_avg = current_avg - divi;
+            current_index += 1;
+            prev = tracker_out;
+
+            slow_val = slow_lag_prev = tracker_out + (slow_lag_coef * (slow_lag_prev - tracker_out));
+            fast_val = fast_lag_prev = tracker_out + (fast_lag_coef * (fast_lag_prev - tracker_out));
+            avg_val = avg_lag_prev = current_avg + (fast_lag_coef * (avg_lag_prev - current_avg));
+
+            slow_lag_prev = lpzapgremlins(slow_lag_prev);
+            fast_lag_prev = lpzapgremlins(fast_lag_prev);
+            avg_lag_prev = lpzapgremlins(avg_lag_prev);
+
+            trig = ((fast_val > slow_val) || (fast_val > avg_val)) * (tracker_out > thresh) * gate;
+            avg_trig = trig;
+            e_time += 1;
+
+            if(trig == 1 && gate == 1) {
+                if(count < maxonsets) onsets[count++] = i + j;
+                e_time = 0;
+                gate = 0;
+            }
+
+            if((e_time > min_frames) && (gate == 0)) {
+                gate = 1;
+            }
+        }
+    }
+
+    od->prev_amp = prev;
+    od->slow_lag_prev = slow_lag_prev;
+    od->fast_lag_prev = fast_lag_prev;
+    od->avg_lag_prev = avg_lag_prev;
+    od->current_avg = current_avg;
+    od->current_index = current_index;
+    od->avg_trig = avg_trig;
+    od->e_time = e_time;
+    od->gate = gate;
+
+    return count;
+}
+
 void coyote_destroy(lpcoyote_t * od) {
     LPMemoryPool.free(od);
 }
@@ -228,7 +415,52 @@ void envelopefollower_process(lpenvelopefollower_t * env, lpfloat_t input) {
     if(env->phase >= env->interval) {
         env->phase -= env->interval;        
         env->value = env->last;
+        env->last = 0.f;
+    }
+}
+
+/* Frames until the next decimated value, counting this one */
+static size_t follower_frames_to_boundry(lpfloat_t phase, lpfloat_t interval) {
+    lpfloat_t frames = ceil(interval - phase);
+    return (frames < 1) ? 1 : (size_t)frames;
+}
+
+/* The block form of envelopefollower_process. Every 
+ * interval frames the loudest magnitude on any channel 
+ * is written to out. Returns the number of values 
+ * written, at most maxout. Sizing out to 
+ * nframes / interval + 1 is always enough. */
+size_t envelopefollower_process_block(lpenvelopefollower_t * env, lpfloat_t * in, int channels, size_t nframes, lpfloat_t * out, size_t maxout) {
+    lpfloat_t last;
+    size_t i, j, n, len, count;
+
+    last = env->last;
+    count = 0;
+    i = 0;
+    while(i < nframes) {
+        n = follower_frames_to_boundry(env->phase, env->interval);
+        len = nframes - i;
+        if(len > n) len = n;
+
+        /* A plain max reduction over the segment */
+        len *= channels;
+        for(j=0; j < len; j++) {
+            last = lpfmax(last, fabs(in[i * channels + j]));
+        }
+        len /= channels;
+
+        i += len;
+        env->phase += len;
+        if(len == n) {
+            env->phase -= env->interval;
+            env->value = last;
+            if(count < maxout) out[count++] = last;
+            last = 0.f;
+        }
     }
+    env->last = last;
+
+    return count;
 }
 
 void envelopefollower_destroy(lpenvelopefollower_t * env) {
@@ -258,11 +490,49 @@ void peakfollower_process(lppeakfollower_t * peak, lpfloat_t input) {
         peak->change = 1;
         peak->phase -= peak->interval;        
         peak->value = peak->last;
+        peak->last = 0.f;
     } else {
         peak->change = 0;
     }
 }
 
+/* The block form of peakfollower_process, which writes 
+ * the highest value on any channel every interval 
+ * frames to out. Returns the number of values written, 
+ * and change is set if there was at least one. */
+size_t peakfollower_process_block(lppeakfollower_t * peak, lpfloat_t * in, int channels, size_t nframes, lpfloat_t * out, size_t maxout) {
+    lpfloat_t last;
+    size_t i, j, n, len, count;
+
+    last = peak->last;
+    count = 0;
+    i = 0;
+    while(i < nframes) {
+        n = follower_frames_to_boundry(peak->phase, peak->interval);
+        len = nframes - i;
+        if(len > n) len = n;
+
+        len *= channels;
+        for(j=0; j < len; j++) {
+            last = lpfmax(last, in[i * channels + j]);
+        }
+        len /= channels;
+
+        i += len;
+        peak->phase += len;
+        if(len == n) {
+            peak->phase -= peak->interval;
+            peak->value = last;
+            if(count < maxout) out[count++] = last;
+            last = 0.f;
+        }
+    }
+    peak->last = last;
+    peak->change = count > 0;
+
+    return count;
+}
+
 void peakfollower_destroy(lppeakfollower_t * peak) {
     LPMemoryPool.free(peak);
 }
@@ -303,15 +573,74 @@ void crossingfollower_process(lpcrossingfollower_t * c, lpfloat_t input) {
     c->lastsign = current;
 }
 
+/* The block form of crossingfollower_process. Follows one 
+ * channel of the block and writes the frame offset of 
+ * every ws_transition to transitions, returning how many 
+ * there were, at most maxtransitions. Set num_crossings 
+ * to 1 to get every crossing. */
+size_t crossingfollower_process_block(lpcrossingfollower_t * c, lpfloat_t * in, int channels, int channel, size_t nframes, size_t * transitions, size_t maxtransitions) {
+    unsigned char flip[LPMIR_BLOCKSIZE];
+    int signs[LPMIR_BLOCKSIZE];
+    int lastsign, crossing_count, num_crossings;
+    size_t i, j, n, count;
+
+    assert(channel >= 0 && channel < channels);
+
+    lastsign = c->lastsign != 0;
+    crossing_count = c->crossing_count;
+    num_crossings = c->num_crossings;
+    c->in_transition = 0;
+    c->ws_transition = 0;
+
+    count = 0;
+    for(i=0; i < nframes; i += n) {
+        n = nframes - i;
+        if(n > LPMIR_BLOCKSIZE) n = LPMIR_BLOCKSIZE;
+
+        for(j=0; j < n; j++) {
+            signs[j] = signbit(in[(i+j) * channels + channel]) != 0;
+        }
+
+        flip[0] = signs[0] != lastsign;
+        for(j=1; j < n; j++) {
+            flip[j] = signs[j] != signs[j-1];
+        }
+
+        /* Crossings are sparse, so only this part is serial */
+        for(j=0; j < n; j++) {
+            if(!flip[j]) continue;
+            crossing_count += 1;
+            if(crossing_count >= num_crossings) {
+                if(count < maxtransitions) transitions[count++] = i + j;
+                crossing_count = 0;
+            }
+        }
+
+        lastsign = signs[n-1];
+    }
+
+    /* Leave the flags as the last frame would have */
+    if(nframes > 0 && flip[(nframes-1) % LPMIR_BLOCKSIZE]) {
+        c->value = lastsign;
+        c->in_transition = 1;
+        c->ws_transition = crossing_count == 0;
+    }
+
+    c->lastsign = lastsign;
+    c->crossing_count = crossing_count;
+
+    return count;
+}
+
 void crossingfollower_destroy(lpcrossingfollower_t * crossing) {
     LPMemoryPool.free(crossing);
 }
 
 
 
-const lpmir_pitch_factory_t LPPitchTracker = { yin_create, yin_process, yin_destroy };
-const lpmir_onset_factory_t LPOnsetDetector = { coyote_create, coyote_process, coyote_destroy };
-const lpmir_envelopefollower_factory_t LPEnvelopeFollower = { envelopefollower_create, envelopefollower_process, envelopefollower_destroy };
-const lpmir_peakfollower_factory_t LPPeakFollower = { peakfollower_create, peakfollower_process, peakfollower_destroy };
-const lpmir_crossingfollower_factory_t LPCrossingFollower = { crossingfollower_create, crossingfollower_process, crossingfollower_destroy };
+const lpmir_pitch_factory_t LPPitchTracker = { yin_create, yin_process, yin_process_block, yin_destroy };
+const lpmir_onset_factory_t LPOnsetDetector = { coyote_create, coyote_process, coyote_process_block, coyote_destroy };
+const lpmir_envelopefollower_factory_t LPEnvelopeFollower = { envelopefollower_create, envelopefollower_process, envelopefollower_process_block, envelopefollower_destroy };
+const lpmir_peakfollower_factory_t LPPeakFollower = { peakfollower_create, peakfollower_process, peakfollower_process_block, peakfollower_destroy };
+const lpmir_crossingfollower_factory_t LPCrossingFollower = { crossingfollower_create, crossingfollower_process, crossingfollower_process_block, crossingfollower_destroy };
 
@@ -2,9 +2,24 @@
 #define LP_MIR_H
 
 #include "pippicore.h"
-
+#include "spectral.h"
+
+/* Frames analysed per pass by the process_block forms.
+ * Each pass fills a small scratch array in a loop with
+ * no carried state, which the compiler can vectorize, 
+ * before running the serial part of the follower. */
+#define LPMIR_BLOCKSIZE 256
+
+/* YIN pitch tracker.
+ *
+ * Every stepsize samples the last 2 * tau_max samples 
+ * are analysed. The difference function is computed 
+ * from an FFT autocorrelation and a running energy sum 
+ * instead of summing every lag directly, so each hop 
+ * costs O(N log N) rather than O(tau_max^2), and the 
+ * chosen lag is refined with parabolic interpolation. */
 typedef struct lpyin_t {
-    lpbuffer_t * block;
+    lpbuffer_t * block; /* ring of the most recent input */
     int samplerate;
     int blocksize;
     int stepsize; /* overlap between analysis blocks */
@@ -14,10 +29,19 @@ typedef struct lpyin_t {
     int offset;
     int elapsed;
 
-    lpbuffer_t * tmp; /* Temp buffer for processing */
+    lpbuffer_t * tmp; /* The difference function of the last analysis */
 
     int tau_max;
     int tau_min;
+
+    /* FFT scratch */
+    lpfft_t * fft;
+    lpfloat_t * frame;
+    lpfloat_t * window;
+    lpfloat_t * are;
+    lpfloat_t * aim;
+    lpfloat_t * bre;
+    lpfloat_t * bim;
 } lpyin_t;
 
 /**
@@ -108,30 +132,35 @@ typedef struct lpenvelopefollower_t {
 typedef struct lpmir_crossingfollower_factory_t {
     lpcrossingfollower_t * (*create)();
     void (*process)(lpcrossingfollower_t *, lpfloat_t);
+    size_t (*process_block)(lpcrossingfollower_t *, lpfloat_t * in, int channels, int channel, size_t nframes, size_t * transitions, size_t maxtransitions);
     void (*destroy)(lpcrossingfollower_t *);
 } lpmir_crossingfollower_factory_t;
 
 typedef struct lpmir_peakfollower_factory_t {
     lppeakfollower_t * (*create)(lpfloat_t);
     void (*process)(lppeakfollower_t *, lpfloat_t);
+    size_t (*process_block)(lppeakfollower_t *, lpfloat_t * in, int channels, size_t nframes, lpfloat_t * out, size_t maxout);
     void (*destroy)(lppeakfollower_t *);
 } lpmir_peakfollower_factory_t;
 
 typedef struct lpmir_envelopefollower_factory_t {
     lpenvelopefollower_t * (*create)(lpfloat_t);
     void (*process)(lpenvelopefollower_t *, lpfloat_t);
+    size_t (*process_block)(lpenvelopefollower_t *, lpfloat_t * in, int channels, size_t nframes, lpfloat_t * out, size_t maxout);
     void (*destroy)(lpenvelopefollower_t *);
 } lpmir_envelopefollower_factory_t;
 
 typedef struct lpmir_pitch_factory_t {
     lpyin_t * (*yin_create)(int, int);
     lpfloat_t (*yin_process)(lpyin_t *, lpfloat_t);
+    lpfloat_t (*yin_process_block)(lpyin_t *, lpfloat_t * in, size_t nframes);
     void (*yin_destroy)(lpyin_t *);
 } lpmir_pitch_factory_t;
 
 typedef struct lpmir_onset_factory_t {
     lpcoyote_t * (*coyote_create)(int samplerate);
     lpfloat_t (*coyote_process)(lpcoyote_t * od, lpfloat_t sample);
+    size_t (*coyote_process_block)(lpcoyote_t * od, lpfloat_t * in, int channels, size_t nframes, size_t * onsets, size_t maxonsets);
     void (*coyote_destory)(lpcoyote_t * od);
 } lpmir_onset_factory_t;
 
@@ -2,10 +2,11 @@
 
 lpblnosc_t * create_blnosc(lpbuffer_t * buf, lpfloat_t minfreq, lpfloat_t maxfreq);
 lpfloat_t process_blnosc(lpblnosc_t * osc);
+void process_block_blnosc(lpblnosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp);
 lpbuffer_t * render_blnosc(lpblnosc_t * osc, size_t length, lpbuffer_t * amp, int channels);
 void destroy_blnosc(lpblnosc_t * osc);
 
-const lpblnosc_factory_t LPBLNOsc = { create_blnosc, process_blnosc, render_blnosc, destroy_blnosc };
+const lpblnosc_factory_t LPBLNOsc = { create_blnosc, process_blnosc, process_block_blnosc, render_blnosc, destroy_blnosc };
 
 lpblnosc_t * create_blnosc(lpbuffer_t * buf, lpfloat_t minfreq, lpfloat_t maxfreq) {
     lpblnosc_t* osc = (lpblnosc_t*)LPMemoryPool.alloc(1, sizeof(lpblnosc_t));
@@ -53,21 +54,83 @@ lpfloat_t process_blnosc(lpblnosc_t * osc) {
     return sample;
 }
 
+/* Render nframes into out. With a NULL freq block the osc picks 
+ * a new random freq between minfreq and maxfreq on each cycle 
+ * as usual, otherwise it follows the block. A NULL amp block 
+ * is unity. The gate is set if the table wrapped in the block. */
+void process_block_blnosc(lpblnosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, sample, f, a, b;
+    lpfloat_t * data;
+    size_t i, idxa, idxb, boundry;
+    int c, channels, gate;
+
+    if(nframes == 0) return;
+
+    data = osc->buf->data;
+    channels = osc->buf->channels;
+    boundry = osc->buf->length-1;
+    phase = osc->phase;
+    phaseinc = osc->phaseinc * osc->freq;
+    gate = 0;
+
+    for(i=0; i < nframes; i++) {
+        f = phase - (int)phase;
+        idxa = (size_t)phase;
+        idxb = idxa + 1;
+
+        sample = 0.f;
+        for(c=0; c < channels; c++) {
+            a = data[idxa * channels + c];
+            b = data[idxb * channels + c];
+            sample += (1.f - f) * a + (f * b);
+        }
+        out[i] = sample;
+
+        if(freq != NULL) phaseinc = osc->phaseinc * freq[i];
+        phase += phaseinc;
+
+        if(phase >= boundry) {
+            phase -= boundry;
+            gate = 1;
+            if(freq == NULL) {
+                osc->freq = LPRand.rand(osc->minfreq, osc->maxfreq);
+                phaseinc = osc->phaseinc * osc->freq;
+            }
+        }
+    }
+
+    if(freq != NULL) osc->freq = freq[nframes-1];
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+
+    osc->phase = phase;
+    osc->gate = gate;
+}
+
 lpbuffer_t * render_blnosc(lpblnosc_t * osc, size_t length, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
-    lpfloat_t _amp, sample;
-    size_t i;
+    lpfloat_t block[LPOSC_BLOCKSIZE], ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * amps;
+    lpfloat_t _amp;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant path */
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        sample = process_blnosc(osc);
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = sample * _amp;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_blnosc(osc, block, n, NULL, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j] * _amp;
+            }
         }
     }
 
@@ -17,6 +17,7 @@ typedef struct lpblnosc_t {
 typedef struct lpblnosc_factory_t {
     lpblnosc_t * (*create)(lpbuffer_t *, lpfloat_t, lpfloat_t);
     lpfloat_t (*process)(lpblnosc_t *);
+    void (*process_block)(lpblnosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     lpbuffer_t * (*render)(lpblnosc_t *, size_t, lpbuffer_t *, int);
     void (*destroy)(lpblnosc_t *);
 } lpblnosc_factory_t;
@@ -56,7 +56,7 @@ void lpnode_connect_signal(lpnode_t * node, int param_type, lpfloat_t value) {
 lpfloat_t lpnode_sineosc_process(lpnode_t * node) {
     lpfloat_t sample, freq;
     
-    sample = sin((lpfloat_t)PI2 * node->params.sineosc->phase);
+    sample = lpfastsin(node->params.sineosc->phase);
     freq = node->params.sineosc->freq->last;
     freq *= node->params.sineosc->freq_mul;
     freq += node->params.sineosc->freq_add;
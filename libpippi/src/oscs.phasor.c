@@ -3,10 +3,11 @@
 
 lpphasorosc_t * create_phasorosc(void);
 lpfloat_t process_phasorosc(lpphasorosc_t * osc);
+void process_block_phasorosc(lpphasorosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp);
 lpbuffer_t * render_phasorosc(lpphasorosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels);
 void destroy_phasorosc(lpphasorosc_t * osc);
 
-const lpphasorosc_factory_t LPPhasorOsc = { create_phasorosc, process_phasorosc, render_phasorosc, destroy_phasorosc };
+const lpphasorosc_factory_t LPPhasorOsc = { create_phasorosc, process_phasorosc, process_block_phasorosc, render_phasorosc, destroy_phasorosc };
 
 lpphasorosc_t * create_phasorosc(void) {
     lpphasorosc_t * osc = (lpphasorosc_t *)LPMemoryPool.alloc(1, sizeof(lpphasorosc_t));
@@ -22,22 +23,64 @@ lpfloat_t process_phasorosc(lpphasorosc_t* osc) {
     return osc->phase * 2.f - 1.f;
 }
 
+/* Render nframes into out. The freq and amp blocks hold one 
+ * value per frame, or may be NULL to use osc->freq and unity amp. */
+void process_block_phasorosc(lpphasorosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, isr;
+    size_t i;
+
+    if(nframes == 0) return;
+
+    phase = osc->phase;
+    isr = 1.0f/osc->samplerate;
+
+    if(freq == NULL) {
+        phaseinc = osc->freq * isr;
+        for(i=0; i < nframes; i++) {
+            phase += phaseinc;
+            while(phase >= 1) phase -= 1.0f;
+            out[i] = phase * 2.f - 1.f;
+        }
+    } else {
+        for(i=0; i < nframes; i++) {
+            phase += freq[i] * isr;
+            while(phase >= 1) phase -= 1.0f;
+            out[i] = phase * 2.f - 1.f;
+        }
+        osc->freq = freq[nframes-1];
+    }
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+
+    osc->phase = phase;
+}
+
 lpbuffer_t * render_phasorosc(lpphasorosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
-    lpfloat_t sample, _amp;
-    size_t i;
+    lpfloat_t block[LPOSC_BLOCKSIZE], freqblock[LPOSC_BLOCKSIZE], ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * freqs, * amps;
+    lpfloat_t _amp;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant paths */
+    if(freq->range == 1) osc->freq = freq->data[0];
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        osc->freq = LPInterpolation.linear_pos(freq, pos);
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        sample = process_phasorosc(osc) * _amp;
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = sample;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        freqs = (freq->range == 1) ? NULL : LPParam.fill_block(freq, freqblock, i, n, length);
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_phasorosc(osc, block, n, freqs, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j] * _amp;
+            }
         }
     }
 
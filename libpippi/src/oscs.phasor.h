@@ -12,6 +12,7 @@ typedef struct lpphasorosc_t {
 typedef struct lpphasorosc_factory_t {
     lpphasorosc_t * (*create)(void);
     lpfloat_t (*process)(lpphasorosc_t *);
+    void (*process_block)(lpphasorosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     lpbuffer_t * (*render)(lpphasorosc_t*, size_t, lpbuffer_t *, lpbuffer_t *, int);
     void (*destroy)(lpphasorosc_t *);
 } lpphasorosc_factory_t;
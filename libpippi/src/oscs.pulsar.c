@@ -91,26 +91,28 @@ void burst_table_from_file(lppulsarosc_t * osc, char * filename, size_t burst_si
 }
 
 
+/* The stacks come from the table cache and are shared 
+ * between voices: they must not be written to */
 void create_pulsarosc_wavetable_stack(lppulsarosc_t * p, int numtables, va_list vl) {
-    LPMemoryPool.free(p->wavetables);
+    LPBuffer.destroy(p->wavetables);
     LPMemoryPool.free(p->wavetable_onsets);
     LPMemoryPool.free(p->wavetable_lengths);
 
     p->num_wavetables = numtables;
     p->wavetable_onsets = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
     p->wavetable_lengths = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
-    p->wavetables = lpbuffer_create_stack(LPWavetable.create, numtables, p->wavetable_onsets, p->wavetable_lengths, vl);
+    p->wavetables = lptablecache_stack(LPTABLE_WAVETABLE, numtables, p->wavetable_onsets, p->wavetable_lengths, vl);
 }
 
 void create_pulsarosc_window_stack(lppulsarosc_t * p, int numtables, va_list vl) {
-    LPMemoryPool.free(p->windows);
+    LPBuffer.destroy(p->windows);
     LPMemoryPool.free(p->window_onsets);
     LPMemoryPool.free(p->window_lengths);
 
     p->num_windows = numtables;
     p->window_onsets = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
     p->window_lengths = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
-    p->windows = lpbuffer_create_stack(LPWindow.create, numtables, p->window_onsets, p->window_lengths, vl);
+    p->windows = lptablecache_stack(LPTABLE_WINDOW, numtables, p->window_onsets, p->window_lengths, vl);
 }
 
 
@@ -140,32 +142,22 @@ lppulsarosc_t * create_pulsarosc(int num_wavetables, int num_windows, ...) {
     return p;
 }
 
-lpfloat_t process_pulsarosc(lppulsarosc_t * p) {
-    lpfloat_t ipw, isr, sample, mod, a, b, 
+/* One sample of the pulsar osc. The inverse samplerate and 
+ * inverse pulsewidth are passed in so block rendering can 
+ * compute them once per block instead of once per sample. */
+static inline lpfloat_t pulsarosc_step(lppulsarosc_t * p, lpfloat_t isr, lpfloat_t ipw) {
+    lpfloat_t sample, mod, a, b, 
               wtmorphpos, wtmorphfrac,
               winmorphpos, winmorphfrac;
     int wavetable_index, window_index;
     int burst;
 
-#if DEBUG
-    assert(p->wavetables != NULL);
-    assert(p->num_wavetables > 0);
-    assert(p->windows != NULL);
-    assert(p->num_windows > 0);
-#endif
-
-    assert(p->samplerate > 0);
     wavetable_index = 0;
     window_index = 0;
-    isr = 1.f / (lpfloat_t)p->samplerate;
-    ipw = 1.f;
     sample = 0.f;
     mod = 0.f;
     burst = 1;
 
-    /* Store the inverse pulsewidth if non-zero */
-    if(p->pulsewidth > 0) ipw = 1.0/p->pulsewidth;
-
     /* Look up the burst value -- NULL burst is always on. 
      * In other words, bursting only happens when the burst 
      * table is non-NULL. Otherwise all pulses sound. */
@@ -245,9 +237,62 @@ lpfloat_t process_pulsarosc(lppulsarosc_t * p) {
     return sample * mod;
 }
 
+lpfloat_t process_pulsarosc(lppulsarosc_t * p) {
+    lpfloat_t ipw, isr;
+
+#if DEBUG
+    assert(p->wavetables != NULL);
+    assert(p->num_wavetables > 0);
+    assert(p->windows != NULL);
+    assert(p->num_windows > 0);
+#endif
+
+    assert(p->samplerate > 0);
+    isr = 1.f / (lpfloat_t)p->samplerate;
+    ipw = 1.f;
+
+    /* Store the inverse pulsewidth if non-zero */
+    if(p->pulsewidth > 0) ipw = 1.0/p->pulsewidth;
+
+    return pulsarosc_step(p, isr, ipw);
+}
+
+/* Render nframes into out. The freq and amp blocks hold one 
+ * value per frame, or may be NULL to use p->freq and unity amp. 
+ * Pulsewidth and saturation are read once per block, and 
+ * pulse_edge reflects the last frame rendered. */
+void process_block_pulsarosc(lppulsarosc_t * p, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t ipw, isr;
+    size_t i;
+
+    if(nframes == 0) return;
+
+    assert(p->samplerate > 0);
+    isr = 1.f / (lpfloat_t)p->samplerate;
+    ipw = 1.f;
+    if(p->pulsewidth > 0) ipw = 1.0/p->pulsewidth;
+
+    if(freq == NULL) {
+        for(i=0; i < nframes; i++) {
+            out[i] = pulsarosc_step(p, isr, ipw);
+        }
+    } else {
+        for(i=0; i < nframes; i++) {
+            p->freq = freq[i];
+            out[i] = pulsarosc_step(p, isr, ipw);
+        }
+    }
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+}
+
 void destroy_pulsarosc(lppulsarosc_t* p) {
+    LPBuffer.destroy(p->wavetables);
+    LPBuffer.destroy(p->windows);
     LPMemoryPool.free(p);
 }
 
 
-const lppulsarosc_factory_t LPPulsarOsc = { create_pulsarosc, burst_table_from_file, burst_table_from_bytes, process_pulsarosc, destroy_pulsarosc };
+const lppulsarosc_factory_t LPPulsarOsc = { create_pulsarosc, burst_table_from_file, burst_table_from_bytes, process_pulsarosc, process_block_pulsarosc, destroy_pulsarosc };
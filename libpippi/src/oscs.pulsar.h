@@ -38,6 +38,7 @@ typedef struct lppulsarosc_factory_t {
     void (*burst_file)(lppulsarosc_t * osc, char * filename, size_t burst_size);
     void (*burst_bytes)(lppulsarosc_t * osc, unsigned char * bytes, size_t burst_size);
     lpfloat_t (*process)(lppulsarosc_t *);
+    void (*process_block)(lppulsarosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     void (*destroy)(lppulsarosc_t*);
 } lppulsarosc_factory_t;
 
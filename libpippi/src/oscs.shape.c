@@ -28,6 +28,26 @@ lpfloat_t shapeosc_process(lpshapeosc_t * s) {
     return out;
 }
 
+/* Render nframes into out. Shape oscs pick their own freq from 
+ * their density, so the control block here drives density instead. 
+ * Either block may be NULL to use s->density and unity amp. */
+void shapeosc_process_block(lpshapeosc_t * s, lpfloat_t * out, size_t nframes, lpfloat_t * density, lpfloat_t * amp) {
+    size_t i;
+
+    if(density == NULL) {
+        for(i=0; i < nframes; i++) out[i] = shapeosc_process(s);
+    } else {
+        for(i=0; i < nframes; i++) {
+            s->density = density[i];
+            out[i] = shapeosc_process(s);
+        }
+    }
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+}
+
 lpfloat_t shapeosc_multiprocess(lpmultishapeosc_t * m) {
     lpfloat_t out;
     int i;
@@ -102,4 +122,4 @@ void shapeosc_multidestroy(lpmultishapeosc_t * m) {
     LPMemoryPool.free(m); 
 }
 
-const lpshapeosc_factory_t LPShapeOsc = { shapeosc_create, shapeosc_multicreate, shapeosc_process, shapeosc_multiprocess, shapeosc_destroy, shapeosc_multidestroy };
+const lpshapeosc_factory_t LPShapeOsc = { shapeosc_create, shapeosc_multicreate, shapeosc_process, shapeosc_process_block, shapeosc_multiprocess, shapeosc_destroy, shapeosc_multidestroy };
@@ -37,6 +37,7 @@ typedef struct lpshapeosc_factory_t {
     lpshapeosc_t * (*create)(lpbuffer_t * wt);
     lpmultishapeosc_t * (*multi)(int numshapeosc, ...);
     lpfloat_t (*process)(lpshapeosc_t * s);
+    void (*process_block)(lpshapeosc_t * s, lpfloat_t * out, size_t nframes, lpfloat_t * density, lpfloat_t * amp);
     lpfloat_t (*multiprocess)(lpmultishapeosc_t * m);
     void (*destroy)(lpshapeosc_t * s);
     void (*multidestroy)(lpmultishapeosc_t * m);
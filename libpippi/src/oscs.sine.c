@@ -3,10 +3,11 @@
 
 lpsineosc_t * create_sineosc(void);
 lpfloat_t process_sineosc(lpsineosc_t * osc);
+void process_block_sineosc(lpsineosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp);
 lpbuffer_t * render_sineosc(lpsineosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels);
 void destroy_sineosc(lpsineosc_t * osc);
 
-const lpsineosc_factory_t LPSineOsc = { create_sineosc, process_sineosc, render_sineosc, destroy_sineosc };
+const lpsineosc_factory_t LPSineOsc = { create_sineosc, process_sineosc, process_block_sineosc, render_sineosc, destroy_sineosc };
 
 lpsineosc_t * create_sineosc(void) {
     lpsineosc_t * osc = (lpsineosc_t *)LPMemoryPool.alloc(1, sizeof(lpsineosc_t));
@@ -19,7 +20,7 @@ lpsineosc_t * create_sineosc(void) {
 lpfloat_t process_sineosc(lpsineosc_t* osc) {
     lpfloat_t sample;
     
-    sample = sin((lpfloat_t)PI2 * osc->phase);
+    sample = lpfastsin(osc->phase);
 
     osc->phase += osc->freq * (1.0f/osc->samplerate);
 
@@ -30,22 +31,68 @@ lpfloat_t process_sineosc(lpsineosc_t* osc) {
     return sample;
 }
 
+/* Render nframes into out. The freq and amp blocks hold one 
+ * value per frame, or may be NULL to use osc->freq and unity amp. */
+void process_block_sineosc(lpsineosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, isr;
+    size_t i;
+
+    if(nframes == 0) return;
+
+    phase = osc->phase;
+    isr = 1.0f/osc->samplerate;
+
+    /* Lay the phases out in the output block first 
+     * and then take the sine of the whole block */
+    if(freq == NULL) {
+        phaseinc = osc->freq * isr;
+        for(i=0; i < nframes; i++) {
+            out[i] = phase;
+            phase += phaseinc;
+            while(phase >= 1) phase -= 1.0f;
+        }
+    } else {
+        for(i=0; i < nframes; i++) {
+            out[i] = phase;
+            phase += freq[i] * isr;
+            while(phase >= 1) phase -= 1.0f;
+        }
+        osc->freq = freq[nframes-1];
+    }
+
+    lpfastsin_block(out, out, nframes);
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+
+    osc->phase = phase;
+}
+
 lpbuffer_t * render_sineosc(lpsineosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
-    lpfloat_t sample, _amp;
-    size_t i;
+    lpfloat_t block[LPOSC_BLOCKSIZE], freqblock[LPOSC_BLOCKSIZE], ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * freqs, * amps;
+    lpfloat_t _amp;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant paths */
+    if(freq->range == 1) osc->freq = freq->data[0];
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        osc->freq = LPInterpolation.linear_pos(freq, pos);
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        sample = process_sineosc(osc) * _amp;
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = sample;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        freqs = (freq->range == 1) ? NULL : LPParam.fill_block(freq, freqblock, i, n, length);
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_sineosc(osc, block, n, freqs, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j] * _amp;
+            }
         }
     }
 
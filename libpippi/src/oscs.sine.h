@@ -12,6 +12,7 @@ typedef struct lpsineosc_t {
 typedef struct lpsineosc_factory_t {
     lpsineosc_t * (*create)(void);
     lpfloat_t (*process)(lpsineosc_t *);
+    void (*process_block)(lpsineosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     lpbuffer_t * (*render)(lpsineosc_t*, size_t, lpbuffer_t *, lpbuffer_t *, int);
     void (*destroy)(lpsineosc_t *);
 } lpsineosc_factory_t;
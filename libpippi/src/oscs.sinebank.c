@@ -0,0 +1,145 @@
+#include "pippicore.h"
+#include "oscs.sinebank.h"
+
+typedef lpfloat_t lpsinebank_vec_t __attribute__((vector_size(LPSINEBANK_LANES * sizeof(lpfloat_t))));
+
+lpsinebank_t * create_sinebank(size_t numpartials, lpfloat_t samplerate);
+void set_partial_sinebank(lpsinebank_t * bank, size_t index, lpfloat_t freq, lpfloat_t amp);
+void set_phase_sinebank(lpsinebank_t * bank, size_t index, lpfloat_t phase);
+void process_block_sinebank(lpsinebank_t * bank, lpfloat_t * out, size_t nframes);
+lpbuffer_t * render_sinebank(lpsinebank_t * bank, size_t length, int channels);
+void destroy_sinebank(lpsinebank_t * bank);
+
+const lpsinebank_factory_t LPSineBank = { create_sinebank, set_partial_sinebank, set_phase_sinebank, process_block_sinebank, render_sinebank, destroy_sinebank };
+
+lpsinebank_t * create_sinebank(size_t numpartials, lpfloat_t samplerate) {
+    lpsinebank_t * bank;
+    size_t p;
+
+    bank = (lpsinebank_t *)LPMemoryPool.alloc(1, sizeof(lpsinebank_t));
+    bank->numpartials = numpartials;
+    bank->numlanes = ((numpartials + LPSINEBANK_LANES - 1) / LPSINEBANK_LANES) * LPSINEBANK_LANES;
+    bank->samplerate = samplerate;
+
+    bank->freqs = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+    bank->amps = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+    bank->re = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+    bank->im = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+    bank->rotre = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+    bank->rotim = (lpfloat_t *)LPMemoryPool.alloc(bank->numlanes, sizeof(lpfloat_t));
+
+    /* Silent partials at phase 0 that don't rotate.
+     * The padding lanes stay this way. */
+    for(p=0; p < bank->numlanes; p++) {
+        bank->freqs[p] = 0.f;
+        bank->amps[p] = 0.f;
+        bank->re[p] = 1.f;
+        bank->im[p] = 0.f;
+        bank->rotre[p] = 1.f;
+        bank->rotim[p] = 0.f;
+    }
+
+    return bank;
+}
+
+void set_partial_sinebank(lpsinebank_t * bank, size_t index, lpfloat_t freq, lpfloat_t amp) {
+    lpfloat_t phaseinc;
+
+    assert(index < bank->numpartials);
+
+    phaseinc = freq / bank->samplerate;
+    bank->freqs[index] = freq;
+    bank->amps[index] = amp;
+    /* The rotation is applied every frame, so any error 
+     * here accumulates as phase drift: this is control 
+     * rate, so take it from libm at full precision */
+    bank->rotre[index] = (lpfloat_t)cos((lpfloat_t)PI2 * phaseinc);
+    bank->rotim[index] = (lpfloat_t)sin((lpfloat_t)PI2 * phaseinc);
+}
+
+/* Phase is in cycles */
+void set_phase_sinebank(lpsinebank_t * bank, size_t index, lpfloat_t phase) {
+    assert(index < bank->numpartials);
+    bank->re[index] = lpfastcos(phase);
+    bank->im[index] = lpfastsin(phase);
+}
+
+/* Sum every partial into nframes of out.
+ *
+ * The rotation is exact only up to rounding, so the
+ * phasors slowly drift off the unit circle: they are
+ * pulled back with one Newton step toward |z| = 1
+ * after each LPOSC_BLOCKSIZE frames, well before the
+ * drift is measurable. */
+void process_block_sinebank(lpsinebank_t * bank, lpfloat_t * out, size_t nframes) {
+    lpsinebank_vec_t acc[LPOSC_BLOCKSIZE];
+    lpsinebank_vec_t re, im, rotre, rotim, amp, tmp, gain;
+    lpfloat_t sample;
+    size_t i, j, p, n, offset;
+
+    for(offset=0; offset < nframes; offset += n) {
+        n = (nframes - offset < LPOSC_BLOCKSIZE) ? nframes - offset : LPOSC_BLOCKSIZE;
+        memset(acc, 0, sizeof(lpsinebank_vec_t) * n);
+
+        for(p=0; p < bank->numlanes; p += LPSINEBANK_LANES) {
+            memcpy(&re, bank->re + p, sizeof(lpsinebank_vec_t));
+            memcpy(&im, bank->im + p, sizeof(lpsinebank_vec_t));
+            memcpy(&rotre, bank->rotre + p, sizeof(lpsinebank_vec_t));
+            memcpy(&rotim, bank->rotim + p, sizeof(lpsinebank_vec_t));
+            memcpy(&amp, bank->amps + p, sizeof(lpsinebank_vec_t));
+
+            for(i=0; i < n; i++) {
+                acc[i] += amp * im;
+                tmp = re * rotre - im * rotim;
+                im = re * rotim + im * rotre;
+                re = tmp;
+            }
+
+            gain = (lpfloat_t)1.5f - (lpfloat_t)0.5f * (re * re + im * im);
+            re *= gain;
+            im *= gain;
+
+            memcpy(bank->re + p, &re, sizeof(lpsinebank_vec_t));
+            memcpy(bank->im + p, &im, sizeof(lpsinebank_vec_t));
+        }
+
+        for(i=0; i < n; i++) {
+            sample = 0.f;
+            for(j=0; j < LPSINEBANK_LANES; j++) {
+                sample += acc[i][j];
+            }
+            out[offset + i] = sample;
+        }
+    }
+}
+
+lpbuffer_t * render_sinebank(lpsinebank_t * bank, size_t length, int channels) {
+    lpbuffer_t * out;
+    lpfloat_t block[LPOSC_BLOCKSIZE];
+    size_t i, j, n;
+    int c;
+
+    out = LPBuffer.create(length, channels, bank->samplerate);
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        process_block_sinebank(bank, block, n);
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j];
+            }
+        }
+    }
+
+    return out;
+}
+
+void destroy_sinebank(lpsinebank_t * bank) {
+    if(bank == NULL) return;
+    LPMemoryPool.free(bank->freqs);
+    LPMemoryPool.free(bank->amps);
+    LPMemoryPool.free(bank->re);
+    LPMemoryPool.free(bank->im);
+    LPMemoryPool.free(bank->rotre);
+    LPMemoryPool.free(bank->rotim);
+    LPMemoryPool.free(bank);
+}
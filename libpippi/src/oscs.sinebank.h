@@ -0,0 +1,47 @@
+#ifndef LP_SINEBANK_H
+#define LP_SINEBANK_H
+
+#include "pippicore.h"
+
+/* Partials are processed this many at a time */
+#define LPSINEBANK_LANES 4
+
+/* A bank of sine partials rendered with quadrature 
+ * oscillators: each partial is a unit phasor (re, im) 
+ * rotated by a fixed (rotre, rotim) every frame, so 
+ * there is no sin() in the render loop at all.
+ *
+ * Partial state is stored as arrays (one per field) 
+ * padded out to a multiple of LPSINEBANK_LANES so the 
+ * render loop can step through the partials in vectors.
+ *
+ * Frequencies and amplitudes are meant to change 
+ * between blocks: set_partial takes effect at the 
+ * start of the next process_block call.
+ */
+typedef struct lpsinebank_t {
+    size_t numpartials;
+    size_t numlanes;
+    lpfloat_t samplerate;
+
+    lpfloat_t * freqs;
+    lpfloat_t * amps;
+
+    lpfloat_t * re;
+    lpfloat_t * im;
+    lpfloat_t * rotre;
+    lpfloat_t * rotim;
+} lpsinebank_t;
+
+typedef struct lpsinebank_factory_t {
+    lpsinebank_t * (*create)(size_t numpartials, lpfloat_t samplerate);
+    void (*set_partial)(lpsinebank_t *, size_t index, lpfloat_t freq, lpfloat_t amp);
+    void (*set_phase)(lpsinebank_t *, size_t index, lpfloat_t phase);
+    void (*process_block)(lpsinebank_t *, lpfloat_t *, size_t);
+    lpbuffer_t * (*render)(lpsinebank_t *, size_t, int);
+    void (*destroy)(lpsinebank_t *);
+} lpsinebank_factory_t;
+
+extern const lpsinebank_factory_t LPSineBank;
+
+#endif
@@ -2,10 +2,11 @@
 
 lptableosc_t * create_tableosc(lpbuffer_t * buf);
 lpfloat_t process_tableosc(lptableosc_t * osc);
+void process_block_tableosc(lptableosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp);
 lpbuffer_t * render_tableosc(lptableosc_t * osc, size_t length, lpbuffer_t * amp, int channels);
 void destroy_tableosc(lptableosc_t * osc);
 
-const lptableosc_factory_t LPTableOsc = { create_tableosc, process_tableosc, render_tableosc, destroy_tableosc };
+const lptableosc_factory_t LPTableOsc = { create_tableosc, process_tableosc, process_block_tableosc, render_tableosc, destroy_tableosc };
 
 lptableosc_t * create_tableosc(lpbuffer_t * buf) {
     lptableosc_t* osc = (lptableosc_t*)LPMemoryPool.alloc(1, sizeof(lptableosc_t));
@@ -50,21 +51,78 @@ lpfloat_t process_tableosc(lptableosc_t * osc) {
     return sample;
 }
 
+/* Render nframes into out. The freq and amp blocks hold one 
+ * value per frame, or may be NULL to use osc->freq and unity amp. 
+ * The gate is set if the table wrapped anywhere in the block. */
+void process_block_tableosc(lptableosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, sample, f, a, b;
+    lpfloat_t * data;
+    size_t i, idxa, idxb, boundry;
+    int c, channels, gate;
+
+    if(nframes == 0) return;
+
+    data = osc->buf->data;
+    channels = osc->buf->channels;
+    boundry = osc->buf->length-1;
+    phase = osc->phase;
+    phaseinc = osc->phaseinc * osc->freq;
+    gate = 0;
+
+    for(i=0; i < nframes; i++) {
+        f = phase - (int)phase;
+        idxa = (size_t)phase;
+        idxb = idxa + 1;
+
+        sample = 0.f;
+        for(c=0; c < channels; c++) {
+            a = data[idxa * channels + c];
+            b = data[idxb * channels + c];
+            sample += (1.f - f) * a + (f * b);
+        }
+        out[i] = sample;
+
+        if(freq != NULL) phaseinc = osc->phaseinc * freq[i];
+        phase += phaseinc;
+
+        if(phase >= boundry) {
+            phase -= boundry;
+            gate = 1;
+        }
+    }
+
+    if(freq != NULL) osc->freq = freq[nframes-1];
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+
+    osc->phase = phase;
+    osc->gate = gate;
+}
+
 lpbuffer_t * render_tableosc(lptableosc_t * osc, size_t length, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
-    lpfloat_t _amp, sample;
-    size_t i;
+    lpfloat_t block[LPOSC_BLOCKSIZE], ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * amps;
+    lpfloat_t _amp;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant path */
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        sample = process_tableosc(osc);
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = sample * _amp;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_tableosc(osc, block, n, NULL, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j] * _amp;
+            }
         }
     }
 
@@ -15,6 +15,7 @@ typedef struct lptableosc_t {
 typedef struct lptableosc_factory_t {
     lptableosc_t * (*create)(lpbuffer_t *);
     lpfloat_t (*process)(lptableosc_t *);
+    void (*process_block)(lptableosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     lpbuffer_t * (*render)(lptableosc_t *, size_t, lpbuffer_t *, int);
     void (*destroy)(lptableosc_t *);
 } lptableosc_factory_t;
@@ -2,6 +2,7 @@
 
 lptapeosc_t * create_tapeosc(lpbuffer_t * buf, lpfloat_t range);
 void process_tapeosc(lptapeosc_t * osc);
+void process_block_tapeosc(lptapeosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * speed, lpfloat_t * amp);
 void rewind_tapeosc(lptapeosc_t * osc);
 lpbuffer_t * render_tapeosc(lptapeosc_t * osc, size_t length, lpbuffer_t * amp, int channels);
 void destroy_tapeosc(lptapeosc_t * osc);
@@ -9,6 +10,7 @@ void destroy_tapeosc(lptapeosc_t * osc);
 const lptapeosc_factory_t LPTapeOsc = { 
     create_tapeosc, 
     process_tapeosc, 
+    process_block_tapeosc, 
     rewind_tapeosc, 
     render_tapeosc, 
     destroy_tapeosc 
@@ -55,8 +57,6 @@ void process_tapeosc(lptapeosc_t * osc) {
     channels = osc->buf->channels;
     boundry = osc->range + osc->start;
 
-    printf("phase %f channels %i boundry %ld speed %f\n", osc->phase, channels, boundry, osc->speed);
-
     f = osc->phase - (int)osc->phase;
     idxa = (size_t)osc->phase;
     idxb = idxa + 1;
@@ -69,7 +69,6 @@ void process_tapeosc(lptapeosc_t * osc) {
     }
 
     osc->phase += osc->speed;
-    printf("phase %f channels %i boundry %ld speed %f\n", osc->phase, channels, boundry, osc->speed);
 
     if(osc->phase >= boundry) {
         osc->phase = osc->start;
@@ -120,21 +119,86 @@ void process_tapeosc(lptapeosc_t * osc) {
 }
 */
 
+/* Render nframes of interleaved frames into out, which must hold 
+ * nframes * osc->buf->channels values. The speed and amp blocks 
+ * hold one value per frame, or may be NULL to use osc->speed and 
+ * unity amp. The last frame is also left in osc->current_frame, 
+ * and the gate is set if the tape looped anywhere in the block. */
+void process_block_tapeosc(lptapeosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * speed, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, start, f, a, b;
+    lpfloat_t * data;
+    size_t i, idxa, idxb, boundry;
+    int c, channels, gate;
+
+    if(nframes == 0) return;
+
+    data = osc->buf->data;
+    channels = osc->buf->channels;
+    start = osc->start;
+    boundry = osc->range + osc->start;
+    phase = osc->phase;
+    phaseinc = osc->speed;
+    gate = 0;
+
+    for(i=0; i < nframes; i++) {
+        f = phase - (int)phase;
+        idxa = (size_t)phase;
+        idxb = idxa + 1;
+
+        for(c=0; c < channels; c++) {
+            a = data[idxa * channels + c];
+            b = data[idxb * channels + c];
+            out[i * channels + c] = (1.f - f) * a + (f * b);
+        }
+
+        if(speed != NULL) phaseinc = speed[i];
+        phase += phaseinc;
+
+        if(phase >= boundry) {
+            phase = start;
+            gate = 1;
+        }
+    }
+
+    if(speed != NULL) osc->speed = speed[nframes-1];
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) {
+            for(c=0; c < channels; c++) out[i * channels + c] *= amp[i];
+        }
+    }
+
+    for(c=0; c < channels; c++) {
+        osc->current_frame->data[c] = out[(nframes-1) * channels + c];
+    }
+
+    osc->phase = phase;
+    osc->gate = gate;
+}
+
 lpbuffer_t * render_tapeosc(lptapeosc_t * osc, size_t length, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
+    lpfloat_t block[LPOSC_BLOCKSIZE * osc->buf->channels];
+    lpfloat_t ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * amps;
     lpfloat_t _amp;
-    size_t i;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant path */
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        process_tapeosc(osc);
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = osc->current_frame->data[c] * _amp;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_tapeosc(osc, block, n, NULL, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j * osc->buf->channels + (c % osc->buf->channels)] * _amp;
+            }
         }
     }
 
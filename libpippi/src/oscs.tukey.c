@@ -3,10 +3,11 @@
 
 lptukeyosc_t * create_tukeyosc(void);
 lpfloat_t process_tukeyosc(lptukeyosc_t * osc);
+void process_block_tukeyosc(lptukeyosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp);
 lpbuffer_t * render_tukeyosc(lptukeyosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels);
 void destroy_tukeyosc(lptukeyosc_t * osc);
 
-const lptukeyosc_factory_t LPTukeyOsc = { create_tukeyosc, process_tukeyosc, render_tukeyosc, destroy_tukeyosc };
+const lptukeyosc_factory_t LPTukeyOsc = { create_tukeyosc, process_tukeyosc, process_block_tukeyosc, render_tukeyosc, destroy_tukeyosc };
 
 lptukeyosc_t * create_tukeyosc(void) {
     lptukeyosc_t * osc = (lptukeyosc_t *)LPMemoryPool.alloc(1, sizeof(lptukeyosc_t));
@@ -50,22 +51,78 @@ lpfloat_t process_tukeyosc(lptukeyosc_t* osc) {
     return sample;
 }
 
+/* Render nframes into out. The freq and amp blocks hold one 
+ * value per frame, or may be NULL to use osc->freq and unity amp. 
+ * The shape is read once per block. */
+void process_block_tukeyosc(lptukeyosc_t * osc, lpfloat_t * out, size_t nframes, lpfloat_t * freq, lpfloat_t * amp) {
+    lpfloat_t phase, phaseinc, isr, a, halfshape, sample;
+    int direction;
+    size_t i;
+
+    if(nframes == 0) return;
+
+    if(osc->shape < 0.00001f) osc->shape = 0.00001f;
+    if(osc->shape > 1.f) osc->shape = 1.f;
+
+    a = PI2 / osc->shape;
+    halfshape = osc->shape / 2.f;
+    isr = 1.0/osc->samplerate;
+    phase = osc->phase;
+    direction = osc->direction;
+    phaseinc = isr * osc->freq * 2.f;
+
+    for(i=0; i < nframes; i++) {
+        if(phase <= halfshape) {
+            sample = 0.5 * (1.f + cos(a * (phase - halfshape)));
+        } else if(phase < 1 - halfshape) {
+            sample = 1.f;
+        } else {
+            sample = 0.5f * (1.f + cos(a * (phase - 1.f + halfshape)));
+        }
+
+        out[i] = sample * direction;
+
+        if(freq != NULL) phaseinc = isr * freq[i] * 2.f;
+        phase += phaseinc;
+
+        if(phase > 1.f) direction *= -1;
+        while(phase >= 1.f) phase -= 1.f;
+    }
+
+    if(freq != NULL) osc->freq = freq[nframes-1];
+
+    if(amp != NULL) {
+        for(i=0; i < nframes; i++) out[i] *= amp[i];
+    }
+
+    osc->phase = phase;
+    osc->direction = direction;
+}
+
 lpbuffer_t * render_tukeyosc(lptukeyosc_t * osc, size_t length, lpbuffer_t * freq, lpbuffer_t * amp, int channels) {
     lpbuffer_t * out;
-    lpfloat_t sample, _amp;
-    size_t i;
+    lpfloat_t block[LPOSC_BLOCKSIZE], freqblock[LPOSC_BLOCKSIZE], ampblock[LPOSC_BLOCKSIZE];
+    lpfloat_t * freqs, * amps;
+    lpfloat_t _amp;
+    size_t i, j, n;
     int c;
-    float pos;
 
-    pos = 0.f;
+    /* Single value params take the constant paths */
+    if(freq->range == 1) osc->freq = freq->data[0];
+    _amp = (amp->range == 1) ? amp->data[0] : 1.f;
+
     out = LPBuffer.create(length, channels, osc->samplerate);
-    for(i=0; i < length; i++) {
-        pos = (float)i/length;
-        osc->freq = LPInterpolation.linear_pos(freq, pos);
-        _amp = LPInterpolation.linear_pos(amp, pos);
-        sample = process_tukeyosc(osc) * _amp;
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = sample;
+    for(i=0; i < length; i += n) {
+        n = (length - i < LPOSC_BLOCKSIZE) ? length - i : LPOSC_BLOCKSIZE;
+        freqs = (freq->range == 1) ? NULL : LPParam.fill_block(freq, freqblock, i, n, length);
+        amps = (amp->range == 1) ? NULL : LPParam.fill_block(amp, ampblock, i, n, length);
+
+        process_block_tukeyosc(osc, block, n, freqs, amps);
+
+        for(j=0; j < n; j++) {
+            for(c=0; c < channels; c++) {
+                out->data[(i+j) * channels + c] = block[j] * _amp;
+            }
         }
     }
 
@@ -14,6 +14,7 @@ typedef struct lptukeyosc_t {
 typedef struct lptukeyosc_factory_t {
     lptukeyosc_t * (*create)(void);
     lpfloat_t (*process)(lptukeyosc_t *);
+    void (*process_block)(lptukeyosc_t *, lpfloat_t *, size_t, lpfloat_t *, lpfloat_t *);
     lpbuffer_t * (*render)(lptukeyosc_t*, size_t, lpbuffer_t *, lpbuffer_t *, int);
     void (*destroy)(lptukeyosc_t *);
 } lptukeyosc_factory_t;
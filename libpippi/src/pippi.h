@@ -1,6 +1,7 @@
 #include "pippicore.h"
 
 #include "fx.softclip.h"
+#include "fx.convolver.h"
 
 #include "oscs.bln.h"
 #include "oscs.node.h"
@@ -8,14 +9,19 @@
 #include "oscs.pulsar.h"
 #include "oscs.shape.h"
 #include "oscs.sine.h"
+#include "oscs.sinebank.h"
 #include "oscs.fract.h"
 #include "oscs.tape.h"
 #include "oscs.table.h"
 #include "oscs.tukey.h"
 
+#include "jobs.h"
 #include "microsound.h"
 #include "mir.h"
+#include "resampler.h"
+#include "samplelib.h"
 #include "soundfile.h"
 #include "spectral.h"
+#include "ugens.graph.h"
 
 
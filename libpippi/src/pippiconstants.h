@@ -49,6 +49,55 @@
 #define DEFAULT_SAMPLERATE 48000
 #define DEFAULT_TABLESIZE 4096
 
+/* Oscillator render helpers step through their 
+ * control curves in blocks of this many frames */
+#define LPOSC_BLOCKSIZE 256
+
+/* Buffer ops that have to expand a mono source 
+ * or an envelope before handing it to the vector 
+ * kernels work through it in chunks of this size */
+#define LPKERNELS_BLOCKSIZE 256
+
+/* Memorypool blocks are aligned to (and carry a header 
+ * of) LPMEMORYPOOL_ALIGN bytes. Sizes are rounded up to 
+ * one of LPMEMORYPOOL_NUMCLASSES size classes: four 
+ * steps per power of two, so at most 25% is wasted. 
+ *
+ * Each thread keeps up to LPMEMORYPOOL_CACHESIZE freed 
+ * blocks of each of the first LPMEMORYPOOL_CACHECLASSES 
+ * classes (up to 64KB) for the primary pool. */
+#define LPMEMORYPOOL_ALIGN 16
+#define LPMEMORYPOOL_NUMCLASSES 160
+#define LPMEMORYPOOL_CACHECLASSES 40
+#define LPMEMORYPOOL_CACHESIZE 8
+#define LPMEMORYPOOL_MAXSCOPES 8
+
+/* The bulk LPRand fills step this many generators 
+ * at once, through a scratch block of LPRAND_BLOCKSIZE 
+ * raw values at a time */
+#define LPRAND_LANES 4
+#define LPRAND_BLOCKSIZE 256
+#define LPRAND_SEED_DEFAULT 0
+
+/* Table cache keys and shared memory names fit in 
+ * LPTABLECACHE_KEYSIZE bytes. A process mapping a table 
+ * another one is still filling waits for it up to 
+ * LPTABLECACHE_WAIT times a millisecond. Bump the version 
+ * whenever a table generator changes. */
+#define LPTABLECACHE_KEYSIZE 256
+#define LPTABLECACHE_PREFIXSIZE 32
+#define LPTABLECACHE_WAIT 1000
+#define LPTABLECACHE_VERSION 1
+
+/* The table cache keeps at most LPTABLECACHE_MAXENTRIES 
+ * tables that nobody else is holding, hashed into 
+ * LPTABLECACHE_BUCKETS (a power of two) chains. Wavetables 
+ * and windows are only cached at power of two lengths up 
+ * to LPTABLECACHE_MAXLENGTH. */
+#define LPTABLECACHE_MAXENTRIES 512
+#define LPTABLECACHE_BUCKETS 256
+#define LPTABLECACHE_MAXLENGTH 65536
+
 #ifdef LP_FLOAT
 #define HANN_WINDOW_SIZE 256
 #else
@@ -60,7 +109,9 @@
 #endif
 
 #define LPMAXNAME 24
-#define LPMAXMSG (PIPE_BUF - (sizeof(double) * 4) - (sizeof(size_t) * 3) - (sizeof(uint16_t) * 2) - LPMAXNAME)
+#define LPMAXROUTE 32
+#define LPROUTESIZE (sizeof(uint32_t) + (sizeof(uint16_t) * LPMAXROUTE) + (sizeof(float) * LPMAXROUTE))
+#define LPMAXMSG (PIPE_BUF - (sizeof(double) * 4) - (sizeof(size_t) * 3) - (sizeof(uint16_t) * 2) - LPROUTESIZE - LPMAXNAME)
 
 
 enum Wavetables {
@@ -93,6 +144,12 @@ enum Windows {
     NUM_WINDOWS
 };
 
+enum LPTableKinds {
+    LPTABLE_WAVETABLE,
+    LPTABLE_WINDOW,
+    NUM_LPTABLEKINDS
+};
+
 enum PanMethods {
     PANMETHOD_CONSTANT,
     PANMETHOD_LINEAR,
@@ -1,5 +1,12 @@
 #include "pippicore.h"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
 
 /* Forward declarations */
 void rand_preseed(void);
@@ -14,10 +21,35 @@ lpfloat_t rand_base_lorenzZ(lpfloat_t low, lpfloat_t high);
 int rand_randint(int low, int high);
 int rand_randbool(void);
 int rand_choice(int numchoices);
+lpfloat_t rand_base_xoshiro(lpfloat_t low, lpfloat_t high);
+lprng_t * rand_create(uint64_t seed);
+lprng_t * rand_thread_default(void);
+void rand_seed_state(lprng_t * rng, uint64_t seed);
+void rand_jump(lprng_t * rng);
+lprng_t * rand_split(lprng_t * rng);
+uint64_t rand_next(lprng_t * rng);
+lpfloat_t rand_uniform(lprng_t * rng, lpfloat_t low, lpfloat_t high);
+lpfloat_t rand_gaussian(lprng_t * rng, lpfloat_t mean, lpfloat_t stddev);
+void rand_fill_uniform(lprng_t * rng, lpfloat_t * out, size_t n, lpfloat_t low, lpfloat_t high);
+void rand_fill_gaussian(lprng_t * rng, lpfloat_t * out, size_t n, lpfloat_t mean, lpfloat_t stddev);
+void rand_fill_choice(lprng_t * rng, int * out, size_t n, int numchoices);
+void rand_destroy(lprng_t * rng);
 
 lparray_t * create_array_from(int numvalues, ...);
 lparray_t * create_array(size_t length);
 void destroy_array(lparray_t * array);
+void kernel_ref_add(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+void kernel_ref_subtract(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+void kernel_ref_multiply(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+void kernel_ref_divide(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+void kernel_ref_add_scalar(lpfloat_t * a, lpfloat_t b, size_t n);
+void kernel_ref_subtract_scalar(lpfloat_t * a, lpfloat_t b, size_t n);
+void kernel_ref_multiply_scalar(lpfloat_t * a, lpfloat_t b, size_t n);
+void kernel_ref_divide_scalar(lpfloat_t * a, lpfloat_t b, size_t n);
+void kernel_ref_scale(lpfloat_t * a, size_t n, lpfloat_t from_min, lpfloat_t from_diff, lpfloat_t to_diff, lpfloat_t to_min);
+void kernel_ref_clip(lpfloat_t * a, size_t n, lpfloat_t minval, lpfloat_t maxval);
+lpfloat_t kernel_ref_mag(const lpfloat_t * a, size_t n);
+int kernels_select(const char * name);
 
 lpbuffer_t * create_buffer(size_t length, int channels, int samplerate);
 lpbuffer_t * create_buffer_from_float(lpfloat_t value, size_t length, int channels, int samplerate);
@@ -28,6 +60,7 @@ void scale_buffer(lpbuffer_t * buf, lpfloat_t from_min, lpfloat_t from_max, lpfl
 lpfloat_t min_buffer(lpbuffer_t * buf);
 lpfloat_t max_buffer(lpbuffer_t * buf);
 lpfloat_t mag_buffer(lpbuffer_t * buf);
+lpsamples_t samples_buffer(lpbuffer_t * buf, int channel);
 void multiply_buffer(lpbuffer_t * a, lpbuffer_t * b);
 void scalar_multiply_buffer(lpbuffer_t * a, lpfloat_t b);
 void add_buffers(lpbuffer_t * a, lpbuffer_t * b);
@@ -63,7 +96,22 @@ lpbuffer_t * reverse_buffer(lpbuffer_t * buf);
 lpbuffer_t * resize_buffer(lpbuffer_t *, size_t);
 void destroy_buffer(lpbuffer_t * buf);
 
+lpbufferview_t * view_create(lpbuffer_t * buf);
+lpbufferview_t * view_cut(lpbufferview_t * view, size_t start, size_t length);
+lpbufferview_t * view_reverse(lpbufferview_t * view);
+lpbufferview_t * view_channel(lpbufferview_t * view, int channel);
+lpbufferview_t * view_pad(lpbufferview_t * view, size_t before, size_t after);
+lpfloat_t view_read(lpbufferview_t * view, size_t frame, int channel);
+lpsamples_t view_samples(lpbufferview_t * view, int channel);
+lpfloat_t view_min(lpbufferview_t * view);
+lpfloat_t view_max(lpbufferview_t * view);
+lpfloat_t view_mag(lpbufferview_t * view);
+void view_dub(lpbuffer_t * out, lpbufferview_t * view, lpbuffer_t * env, size_t start);
+lpbuffer_t * view_materialize(lpbufferview_t * view);
+void view_destroy(lpbufferview_t * view);
+
 lpfloat_t read_skewed_buffer(lpfloat_t freq, lpbuffer_t * buf, lpfloat_t phase, lpfloat_t skew);
+lpfloat_t read_skewed_samples(lpfloat_t freq, lpsamples_t samples, lpfloat_t phase, lpfloat_t skew);
 lpfloat_t fx_lpf1(lpfloat_t x, lpfloat_t * y, lpfloat_t cutoff, lpfloat_t samplerate);
 void fx_convolve(lpbuffer_t * a, lpbuffer_t * b, lpbuffer_t * out);
 void fx_norm(lpbuffer_t * buf, lpfloat_t ceiling);
@@ -79,12 +127,27 @@ void ringbuffer_writefrom(lpbuffer_t * ringbuf, lpfloat_t * data, size_t length,
 void ringbuffer_write(lpbuffer_t * ringbuf, lpbuffer_t * buf);
 void ringbuffer_dub(lpbuffer_t * buf, lpbuffer_t * src);
 void ringbuffer_destroy(lpbuffer_t * buf);
+void ringbuffer_tap(lpbuffer_t * ringbuf, lpfloat_t delay, lpfloat_t * frame);
+void ringbuffer_tapinto(lpbuffer_t * ringbuf, const lpfloat_t * delays, lpfloat_t * out, size_t nframes);
+
+lpspscring_t * spscring_create(size_t length, int channels, int samplerate);
+size_t spscring_write(lpspscring_t * ring, const lpfloat_t * data, size_t nframes);
+size_t spscring_read(lpspscring_t * ring, lpfloat_t * data, size_t nframes);
+size_t spscring_readable(lpspscring_t * ring);
+size_t spscring_writable(lpspscring_t * ring);
+void spscring_destroy(lpspscring_t * ring);
 
 void memorypool_init(unsigned char * pool, size_t poolsize);
 lpmemorypool_t * memorypool_custom_init(unsigned char * pool, size_t poolsize);
 void * memorypool_alloc(size_t itemcount, size_t itemsize);
 void * memorypool_custom_alloc(lpmemorypool_t * pool, size_t itemcount, size_t itemsize);
 void memorypool_free(void * ptr);
+size_t memorypool_mark(lpmemorypool_t * mp);
+void memorypool_reset(lpmemorypool_t * mp, size_t mark);
+size_t memorypool_scope_begin(lpmemorypool_t * arena);
+void memorypool_scope_end(lpmemorypool_t * arena, size_t mark);
+void memorypool_thread_release(void);
+lpmemorypool_stats_t memorypool_stats(lpmemorypool_t * mp);
 
 lpfloat_t interpolate_hermite(lpbuffer_t * buf, lpfloat_t phase);
 lpfloat_t interpolate_hermite_pos(lpbuffer_t * buf, lpfloat_t pos);
@@ -95,6 +158,7 @@ lpfloat_t interpolate_linear_channel(lpbuffer_t* buf, lpfloat_t phase, int chann
 
 lpbuffer_t * param_create_from_float(lpfloat_t value);
 lpbuffer_t * param_create_from_int(int value);
+lpfloat_t * param_fill_block(lpbuffer_t * param, lpfloat_t * block, size_t offset, size_t nframes, size_t length);
 
 lpbuffer_t * create_wavetable(int name, size_t length);
 void destroy_wavetable(lpbuffer_t* buf);
@@ -103,6 +167,13 @@ lpbuffer_t * lpbuffer_create_stack(lpbuffer_t * (*table_creator)(int name, size_
 lpbuffer_t * create_window_stack(int numtables, size_t * onsets, size_t * lengths, ...);
 lpbuffer_t * create_wavetable_stack(int numtables, size_t * onsets, size_t * lengths, ...);
 void destroy_window(lpbuffer_t* buf);
+lpbuffer_t * tablecache_get(int kind, int name, size_t length);
+static int tablecache_cacheable(size_t length);
+static void tablecache_fill(int kind, int numtables, const int * names, const size_t * tablesizes, lpfloat_t * out);
+lpbuffer_t * tablecache_get_stack(int kind, int numtables, size_t * onsets, size_t * lengths, ...);
+int tablecache_share(const char * prefix);
+size_t tablecache_count(void);
+void tablecache_flush(void);
 
 #ifdef LP_FLOAT
 const lpfloat_t LPHANN_WINDOW[] = { 0.0000000000,0.0001517740,0.0006070039,0.0013654133,0.0024265418,0.0037897452,0.0054541958,0.0074188833,0.0096826148,0.0122440160,0.0151015320,0.0182534279,0.0216977902,0.0254325280,0.0294553737,0.0337638853,0.0383554469,0.0432272712,0.0483764003,0.0537997084,0.0594939029,0.0654555268,0.0716809611,0.0781664261,0.0849079846,0.0919015438,0.0991428580,0.1066275310,0.1143510188,0.1223086326,0.1304955414,0.1389067748,0.1475372265,0.1563816570,0.1654346968,0.1746908499,0.1841444969,0.1937898985,0.2036211990,0.2136324300,0.2238175135,0.2341702664,0.2446844034,0.2553535415,0.2661712036,0.2771308221,0.2882257437,0.2994492325,0.3107944750,0.3222545833,0.3338226003,0.3454915028,0.3572542069,0.3691035713,0.3810324025,0.3930334584,0.4050994533,0.4172230619,0.4293969241,0.4416136491,0.4538658203,0.4661459993,0.4784467310,0.4907605475,0.5030799733,0.5153975293,0.5277057375,0.5399971256,0.5522642316,0.5644996083,0.5766958274,0.5888454849,0.6009412046,0.6129756433,0.6249414949,0.6368314950,0.6486384253,0.6603551178,0.6719744593,0.6834893958,0.6948929366,0.7061781587,0.7173382109,0.7283663179,0.7392557846,0.7500000000,0.7605924414,0.7710266782,0.7812963758,0.7913952995,0.8013173182,0.8110564084,0.8206066574,0.8299622674,0.8391175587,0.8480669730,0.8568050772,0.8653265665,0.8736262674,0.8816991414,0.8895402873,0.8971449448,0.9045084972,0.9116264741,0.9184945542,0.9251085679,0.9314644998,0.9375584914,0.9433868430,0.9489460161,0.9542326359,0.9592434929,0.9639755449,0.9684259193,0.9725919141,0.9764710002,0.9800608227,0.9833592021,0.9863641361,0.9890738004,0.9914865498,0.9936009198,0.9954156265,0.9969295684,0.9981418264,0.9990516644,0.9996585301,0.9999620551,0.9999620551,0.9996585301,0.9990516644,0.9981418264,0.9969295684,0.9954156265,0.9936009198,0.9914865498,0.9890738004,0.9863641361,0.9833592021,0.9800608227,0.9764710002,0.9725919141,0.9684259193,0.9639755449,0.9592434929,0.9542326359,0.9489460161,0.9433868430,0.9375584914,0.9314644998,0.9251085679,0.9184945542,0.9116264741,0.9045084972,0.8971449448,0.8895402873,0.8816991414,0.8736262674,0.8653265665,0.8568050772,0.8480669730,0.8391175587,0.8299622674,0.8206066574,0.8110564084,0.8013173182,0.7913952995,0.7812963758,0.7710266782,0.7605924414,0.7500000000,0.7392557846,0.7283663179,0.7173382109,0.7061781587,0.6948929366,0.6834893958,0.6719744593,0.6603551178,0.6486384253,0.6368314950,0.6249414949,0.6129756433,0.6009412046,0.5888454849,0.5766958274,0.5644996083,0.5522642316,0.5399971256,0.5277057375,0.5153975293,0.5030799733,0.4907605475,0.4784467310,0.4661459993,0.4538658203,0.4416136491,0.4293969241,0.4172230619,0.4050994533,0.3930334584,0.3810324025,0.3691035713,0.3572542069,0.3454915028,0.3338226003,0.3222545833,0.3107944750,0.2994492325,0.2882257437,0.2771308221,0.2661712036,0.2553535415,0.2446844034,0.2341702664,0.2238175135,0.2136324300,0.2036211990,0.1937898985,0.1841444969,0.1746908499,0.1654346968,0.1563816570,0.1475372265,0.1389067748,0.1304955414,0.1223086326,0.1143510188,0.1066275310,0.0991428580,0.0919015438,0.0849079846,0.0781664261,0.0716809611,0.0654555268,0.0594939029,0.0537997084,0.0483764003,0.0432272712,0.0383554469,0.0337638853,0.0294553737,0.0254325280,0.0216977902,0.0182534279,0.0151015320,0.0122440160,0.0096826148,0.0074188833,0.0054541958,0.0037897452,0.0024265418,0.0013654133,0.0006070039,0.0001517740,0.0000000000 };
@@ -117,16 +188,78 @@ lprand_t LPRand = { LOGISTIC_SEED_DEFAULT, LOGISTIC_X_DEFAULT, \
     LORENZ_A_DEFAULT, LORENZ_B_DEFAULT, LORENZ_C_DEFAULT, \
     rand_preseed, rand_seed, rand_base_stdlib, rand_base_logistic, \
     rand_base_lorenz, rand_base_lorenzX, rand_base_lorenzY, rand_base_lorenzZ, \
-    rand_base_stdlib, rand_rand, rand_randint, rand_randbool, rand_choice };
-lpmemorypool_factory_t LPMemoryPool = { 0, 0, 0, memorypool_init, memorypool_custom_init, memorypool_alloc, memorypool_custom_alloc, memorypool_free };
+    rand_base_xoshiro, rand_rand, rand_randint, rand_randbool, rand_choice, \
+    rand_base_xoshiro, rand_create, rand_thread_default, rand_seed_state, rand_jump, rand_split, \
+    rand_next, rand_uniform, rand_gaussian, rand_fill_uniform, rand_fill_gaussian, rand_fill_choice, \
+    rand_destroy };
+lpkernels_t LPKernels = { "scalar", 
+    kernel_ref_add, kernel_ref_subtract, kernel_ref_multiply, kernel_ref_divide, 
+    kernel_ref_add_scalar, kernel_ref_subtract_scalar, kernel_ref_multiply_scalar, kernel_ref_divide_scalar, 
+    kernel_ref_scale, kernel_ref_clip, kernel_ref_mag, kernels_select
+};
+lpmemorypool_factory_t LPMemoryPool = { memorypool_init, memorypool_custom_init, memorypool_alloc, memorypool_custom_alloc, memorypool_free, memorypool_mark, memorypool_reset, memorypool_scope_begin, memorypool_scope_end, memorypool_thread_release, memorypool_stats };
 const lparray_factory_t LPArray = { create_array, create_array_from, destroy_array };
-const lpbuffer_factory_t LPBuffer = { create_buffer, create_buffer_from_float, create_buffer_from_bytes, copy_buffer, clear_buffer, split2_buffer, scale_buffer, min_buffer, max_buffer, mag_buffer, play_buffer, pan_stereo_buffer, mix_buffers, remix_buffer, clip_buffer, cut_buffer, cut_into_buffer, varispeed_buffer, resample_buffer, multiply_buffer, scalar_multiply_buffer, add_buffers, scalar_add_buffer, subtract_buffers, scalar_subtract_buffer, divide_buffers, scalar_divide_buffer, concat_buffers, buffers_are_equal, buffers_are_close, dub_buffer, dub_scalar, env_buffer, pad_buffer, taper_buffer, trim_buffer, fill_buffer, repeat_buffer, reverse_buffer, resize_buffer, plot_buffer, destroy_buffer };
+const lpbuffer_factory_t LPBuffer = { create_buffer, create_buffer_from_float, create_buffer_from_bytes, copy_buffer, clear_buffer, split2_buffer, scale_buffer, min_buffer, max_buffer, mag_buffer, samples_buffer, play_buffer, pan_stereo_buffer, mix_buffers, remix_buffer, clip_buffer, cut_buffer, cut_into_buffer, varispeed_buffer, resample_buffer, multiply_buffer, scalar_multiply_buffer, add_buffers, scalar_add_buffer, subtract_buffers, scalar_subtract_buffer, divide_buffers, scalar_divide_buffer, concat_buffers, buffers_are_equal, buffers_are_close, dub_buffer, dub_scalar, env_buffer, pad_buffer, taper_buffer, trim_buffer, fill_buffer, repeat_buffer, reverse_buffer, resize_buffer, plot_buffer, destroy_buffer };
+const lpbufferview_factory_t LPBufferView = { view_create, view_cut, view_reverse, view_channel, view_pad, view_read, view_samples, view_min, view_max, view_mag, view_dub, view_materialize, view_destroy };
 const lpinterpolation_factory_t LPInterpolation = { interpolate_linear_pos, interpolate_linear_pos2, interpolate_linear, interpolate_linear_channel, interpolate_hermite_pos, interpolate_hermite };
-const lpparam_factory_t LPParam = { param_create_from_float, param_create_from_int };
+const lpparam_factory_t LPParam = { param_create_from_float, param_create_from_int, param_fill_block };
 const lpwavetable_factory_t LPWavetable = { create_wavetable, create_wavetable_stack, destroy_wavetable };
 const lpwindow_factory_t LPWindow = { create_window, create_window_stack, destroy_window };
-const lpringbuffer_factory_t LPRingBuffer = { ringbuffer_create, ringbuffer_fill, ringbuffer_read, ringbuffer_readinto, ringbuffer_writefrom, ringbuffer_write, ringbuffer_readone, ringbuffer_writeone, ringbuffer_dub, ringbuffer_destroy };
-const lpfx_factory_t LPFX = { read_skewed_buffer, fx_lpf1, fx_convolve, fx_norm, fx_crush };
+const lptablecache_factory_t LPTableCache = { tablecache_get, tablecache_get_stack, tablecache_share, tablecache_count, tablecache_flush };
+const lpringbuffer_factory_t LPRingBuffer = { ringbuffer_create, ringbuffer_fill, ringbuffer_read, ringbuffer_readinto, ringbuffer_writefrom, ringbuffer_write, ringbuffer_readone, ringbuffer_writeone, ringbuffer_dub, ringbuffer_destroy, ringbuffer_tap, ringbuffer_tapinto };
+const lpspscring_factory_t LPSPSCRing = { spscring_create, spscring_write, spscring_read, spscring_readable, spscring_writable, spscring_destroy };
+const lpfx_factory_t LPFX = { read_skewed_buffer, read_skewed_samples, fx_lpf1, fx_convolve, fx_norm, fx_crush };
+
+/* xoshiro256** and the splitmix64 used to seed it are
+ * from Blackman & Vigna's public domain reference code:
+ *      https://prng.di.unimi.it/
+ *
+ * The root state is what LPRand.seed last set up, and 
+ * starts out as LPRAND_SEED_DEFAULT would leave it. A 
+ * thread copies it the first time it draws a number 
+ * after a seed, and jumps ahead once for every thread 
+ * that got there first, so each gets its own stream. 
+ * Seeding while other threads are drawing is a race. */
+typedef uint64_t lprand_vec_t __attribute__((vector_size(LPRAND_LANES * sizeof(uint64_t))));
+
+#define LPRAND_BITS ((sizeof(lpfloat_t) == sizeof(double)) ? 53 : 24)
+#define LPRAND_SCALE ((lpfloat_t)(1.0 / (double)(1ULL << LPRAND_BITS)))
+
+static lprng_t rand_root = { .s = { 0xe220a8397b1dcdafULL, 0x6e789e6aa1b965f4ULL, 0x06c45d188009454fULL, 0xf88bb8a8724c81ecULL } };
+static size_t rand_generation = 1;
+static size_t rand_numthreads = 0;
+static _Thread_local lprng_t rand_thread_state;
+static _Thread_local size_t rand_thread_generation = 0;
+
+static inline uint64_t rand_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t rand_splitmix64(uint64_t * x) {
+    uint64_t z;
+    z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [0, 1) from the top bits of a raw value */
+static inline lpfloat_t rand_unit(uint64_t x) {
+    return (lpfloat_t)(x >> (64 - LPRAND_BITS)) * LPRAND_SCALE;
+}
+
+static void rand_reseed_root(uint64_t seed) {
+    size_t generation;
+
+    rand_seed_state(&rand_root, seed);
+    generation = __atomic_add_fetch(&rand_generation, 1, __ATOMIC_RELEASE);
+
+    /* The thread doing the seeding always gets the 
+     * first stream */
+    __atomic_store_n(&rand_numthreads, 1, __ATOMIC_RELAXED);
+    rand_thread_state = rand_root;
+    rand_thread_generation = generation;
+}
 
 /* Platform-specific random seed, called 
  * on program init (and on process pool init) 
@@ -134,20 +267,24 @@ const lpfx_factory_t LPFX = { read_skewed_buffer, fx_lpf1, fx_convolve, fx_norm,
  * seed random with nice bytes. */
 void rand_preseed() {
 #ifdef __linux__
-    unsigned int * buffer;
+    uint64_t * buffer;
     ssize_t bytes_read;
     size_t buffer_size;
-    buffer_size = sizeof(unsigned int);
-    buffer = LPMemoryPool.alloc(1, buffer_size);
+    buffer_size = sizeof(uint64_t);
+    if((buffer = LPMemoryPool.alloc(1, buffer_size)) == NULL) return;
     bytes_read = getrandom(buffer, buffer_size, 0);
-    if(bytes_read > 0) srand(*buffer);
-    free(buffer);
+    if(bytes_read > 0) {
+        srand((unsigned int)*buffer);
+        rand_reseed_root(*buffer);
+    }
+    LPMemoryPool.free(buffer);
 #endif
 }
 
 /* User rand seed */
 void rand_seed(int value) {
     srand((unsigned int)value);
+    rand_reseed_root((uint64_t)value);
 }
 
 /* Default rand_base callback. 
@@ -157,8 +294,15 @@ void rand_seed(int value) {
  * choice and randint.
  *
  * They may be swapped out at runtime by setting 
- * LPRand.rand_base to the desired rand_base pointer;
+ * LPRand.rand_base to the desired rand_base pointer.
+ * Only this one is safe to call from more than one 
+ * thread: the others all share their state.
  * */
+lpfloat_t rand_base_xoshiro(lpfloat_t low, lpfloat_t high) {
+    return rand_uniform(NULL, low, high);
+}
+
+/* libc rand, which was the default before */
 lpfloat_t rand_base_stdlib(lpfloat_t low, lpfloat_t high) {
     return (rand()/(lpfloat_t)RAND_MAX) * (high-low) + low;
 }
@@ -256,10 +400,241 @@ int rand_choice(int numchoices) {
     return rand_randint(0, numchoices);
 }
 
+lprng_t * rand_thread_default(void) {
+    size_t generation, ordinal;
+
+    generation = __atomic_load_n(&rand_generation, __ATOMIC_ACQUIRE);
+    if(rand_thread_generation != generation) {
+        ordinal = __atomic_fetch_add(&rand_numthreads, 1, __ATOMIC_RELAXED);
+        rand_thread_state = rand_root;
+        while(ordinal-- > 0) rand_jump(&rand_thread_state);
+        rand_thread_generation = generation;
+    }
+
+    return &rand_thread_state;
+}
+
+lprng_t * rand_create(uint64_t seed) {
+    lprng_t * rng;
+    if((rng = (lprng_t *)LPMemoryPool.alloc(1, sizeof(lprng_t))) == NULL) return NULL;
+    rand_seed_state(rng, seed);
+    return rng;
+}
+
+void rand_seed_state(lprng_t * rng, uint64_t seed) {
+    int i;
+
+    if(rng == NULL) rng = rand_thread_default();
+    for(i=0; i < 4; i++) rng->s[i] = rand_splitmix64(&seed);
+    rng->lanesready = 0;
+    rng->hasspare = 0;
+}
+
+uint64_t rand_next(lprng_t * rng) {
+    uint64_t out, t;
+
+    if(rng == NULL) rng = rand_thread_default();
+
+    out = rand_rotl(rng->s[1] * 5, 7) * 9;
+    t = rng->s[1] << 17;
+
+    rng->s[2] ^= rng->s[0];
+    rng->s[3] ^= rng->s[1];
+    rng->s[1] ^= rng->s[2];
+    rng->s[0] ^= rng->s[3];
+    rng->s[2] ^= t;
+    rng->s[3] = rand_rotl(rng->s[3], 45);
+
+    return out;
+}
+
+/* Advance by 2^128 draws: the same as calling next that 
+ * many times, so streams from successive jumps never 
+ * overlap. */
+void rand_jump(lprng_t * rng) {
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    uint64_t s[4] = {0};
+    int i, b;
+
+    if(rng == NULL) rng = rand_thread_default();
+
+    for(i=0; i < 4; i++) {
+        for(b=0; b < 64; b++) {
+            if(JUMP[i] & (1ULL << b)) {
+                s[0] ^= rng->s[0];
+                s[1] ^= rng->s[1];
+                s[2] ^= rng->s[2];
+                s[3] ^= rng->s[3];
+            }
+            rand_next(rng);
+        }
+    }
+
+    memcpy(rng->s, s, sizeof(s));
+    rng->lanesready = 0;
+    rng->hasspare = 0;
+}
+
+/* A new generator which carries on from where rng is, 
+ * while rng jumps ahead. Splitting the same generator 
+ * again and again hands out streams in a fixed order, 
+ * one per worker say, no matter when they get used. */
+lprng_t * rand_split(lprng_t * rng) {
+    lprng_t * child;
+
+    if(rng == NULL) rng = rand_thread_default();
+
+    if((child = (lprng_t *)LPMemoryPool.alloc(1, sizeof(lprng_t))) == NULL) return NULL;
+    memcpy(child->s, rng->s, sizeof(rng->s));
+    child->lanesready = 0;
+    child->hasspare = 0;
+    rand_jump(rng);
+
+    return child;
+}
+
+lpfloat_t rand_uniform(lprng_t * rng, lpfloat_t low, lpfloat_t high) {
+    return rand_unit(rand_next(rng)) * (high-low) + low;
+}
+
+/* Box-Muller makes two at a time: the second is kept 
+ * for the next call */
+lpfloat_t rand_gaussian(lprng_t * rng, lpfloat_t mean, lpfloat_t stddev) {
+    lpfloat_t r, theta;
+
+    if(rng == NULL) rng = rand_thread_default();
+
+    if(rng->hasspare) {
+        rng->hasspare = 0;
+        return rng->spare * stddev + mean;
+    }
+
+    r = (lpfloat_t)sqrt(-2 * log(1 - rand_unit(rand_next(rng))));
+    theta = (lpfloat_t)PI2 * rand_unit(rand_next(rng));
+    rng->spare = r * (lpfloat_t)sin(theta);
+    rng->hasspare = 1;
+
+    return r * (lpfloat_t)cos(theta) * stddev + mean;
+}
+
+/* Raw values from the lane generators, LPRAND_LANES at a 
+ * time: n must be a multiple of LPRAND_LANES. The lanes 
+ * are seeded from the main generator the first time. */
+static void rand_fill_raw(lprng_t * rng, uint64_t * out, size_t n) {
+    lprand_vec_t s0, s1, s2, s3, t, x;
+    uint64_t seed;
+    size_t i;
+    int j, k;
+
+    assert(n % LPRAND_LANES == 0);
+
+    if(!rng->lanesready) {
+        for(k=0; k < LPRAND_LANES; k++) {
+            seed = rand_next(rng);
+            for(j=0; j < 4; j++) rng->lanes[j][k] = rand_splitmix64(&seed);
+        }
+        rng->lanesready = 1;
+    }
+
+    memcpy(&s0, rng->lanes[0], sizeof(lprand_vec_t));
+    memcpy(&s1, rng->lanes[1], sizeof(lprand_vec_t));
+    memcpy(&s2, rng->lanes[2], sizeof(lprand_vec_t));
+    memcpy(&s3, rng->lanes[3], sizeof(lprand_vec_t));
+
+    for(i=0; i < n; i += LPRAND_LANES) {
+        x = s1 * 5;
+        x = ((x << 7) | (x >> 57)) * 9;
+        memcpy(out + i, &x, sizeof(lprand_vec_t));
+
+        t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 45) | (s3 >> 19);
+    }
+
+    memcpy(rng->lanes[0], &s0, sizeof(lprand_vec_t));
+    memcpy(rng->lanes[1], &s1, sizeof(lprand_vec_t));
+    memcpy(rng->lanes[2], &s2, sizeof(lprand_vec_t));
+    memcpy(rng->lanes[3], &s3, sizeof(lprand_vec_t));
+}
+
+/* The bulk fills draw from the lanes in blocks rounded 
+ * up to a whole step of them: leftovers are dropped, so 
+ * the same sequence of calls on the same seed always 
+ * gives the same numbers. They don't give the same 
+ * numbers as calling uniform n times. */
+void rand_fill_uniform(lprng_t * rng, lpfloat_t * out, size_t n, lpfloat_t low, lpfloat_t high) {
+    uint64_t raw[LPRAND_BLOCKSIZE];
+    lpfloat_t scale;
+    size_t pos, i, count;
+
+    if(rng == NULL) rng = rand_thread_default();
+    scale = (high-low) * LPRAND_SCALE;
+
+    for(pos=0; pos < n; pos += count) {
+        count = n - pos;
+        if(count > LPRAND_BLOCKSIZE) count = LPRAND_BLOCKSIZE;
+        rand_fill_raw(rng, raw, (count + LPRAND_LANES - 1) & ~(size_t)(LPRAND_LANES - 1));
+        for(i=0; i < count; i++) {
+            out[pos + i] = (lpfloat_t)(raw[i] >> (64 - LPRAND_BITS)) * scale + low;
+        }
+    }
+}
+
+void rand_fill_gaussian(lprng_t * rng, lpfloat_t * out, size_t n, lpfloat_t mean, lpfloat_t stddev) {
+    uint64_t raw[LPRAND_BLOCKSIZE];
+    lpfloat_t r, theta;
+    size_t pos, i, count;
+
+    if(rng == NULL) rng = rand_thread_default();
+
+    for(pos=0; pos < n; pos += count) {
+        count = n - pos;
+        if(count > LPRAND_BLOCKSIZE) count = LPRAND_BLOCKSIZE;
+        rand_fill_raw(rng, raw, (count + LPRAND_LANES - 1) & ~(size_t)(LPRAND_LANES - 1));
+        for(i=0; i < count; i += 2) {
+            r = (lpfloat_t)sqrt(-2 * log(1 - rand_unit(raw[i]))) * stddev;
+            theta = (lpfloat_t)PI2 * rand_unit(raw[i+1]);
+            out[pos + i] = r * (lpfloat_t)cos(theta) + mean;
+            if(i + 1 < count) out[pos + i + 1] = r * (lpfloat_t)sin(theta) + mean;
+        }
+    }
+}
+
+/* Ints from 0 to numchoices-1, using the top 32 bits 
+ * scaled by numchoices rather than a modulo */
+void rand_fill_choice(lprng_t * rng, int * out, size_t n, int numchoices) {
+    uint64_t raw[LPRAND_BLOCKSIZE];
+    size_t pos, i, count;
+
+    assert(numchoices > 0);
+    if(rng == NULL) rng = rand_thread_default();
+
+    for(pos=0; pos < n; pos += count) {
+        count = n - pos;
+        if(count > LPRAND_BLOCKSIZE) count = LPRAND_BLOCKSIZE;
+        rand_fill_raw(rng, raw, (count + LPRAND_LANES - 1) & ~(size_t)(LPRAND_LANES - 1));
+        for(i=0; i < count; i++) {
+            out[pos + i] = (int)(((raw[i] >> 32) * (uint64_t)numchoices) >> 32);
+        }
+    }
+}
+
+void rand_destroy(lprng_t * rng) {
+    LPMemoryPool.free(rng);
+}
+
 lparray_t * create_array(size_t length) {
     size_t i = 0;
     lparray_t * array = (lparray_t*)LPMemoryPool.alloc(1, sizeof(lparray_t));
-    array->data = (int*)LPMemoryPool.alloc(length, sizeof(int));
+    if(array == NULL) return NULL;
+    if((array->data = (int*)LPMemoryPool.alloc(length, sizeof(int))) == NULL) {
+        LPMemoryPool.free(array);
+        return NULL;
+    }
     array->length = length;
     for(i=0; i < array->length; i++) {
         array->data[i] = 0;
@@ -273,10 +648,13 @@ lparray_t * create_array_from(int numvalues, ...) {
     lparray_t * array;
     int i;
 
-    va_start(vl, numvalues);
+    if((array = (lparray_t*)LPMemoryPool.alloc(1, sizeof(lparray_t))) == NULL) return NULL;
+    if((array->data = (int*)LPMemoryPool.alloc(numvalues, sizeof(int))) == NULL) {
+        LPMemoryPool.free(array);
+        return NULL;
+    }
 
-    array = (lparray_t*)LPMemoryPool.alloc(1, sizeof(lparray_t));
-    array->data = (int*)LPMemoryPool.alloc(numvalues, sizeof(int));
+    va_start(vl, numvalues);
 
     for(i=0; i < numvalues; i++) {
         array->data[i] = va_arg(vl, int);
@@ -294,6 +672,322 @@ void destroy_array(lparray_t * array) {
     }
 }
 
+/* Kernels
+ *
+ * The scalar reference implementations come first. 
+ * They define the expected results: the vector 
+ * versions below have to match them sample for sample.
+ * */
+void kernel_ref_add(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] += b[i];
+    }
+}
+
+void kernel_ref_subtract(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] -= b[i];
+    }
+}
+
+void kernel_ref_multiply(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] *= b[i];
+    }
+}
+
+void kernel_ref_divide(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        if(b[i] == 0) {
+            a[i] = 0.f;
+        } else {
+            a[i] /= b[i];
+        }
+    }
+}
+
+void kernel_ref_add_scalar(lpfloat_t * a, lpfloat_t b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] += b;
+    }
+}
+
+void kernel_ref_subtract_scalar(lpfloat_t * a, lpfloat_t b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] -= b;
+    }
+}
+
+void kernel_ref_multiply_scalar(lpfloat_t * a, lpfloat_t b, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] *= b;
+    }
+}
+
+void kernel_ref_divide_scalar(lpfloat_t * a, lpfloat_t b, size_t n) {
+    size_t i;
+    if(b == 0) {
+        for(i=0; i < n; i++) {
+            a[i] = 0.f;
+        }
+    } else {
+        for(i=0; i < n; i++) {
+            a[i] /= b;
+        }
+    }
+}
+
+void kernel_ref_scale(lpfloat_t * a, size_t n, lpfloat_t from_min, lpfloat_t from_diff, lpfloat_t to_diff, lpfloat_t to_min) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] = ((a[i] - from_min) / from_diff) * to_diff + to_min;
+    }
+}
+
+void kernel_ref_clip(lpfloat_t * a, size_t n, lpfloat_t minval, lpfloat_t maxval) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        a[i] = fmin(fmax(a[i], minval), maxval);
+    }
+}
+
+lpfloat_t kernel_ref_mag(const lpfloat_t * a, size_t n) {
+    lpfloat_t out = 0.f;
+    size_t i;
+    for(i=0; i < n; i++) {
+        out = fmax(fabs(a[i]), out);
+    }
+    return out;
+}
+
+static const lpkernels_t kernels_scalar = { "scalar", 
+    kernel_ref_add, kernel_ref_subtract, kernel_ref_multiply, kernel_ref_divide, 
+    kernel_ref_add_scalar, kernel_ref_subtract_scalar, kernel_ref_multiply_scalar, kernel_ref_divide_scalar, 
+    kernel_ref_scale, kernel_ref_clip, kernel_ref_mag, kernels_select
+};
+
+/* The vector kernels are written once against GCC's 
+ * generic vector types and stamped out per instruction 
+ * set with the target attribute, so the same source 
+ * compiles to SSE2, AVX2 or AVX-512 code and the library 
+ * itself can still be built for a baseline CPU.
+ *
+ * Loads and stores go through memcpy since buffer 
+ * data is only guaranteed to be lpfloat_t aligned. 
+ * Selects are done with bitmasks: these are plain C 
+ * vectors, so there is no ternary to lean on.
+ */
+#define LPKERNEL_SPLAT(TIER, v, value) \
+    for(j=0; j < LPKERNEL_LANES(TIER); j++) { v[j] = value; }
+
+#define LPKERNEL_LANES(TIER) (sizeof(lpkvec_##TIER##_t) / sizeof(lpfloat_t))
+
+#define LPKERNEL_SELECT(TIER, mask, a, b) \
+    (lpkvec_##TIER##_t)(((__typeof__(mask))(a) & ~(mask)) | ((__typeof__(mask))(b) & (mask)))
+
+#define LPKERNEL_BINARY(TIER, ATTR, NAME, OP) \
+ATTR static void kernel_##TIER##_##NAME(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) { \
+    lpkvec_##TIER##_t va, vb; \
+    size_t i = 0; \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        memcpy(&vb, b + i, sizeof(vb)); \
+        va = va OP vb; \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    for(; i < n; i++) { \
+        a[i] = a[i] OP b[i]; \
+    } \
+} \
+ATTR static void kernel_##TIER##_##NAME##_scalar(lpfloat_t * a, lpfloat_t b, size_t n) { \
+    lpkvec_##TIER##_t va, vb; \
+    size_t i = 0, j; \
+    LPKERNEL_SPLAT(TIER, vb, b) \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        va = va OP vb; \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    for(; i < n; i++) { \
+        a[i] = a[i] OP b; \
+    } \
+}
+
+#define LPKERNELS_TIER(TIER, ATTR, BYTES) \
+typedef lpfloat_t lpkvec_##TIER##_t __attribute__((vector_size(BYTES))); \
+LPKERNEL_BINARY(TIER, ATTR, add, +) \
+LPKERNEL_BINARY(TIER, ATTR, subtract, -) \
+LPKERNEL_BINARY(TIER, ATTR, multiply, *) \
+ATTR static void kernel_##TIER##_divide(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n) { \
+    lpkvec_##TIER##_t va, vb, zero = {0}; \
+    __typeof__(va == vb) iszero; \
+    size_t i = 0; \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        memcpy(&vb, b + i, sizeof(vb)); \
+        iszero = vb == zero; \
+        va = LPKERNEL_SELECT(TIER, iszero, va / vb, zero); \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    kernel_ref_divide(a + i, b + i, n - i); \
+} \
+ATTR static void kernel_##TIER##_divide_scalar(lpfloat_t * a, lpfloat_t b, size_t n) { \
+    lpkvec_##TIER##_t va, vb; \
+    size_t i = 0, j; \
+    if(b == 0) { \
+        memset(a, 0, sizeof(lpfloat_t) * n); \
+        return; \
+    } \
+    LPKERNEL_SPLAT(TIER, vb, b) \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        va = va / vb; \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    kernel_ref_divide_scalar(a + i, b, n - i); \
+} \
+ATTR static void kernel_##TIER##_scale(lpfloat_t * a, size_t n, lpfloat_t from_min, lpfloat_t from_diff, lpfloat_t to_diff, lpfloat_t to_min) { \
+    lpkvec_##TIER##_t va, vfrom_min, vfrom_diff, vto_diff, vto_min; \
+    size_t i = 0, j; \
+    LPKERNEL_SPLAT(TIER, vfrom_min, from_min) \
+    LPKERNEL_SPLAT(TIER, vfrom_diff, from_diff) \
+    LPKERNEL_SPLAT(TIER, vto_diff, to_diff) \
+    LPKERNEL_SPLAT(TIER, vto_min, to_min) \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        va = ((va - vfrom_min) / vfrom_diff) * vto_diff + vto_min; \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    kernel_ref_scale(a + i, n - i, from_min, from_diff, to_diff, to_min); \
+} \
+ATTR static void kernel_##TIER##_clip(lpfloat_t * a, size_t n, lpfloat_t minval, lpfloat_t maxval) { \
+    lpkvec_##TIER##_t va, vmin, vmax; \
+    __typeof__(va == va) out; \
+    size_t i = 0, j; \
+    LPKERNEL_SPLAT(TIER, vmin, minval) \
+    LPKERNEL_SPLAT(TIER, vmax, maxval) \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        /* Written as !(a >= min) so NaNs clip to min like fmax */ \
+        out = ~(va >= vmin); \
+        va = LPKERNEL_SELECT(TIER, out, va, vmin); \
+        out = va > vmax; \
+        va = LPKERNEL_SELECT(TIER, out, va, vmax); \
+        memcpy(a + i, &va, sizeof(va)); \
+    } \
+    kernel_ref_clip(a + i, n - i, minval, maxval); \
+} \
+ATTR static lpfloat_t kernel_##TIER##_mag(const lpfloat_t * a, size_t n) { \
+    lpkvec_##TIER##_t va, acc = {0}, zero = {0}; \
+    __typeof__(va == va) mask; \
+    lpfloat_t out = 0.f; \
+    size_t i = 0, j; \
+    for(; i + LPKERNEL_LANES(TIER) <= n; i += LPKERNEL_LANES(TIER)) { \
+        memcpy(&va, a + i, sizeof(va)); \
+        mask = va < zero; \
+        va = LPKERNEL_SELECT(TIER, mask, va, -va); \
+        mask = va > acc; \
+        acc = LPKERNEL_SELECT(TIER, mask, acc, va); \
+    } \
+    for(j=0; j < LPKERNEL_LANES(TIER); j++) { \
+        out = fmax(acc[j], out); \
+    } \
+    return fmax(kernel_ref_mag(a + i, n - i), out); \
+} \
+static const lpkernels_t kernels_##TIER = { #TIER, \
+    kernel_##TIER##_add, kernel_##TIER##_subtract, kernel_##TIER##_multiply, kernel_##TIER##_divide, \
+    kernel_##TIER##_add_scalar, kernel_##TIER##_subtract_scalar, kernel_##TIER##_multiply_scalar, kernel_##TIER##_divide_scalar, \
+    kernel_##TIER##_scale, kernel_##TIER##_clip, kernel_##TIER##_mag, kernels_select \
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+LPKERNELS_TIER(sse2, __attribute__((target("sse2"))), 16)
+LPKERNELS_TIER(avx2, __attribute__((target("avx2"))), 32)
+LPKERNELS_TIER(avx512, __attribute__((target("avx512f"))), 64)
+#elif defined(__aarch64__)
+/* Advanced SIMD is part of the aarch64 baseline */
+LPKERNELS_TIER(neon, , 16)
+#endif
+
+/* Pick a kernel implementation by name, or the 
+ * widest one this CPU supports when name is NULL. 
+ * Returns -1 if the implementation isn't available. */
+int kernels_select(const char * name) {
+    const lpkernels_t * kernels = NULL;
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(name == NULL || strcmp(name, "avx512") == 0) {
+        if(__builtin_cpu_supports("avx512f")) kernels = &kernels_avx512;
+    }
+    if(kernels == NULL && (name == NULL || strcmp(name, "avx2") == 0)) {
+        if(__builtin_cpu_supports("avx2")) kernels = &kernels_avx2;
+    }
+    if(kernels == NULL && (name == NULL || strcmp(name, "sse2") == 0)) {
+        if(__builtin_cpu_supports("sse2")) kernels = &kernels_sse2;
+    }
+#elif defined(__aarch64__)
+    if(name == NULL || strcmp(name, "neon") == 0) kernels = &kernels_neon;
+#endif
+
+    if(kernels == NULL && (name == NULL || strcmp(name, "scalar") == 0)) {
+        kernels = &kernels_scalar;
+    }
+
+    if(kernels == NULL) return -1;
+
+    LPKernels = *kernels;
+    return 0;
+}
+
+/* Runs when the library is loaded */
+__attribute__((constructor)) static void kernels_init(void) {
+    const char * name;
+
+    name = getenv("LPKERNELS");
+    if(name == NULL || kernels_select(name) < 0) {
+        kernels_select(NULL);
+    }
+}
+
+/* Apply a binary kernel across two interleaved buffers 
+ * with the usual c % b->channels channel mapping.
+ *
+ * Matching layouts go straight to the kernel. Otherwise 
+ * b is expanded to a's layout a block at a time (which 
+ * covers the mono to N channel broadcast) and the kernel 
+ * runs over the expanded block. */
+static void kernels_apply(void (*kernel)(lpfloat_t * restrict, const lpfloat_t * restrict, size_t), lpfloat_t * a, int achannels, const lpfloat_t * b, int bchannels, size_t length) {
+    lpfloat_t block[LPKERNELS_BLOCKSIZE];
+    size_t i, f, frames, blockframes;
+    int c;
+
+    if(achannels == bchannels) {
+        kernel(a, b, length * achannels);
+        return;
+    }
+
+    blockframes = LPKERNELS_BLOCKSIZE / achannels;
+    assert(blockframes > 0);
+
+    for(i=0; i < length; i += frames) {
+        frames = (length - i < blockframes) ? length - i : blockframes;
+        for(f=0; f < frames; f++) {
+            for(c=0; c < achannels; c++) {
+                block[f * achannels + c] = b[(i+f) * bchannels + (c % bchannels)];
+            }
+        }
+        kernel(a + i * achannels, block, frames * achannels);
+    }
+}
+
 /* Buffer
  * */
 lpbuffer_t * create_buffer(size_t length, int channels, int samplerate) {
@@ -321,6 +1015,7 @@ lpbuffer_t * create_buffer(size_t length, int channels, int samplerate) {
     buf->range = length;
     buf->onset = 0;
     buf->is_looping = 0;
+    buf->refcount = 1;
     return buf;
 }
 
@@ -328,7 +1023,7 @@ lpbuffer_t * create_buffer_from_float(lpfloat_t value, size_t length, int channe
     size_t i;
     int c;
     lpbuffer_t * buf;
-    buf = create_buffer(length, channels, samplerate);
+    if((buf = create_buffer(length, channels, samplerate)) == NULL) return NULL;
     for(i=0; i < length; i++) {
         for(c=0; c < channels; c++) {
             buf->data[i * channels + c] = value;
@@ -341,7 +1036,7 @@ lpbuffer_t * create_buffer_from_bytes(char * bytes, size_t length, int channels,
     size_t i;
     char val = 0;
     lpbuffer_t * buf;
-    buf = create_buffer(length, channels, samplerate);
+    if((buf = create_buffer(length, channels, samplerate)) == NULL) return NULL;
     for(i=0; i < buf->length * channels; i++) {
         val = (int)bytes[i];
         buf->data[i] = (float)(val / CHAR_MAX);
@@ -406,8 +1101,6 @@ void clear_buffer(lpbuffer_t * buf) {
 }
 
 void scale_buffer(lpbuffer_t * buf, lpfloat_t from_min, lpfloat_t from_max, lpfloat_t to_min, lpfloat_t to_max) {
-    size_t i;
-    int c, idx;
     lpfloat_t from_diff, to_diff;
 
     to_diff = to_max - to_min;;
@@ -423,61 +1116,80 @@ void scale_buffer(lpbuffer_t * buf, lpfloat_t from_min, lpfloat_t from_max, lpfl
      */
     assert(from_diff != 0);
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < buf->channels; c++) {
-            idx = i * buf->channels + c;
-            buf->data[idx] = ((buf->data[idx] - from_min) / from_diff) * to_diff + to_min;
-        }
-    }
+    LPKernels.scale(buf->data, buf->length * buf->channels, from_min, from_diff, to_diff, to_min);
 }
 
-lpfloat_t min_buffer(lpbuffer_t * buf) {
-    lpfloat_t out = 0.f;
+/* Shared by the buffer and view versions: the smallest, 
+ * largest and largest absolute sample, or 0 when empty */
+static lpfloat_t samples_min(lpsamples_t samples) {
+    lpfloat_t out;
     size_t i;
-    int c;
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < buf->channels; c++) {
-            if(i==0 && c==0) {
-                out = buf->data[i * buf->channels + c];
-                continue;
-            }
-            out = fmin(buf->data[i * buf->channels + c], out);
-        }
-    }
+    if(samples.length == 0) return 0.f;
+
+    out = samples.data[0];
+    for(i=1; i < samples.length; i++) out = fmin(samples.data[(ptrdiff_t)i * samples.stride], out);
     return out;
 }
 
-lpfloat_t max_buffer(lpbuffer_t * buf) {
-    lpfloat_t out = 0.f;
+static lpfloat_t samples_max(lpsamples_t samples) {
+    lpfloat_t out;
     size_t i;
-    int c;
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < buf->channels; c++) {
-            if(i==0 && c==0) {
-                out = buf->data[i * buf->channels + c];
-                continue;
-            }
-            out = fmax(buf->data[i * buf->channels + c], out);
-        }
-    }
+    if(samples.length == 0) return 0.f;
+
+    out = samples.data[0];
+    for(i=1; i < samples.length; i++) out = fmax(samples.data[(ptrdiff_t)i * samples.stride], out);
     return out;
 }
 
-lpfloat_t mag_buffer(lpbuffer_t * buf) {
-    lpfloat_t out = 0.f;
+static lpfloat_t samples_mag(lpsamples_t samples) {
+    lpfloat_t sample, out = 0;
     size_t i;
-    int c;
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < buf->channels; c++) {
-            out = fmax(fabs(buf->data[i * buf->channels + c]), out);
-        }
+    if(samples.stride == 1) return LPKernels.mag(samples.data, samples.length);
+
+    for(i=0; i < samples.length; i++) {
+        sample = samples.data[(ptrdiff_t)i * samples.stride];
+        if(sample < 0) sample = -sample;
+        if(sample > out) out = sample;
     }
     return out;
 }
 
+lpsamples_t samples_buffer(lpbuffer_t * buf, int channel) {
+    lpsamples_t samples;
+
+    assert(channel >= 0 && channel < buf->channels);
+    samples.data = buf->data + channel;
+    samples.length = buf->length;
+    samples.stride = buf->channels;
+
+    return samples;
+}
+
+lpfloat_t min_buffer(lpbuffer_t * buf) {
+    lpfloat_t out;
+    int c;
+
+    out = samples_min(samples_buffer(buf, 0));
+    for(c=1; c < buf->channels; c++) out = fmin(samples_min(samples_buffer(buf, c)), out);
+    return out;
+}
+
+lpfloat_t max_buffer(lpbuffer_t * buf) {
+    lpfloat_t out;
+    int c;
+
+    out = samples_max(samples_buffer(buf, 0));
+    for(c=1; c < buf->channels; c++) out = fmax(samples_max(samples_buffer(buf, c)), out);
+    return out;
+}
+
+lpfloat_t mag_buffer(lpbuffer_t * buf) {
+    return LPKernels.mag(buf->data, buf->length * buf->channels);
+}
+
 void pan_stereo_constant(lpfloat_t pos, lpfloat_t left_in, lpfloat_t right_in, lpfloat_t * left_out, lpfloat_t * right_out) {
     *left_out = left_in * (lpfloat_t)sqrt(1.f - pos);
     *right_out = right_in * (lpfloat_t)sqrt(pos);
@@ -500,8 +1212,9 @@ void pan_stereo_gogins(lpfloat_t pos, lpfloat_t left_in, lpfloat_t right_in, lpf
 
 void pan_stereo_buffer(lpbuffer_t * buf, lpbuffer_t * pos, int method) {
     void (*handler)(lpfloat_t, lpfloat_t, lpfloat_t, lpfloat_t *, lpfloat_t *);
+    lpfloat_t gains[LPKERNELS_BLOCKSIZE];
     lpfloat_t _pos;
-    size_t i;
+    size_t i, f, frames;
 
     assert(buf->channels == 2);
 
@@ -517,9 +1230,15 @@ void pan_stereo_buffer(lpbuffer_t * buf, lpbuffer_t * pos, int method) {
         handler = &pan_stereo_constant;
     }
 
-    for(i=0; i < buf->length; i++) {
-        _pos = interpolate_linear_pos(pos, (lpfloat_t)i/buf->length);
-        handler(_pos, buf->data[i*2], buf->data[i*2+1], &buf->data[i*2], &buf->data[i*2+1]);
+    /* Panning a unit signal gives the gain pair for 
+     * each frame, which is then applied as a block */
+    for(i=0; i < buf->length; i += frames) {
+        frames = (buf->length - i < LPKERNELS_BLOCKSIZE/2) ? buf->length - i : LPKERNELS_BLOCKSIZE/2;
+        for(f=0; f < frames; f++) {
+            _pos = interpolate_linear_pos(pos, (lpfloat_t)(i+f)/buf->length);
+            handler(_pos, 1.f, 1.f, &gains[f*2], &gains[f*2+1]);
+        }
+        LPKernels.multiply(buf->data + i * 2, gains, frames * 2);
     }
 }
 
@@ -546,7 +1265,7 @@ lpbuffer_t * varispeed_buffer(lpbuffer_t * buf, lpbuffer_t * speed) {
 
     assert(length > 1);
 
-    out = create_buffer(length, buf->channels, buf->samplerate);
+    if((out = create_buffer(length, buf->channels, buf->samplerate)) == NULL) return NULL;
     for(i=0; i < length; i++) {
         pos = (lpfloat_t)i / length;
 
@@ -560,7 +1279,7 @@ lpbuffer_t * varispeed_buffer(lpbuffer_t * buf, lpbuffer_t * speed) {
     }
 
     trimmed = cut_buffer(out, 0, i);
-    free(out);
+    destroy_buffer(out);
     return trimmed;
 }
 
@@ -571,7 +1290,7 @@ lpbuffer_t * resample_buffer(lpbuffer_t * buf, size_t length) {
     int c;
 
     assert(length > 1);
-    out = create_buffer(length, buf->channels, buf->samplerate);
+    if((out = create_buffer(length, buf->channels, buf->samplerate)) == NULL) return NULL;
     for(i=0; i < length; i++) {
         pos = (lpfloat_t)i/length;
         for(c=0; c < buf->channels; c++) {
@@ -583,25 +1302,13 @@ lpbuffer_t * resample_buffer(lpbuffer_t * buf, size_t length) {
 }
 
 void multiply_buffer(lpbuffer_t * a, lpbuffer_t * b) {
-    size_t length, i;
-    int c, j;
+    size_t length;
     length = (a->length <= b->length) ? a->length : b->length;
-    for(i=0; i < length; i++) {
-        for(c=0; c < a->channels; c++) {
-            j = c % b->channels;
-            a->data[i * a->channels + c] *= b->data[i * b->channels + j];
-        }
-    }
+    kernels_apply(LPKernels.multiply, a->data, a->channels, b->data, b->channels, length);
 }
 
 void scalar_multiply_buffer(lpbuffer_t * a, lpfloat_t b) {
-    size_t i;
-    int c;
-    for(i=0; i < a->length; i++) {
-        for(c=0; c < a->channels; c++) {
-            a->data[i * a->channels + c] *= b;
-        }
-    }
+    LPKernels.multiply_scalar(a->data, b, a->length * a->channels);
 }
 
 lpbuffer_t * concat_buffers(lpbuffer_t * a, lpbuffer_t * b) {
@@ -611,7 +1318,7 @@ lpbuffer_t * concat_buffers(lpbuffer_t * a, lpbuffer_t * b) {
 
     length = a->length + b->length;
     channels = a->channels;
-    out = create_buffer(length, channels, a->samplerate);
+    if((out = create_buffer(length, channels, a->samplerate)) == NULL) return NULL;
 
     for(i=0; i < a->length; i++) {
         for(c=0; c < channels; c++) {
@@ -629,81 +1336,34 @@ lpbuffer_t * concat_buffers(lpbuffer_t * a, lpbuffer_t * b) {
 }
 
 void add_buffers(lpbuffer_t * a, lpbuffer_t * b) {
-    size_t length, i;
-    int c, j;
+    size_t length;
     length = (a->length <= b->length) ? a->length : b->length;
-    for(i=0; i < length; i++) {
-        for(c=0; c < a->channels; c++) {
-            j = c % b->channels;
-            a->data[i * a->channels + c] += b->data[i * b->channels + j];
-        }
-    }
+    kernels_apply(LPKernels.add, a->data, a->channels, b->data, b->channels, length);
 }
 
 void scalar_add_buffer(lpbuffer_t * a, lpfloat_t b) {
-    size_t i;
-    int c;
-    for(i=0; i < a->length; i++) {
-        for(c=0; c < a->channels; c++) {
-            a->data[i * a->channels + c] += b;
-        }
-    }
+    LPKernels.add_scalar(a->data, b, a->length * a->channels);
 }
 
 void subtract_buffers(lpbuffer_t * a, lpbuffer_t * b) {
-    size_t length, i;
-    int c, j;
+    size_t length;
     length = (a->length <= b->length) ? a->length : b->length;
-    for(i=0; i < length; i++) {
-        for(c=0; c < a->channels; c++) {
-            j = c % b->channels;
-            a->data[i * a->channels + c] -= b->data[i * b->channels + j];
-        }
-    }
+    kernels_apply(LPKernels.subtract, a->data, a->channels, b->data, b->channels, length);
 }
 
 void scalar_subtract_buffer(lpbuffer_t * a, lpfloat_t b) {
-    size_t i;
-    int c;
-    for(i=0; i < a->length; i++) {
-        for(c=0; c < a->channels; c++) {
-            a->data[i * a->channels + c] -= b;
-        }
-    }
+    LPKernels.subtract_scalar(a->data, b, a->length * a->channels);
 }
 
+/* Dividing by zero gives zero */
 void divide_buffers(lpbuffer_t * a, lpbuffer_t * b) {
-    size_t length, i;
-    int c, j;
+    size_t length;
     length = (a->length <= b->length) ? a->length : b->length;
-    for(i=0; i < length; i++) {
-        for(c=0; c < a->channels; c++) {
-            j = c % b->channels;
-            if(b->data[i * b->channels + j] == 0) {
-                a->data[i * a->channels + c] = 0.f;
-            } else {
-                a->data[i * a->channels + c] /= b->data[i * b->channels + j];
-            }
-        }
-    }
+    kernels_apply(LPKernels.divide, a->data, a->channels, b->data, b->channels, length);
 }
 
 void scalar_divide_buffer(lpbuffer_t * a, lpfloat_t b) {
-    size_t i;
-    int c;
-    if(b == 0) {
-        for(i=0; i < a->length; i++) {
-            for(c=0; c < a->channels; c++) {
-                a->data[i * a->channels + c] = 0.f;
-            }
-        }
-    } else {
-        for(i=0; i < a->length; i++) {
-            for(c=0; c < a->channels; c++) {
-                a->data[i * a->channels + c] /= b;
-            }
-        }
-    }
+    LPKernels.divide_scalar(a->data, b, a->length * a->channels);
 }
 
 int buffers_are_equal(lpbuffer_t * a, lpbuffer_t * b) {
@@ -737,19 +1397,18 @@ int buffers_are_close(lpbuffer_t * a, lpbuffer_t * b, int d) {
 
 
 void env_buffer(lpbuffer_t * buf, lpbuffer_t * env) {
-    lpfloat_t pos, value;
-    size_t i;
-    int c;
+    lpfloat_t block[LPKERNELS_BLOCKSIZE];
+    size_t i, f, frames;
 
     assert(env->length > 0);
     assert(env->channels == 1);
 
-    for(i=0; i < buf->length; i++) {
-        pos = (lpfloat_t)i / buf->length;
-        value = interpolate_linear_pos(env, pos);
-        for(c=0; c < buf->channels; c++) {
-            buf->data[i * buf->channels + c] *= value;
+    for(i=0; i < buf->length; i += frames) {
+        frames = (buf->length - i < LPKERNELS_BLOCKSIZE) ? buf->length - i : LPKERNELS_BLOCKSIZE;
+        for(f=0; f < frames; f++) {
+            block[f] = interpolate_linear_pos(env, (lpfloat_t)(i+f) / buf->length);
         }
+        kernels_apply(LPKernels.multiply, buf->data + i * buf->channels, buf->channels, block, 1, frames);
     }
 }
 
@@ -759,7 +1418,7 @@ lpbuffer_t * pad_buffer(lpbuffer_t * buf, size_t before, size_t after) {
     lpbuffer_t * out;
 
     length = buf->length + before + after;
-    out = LPBuffer.create(length, buf->channels, buf->samplerate);
+    if((out = LPBuffer.create(length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     for(i=0; i < buf->length; i++) {
         for(c=0; c < out->channels; c++) {
@@ -863,7 +1522,7 @@ lpbuffer_t * trim_buffer(lpbuffer_t * buf, size_t start, size_t end, lpfloat_t t
     }
 
     length = trimend - trimstart;
-    out = LPBuffer.create(length, buf->channels, buf->samplerate);
+    if((out = LPBuffer.create(length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     for(i=0; i < length; i++) {
         for(c=0; c < buf->channels; c++) {
@@ -1011,21 +1670,11 @@ void plot_buffer(lpbuffer_t * buf) {
 }
 
 void dub_buffer(lpbuffer_t * a, lpbuffer_t * b, size_t start) {
-    size_t i;
-    int c, j;
-    lpfloat_t sample;
-
     assert(start + b->length <= a->length);
     assert(b->length <= a->length);
     assert(a->channels == b->channels);
 
-    for(i=0; i < b->length; i++) {
-        for(c=0; c < a->channels; c++) {
-            j = c % b->channels;
-            sample = b->data[i * b->channels + j];
-            a->data[(i+start) * a->channels + c] += sample;
-        }
-    }
+    LPKernels.add(a->data + start * a->channels, b->data, b->length * b->channels);
 }
 
 void dub_scalar(lpbuffer_t * a, lpfloat_t val, size_t start) {
@@ -1056,11 +1705,7 @@ void cut_into_buffer(lpbuffer_t * buf, lpbuffer_t * out, size_t start, size_t le
 }
 
 void clip_buffer(lpbuffer_t * buf, lpfloat_t minval, lpfloat_t maxval) {
-    size_t i, elements;
-    elements = buf->length * buf->channels;
-    for(i=0; i < elements; i++) {
-        buf->data[i] = fmin(fmax(buf->data[i], minval), maxval);
-    }
+    LPKernels.clip(buf->data, buf->length * buf->channels, minval, maxval);
 }
 
 lpbuffer_t * cut_buffer(lpbuffer_t * buf, size_t start, size_t length) {
@@ -1069,14 +1714,13 @@ lpbuffer_t * cut_buffer(lpbuffer_t * buf, size_t start, size_t length) {
     /* FIXME support zero-length buffers */
     assert(length > 0);
 
-    out = LPBuffer.create(length, buf->channels, buf->samplerate);
+    if((out = LPBuffer.create(length, buf->channels, buf->samplerate)) == NULL) return NULL;
     cut_into_buffer(buf, out, start, length);
     return out;
 }
 
 lpbuffer_t * mix_buffers(lpbuffer_t * a, lpbuffer_t * b) {
-    int max_channels, max_samplerate, c;
-    size_t i;
+    int max_channels, max_samplerate;
     lpbuffer_t * out;
     lpbuffer_t * longest;
     lpbuffer_t * shortest;
@@ -1089,19 +1733,10 @@ lpbuffer_t * mix_buffers(lpbuffer_t * a, lpbuffer_t * b) {
 
     max_channels = (a->channels >= b->channels) ? a->channels : b->channels;
     max_samplerate = (a->samplerate >= b->samplerate) ? a->samplerate : b->samplerate;
-    out = LPBuffer.create(longest->length, max_channels, max_samplerate);
+    if((out = LPBuffer.create(longest->length, max_channels, max_samplerate)) == NULL) return NULL;
 
-    for(i=0; i < longest->length; i++) {
-        for(c=0; c < max_channels; c++) {
-            out->data[i * max_channels + c] += longest->data[i * max_channels + c];
-        }
-    }
-
-    for(i=0; i < shortest->length; i++) {
-        for(c=0; c < max_channels; c++) {
-            out->data[i * max_channels + c] += shortest->data[i * max_channels + c];
-        }
-    }
+    kernels_apply(LPKernels.add, out->data, max_channels, longest->data, longest->channels, longest->length);
+    kernels_apply(LPKernels.add, out->data, max_channels, shortest->data, shortest->channels, shortest->length);
 
     return out;
 }
@@ -1112,7 +1747,7 @@ lpbuffer_t * remix_buffer(lpbuffer_t * buf, int channels) {
     lpbuffer_t * newbuf;
     lpfloat_t sample, phase, frac, a, b;
 
-    newbuf = create_buffer(buf->length, channels, buf->samplerate);
+    if((newbuf = create_buffer(buf->length, channels, buf->samplerate)) == NULL) return NULL;
 
     if(channels <= 1) {
         for(i=0; i < buf->length; i++) {
@@ -1144,7 +1779,7 @@ lpbuffer_t * remix_buffer_to_channels(lpbuffer_t * buf, int * channels, int num_
 
     assert(num_channels > 0);
 
-    newbuf = create_buffer(buf->length, num_channels, buf->samplerate);
+    if((newbuf = create_buffer(buf->length, num_channels, buf->samplerate)) == NULL) return NULL;
 
     for(i=0; i < buf->length; i++) {
         for(c=0; c < num_channels; c++) {
@@ -1160,7 +1795,7 @@ lpbuffer_t * fill_buffer(lpbuffer_t * buf, size_t length) {
     size_t i, j;
     int c;
     lpbuffer_t * out;
-    out = create_buffer(length, buf->channels, buf->samplerate);
+    if((out = create_buffer(length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     for(i=0; i < length; i++) {
         j = i % buf->length;
@@ -1176,7 +1811,7 @@ lpbuffer_t * repeat_buffer(lpbuffer_t * buf, size_t repeats) {
     size_t length, pos, i;
     lpbuffer_t * out;
     length = buf->length * repeats;
-    out = create_buffer(length, buf->channels, buf->samplerate);
+    if((out = create_buffer(length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     pos = 0;
     for(i=0; i < repeats; i++) {
@@ -1191,7 +1826,7 @@ lpbuffer_t * reverse_buffer(lpbuffer_t * buf) {
     size_t i, r;
     int c;
     lpbuffer_t * out;
-    out = create_buffer(buf->length, buf->channels, buf->samplerate);
+    if((out = create_buffer(buf->length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     for(c=0; c < buf->channels; c++) {
         for(i=0; i < buf->length; i++) {
@@ -1209,7 +1844,7 @@ lpbuffer_t * resize_buffer(lpbuffer_t * buf, size_t length) {
     int c;
     lpbuffer_t * newbuf;
 
-    newbuf = create_buffer(length, buf->channels, buf->samplerate);
+    if((newbuf = create_buffer(length, buf->channels, buf->samplerate)) == NULL) return NULL;
 
     for(i=0; i < length; i++) {
         if(i >= buf->length) break;
@@ -1222,28 +1857,239 @@ lpbuffer_t * resize_buffer(lpbuffer_t * buf, size_t length) {
     return newbuf;
 }
 
+/* Frees the buffer once the owner and every view 
+ * of it are done with it */
 void destroy_buffer(lpbuffer_t * buf) {
-    if(buf != NULL) {
-        LPMemoryPool.free(buf->data);
-        LPMemoryPool.free(buf);
+    if(buf == NULL) return;
+    if(__atomic_sub_fetch(&buf->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+    LPMemoryPool.free(buf->data);
+    LPMemoryPool.free(buf);
+}
+
+/* Buffer views
+ */
+static void buffer_retain(lpbuffer_t * buf) {
+    int expected = 0;
+
+    /* A buffer that was never counted has one owner */
+    if(__atomic_compare_exchange_n(&buf->refcount, &expected, 2, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return;
+    __atomic_fetch_add(&buf->refcount, 1, __ATOMIC_ACQ_REL);
+}
+
+static lpbufferview_t * view_copy(lpbufferview_t * view) {
+    lpbufferview_t * out;
+
+    if((out = (lpbufferview_t *)LPMemoryPool.alloc(1, sizeof(lpbufferview_t))) == NULL) {
+        fprintf(stderr, "Could not alloc memory for buffer view\n");
+        return NULL;
+    }
+
+    memcpy(out, view, sizeof(lpbufferview_t));
+    buffer_retain(out->buf);
+    return out;
+}
+
+lpbufferview_t * view_create(lpbuffer_t * buf) {
+    lpbufferview_t view = {0};
+
+    view.buf = buf;
+    view.data = buf->data;
+    view.length = buf->length;
+    view.frames = buf->length;
+    view.framestride = buf->channels;
+    view.channelstride = 1;
+    view.channels = buf->channels;
+    view.samplerate = buf->samplerate;
+
+    return view_copy(&view);
+}
+
+/* Frames past the end of the view read as silence */
+lpbufferview_t * view_cut(lpbufferview_t * view, size_t start, size_t length) {
+    lpbufferview_t * out;
+    size_t from, to;
+
+    if((out = view_copy(view)) == NULL) return NULL;
+
+    /* The overlap of the cut with the frames of the view */
+    from = (start > view->before) ? start : view->before;
+    to = (start + length < view->before + view->frames) ? start + length : view->before + view->frames;
+
+    out->length = length;
+    if(from < to) {
+        out->data = view->data + (ptrdiff_t)(from - view->before) * view->framestride;
+        out->before = from - start;
+        out->frames = to - from;
+    } else {
+        out->before = 0;
+        out->frames = 0;
+    }
+
+    return out;
+}
+
+lpbufferview_t * view_reverse(lpbufferview_t * view) {
+    lpbufferview_t * out;
+
+    if((out = view_copy(view)) == NULL) return NULL;
+
+    if(view->frames > 0) out->data = view->data + (ptrdiff_t)(view->frames - 1) * view->framestride;
+    out->framestride = -view->framestride;
+    out->before = view->length - view->before - view->frames;
+
+    return out;
+}
+
+lpbufferview_t * view_channel(lpbufferview_t * view, int channel) {
+    lpbufferview_t * out;
+
+    assert(channel >= 0 && channel < view->channels);
+    if((out = view_copy(view)) == NULL) return NULL;
+
+    out->data = view->data + channel * view->channelstride;
+    out->channels = 1;
+
+    return out;
+}
+
+lpbufferview_t * view_pad(lpbufferview_t * view, size_t before, size_t after) {
+    lpbufferview_t * out;
+
+    if((out = view_copy(view)) == NULL) return NULL;
+
+    out->length = view->length + before + after;
+    out->before = view->before + before;
+
+    return out;
+}
+
+lpfloat_t view_read(lpbufferview_t * view, size_t frame, int channel) {
+    assert(channel >= 0 && channel < view->channels);
+    if(frame < view->before || frame >= view->before + view->frames) return 0;
+    return view->data[(ptrdiff_t)(frame - view->before) * view->framestride + channel * view->channelstride];
+}
+
+lpsamples_t view_samples(lpbufferview_t * view, int channel) {
+    lpsamples_t samples;
+
+    assert(channel >= 0 && channel < view->channels);
+    samples.data = view->data + channel * view->channelstride;
+    samples.length = view->frames;
+    samples.stride = view->framestride;
+
+    return samples;
+}
+
+/* Padding counts as silence, as it would once 
+ * materialized */
+lpfloat_t view_min(lpbufferview_t * view) {
+    lpfloat_t out;
+    int c;
+
+    out = samples_min(view_samples(view, 0));
+    for(c=1; c < view->channels; c++) out = fmin(samples_min(view_samples(view, c)), out);
+    if(view->frames < view->length) out = fmin(0.f, out);
+    return out;
+}
+
+lpfloat_t view_max(lpbufferview_t * view) {
+    lpfloat_t out;
+    int c;
+
+    out = samples_max(view_samples(view, 0));
+    for(c=1; c < view->channels; c++) out = fmax(samples_max(view_samples(view, c)), out);
+    if(view->frames < view->length) out = fmax(0.f, out);
+    return out;
+}
+
+lpfloat_t view_mag(lpbufferview_t * view) {
+    lpfloat_t out = 0;
+    int c;
+
+    for(c=0; c < view->channels; c++) out = fmax(samples_mag(view_samples(view, c)), out);
+    return out;
+}
+
+/* Mix the view into out at start, scaled by env when 
+ * it isn't NULL. env is stretched over the length of 
+ * the view like LPBuffer.env does. */
+void view_dub(lpbuffer_t * out, lpbufferview_t * view, lpbuffer_t * env, size_t start) {
+    lpfloat_t * frame, * dest, amp = 1.f;
+    size_t i;
+    int c;
+
+    assert(out->channels == view->channels);
+    assert(start + view->length <= out->length);
+    assert(env == NULL || env->channels == 1);
+
+    dest = out->data + (start + view->before) * out->channels;
+    for(i=0; i < view->frames; i++) {
+        if(env != NULL) amp = interpolate_linear_pos(env, (lpfloat_t)(i + view->before) / view->length);
+        frame = view->data + (ptrdiff_t)i * view->framestride;
+        for(c=0; c < view->channels; c++) {
+            dest[i * out->channels + c] += frame[c * view->channelstride] * amp;
+        }
+    }
+}
+
+lpbuffer_t * view_materialize(lpbufferview_t * view) {
+    lpfloat_t * frame, * dest;
+    lpbuffer_t * out;
+    size_t i;
+    int c;
+
+    if((out = create_buffer(view->length, view->channels, view->samplerate)) == NULL) return NULL;
+
+    dest = out->data + view->before * view->channels;
+    if(view->framestride == view->channels && view->channelstride == 1) {
+        memcpy(dest, view->data, sizeof(lpfloat_t) * view->frames * view->channels);
+        return out;
+    }
+
+    for(i=0; i < view->frames; i++) {
+        frame = view->data + (ptrdiff_t)i * view->framestride;
+        for(c=0; c < view->channels; c++) {
+            dest[i * view->channels + c] = frame[c * view->channelstride];
+        }
     }
+
+    return out;
+}
+
+void view_destroy(lpbufferview_t * view) {
+    if(view == NULL) return;
+    destroy_buffer(view->buf);
+    LPMemoryPool.free(view);
 }
 
 /* Basic FX / waveshaping
  */
 lpfloat_t read_skewed_buffer(lpfloat_t freq, lpbuffer_t * buf, lpfloat_t phase, lpfloat_t skew) {
-    lpfloat_t warp, m, pos;
+    return read_skewed_samples(freq, samples_buffer(buf, 0), phase, skew);
+}
+
+lpfloat_t read_skewed_samples(lpfloat_t freq, lpsamples_t samples, lpfloat_t phase, lpfloat_t skew) {
+    lpfloat_t warp, m, pos, frac;
+    size_t i;
 
     m = 0.5f - skew;
 
-    pos = phase / buf->length;
+    pos = phase / samples.length;
     if(phase < skew) {
         warp = m * (pos / skew);
     } else {
         warp = m * ((1.f-pos) / (1.f-skew));
     }
 
-    return LPInterpolation.linear(buf, (phase + (warp * buf->length)) * freq);
+    /* The same linear read as LPInterpolation.linear */
+    if(samples.length == 1) return samples.data[0];
+
+    phase = (phase + (warp * samples.length)) * freq;
+    frac = phase - (int)phase;
+    i = (int)phase;
+    if(i >= samples.length-1) return 0;
+
+    return (1.0f - frac) * samples.data[(ptrdiff_t)i * samples.stride] + frac * samples.data[(ptrdiff_t)(i+1) * samples.stride];
 }
 
 lpfloat_t fx_lpf1(lpfloat_t x, lpfloat_t * y, lpfloat_t cutoff, lpfloat_t samplerate) {
@@ -1254,17 +2100,11 @@ lpfloat_t fx_lpf1(lpfloat_t x, lpfloat_t * y, lpfloat_t cutoff, lpfloat_t sample
 
 void fx_norm(lpbuffer_t * buf, lpfloat_t ceiling) {
     lpfloat_t maxval, normval;
-    size_t i;
-    int c;
 
     maxval = mag_buffer(buf);
     normval = ceiling / maxval;
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < buf->channels; c++) {
-            buf->data[i * buf->channels + c] *= normval;
-        }
-    }
+    LPKernels.multiply_scalar(buf->data, normval, buf->length * buf->channels);
 }
 
 lpfloat_t fx_crush(lpfloat_t val, int bits) {
@@ -1310,12 +2150,67 @@ void fx_convolve(lpbuffer_t * a, lpbuffer_t * b, lpbuffer_t * out) {
 
 
 /* RingBuffers
+ *
+ * The capacity is rounded up to a power of two so 
+ * positions wrap with a mask: boundry holds it. The 
+ * length asked for is kept in range, for anything 
+ * that treats the ring as a table of that length. 
+ *
+ * Block reads and writes are done in at most two runs, 
+ * one up to the end of the ring and one from its start. 
  */
+static size_t ringbuffer_capacity(size_t length) {
+    size_t capacity = 1;
+    while(capacity < length) capacity <<= 1;
+    return capacity;
+}
+
+static inline void ringbuffer_check(lpbuffer_t * ringbuf) {
+    assert(ringbuf->length > 0);
+    assert((ringbuf->length & (ringbuf->length - 1)) == 0);
+    assert(ringbuf->boundry == ringbuf->length - 1);
+}
+
+/* Copy nframes out of the ring from frame pos on */
+static void ringbuffer_copyout(lpbuffer_t * ringbuf, size_t pos, lpfloat_t * out, size_t nframes) {
+    size_t run, channels = ringbuf->channels;
+
+    while(nframes > 0) {
+        pos &= ringbuf->boundry;
+        run = ringbuf->length - pos;
+        if(run > nframes) run = nframes;
+        memcpy(out, ringbuf->data + pos * channels, sizeof(lpfloat_t) * run * channels);
+        out += run * channels;
+        pos += run;
+        nframes -= run;
+    }
+}
+
+/* Copy or mix nframes into the ring at the write 
+ * position, and move it along */
+static void ringbuffer_copyin(lpbuffer_t * ringbuf, const lpfloat_t * in, size_t nframes, int dub) {
+    size_t run, channels = ringbuf->channels;
+
+    while(nframes > 0) {
+        run = ringbuf->length - ringbuf->pos;
+        if(run > nframes) run = nframes;
+        if(dub) {
+            LPKernels.add(ringbuf->data + ringbuf->pos * channels, in, run * channels);
+        } else {
+            memcpy(ringbuf->data + ringbuf->pos * channels, in, sizeof(lpfloat_t) * run * channels);
+        }
+        in += run * channels;
+        ringbuf->pos = (ringbuf->pos + run) & ringbuf->boundry;
+        nframes -= run;
+    }
+}
+
 lpbuffer_t * ringbuffer_create(size_t length, int channels, int samplerate) {
     lpbuffer_t * ringbuf;
-    ringbuf = LPBuffer.create(length, channels, samplerate);
+    if((ringbuf = LPBuffer.create(ringbuffer_capacity(length), channels, samplerate)) == NULL) return NULL;
     ringbuf->pos = 0;
-    ringbuf->boundry = length - 1;
+    ringbuf->boundry = ringbuf->length - 1;
+    ringbuf->range = length;
     return ringbuf;
 }
 
@@ -1323,200 +2218,606 @@ void ringbuffer_fill(lpbuffer_t * ringbuf, lpbuffer_t * buf, int offset) {
     size_t i;
     int c;
     size_t pos = ringbuf->pos - buf->length - offset;
-    pos = pos % ringbuf->length;
+
+    ringbuffer_check(ringbuf);
+    if(buf->channels == ringbuf->channels) {
+        ringbuffer_copyout(ringbuf, pos, buf->data, buf->length);
+        return;
+    }
+
     for(i=0; i < buf->length; i++) {
-        for(c=0; c < ringbuf->channels; c++) {
-            buf->data[i * buf->channels + c] = ringbuf->data[pos * ringbuf->channels + c];
+        pos &= ringbuf->boundry;
+        for(c=0; c < buf->channels; c++) {
+            buf->data[i * buf->channels + c] = ringbuf->data[pos * ringbuf->channels + (c % ringbuf->channels)];
         }
-
         pos += 1;
-        pos = pos % ringbuf->length;
     }
 }
 
 lpfloat_t ringbuffer_readone(lpbuffer_t * ringbuf, int offset) {
-    return ringbuf->data[(ringbuf->pos - offset) % ringbuf->length];
+    return ringbuf->data[(ringbuf->pos - offset) & ringbuf->boundry];
 }
 
 void ringbuffer_readinto(lpbuffer_t * ringbuf, lpfloat_t * data, size_t length, int channels) {
     size_t i;
     int c;
     size_t pos = ringbuf->pos - length;
-    pos = pos % ringbuf->length;
+
+    ringbuffer_check(ringbuf);
+    if(channels == ringbuf->channels) {
+        ringbuffer_copyout(ringbuf, pos, data, length);
+        return;
+    }
 
     for(i=0; i < length; i++) {
+        pos &= ringbuf->boundry;
         for(c=0; c < channels; c++) {
-            data[i * channels + c] = ringbuf->data[pos * channels + c];
+            data[i * channels + c] = ringbuf->data[pos * ringbuf->channels + (c % ringbuf->channels)];
         }
-
         pos += 1;
-        pos = pos % ringbuf->length;
     }
 }
 
 lpbuffer_t * ringbuffer_read(lpbuffer_t * ringbuf, size_t length) {
-    size_t i;
-    int c;
-    size_t pos = ringbuf->pos - length;
     lpbuffer_t * out;
 
-    pos = pos % ringbuf->length;
-    out = LPBuffer.create(length, ringbuf->channels, ringbuf->samplerate);
-    for(i=0; i < length; i++) {
-        for(c=0; c < ringbuf->channels; c++) {
-            out->data[i * out->channels + c] = ringbuf->data[pos * ringbuf->channels + c];
-        }
-
-        pos += 1;
-        pos = pos % ringbuf->length;
-    }
+    ringbuffer_check(ringbuf);
+    if((out = LPBuffer.create(length, ringbuf->channels, ringbuf->samplerate)) == NULL) return NULL;
+    ringbuffer_copyout(ringbuf, ringbuf->pos - length, out->data, length);
 
     return out;
 }
 
 void ringbuffer_writeone(lpbuffer_t * ringbuf, lpfloat_t sample) {
     ringbuf->data[ringbuf->pos] = sample;
-    ringbuf->pos += 1;
-    ringbuf->pos = ringbuf->pos % ringbuf->length;
+    ringbuf->pos = (ringbuf->pos + 1) & ringbuf->boundry;
 }
 
+/* Sources with fewer channels than the ring are 
+ * wrapped around its channels, one frame at a time */
 void ringbuffer_writefrom(lpbuffer_t * ringbuf, lpfloat_t * data, size_t length, int channels) {
     size_t i;
-    int c, j;
+    int c;
+
+    ringbuffer_check(ringbuf);
+    if(channels == ringbuf->channels) {
+        ringbuffer_copyin(ringbuf, data, length, 0);
+        return;
+    }
+
     for(i=0; i < length; i++) {
         for(c=0; c < ringbuf->channels; c++) {
-            j = c % channels;
-            ringbuf->data[ringbuf->pos * ringbuf->channels + c] = data[i * channels + j];
+            ringbuf->data[ringbuf->pos * ringbuf->channels + c] = data[i * channels + (c % channels)];
         }
-
-        ringbuf->pos += 1;
-        ringbuf->pos = ringbuf->pos % ringbuf->length;
+        ringbuf->pos = (ringbuf->pos + 1) & ringbuf->boundry;
     }
 }
 
 void ringbuffer_write(lpbuffer_t * ringbuf, lpbuffer_t * buf) {
-    size_t i;
-    int c, j;
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < ringbuf->channels; c++) {
-            j = c % buf->channels;
-            ringbuf->data[ringbuf->pos * ringbuf->channels + c] = buf->data[i * buf->channels + j];
-        }
-
-        ringbuf->pos += 1;
-        ringbuf->pos = ringbuf->pos % ringbuf->length;
-    }
+    ringbuffer_writefrom(ringbuf, buf->data, buf->length, buf->channels);
 }
 
 void ringbuffer_dub(lpbuffer_t * buf, lpbuffer_t * src) {
     size_t i;
-    int c, j;
+    int c;
+
+    ringbuffer_check(buf);
+    if(src->channels == buf->channels) {
+        ringbuffer_copyin(buf, src->data, src->length, 1);
+        return;
+    }
+
     for(i=0; i < src->length; i++) {
         for(c=0; c < buf->channels; c++) {
-            j = c % src->channels;
-            buf->data[buf->pos * buf->channels + c] += src->data[i * src->channels + j];
+            buf->data[buf->pos * buf->channels + c] += src->data[i * src->channels + (c % src->channels)];
         }
-
-        buf->pos += 1;
-        buf->pos = buf->pos % buf->length;
+        buf->pos = (buf->pos + 1) & buf->boundry;
     }
 }
 
-void ringbuffer_destroy(lpbuffer_t * buf) {
-    LPBuffer.destroy(buf);
+/* Read a frame delay frames before the last one written, 
+ * which is a delay of 0. Fractional delays interpolate 
+ * linearly, and delays are clamped to what the ring 
+ * can hold. */
+void ringbuffer_tap(lpbuffer_t * ringbuf, lpfloat_t delay, lpfloat_t * frame) {
+    ringbuffer_tapinto(ringbuf, &delay, frame, 1);
 }
 
+/* Tap one frame for each of the last nframes written, 
+ * as a delay line running in blocks would: out frame i 
+ * is delays[i] frames before written frame i. */
+void ringbuffer_tapinto(lpbuffer_t * ringbuf, const lpfloat_t * delays, lpfloat_t * out, size_t nframes) {
+    lpfloat_t delay, frac, maxdelay, * newer, * older;
+    size_t i, whole, pos;
+    int c, channels;
 
-/* LPMemoryPool
- * */
-void memorypool_init(unsigned char * pool, size_t poolsize) {
-    assert(poolsize >= 1);
-    LPMemoryPool.pool = pool;
-    LPMemoryPool.poolsize = poolsize;
-    LPMemoryPool.pos = 0;
-}
+    ringbuffer_check(ringbuf);
+    channels = ringbuf->channels;
+    maxdelay = (lpfloat_t)ringbuf->boundry - 1;
+    pos = ringbuf->pos - nframes - 1;
 
-lpmemorypool_t * memorypool_custom_init(unsigned char * pool, size_t poolsize) {
-    lpmemorypool_t * mp;
-    mp = (lpmemorypool_t *)LPMemoryPool.alloc(1, sizeof(lpmemorypool_t));
+    for(i=0; i < nframes; i++) {
+        pos += 1;
+        delay = delays[i];
+        if(delay < 0) delay = 0;
+        if(delay > maxdelay) delay = maxdelay;
 
-    assert(poolsize >= 1);
-    mp->pool = pool;
-    mp->poolsize = poolsize;
-    mp->pos = 0;
+        whole = (size_t)delay;
+        frac = delay - whole;
+        newer = ringbuf->data + ((pos - whole) & ringbuf->boundry) * channels;
+        older = ringbuf->data + ((pos - whole - 1) & ringbuf->boundry) * channels;
 
-    return mp;
+        for(c=0; c < channels; c++) {
+            out[i * channels + c] = newer[c] + (older[c] - newer[c]) * frac;
+        }
+    }
 }
 
-void * memorypool_custom_alloc(lpmemorypool_t * mp, size_t itemcount, size_t itemsize) {
-    void * p;
-    size_t length;
+void ringbuffer_destroy(lpbuffer_t * buf) {
+    LPBuffer.destroy(buf);
+}
 
-    assert(mp->pool != 0); 
-    length = itemcount * itemsize;
 
-    if(mp->poolsize >= mp->pos + length) {
-        p = (void *)(&mp->pool[mp->pos]);
-        mp->pos += length;
-        return p;
+/* SPSC ring buffers
+ *
+ * The writer only stores writepos and the reader only 
+ * stores readpos. Each loads the other's position with 
+ * acquire to see how much room or data there is, and 
+ * stores its own with release once the frames are 
+ * copied, so the frames are visible before the new 
+ * position is. 
+ */
+lpspscring_t * spscring_create(size_t length, int channels, int samplerate) {
+    lpspscring_t * ring;
+
+    if((ring = (lpspscring_t *)LPMemoryPool.alloc(1, sizeof(lpspscring_t))) == NULL) return NULL;
+    ring->capacity = ringbuffer_capacity(length);
+    ring->mask = ring->capacity - 1;
+    ring->channels = channels;
+    ring->samplerate = samplerate;
+    if((ring->data = (lpfloat_t *)LPMemoryPool.alloc(ring->capacity * channels, sizeof(lpfloat_t))) == NULL) {
+        LPMemoryPool.free(ring);
+        return NULL;
     }
-    /* FIXME might as well try to expand the pool here */
-    exit(EXIT_FAILURE);
+    ring->writepos = 0;
+    ring->readpos = 0;
+
+    return ring;
 }
 
-void * memorypool_alloc(size_t itemcount, size_t itemsize) {
-    void * p;
-#ifdef LP_STATIC
-    size_t size;
-    size = itemcount * itemsize;
-    assert(LPMemoryPool.pool != 0); 
-    if(LPMemoryPool.poolsize >= LPMemoryPool.pos + size) {
-        p = (void *)(&LPMemoryPool.pool[LPMemoryPool.pos]);
-        LPMemoryPool.pos += size;
-        return p;
-    }
-    exit(EXIT_FAILURE);
-#else
-    p = (void *)calloc(itemcount, itemsize);
-    if(p == NULL) {
-        fprintf(stderr, "Calloc returned null trying to alloc %d bytes. %s (%d)\n", (int)(itemcount * itemsize), strerror(errno), errno);
-        exit(EXIT_FAILURE);
-    }
-    return p;
-#endif
+size_t spscring_readable(lpspscring_t * ring) {
+    return __atomic_load_n(&ring->writepos, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->readpos, __ATOMIC_ACQUIRE);
 }
 
-void memorypool_free(void * ptr) {
-#ifndef LP_STATIC
-    free(ptr);
-#else
-    (void)ptr;
-#endif
+size_t spscring_writable(lpspscring_t * ring) {
+    return ring->capacity - spscring_readable(ring);
 }
 
-/* Param
- * */
-lpbuffer_t * param_create_from_float(lpfloat_t value) {
-    lpbuffer_t * param = create_buffer(1, 1, DEFAULT_SAMPLERATE);
-    param->data[0] = value;
-    return param;
+/* Write up to nframes, as many as there is room for, 
+ * and return how many were written. Writer side only. */
+size_t spscring_write(lpspscring_t * ring, const lpfloat_t * data, size_t nframes) {
+    size_t writepos, readpos, start, run, count;
+
+    writepos = __atomic_load_n(&ring->writepos, __ATOMIC_RELAXED);
+    readpos = __atomic_load_n(&ring->readpos, __ATOMIC_ACQUIRE);
+    count = ring->capacity - (writepos - readpos);
+    if(count > nframes) count = nframes;
+
+    start = writepos & ring->mask;
+    run = ring->capacity - start;
+    if(run > count) run = count;
+    memcpy(ring->data + start * ring->channels, data, sizeof(lpfloat_t) * run * ring->channels);
+    memcpy(ring->data, data + run * ring->channels, sizeof(lpfloat_t) * (count - run) * ring->channels);
+
+    __atomic_store_n(&ring->writepos, writepos + count, __ATOMIC_RELEASE);
+    return count;
 }
 
-lpbuffer_t * param_create_from_int(int value) {
-    lpbuffer_t * param = create_buffer(1, 1, DEFAULT_SAMPLERATE);
-    param->data[0] = (lpfloat_t)value;
-    return param;
+/* Read up to nframes, as many as there are, and return 
+ * how many were read. Reader side only. */
+size_t spscring_read(lpspscring_t * ring, lpfloat_t * data, size_t nframes) {
+    size_t writepos, readpos, start, run, count;
+
+    readpos = __atomic_load_n(&ring->readpos, __ATOMIC_RELAXED);
+    writepos = __atomic_load_n(&ring->writepos, __ATOMIC_ACQUIRE);
+    count = writepos - readpos;
+    if(count > nframes) count = nframes;
+
+    start = readpos & ring->mask;
+    run = ring->capacity - start;
+    if(run > count) run = count;
+    memcpy(data, ring->data + start * ring->channels, sizeof(lpfloat_t) * run * ring->channels);
+    memcpy(data + run * ring->channels, ring->data, sizeof(lpfloat_t) * (count - run) * ring->channels);
+
+    __atomic_store_n(&ring->readpos, readpos + count, __ATOMIC_RELEASE);
+    return count;
 }
 
-/* Interpolation
+void spscring_destroy(lpspscring_t * ring) {
+    LPMemoryPool.free(ring->data);
+    LPMemoryPool.free(ring);
+}
+
+
+/* LPMemoryPool
+ *
+ * Every block starts with a header recording which pool 
+ * it came from and its size class, so free() can put it 
+ * back without being told the size. Blocks from the heap 
+ * (before a primary pool is set up) and from arena scopes 
+ * are marked with the special classes below.
  * */
-lpfloat_t interpolate_hermite(lpbuffer_t* buf, lpfloat_t phase) {
-    lpfloat_t y0, y1, y2, y3, frac;
-    lpfloat_t c0, c1, c2, c3;
-    int i0, i1, i2, i3;
+#define MEMORYPOOL_MAGIC 0x4c504d50
+#define MEMORYPOOL_HEAPCLASS 0xffffffffu
 
-    if(buf->range == 1) return buf->data[0];
-    if(buf->range < 1) return 0;
+typedef struct memorypool_block_t {
+    union {
+        lpmemorypool_t * owner;
+        size_t heapsize;
+    };
+    uint32_t sizeclass;
+    uint32_t magic;
+} memorypool_block_t;
+
+static_assert(sizeof(memorypool_block_t) <= LPMEMORYPOOL_ALIGN, "memorypool block header must fit in LPMEMORYPOOL_ALIGN");
+
+/* Per thread: a small stack of freed blocks for each of 
+ * the smaller size classes of the primary pool, and the 
+ * stack of active arena scopes. */
+typedef struct memorypool_cache_t {
+    size_t generation;
+    void * blocks[LPMEMORYPOOL_CACHECLASSES][LPMEMORYPOOL_CACHESIZE];
+    int count[LPMEMORYPOOL_CACHECLASSES];
+    lpmemorypool_t * scopes[LPMEMORYPOOL_MAXSCOPES];
+    int numscopes;
+} memorypool_cache_t;
+
+static lpmemorypool_t memorypool_primary = { .lock = ATOMIC_FLAG_INIT };
+static _Thread_local memorypool_cache_t memorypool_cache;
+
+static void memorypool_lock(lpmemorypool_t * mp) {
+    while(atomic_flag_test_and_set_explicit(&mp->lock, memory_order_acquire));
+}
+
+static void memorypool_unlock(lpmemorypool_t * mp) {
+    atomic_flag_clear_explicit(&mp->lock, memory_order_release);
+}
+
+/* Classes 0-3 are 16, 32, 48 and 64 bytes, then every 
+ * power of two is split into four steps: 80, 96, 112, 128, 
+ * 160, 192... */
+static size_t memorypool_class_size(size_t sizeclass) {
+    size_t k, sub;
+    if(sizeclass < 4) return LPMEMORYPOOL_ALIGN * (sizeclass + 1);
+    k = (sizeclass - 4) / 4;
+    sub = (sizeclass - 4) % 4;
+    return ((size_t)64 << k) + ((size_t)16 << k) * (sub + 1);
+}
+
+static size_t memorypool_class(size_t size) {
+    size_t k, step;
+    if(size <= 64) return (size + LPMEMORYPOOL_ALIGN - 1) / LPMEMORYPOOL_ALIGN - 1;
+    k = (sizeof(size_t) * CHAR_BIT - 1 - __builtin_clzl(size - 1)) - 6;
+    step = (size_t)16 << k;
+    return 4 + 4 * k + (size - ((size_t)64 << k) + step - 1) / step - 1;
+}
+
+static void memorypool_count_alloc(lpmemorypool_t * mp, size_t size) {
+    size_t live, highwater;
+
+    __atomic_fetch_add(&mp->stats.allocs, 1, __ATOMIC_RELAXED);
+    live = __atomic_add_fetch(&mp->stats.live, size, __ATOMIC_RELAXED);
+    highwater = __atomic_load_n(&mp->stats.highwater, __ATOMIC_RELAXED);
+    while(live > highwater && !__atomic_compare_exchange_n(&mp->stats.highwater, &highwater, live, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void memorypool_count_free(lpmemorypool_t * mp, size_t size) {
+    __atomic_fetch_add(&mp->stats.frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&mp->stats.live, size, __ATOMIC_RELAXED);
+}
+
+static void memorypool_setup(lpmemorypool_t * mp, unsigned char * pool, size_t poolsize) {
+    size_t offset;
+
+    /* Start the region on a block boundary */
+    offset = (LPMEMORYPOOL_ALIGN - ((uintptr_t)pool % LPMEMORYPOOL_ALIGN)) % LPMEMORYPOOL_ALIGN;
+    assert(poolsize > offset);
+
+    mp->pool = pool + offset;
+    mp->poolsize = poolsize - offset;
+    mp->pos = 0;
+    memset(mp->freelists, 0, sizeof(mp->freelists));
+    memset(&mp->stats, 0, sizeof(lpmemorypool_stats_t));
+    atomic_flag_clear(&mp->lock);
+}
+
+/* Take a block of the given class from the shared free 
+ * list or carve a new one. Called with the pool locked. */
+static memorypool_block_t * memorypool_take(lpmemorypool_t * mp, size_t sizeclass) {
+    memorypool_block_t * block;
+    size_t blocksize;
+
+    block = (memorypool_block_t *)mp->freelists[sizeclass];
+    if(block != NULL) {
+        mp->freelists[sizeclass] = *(void **)((unsigned char *)block + LPMEMORYPOOL_ALIGN);
+        return block;
+    }
+
+    blocksize = memorypool_class_size(sizeclass);
+    if(mp->poolsize - mp->pos < blocksize) return NULL;
+
+    block = (memorypool_block_t *)(&mp->pool[mp->pos]);
+    mp->pos += blocksize;
+    return block;
+}
+
+static void memorypool_put(lpmemorypool_t * mp, memorypool_block_t * block) {
+    *(void **)((unsigned char *)block + LPMEMORYPOOL_ALIGN) = mp->freelists[block->sizeclass];
+    mp->freelists[block->sizeclass] = block;
+}
+
+/* Drop a thread cache that belongs to an earlier 
+ * primary pool region */
+static void memorypool_cache_check(void) {
+    if(memorypool_cache.generation != memorypool_primary.generation) {
+        memset(memorypool_cache.count, 0, sizeof(memorypool_cache.count));
+        memorypool_cache.generation = memorypool_primary.generation;
+    }
+}
+
+static void * memorypool_pool_alloc(lpmemorypool_t * mp, size_t size) {
+    memorypool_block_t * block = NULL;
+    size_t sizeclass;
+    int cached;
+
+    sizeclass = memorypool_class(size + LPMEMORYPOOL_ALIGN);
+    if(sizeclass >= LPMEMORYPOOL_NUMCLASSES) {
+        __atomic_fetch_add(&mp->stats.failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    cached = (mp == &memorypool_primary && sizeclass < LPMEMORYPOOL_CACHECLASSES);
+    if(cached) {
+        memorypool_cache_check();
+        if(memorypool_cache.count[sizeclass] > 0) {
+            block = memorypool_cache.blocks[sizeclass][--memorypool_cache.count[sizeclass]];
+        }
+    }
+
+    if(block == NULL) {
+        memorypool_lock(mp);
+        block = memorypool_take(mp, sizeclass);
+        memorypool_unlock(mp);
+    }
+
+    if(block == NULL) {
+        __atomic_fetch_add(&mp->stats.failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    block->owner = mp;
+    block->sizeclass = (uint32_t)sizeclass;
+    block->magic = MEMORYPOOL_MAGIC;
+    memorypool_count_alloc(mp, memorypool_class_size(sizeclass));
+
+    memset((unsigned char *)block + LPMEMORYPOOL_ALIGN, 0, size);
+    return (unsigned char *)block + LPMEMORYPOOL_ALIGN;
+}
+
+void memorypool_init(unsigned char * pool, size_t poolsize) {
+    assert(poolsize >= 1);
+    memorypool_setup(&memorypool_primary, pool, poolsize);
+    memorypool_primary.generation += 1;
+}
+
+lpmemorypool_t * memorypool_custom_init(unsigned char * pool, size_t poolsize) {
+    lpmemorypool_t * mp;
+    mp = (lpmemorypool_t *)LPMemoryPool.alloc(1, sizeof(lpmemorypool_t));
+    if(mp == NULL) return NULL;
+
+    assert(poolsize >= 1);
+    memorypool_setup(mp, pool, poolsize);
+
+    return mp;
+}
+
+void * memorypool_custom_alloc(lpmemorypool_t * mp, size_t itemcount, size_t itemsize) {
+    assert(mp->pool != 0); 
+    return memorypool_pool_alloc(mp, itemcount * itemsize);
+}
+
+void * memorypool_alloc(size_t itemcount, size_t itemsize) {
+    memorypool_block_t * block;
+    size_t size;
+
+    size = itemcount * itemsize;
+
+    if(memorypool_cache.numscopes > 0) {
+        return memorypool_pool_alloc(memorypool_cache.scopes[memorypool_cache.numscopes-1], size);
+    }
+
+#ifdef LP_STATIC
+    assert(memorypool_primary.pool != 0); 
+#endif
+
+    if(memorypool_primary.pool != NULL) {
+        return memorypool_pool_alloc(&memorypool_primary, size);
+    }
+
+    block = (memorypool_block_t *)calloc(1, size + LPMEMORYPOOL_ALIGN);
+    if(block == NULL) {
+        fprintf(stderr, "Calloc returned null trying to alloc %d bytes. %s (%d)\n", (int)size, strerror(errno), errno);
+        __atomic_fetch_add(&memorypool_primary.stats.failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    block->heapsize = size + LPMEMORYPOOL_ALIGN;
+    block->sizeclass = MEMORYPOOL_HEAPCLASS;
+    block->magic = MEMORYPOOL_MAGIC;
+    memorypool_count_alloc(&memorypool_primary, size + LPMEMORYPOOL_ALIGN);
+
+    return (unsigned char *)block + LPMEMORYPOOL_ALIGN;
+}
+
+void memorypool_free(void * ptr) {
+    memorypool_block_t * block;
+    lpmemorypool_t * mp;
+    size_t sizeclass;
+
+    if(ptr == NULL) return;
+
+    block = (memorypool_block_t *)((unsigned char *)ptr - LPMEMORYPOOL_ALIGN);
+    assert(block->magic == MEMORYPOOL_MAGIC);
+
+    if(block->sizeclass == MEMORYPOOL_HEAPCLASS) {
+        memorypool_count_free(&memorypool_primary, block->heapsize);
+        block->magic = 0;
+        free(block);
+        return;
+    }
+
+    mp = block->owner;
+    sizeclass = block->sizeclass;
+    block->magic = 0;
+    memorypool_count_free(mp, memorypool_class_size(sizeclass));
+
+    if(mp == &memorypool_primary && sizeclass < LPMEMORYPOOL_CACHECLASSES) {
+        memorypool_cache_check();
+        if(memorypool_cache.count[sizeclass] < LPMEMORYPOOL_CACHESIZE) {
+            memorypool_cache.blocks[sizeclass][memorypool_cache.count[sizeclass]++] = block;
+            return;
+        }
+    }
+
+    memorypool_lock(mp);
+    memorypool_put(mp, block);
+    memorypool_unlock(mp);
+}
+
+/* Hand this thread's cached blocks back to the primary pool */
+void memorypool_thread_release(void) {
+    size_t c;
+    int i;
+
+    memorypool_cache_check();
+
+    memorypool_lock(&memorypool_primary);
+    for(c=0; c < LPMEMORYPOOL_CACHECLASSES; c++) {
+        for(i=0; i < memorypool_cache.count[c]; i++) {
+            memorypool_put(&memorypool_primary, (memorypool_block_t *)memorypool_cache.blocks[c][i]);
+        }
+        memorypool_cache.count[c] = 0;
+    }
+    memorypool_unlock(&memorypool_primary);
+}
+
+size_t memorypool_mark(lpmemorypool_t * mp) {
+    size_t pos;
+    assert(mp != NULL && mp != &memorypool_primary);
+    memorypool_lock(mp);
+    pos = mp->pos;
+    memorypool_unlock(mp);
+    return pos;
+}
+
+/* Release every block carved from the pool since mark. 
+ * Blocks above the mark that were already freed have to 
+ * come off the free lists too.
+ *
+ * Blocks below the mark that were reused after it was 
+ * taken stay allocated: with nested marks they are 
+ * released by the reset of the outer mark. */
+void memorypool_reset(lpmemorypool_t * mp, size_t mark) {
+    memorypool_block_t * block;
+    void ** link;
+    unsigned char * top;
+    size_t c, released;
+
+    assert(mp != NULL && mp != &memorypool_primary);
+
+    memorypool_lock(mp);
+    assert(mark <= mp->pos);
+    top = mp->pool + mark;
+
+    /* Everything above the mark that isn't on a free list is live */
+    released = mp->pos - mark;
+    for(c=0; c < LPMEMORYPOOL_NUMCLASSES; c++) {
+        link = &mp->freelists[c];
+        while(*link != NULL) {
+            block = (memorypool_block_t *)*link;
+            if((unsigned char *)block >= top) {
+                *link = *(void **)((unsigned char *)block + LPMEMORYPOOL_ALIGN);
+                released -= memorypool_class_size(c);
+            } else {
+                link = (void **)((unsigned char *)block + LPMEMORYPOOL_ALIGN);
+            }
+        }
+    }
+
+    __atomic_fetch_sub(&mp->stats.live, released, __ATOMIC_RELAXED);
+    mp->pos = mark;
+    memorypool_unlock(mp);
+}
+
+size_t memorypool_scope_begin(lpmemorypool_t * arena) {
+    assert(memorypool_cache.numscopes < LPMEMORYPOOL_MAXSCOPES);
+    memorypool_cache.scopes[memorypool_cache.numscopes++] = arena;
+    return memorypool_mark(arena);
+}
+
+void memorypool_scope_end(lpmemorypool_t * arena, size_t mark) {
+    assert(memorypool_cache.numscopes > 0);
+    assert(memorypool_cache.scopes[memorypool_cache.numscopes-1] == arena);
+    memorypool_cache.numscopes -= 1;
+    memorypool_reset(arena, mark);
+}
+
+lpmemorypool_stats_t memorypool_stats(lpmemorypool_t * mp) {
+    lpmemorypool_stats_t stats;
+    if(mp == NULL) mp = &memorypool_primary;
+    stats.live = __atomic_load_n(&mp->stats.live, __ATOMIC_RELAXED);
+    stats.highwater = __atomic_load_n(&mp->stats.highwater, __ATOMIC_RELAXED);
+    stats.allocs = __atomic_load_n(&mp->stats.allocs, __ATOMIC_RELAXED);
+    stats.frees = __atomic_load_n(&mp->stats.frees, __ATOMIC_RELAXED);
+    stats.failed = __atomic_load_n(&mp->stats.failed, __ATOMIC_RELAXED);
+    return stats;
+}
+
+/* Param
+ * */
+lpbuffer_t * param_create_from_float(lpfloat_t value) {
+    lpbuffer_t * param = create_buffer(1, 1, DEFAULT_SAMPLERATE);
+    if(param == NULL) return NULL;
+    param->data[0] = value;
+    return param;
+}
+
+lpbuffer_t * param_create_from_int(int value) {
+    lpbuffer_t * param = create_buffer(1, 1, DEFAULT_SAMPLERATE);
+    if(param == NULL) return NULL;
+    param->data[0] = (lpfloat_t)value;
+    return param;
+}
+
+/* Sample nframes of a param curve stretched over length frames, 
+ * starting at offset, into a control block for process_block */
+lpfloat_t * param_fill_block(lpbuffer_t * param, lpfloat_t * block, size_t offset, size_t nframes, size_t length) {
+    size_t i;
+    for(i=0; i < nframes; i++) {
+        block[i] = interpolate_linear_pos(param, (float)(offset+i)/length);
+    }
+    return block;
+}
+
+/* Interpolation
+ * */
+lpfloat_t interpolate_hermite(lpbuffer_t* buf, lpfloat_t phase) {
+    lpfloat_t y0, y1, y2, y3, frac;
+    lpfloat_t c0, c1, c2, c3;
+    int i0, i1, i2, i3;
+
+    if(buf->range == 1) return buf->data[0];
+    if(buf->range < 1) return 0;
 
     frac = phase - (int)phase;
     i1 = (int)phase;
@@ -1617,14 +2918,14 @@ lpfloat_t interpolate_linear_pos2(lpfloat_t * buf, size_t length, lpfloat_t pos)
 void wavetable_sine(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = sin((i/(lpfloat_t)length) * (lpfloat_t)PI * 2.0f);
+        out[i] = lpfastsin(i/(lpfloat_t)length);
     }
 }
 
 void wavetable_cosine(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = cos((i/(lpfloat_t)length) * (lpfloat_t)PI * 2.0f);
+        out[i] = lpfastcos(i/(lpfloat_t)length);
     }
 }
 
@@ -1668,89 +2969,113 @@ void wavetable_rsaw(lpfloat_t* out, int length) {
     }
 }
 
-/* create a wavetable (-1 to 1) */
-lpbuffer_t* create_wavetable(int name, size_t length) {
-    lpbuffer_t* buf = LPBuffer.create(length, 1, DEFAULT_SAMPLERATE);
+/* Fill out with the named wavetable: sine for 
+ * anything without a generator */
+static void fill_wavetable(int name, lpfloat_t * out, size_t length) {
     if(name == WT_SINE) {
-        wavetable_sine(buf->data, length);            
+        wavetable_sine(out, length);            
     } else if (name == WT_COS) {
-        wavetable_cosine(buf->data, length);            
+        wavetable_cosine(out, length);            
     } else if (name == WT_TRI) {
-        wavetable_tri(buf->data, length);            
+        wavetable_tri(out, length);            
     } else if (name == WT_TRI2) {
-        wavetable_tri2(buf->data, length);            
+        wavetable_tri2(out, length);            
     } else if (name == WT_SQUARE) {
-        wavetable_square(buf->data, length);            
+        wavetable_square(out, length);            
     } else if (name == WT_SAW) {
-        wavetable_saw(buf->data, length);            
+        wavetable_saw(out, length);            
     } else if (name == WT_RSAW) {
-        wavetable_rsaw(buf->data, length);            
-    } else if (name == WT_RND) {
-        return create_wavetable(rand_choice(NUM_WAVETABLES), length);
+        wavetable_rsaw(out, length);            
     } else {
-        wavetable_sine(buf->data, length);            
+        wavetable_sine(out, length);            
     }
-    return buf;
 }
 
-lpbuffer_t * lpbuffer_create_stack(lpbuffer_t * (*table_creator)(int name, size_t length), int numtables, size_t * onsets, size_t * lengths, va_list vl) {
-    lpbuffer_t * stack;
-    lpbuffer_t * user_bufp;
-    int i;
-    size_t tablesize, stacklength, pos, j;
-    lpbuffer_t ** bufs;
-    size_t * tablesizes;
-    int * tables;
+/* create a wavetable (-1 to 1): a private copy of 
+ * the one in the table cache, or a fresh one for 
+ * lengths the cache doesn't keep */
+lpbuffer_t* create_wavetable(int name, size_t length) {
+    lpbuffer_t * buf, * table;
 
-    bufs = (lpbuffer_t **)LPMemoryPool.alloc(numtables, sizeof(lpbuffer_t *));
-    tablesizes = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
-    tables = (int *)LPMemoryPool.alloc(numtables, sizeof(int));
+    if((buf = LPBuffer.create(length, 1, DEFAULT_SAMPLERATE)) == NULL) return NULL;
 
-    memset(bufs, 0, numtables * sizeof(lpbuffer_t *));
-    memset(tablesizes, 0, numtables * sizeof(size_t));
-    memset(tables, 0, numtables * sizeof(int));
+    if(!tablecache_cacheable(length) || (table = tablecache_get(LPTABLE_WAVETABLE, name, length)) == NULL) {
+        while(name == WT_RND) name = rand_choice(NUM_WAVETABLES);
+        fill_wavetable(name, buf->data, length);
+        return buf;
+    }
 
+    memcpy(buf->data, table->data, sizeof(lpfloat_t) * length);
+    LPBuffer.destroy(table);
+    return buf;
+}
 
-    stacklength = 0;
+/* Read the name and length (or user buffer, when the 
+ * name is user) of each table in a stack from vl. 
+ * Returns the stack length. */
+static size_t stack_read_args(int user, int numtables, int * names, size_t * tablesizes, lpbuffer_t ** userbufs, va_list vl) {
+    size_t stacklength = 0;
+    int i;
 
-    // first pass get all sizes
     for(i=0; i < numtables; i++) {
-        tables[i] = va_arg(vl, int);
-        if(tables[i] == WT_USER) {
-            user_bufp = va_arg(vl, lpbuffer_t *);
-            bufs[i] = LPBuffer.create(user_bufp->length, user_bufp->channels, user_bufp->samplerate);
-            LPBuffer.copy(user_bufp, bufs[i]);
+        names[i] = va_arg(vl, int);
+        userbufs[i] = NULL;
+        if(names[i] == user) {
+            userbufs[i] = va_arg(vl, lpbuffer_t *);
+            tablesizes[i] = userbufs[i]->length;
         } else {
-            tablesize = va_arg(vl, int);
-            stacklength += tablesize;
-            tablesizes[i] = tablesize;
+            tablesizes[i] = (size_t)va_arg(vl, int);
         }
+        stacklength += tablesizes[i];
     }
 
+    return stacklength;
+}
+
+lpbuffer_t * lpbuffer_create_stack(lpbuffer_t * (*table_creator)(int name, size_t length), int numtables, size_t * onsets, size_t * lengths, va_list vl) {
+    lpbuffer_t * stack, * buf;
+    lpbuffer_t ** userbufs;
+    size_t * tablesizes;
+    size_t stacklength, pos, j;
+    int * names;
+    int i;
+
+    userbufs = (lpbuffer_t **)LPMemoryPool.alloc(numtables, sizeof(lpbuffer_t *));
+    tablesizes = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
+    names = (int *)LPMemoryPool.alloc(numtables, sizeof(int));
+    if(userbufs == NULL || tablesizes == NULL || names == NULL) {
+        stack = NULL;
+        goto done;
+    }
+
+    stacklength = stack_read_args(WT_USER, numtables, names, tablesizes, userbufs, vl);
+
     stack = LPBuffer.create(stacklength, 1, DEFAULT_SAMPLERATE);
-    if(stack == NULL) return NULL;
+    if(stack == NULL) goto done;
 
     pos = 0;
     for(i=0; i < numtables; i++) {
-        if(tables[i] != WT_USER) {
-            bufs[i] = table_creator(tables[i], tablesizes[i]); 
-        }
-
-        for(j=0; j < bufs[i]->length; j++) {
-            stack->data[j + pos] = bufs[i]->data[j];
+        if(userbufs[i] != NULL) {
+            /* The first channel of a user table */
+            for(j=0; j < tablesizes[i]; j++) {
+                stack->data[j + pos] = userbufs[i]->data[j * userbufs[i]->channels];
+            }
+        } else {
+            if((buf = table_creator(names[i], tablesizes[i])) != NULL) {
+                memcpy(stack->data + pos, buf->data, sizeof(lpfloat_t) * tablesizes[i]);
+                LPBuffer.destroy(buf);
+            }
         }
 
         onsets[i] = pos;
         lengths[i] = tablesizes[i];
-
-        pos += bufs[i]->length;
-
-        LPMemoryPool.free(bufs[i]);
+        pos += tablesizes[i];
     }
 
-    LPMemoryPool.free(tables);
+done:
+    LPMemoryPool.free(names);
     LPMemoryPool.free(tablesizes);
-    LPMemoryPool.free(bufs);
+    LPMemoryPool.free(userbufs);
 
     return stack;
 }
@@ -1759,8 +3084,8 @@ lpbuffer_t * create_wavetable_stack(int numtables, size_t * onsets, size_t * len
     lpbuffer_t * stack;
     va_list vl;
     va_start(vl, lengths);
-    va_end(vl);
     stack = lpbuffer_create_stack(create_wavetable, numtables, onsets, lengths, vl);
+    va_end(vl);
     return stack;
 }
 
@@ -1808,28 +3133,28 @@ void window_tri(lpfloat_t* out, int length) {
 void window_cosine(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = (lpfloat_t)cos((i/(lpfloat_t)length) * (lpfloat_t)PI);         
+        out[i] = lpfastcos((i/(lpfloat_t)length) * 0.5f);
     }
 }
 
 void window_sine(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = (lpfloat_t)sin((i/(lpfloat_t)length) * (lpfloat_t)PI);         
+        out[i] = lpfastsin((i/(lpfloat_t)length) * 0.5f);
     }
 }
 
 void window_sinein(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = (lpfloat_t)sin((i/(lpfloat_t)length) * (lpfloat_t)HALFPI);         
+        out[i] = lpfastsin((i/(lpfloat_t)length) * 0.25f);
     }
 }
 
 void window_sineout(lpfloat_t* out, int length) {
     int i;
     for(i=0; i < length; i++) {
-        out[i] = (lpfloat_t)sin(((i/(lpfloat_t)length) * (lpfloat_t)HALFPI) + (lpfloat_t)HALFPI);
+        out[i] = lpfastcos((i/(lpfloat_t)length) * 0.25f);
     }
 }
 
@@ -1837,36 +3162,52 @@ void window_hanning(lpfloat_t* out, int length) {
     int i;
     assert(length > 1);
     for(i=0; i < length; i++) {
-        out[i] = 0.5f - 0.5f * (lpfloat_t)cos(2.0f * (lpfloat_t)PI * i / (length-1.0f));
+        out[i] = 0.5f - 0.5f * lpfastcos((lpfloat_t)i / (length-1.0f));
     }
 }
 
-/* create a window (0 to 1) */
-lpbuffer_t * create_window(int name, size_t length) {
-    lpbuffer_t* buf = LPBuffer.create(length, 1, DEFAULT_SAMPLERATE);
+/* Fill out with the named window: sine for anything 
+ * without a generator */
+static void fill_window(int name, lpfloat_t * out, size_t length) {
     if(name == WIN_SINE) {
-        window_sine(buf->data, length);            
+        window_sine(out, length);            
     } else if (name == WIN_SINEIN) {
-        window_sinein(buf->data, length);            
+        window_sinein(out, length);            
     } else if (name == WIN_SINEOUT) {
-        window_sineout(buf->data, length);            
+        window_sineout(out, length);            
     } else if (name == WIN_COS) {
-        window_cosine(buf->data, length);            
+        window_cosine(out, length);            
     } else if (name == WIN_TRI) {
-        window_tri(buf->data, length);            
+        window_tri(out, length);            
     } else if (name == WIN_PHASOR) {
-        window_phasor(buf->data, length);            
+        window_phasor(out, length);            
     } else if (name == WIN_HANN) {
-        window_hanning(buf->data, length);            
+        window_hanning(out, length);            
     } else if (name == WIN_SAW) {
-        window_phasor(buf->data, length);            
+        window_phasor(out, length);            
     } else if (name == WIN_RSAW) {
-        window_rsaw(buf->data, length);            
-    } else if (name == WIN_RND) {
-        return create_window(rand_choice(NUM_WINDOWS), length);
+        window_rsaw(out, length);            
     } else {
-        window_sine(buf->data, length);            
+        window_sine(out, length);            
+    }
+}
+
+/* create a window (0 to 1): a private copy of the 
+ * one in the table cache, or a fresh one for lengths 
+ * the cache doesn't keep */
+lpbuffer_t * create_window(int name, size_t length) {
+    lpbuffer_t * buf, * table;
+
+    if((buf = LPBuffer.create(length, 1, DEFAULT_SAMPLERATE)) == NULL) return NULL;
+
+    if(!tablecache_cacheable(length) || (table = tablecache_get(LPTABLE_WINDOW, name, length)) == NULL) {
+        while(name == WIN_RND) name = rand_choice(NUM_WINDOWS);
+        fill_window(name, buf->data, length);
+        return buf;
     }
+
+    memcpy(buf->data, table->data, sizeof(lpfloat_t) * length);
+    LPBuffer.destroy(table);
     return buf;
 }
 
@@ -1874,6 +3215,453 @@ void destroy_window(lpbuffer_t* buf) {
     LPBuffer.destroy(buf);
 }
 
+/* Table cache
+ *
+ * Every generated table lives here once per process, keyed 
+ * by its kind, name and length -- or for a stack, the names 
+ * and lengths of all its tables. Cached tables are shared 
+ * and read only: a lookup takes a reference that is given 
+ * back with LPBuffer.destroy, and the cache keeps its own 
+ * until flush finds nobody else holding the table, or it 
+ * is the least recently used such table once there are 
+ * more than LPTABLECACHE_MAXENTRIES. LPWavetable and 
+ * LPWindow only go through the cache for power of two 
+ * lengths up to LPTABLECACHE_MAXLENGTH.
+ *
+ * After LPTableCache.share(prefix), new tables are built in 
+ * named shared memory instead. The first process to ask for 
+ * a table creates and fills the segment, and every other 
+ * process sharing the prefix maps that one read only copy. 
+ * Segments outlive the processes, so the next run maps them 
+ * too; the name carries LPTABLECACHE_VERSION and the float 
+ * width so a changed generator or precision never picks up 
+ * a stale table. If a segment can't be used the table is 
+ * built privately instead. */
+typedef struct tablecache_segment_t {
+    uint64_t hash;
+    size_t length;
+    int ready;
+    char key[LPTABLECACHE_KEYSIZE];
+} tablecache_segment_t;
+
+/* Table data starts on a cache line past the header */
+#define TABLECACHE_HEADERSIZE ((sizeof(tablecache_segment_t) + 63) & ~(size_t)63)
+
+/* A table still being built has a NULL table: lookups
+ * for it wait on tablecache_built instead of building it
+ * again, and the lock is never held while generating. */
+typedef struct tablecache_entry_t {
+    uint64_t hash;
+    uint64_t lastuse;
+    char key[LPTABLECACHE_KEYSIZE];
+    lpbuffer_t * table;
+    void * segment;
+    size_t segmentsize;
+    struct tablecache_entry_t * next;
+} tablecache_entry_t;
+
+static tablecache_entry_t * tablecache_buckets[LPTABLECACHE_BUCKETS] = {0};
+static size_t tablecache_numentries = 0;
+static uint64_t tablecache_clock = 0;
+static char tablecache_prefix[LPTABLECACHE_PREFIXSIZE] = {0};
+static pthread_mutex_t tablecache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tablecache_built = PTHREAD_COND_INITIALIZER;
+
+/* FNV-1a */
+static uint64_t tablecache_hash(const char * key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    while(*key) {
+        hash ^= (unsigned char)*key++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* The sizes oscillators and stacks use: anything else 
+ * is usually sized to some buffer, and would only fill 
+ * the cache with tables nobody asks for again */
+static int tablecache_cacheable(size_t length) {
+    return length > 0 && length <= LPTABLECACHE_MAXLENGTH && (length & (length - 1)) == 0;
+}
+
+static void tablecache_fill(int kind, int numtables, const int * names, const size_t * tablesizes, lpfloat_t * out) {
+    int i;
+    for(i=0; i < numtables; i++) {
+        if(kind == LPTABLE_WINDOW) {
+            fill_window(names[i], out, tablesizes[i]);
+        } else {
+            fill_wavetable(names[i], out, tablesizes[i]);
+        }
+        out += tablesizes[i];
+    }
+}
+
+static void tablecache_sleep(void) {
+    struct timespec ts = { 0, 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+/* Map (creating and filling if it isn't there yet) the 
+ * shared segment for key. Returns the table data, or NULL 
+ * to build the table privately. */
+static lpfloat_t * tablecache_map(const char * prefix, const char * key, uint64_t hash, size_t length, int kind, int numtables, const int * names, const size_t * tablesizes, void ** segment, size_t * segmentsize) {
+    char name[LPTABLECACHE_KEYSIZE];
+    tablecache_segment_t * header;
+    struct stat st;
+    lpfloat_t * data;
+    size_t size;
+    int fd, created, waited;
+
+    size = TABLECACHE_HEADERSIZE + sizeof(lpfloat_t) * length;
+    snprintf(name, sizeof(name), "/%s-v%d-%d-%016llx", prefix, LPTABLECACHE_VERSION, (int)(sizeof(lpfloat_t) * 8), (unsigned long long)hash);
+
+    created = 1;
+    if((fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0660)) < 0) {
+        created = 0;
+        if(errno != EEXIST || (fd = shm_open(name, O_RDONLY, 0660)) < 0) {
+            fprintf(stderr, "LPTableCache: could not open %s (%d) %s\n", name, errno, strerror(errno));
+            return NULL;
+        }
+    }
+
+    if(created) {
+        if(ftruncate(fd, size) < 0) {
+            fprintf(stderr, "LPTableCache: could not size %s (%d) %s\n", name, errno, strerror(errno));
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+    } else {
+        /* The process creating it may not have sized it yet */
+        for(waited=0; fstat(fd, &st) == 0 && st.st_size == 0 && waited < LPTABLECACHE_WAIT; waited++) tablecache_sleep();
+        if(fstat(fd, &st) < 0 || (size_t)st.st_size != size) {
+            close(fd);
+            return NULL;
+        }
+    }
+
+    header = (tablecache_segment_t *)mmap(NULL, size, created ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(header == MAP_FAILED) {
+        fprintf(stderr, "LPTableCache: could not map %s (%d) %s\n", name, errno, strerror(errno));
+        return NULL;
+    }
+
+    data = (lpfloat_t *)((char *)header + TABLECACHE_HEADERSIZE);
+
+    if(created) {
+        header->hash = hash;
+        header->length = length;
+        snprintf(header->key, sizeof(header->key), "%s", key);
+        tablecache_fill(kind, numtables, names, tablesizes, data);
+        __atomic_store_n(&header->ready, 1, __ATOMIC_RELEASE);
+        mprotect(header, size, PROT_READ);
+    } else {
+        for(waited=0; !__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) && waited < LPTABLECACHE_WAIT; waited++) tablecache_sleep();
+        if(!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) || header->length != length || strcmp(header->key, key) != 0) {
+            munmap(header, size);
+            return NULL;
+        }
+    }
+
+    *segment = (void *)header;
+    *segmentsize = size;
+    return data;
+}
+
+static tablecache_entry_t ** tablecache_find(uint64_t hash, const char * key) {
+    tablecache_entry_t ** link;
+
+    for(link=&tablecache_buckets[hash & (LPTABLECACHE_BUCKETS-1)]; *link != NULL; link=&(*link)->next) {
+        if((*link)->hash == hash && strcmp((*link)->key, key) == 0) break;
+    }
+
+    return link;
+}
+
+/* Give back the cache's reference to a built table */
+static void tablecache_release_entry(tablecache_entry_t * entry) {
+    if(entry->segment != NULL) {
+        munmap(entry->segment, entry->segmentsize);
+        LPMemoryPool.free(entry->table);
+    } else {
+        LPBuffer.destroy(entry->table);
+    }
+    LPMemoryPool.free(entry);
+}
+
+/* Unlink the least recently used table nobody else 
+ * holds. Returns it, or NULL if every table is in use. 
+ * Called with the lock held. */
+static tablecache_entry_t * tablecache_evict(void) {
+    tablecache_entry_t ** link, ** oldest;
+    tablecache_entry_t * entry;
+    int b;
+
+    oldest = NULL;
+    for(b=0; b < LPTABLECACHE_BUCKETS; b++) {
+        for(link=&tablecache_buckets[b]; *link != NULL; link=&(*link)->next) {
+            if((*link)->table == NULL || __atomic_load_n(&(*link)->table->refcount, __ATOMIC_ACQUIRE) > 1) continue;
+            if(oldest == NULL || (*link)->lastuse < (*oldest)->lastuse) oldest = link;
+        }
+    }
+
+    if(oldest == NULL) return NULL;
+
+    entry = *oldest;
+    *oldest = entry->next;
+    tablecache_numentries -= 1;
+    return entry;
+}
+
+/* Look up the table described by key, building it if 
+ * it isn't cached yet, and take a reference to it */
+static lpbuffer_t * tablecache_lookup(const char * key, int kind, int numtables, const int * names, const size_t * tablesizes, size_t length) {
+    char prefix[LPTABLECACHE_PREFIXSIZE];
+    tablecache_entry_t ** link, * entry, * evicted;
+    lpbuffer_t * table;
+    lpfloat_t * data;
+    void * segment;
+    size_t segmentsize;
+    uint64_t hash;
+
+    hash = tablecache_hash(key);
+
+    pthread_mutex_lock(&tablecache_lock);
+    while(*(link = tablecache_find(hash, key)) != NULL && (*link)->table == NULL) {
+        pthread_cond_wait(&tablecache_built, &tablecache_lock);
+    }
+
+    if((entry = *link) != NULL) {
+        table = entry->table;
+        buffer_retain(table);
+        entry->lastuse = ++tablecache_clock;
+        pthread_mutex_unlock(&tablecache_lock);
+        return table;
+    }
+
+    /* Claim the key, then build the table unlocked */
+    if((entry = (tablecache_entry_t *)LPMemoryPool.alloc(1, sizeof(tablecache_entry_t))) == NULL) {
+        pthread_mutex_unlock(&tablecache_lock);
+        return NULL;
+    }
+    entry->hash = hash;
+    snprintf(entry->key, sizeof(entry->key), "%s", key);
+    *link = entry;
+    tablecache_numentries += 1;
+
+    evicted = NULL;
+    if(tablecache_numentries > LPTABLECACHE_MAXENTRIES) evicted = tablecache_evict();
+
+    snprintf(prefix, sizeof(prefix), "%s", tablecache_prefix);
+    pthread_mutex_unlock(&tablecache_lock);
+
+    if(evicted != NULL) tablecache_release_entry(evicted);
+
+    segment = NULL;
+    segmentsize = 0;
+    data = NULL;
+    if(prefix[0] != '\0') {
+        data = tablecache_map(prefix, key, hash, length, kind, numtables, names, tablesizes, &segment, &segmentsize);
+    }
+
+    if(data != NULL) {
+        /* A buffer struct around the shared data */
+        if((table = (lpbuffer_t *)LPMemoryPool.alloc(1, sizeof(lpbuffer_t))) == NULL) {
+            munmap(segment, segmentsize);
+        } else {
+            table->data = data;
+            table->length = length;
+            table->channels = 1;
+            table->samplerate = DEFAULT_SAMPLERATE;
+            table->boundry = length-1;
+            table->range = length;
+            table->refcount = 1;
+        }
+    } else if((table = LPBuffer.create(length, 1, DEFAULT_SAMPLERATE)) != NULL) {
+        tablecache_fill(kind, numtables, names, tablesizes, table->data);
+    }
+
+    pthread_mutex_lock(&tablecache_lock);
+    if(table == NULL) {
+        /* Let anyone waiting on it try for themselves */
+        *tablecache_find(hash, key) = entry->next;
+        tablecache_numentries -= 1;
+        LPMemoryPool.free(entry);
+    } else {
+        entry->segment = segment;
+        entry->segmentsize = segmentsize;
+        entry->lastuse = ++tablecache_clock;
+        entry->table = table;
+
+        /* One reference for the cache, one for the caller */
+        buffer_retain(table);
+    }
+    pthread_cond_broadcast(&tablecache_built);
+    pthread_mutex_unlock(&tablecache_lock);
+
+    return table;
+}
+
+/* The cached table of the given kind, name and length. 
+ * A random name picks one of the others, and a name 
+ * with no generator gets the sine. */
+lpbuffer_t * tablecache_get(int kind, int name, size_t length) {
+    char key[LPTABLECACHE_KEYSIZE];
+
+    if(length == 0) return NULL;
+
+    if(kind == LPTABLE_WINDOW) {
+        while(name == WIN_RND) name = rand_choice(NUM_WINDOWS);
+        if(name < 0 || name >= NUM_WINDOWS) name = WIN_SINE;
+    } else {
+        while(name == WT_RND) name = rand_choice(NUM_WAVETABLES);
+        if(name < 0 || name >= NUM_WAVETABLES) name = WT_SINE;
+    }
+
+    snprintf(key, sizeof(key), "%s:%d:%zu", (kind == LPTABLE_WINDOW) ? "win" : "wt", name, length);
+    return tablecache_lookup(key, kind, 1, &name, &length, length);
+}
+
+/* A cached stack of tables read from vl the same way as 
+ * lpbuffer_create_stack. Stacks with user tables in them 
+ * can't be shared, so they are built privately. */
+lpbuffer_t * lptablecache_stack(int kind, int numtables, size_t * onsets, size_t * lengths, va_list vl) {
+    char key[LPTABLECACHE_KEYSIZE];
+    lpbuffer_t * stack, * table;
+    lpbuffer_t ** userbufs;
+    size_t * tablesizes;
+    size_t stacklength, pos, j;
+    int * names;
+    int i, keylength, private;
+
+    userbufs = (lpbuffer_t **)LPMemoryPool.alloc(numtables, sizeof(lpbuffer_t *));
+    tablesizes = (size_t *)LPMemoryPool.alloc(numtables, sizeof(size_t));
+    names = (int *)LPMemoryPool.alloc(numtables, sizeof(int));
+    if(userbufs == NULL || tablesizes == NULL || names == NULL) {
+        stack = NULL;
+        goto done;
+    }
+
+    stacklength = stack_read_args((kind == LPTABLE_WINDOW) ? WIN_USER : WT_USER, numtables, names, tablesizes, userbufs, vl);
+
+    /* Resolve random picks first so the key names real tables */
+    private = 0;
+    keylength = snprintf(key, sizeof(key), "%sstack", (kind == LPTABLE_WINDOW) ? "win" : "wt");
+    for(i=0; i < numtables; i++) {
+        if(userbufs[i] != NULL) {
+            private = 1;
+            continue;
+        }
+        if(kind == LPTABLE_WINDOW) {
+            while(names[i] == WIN_RND) names[i] = rand_choice(NUM_WINDOWS);
+        } else {
+            while(names[i] == WT_RND) names[i] = rand_choice(NUM_WAVETABLES);
+        }
+        if(keylength < (int)sizeof(key)) {
+            keylength += snprintf(key + keylength, sizeof(key) - keylength, ":%d:%zu", names[i], tablesizes[i]);
+        }
+    }
+
+    /* Too many tables to name in a key */
+    if(keylength >= (int)sizeof(key)) private = 1;
+
+    pos = 0;
+    for(i=0; i < numtables; i++) {
+        onsets[i] = pos;
+        lengths[i] = tablesizes[i];
+        pos += tablesizes[i];
+    }
+
+    if(!private && stacklength > 0) {
+        stack = tablecache_lookup(key, kind, numtables, names, tablesizes, stacklength);
+    } else {
+        stack = LPBuffer.create(stacklength, 1, DEFAULT_SAMPLERATE);
+        for(i=0; stack != NULL && i < numtables; i++) {
+            if(userbufs[i] != NULL) {
+                for(j=0; j < tablesizes[i]; j++) {
+                    stack->data[onsets[i] + j] = userbufs[i]->data[j * userbufs[i]->channels];
+                }
+            } else if(tablecache_cacheable(tablesizes[i]) && (table = tablecache_get(kind, names[i], tablesizes[i])) != NULL) {
+                memcpy(stack->data + onsets[i], table->data, sizeof(lpfloat_t) * tablesizes[i]);
+                LPBuffer.destroy(table);
+            } else {
+                tablecache_fill(kind, 1, &names[i], &tablesizes[i], stack->data + onsets[i]);
+            }
+        }
+    }
+
+done:
+    LPMemoryPool.free(names);
+    LPMemoryPool.free(tablesizes);
+    LPMemoryPool.free(userbufs);
+
+    return stack;
+}
+
+lpbuffer_t * tablecache_get_stack(int kind, int numtables, size_t * onsets, size_t * lengths, ...) {
+    lpbuffer_t * stack;
+    va_list vl;
+    va_start(vl, lengths);
+    stack = lptablecache_stack(kind, numtables, onsets, lengths, vl);
+    va_end(vl);
+    return stack;
+}
+
+/* Build new tables in shared memory named after prefix, 
+ * or privately again if prefix is NULL or empty. Tables 
+ * already in the cache stay where they are. */
+int tablecache_share(const char * prefix) {
+    if(prefix == NULL) prefix = "";
+
+    if(strlen(prefix) >= LPTABLECACHE_PREFIXSIZE || strchr(prefix, '/') != NULL) {
+        fprintf(stderr, "LPTableCache: bad shared memory prefix %s\n", prefix);
+        return -1;
+    }
+
+    pthread_mutex_lock(&tablecache_lock);
+    snprintf(tablecache_prefix, sizeof(tablecache_prefix), "%s", prefix);
+    pthread_mutex_unlock(&tablecache_lock);
+
+    return 0;
+}
+
+size_t tablecache_count(void) {
+    size_t count;
+    pthread_mutex_lock(&tablecache_lock);
+    count = tablecache_numentries;
+    pthread_mutex_unlock(&tablecache_lock);
+    return count;
+}
+
+/* Drop the tables only the cache is holding on to */
+void tablecache_flush(void) {
+    tablecache_entry_t ** link, * entry, * dropped;
+    int b;
+
+    dropped = NULL;
+    pthread_mutex_lock(&tablecache_lock);
+    for(b=0; b < LPTABLECACHE_BUCKETS; b++) {
+        link = &tablecache_buckets[b];
+        while((entry = *link) != NULL) {
+            if(entry->table == NULL || __atomic_load_n(&entry->table->refcount, __ATOMIC_ACQUIRE) > 1) {
+                link = &entry->next;
+                continue;
+            }
+            *link = entry->next;
+            entry->next = dropped;
+            dropped = entry;
+            tablecache_numentries -= 1;
+        }
+    }
+    pthread_mutex_unlock(&tablecache_lock);
+
+    while((entry = dropped) != NULL) {
+        dropped = entry->next;
+        tablecache_release_entry(entry);
+    }
+}
+
 /* Utilities */
 
 /* The zapgremlins() routine was written by James McCartney as part of SuperCollider:
@@ -1941,3 +3729,55 @@ lpfloat_t lpfpow(lpfloat_t value, int exp) {
     }
     return result;
 }
+
+/* Fast sine
+ *
+ * The phase is wrapped to -0.5..0.5 cycles and the sine 
+ * is evaluated as x * (0.25 - x^2) * P(x^2), which keeps 
+ * the zero crossings at 0 and +/-0.5 cycles exact. 
+ * P is a degree 5 minimax fit: the max error against 
+ * libm is about 1.2e-9 (-178 dB) in double precision, 
+ * and float rounding dominates with LP_FLOAT.
+ *
+ * There are no branches or table lookups, so loops 
+ * over lpfastsin_block vectorize.
+ */
+static inline lpfloat_t fastsin_wrapped(lpfloat_t x) {
+    lpfloat_t u, p;
+
+    u = x * x;
+    p = (lpfloat_t)-3.19337181284834946480e+00;
+    p = p * u + (lpfloat_t)1.40655040434491027061e+01;
+    p = p * u + (lpfloat_t)-3.84984187949981762206e+01;
+    p = p * u + (lpfloat_t)6.70767586864165199015e+01;
+    p = p * u + (lpfloat_t)-6.48358225750955528277e+01;
+    p = p * u + (lpfloat_t)2.51327410800679996745e+01;
+
+    return x * ((lpfloat_t)0.25f - u) * p;
+}
+
+static inline lpfloat_t fastsin_wrap(lpfloat_t phase) {
+    lpfloat_t x;
+
+    /* Truncation rounds toward zero, so negative 
+     * phases can land one cycle low */
+    x = phase - (lpfloat_t)(int64_t)(phase + (lpfloat_t)0.5f);
+    if(x < (lpfloat_t)-0.5f) x += 1.f;
+
+    return x;
+}
+
+lpfloat_t lpfastsin(lpfloat_t phase) {
+    return fastsin_wrapped(fastsin_wrap(phase));
+}
+
+lpfloat_t lpfastcos(lpfloat_t phase) {
+    return fastsin_wrapped(fastsin_wrap(phase + (lpfloat_t)0.25f));
+}
+
+void lpfastsin_block(lpfloat_t * out, const lpfloat_t * phases, size_t n) {
+    size_t i;
+    for(i=0; i < n; i++) {
+        out[i] = fastsin_wrapped(fastsin_wrap(phases[i]));
+    }
+}
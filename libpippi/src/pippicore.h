@@ -8,6 +8,8 @@
 #include <limits.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -19,11 +21,28 @@
 #include <sys/random.h>
 #endif
 
+/* LP_FLOAT32 builds the single precision variant with 
+ * an _f32 suffix on every external symbol, so it can be 
+ * linked into the same program as the double precision 
+ * one. See scripts/build_library.sh. */
+#ifdef LP_FLOAT32
+#ifndef LP_FLOAT
+#define LP_FLOAT
+#endif
+#include "../generated/pippi_f32_symbols.h"
+#endif
+
 /* Core pippi types and constants */
 #include "pippiconstants.h"
 #include "pippitypes.h"
 
-/* ugen wrapper interface */
+/* ugen wrapper interface 
+ *
+ * process_block is optional: it renders nframes of every 
+ * output into outputs[port]. inputs[index] is NULL, or a 
+ * block of values to take that input from frame by frame. 
+ * Ugens without one are run a frame at a time through 
+ * set_param, process and get_output. */
 typedef struct ugen_t ugen_t;
 struct ugen_t {
     void * params;
@@ -31,6 +50,10 @@ struct ugen_t {
     void (*set_param)(ugen_t * u, int index, void * value);
     void (*process)(ugen_t * u);
     void (*destroy)(ugen_t * u);
+
+    int num_inputs;
+    int num_outputs;
+    void (*process_block)(ugen_t * u, lpfloat_t ** inputs, lpfloat_t ** outputs, size_t nframes);
 };
 
 /* Users may create custom memorypools. 
@@ -39,13 +62,53 @@ struct ugen_t {
  *
  * Otherwise initializtion of the pool 
  * will use the stdlib to calloc the space.
+ *
+ * A pool hands out blocks from its region in size 
+ * classes. Freed blocks go onto a free list for their 
+ * class and are reused before the pool grows, so a 
+ * program that keeps allocating the same kinds of 
+ * buffers settles into a fixed footprint.
+ *
+ * pos is the high water mark of the region: space 
+ * below it has been carved into blocks at some point.
  */
+typedef struct lpmemorypool_stats_t {
+    size_t live;        /* bytes in blocks currently allocated */
+    size_t highwater;   /* peak of live */
+    size_t allocs;
+    size_t frees;
+    size_t failed;      /* allocs that didn't fit */
+} lpmemorypool_stats_t;
+
 typedef struct lpmemorypool_t {
     unsigned char * pool;
     size_t poolsize;
     size_t pos;
+
+    void * freelists[LPMEMORYPOOL_NUMCLASSES];
+    atomic_flag lock;
+    size_t generation;
+    lpmemorypool_stats_t stats;
 } lpmemorypool_t;
 
+/* Generator state for xoshiro256**. Every thread has
+ * its own behind LPRand.rand, seeded from LPRand.seed
+ * and jumped ahead by the order threads first use it,
+ * and more can be made with LPRand.create for streams
+ * which should repeat no matter who else draws from 
+ * the default one.
+ *
+ * The bulk fills run LPRAND_LANES more generators side 
+ * by side, which are seeded from s the first time one 
+ * is called after a seed or jump. */
+typedef struct lprng_t {
+    uint64_t s[4];
+    uint64_t lanes[4][LPRAND_LANES];
+    int lanesready;
+    int hasspare;
+    lpfloat_t spare;
+} lprng_t;
+
 /* Factories & static interfaces */
 typedef struct lprand_t {
     lpfloat_t logistic_seed;
@@ -75,8 +138,59 @@ typedef struct lprand_t {
     int (*randint)(int, int);
     int (*randbool)(void);
     int (*choice)(int);
+
+    /* Generator state. Anything taking an lprng_t 
+     * pointer uses the thread default when given NULL. */
+    lpfloat_t (*xoshiro)(lpfloat_t, lpfloat_t);
+    lprng_t * (*create)(uint64_t seed);
+    lprng_t * (*thread_default)(void);
+    void (*seed_state)(lprng_t *, uint64_t seed);
+    void (*jump)(lprng_t *);
+    lprng_t * (*split)(lprng_t *);
+    uint64_t (*next)(lprng_t *);
+    lpfloat_t (*uniform)(lprng_t *, lpfloat_t low, lpfloat_t high);
+    lpfloat_t (*gaussian)(lprng_t *, lpfloat_t mean, lpfloat_t stddev);
+    void (*fill_uniform)(lprng_t *, lpfloat_t * out, size_t n, lpfloat_t low, lpfloat_t high);
+    void (*fill_gaussian)(lprng_t *, lpfloat_t * out, size_t n, lpfloat_t mean, lpfloat_t stddev);
+    void (*fill_choice)(lprng_t *, int * out, size_t n, int numchoices);
+    void (*destroy)(lprng_t *);
 } lprand_t;
 
+/* The arithmetic kernels behind the buffer ops. 
+ * All of them work on flat runs of n samples: 
+ * the buffer ops sort out the channel layout and 
+ * hand over contiguous spans.
+ *
+ * LPKernels starts out pointing at the scalar 
+ * reference implementations and is switched to 
+ * the widest vector implementation the CPU supports 
+ * when the library is loaded. Set LPKERNELS=scalar 
+ * (or sse2, avx2, avx512, neon) in the environment 
+ * to force a specific implementation, or call 
+ * LPKernels.select() at runtime.
+ */
+typedef struct lpkernels_t {
+    const char * name;
+
+    /* a[i] op= b[i] */
+    void (*add)(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+    void (*subtract)(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+    void (*multiply)(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+    void (*divide)(lpfloat_t * restrict a, const lpfloat_t * restrict b, size_t n);
+
+    /* a[i] op= b */
+    void (*add_scalar)(lpfloat_t * a, lpfloat_t b, size_t n);
+    void (*subtract_scalar)(lpfloat_t * a, lpfloat_t b, size_t n);
+    void (*multiply_scalar)(lpfloat_t * a, lpfloat_t b, size_t n);
+    void (*divide_scalar)(lpfloat_t * a, lpfloat_t b, size_t n);
+
+    void (*scale)(lpfloat_t * a, size_t n, lpfloat_t from_min, lpfloat_t from_diff, lpfloat_t to_diff, lpfloat_t to_min);
+    void (*clip)(lpfloat_t * a, size_t n, lpfloat_t minval, lpfloat_t maxval);
+    lpfloat_t (*mag)(const lpfloat_t * a, size_t n);
+
+    int (*select)(const char * name);
+} lpkernels_t;
+
 typedef struct lparray_factory_t {
     lparray_t * (*create)(size_t);
     lparray_t * (*create_from)(int, ...);
@@ -94,6 +208,7 @@ typedef struct lpbuffer_factory_t {
     lpfloat_t (*min)(lpbuffer_t * buf);
     lpfloat_t (*max)(lpbuffer_t * buf);
     lpfloat_t (*mag)(lpbuffer_t * buf);
+    lpsamples_t (*samples)(lpbuffer_t * buf, int channel);
     lpfloat_t (*play)(lpbuffer_t *, lpfloat_t);
     void (*pan)(lpbuffer_t * buf, lpbuffer_t * pos, int method);
     lpbuffer_t * (*mix)(lpbuffer_t *, lpbuffer_t *);
@@ -128,6 +243,44 @@ typedef struct lpbuffer_factory_t {
     void (*destroy)(lpbuffer_t *);
 } lpbuffer_factory_t;
 
+/* Views read another buffer's frames in place, so 
+ * cutting, reversing, padding or picking a channel 
+ * out of a buffer doesn't allocate frames or copy. 
+ * Views can be taken of views, and each one holds 
+ * a reference to the buffer underneath: it stays 
+ * alive until the owner has called LPBuffer.destroy 
+ * and every view of it has been destroyed.
+ *
+ * Views are read only. Write through dub(), which 
+ * mixes a view into a buffer (through an optional 
+ * envelope) in one pass, or copy with materialize().
+ * samples() hands out one channel the same way as 
+ * LPBuffer.samples, for read only code like 
+ * LPFX.read_skewed_samples that takes either.
+ *
+ *     grain = LPBufferView.cut(src, start, length);
+ *     LPBufferView.dub(out, grain, window, pos);
+ *     LPBufferView.destroy(grain);
+ *
+ * Mapped sample library buffers must outlive their 
+ * views: LPSampleLib.close doesn't wait for them.
+ */
+typedef struct lpbufferview_factory_t {
+    lpbufferview_t * (*create)(lpbuffer_t * buf);
+    lpbufferview_t * (*cut)(lpbufferview_t * view, size_t start, size_t length);
+    lpbufferview_t * (*reverse)(lpbufferview_t * view);
+    lpbufferview_t * (*channel)(lpbufferview_t * view, int channel);
+    lpbufferview_t * (*pad)(lpbufferview_t * view, size_t before, size_t after);
+    lpfloat_t (*read)(lpbufferview_t * view, size_t frame, int channel);
+    lpsamples_t (*samples)(lpbufferview_t * view, int channel);
+    lpfloat_t (*min)(lpbufferview_t * view);
+    lpfloat_t (*max)(lpbufferview_t * view);
+    lpfloat_t (*mag)(lpbufferview_t * view);
+    void (*dub)(lpbuffer_t * out, lpbufferview_t * view, lpbuffer_t * env, size_t start);
+    lpbuffer_t * (*materialize)(lpbufferview_t * view);
+    void (*destroy)(lpbufferview_t * view);
+} lpbufferview_factory_t;
+
 typedef struct lpringbuffer_factory_t {
     lpbuffer_t * (*create)(size_t, int, int);
     void (*fill)(lpbuffer_t *, lpbuffer_t *, int);
@@ -139,24 +292,62 @@ typedef struct lpringbuffer_factory_t {
     void (*writeone)(lpbuffer_t *, lpfloat_t);
     void (*dub)(lpbuffer_t *, lpbuffer_t *);
     void (*destroy)(lpbuffer_t *);
+    void (*tap)(lpbuffer_t *, lpfloat_t delay, lpfloat_t * frame);
+    void (*tapinto)(lpbuffer_t *, const lpfloat_t * delays, lpfloat_t * out, size_t nframes);
 } lpringbuffer_factory_t;
 
+typedef struct lpspscring_factory_t {
+    lpspscring_t * (*create)(size_t, int, int);
+    size_t (*write)(lpspscring_t *, const lpfloat_t *, size_t);
+    size_t (*read)(lpspscring_t *, lpfloat_t *, size_t);
+    size_t (*readable)(lpspscring_t *);
+    size_t (*writable)(lpspscring_t *);
+    void (*destroy)(lpspscring_t *);
+} lpspscring_factory_t;
+
 typedef struct lpparam_factory_t {
     lpbuffer_t * (*from_float)(lpfloat_t);
     lpbuffer_t * (*from_int)(int);
+    lpfloat_t * (*fill_block)(lpbuffer_t *, lpfloat_t *, size_t, size_t, size_t);
 } lpparam_factory_t;
 
+/* LPMemoryPool.alloc uses the primary pool once init() 
+ * has given it a region, and calloc until then (or 
+ * fails an assert in LP_STATIC builds). Either way 
+ * blocks are zeroed, must be released with 
+ * LPMemoryPool.free, and NULL is returned (and 
+ * counted) when the pool is exhausted, so callers 
+ * must check the result.
+ *
+ * Scopes route every LPMemoryPool.alloc made on the 
+ * calling thread into a custom pool used as an arena:
+ *
+ *     mark = LPMemoryPool.scope_begin(arena);
+ *     ...render, creating temporary buffers...
+ *     LPMemoryPool.scope_end(arena, mark);
+ *
+ * scope_end drops everything allocated in the arena 
+ * since the mark in one step, so temporaries don't 
+ * need to be freed one by one. Nothing allocated in 
+ * the scope may be used after it ends.
+ *
+ * Threads that free into the primary pool should call 
+ * thread_release() before they exit to hand their 
+ * cached blocks back.
+ */
 typedef struct lpmemorypool_factory_t {
-    /* This is the primary memorypool. */
-    unsigned char * pool;
-    size_t poolsize;
-    size_t pos;
-
     void (*init)(unsigned char *, size_t);
     lpmemorypool_t * (*custom_init)(unsigned char *, size_t);
     void * (*alloc)(size_t, size_t);
     void * (*custom_alloc)(lpmemorypool_t *, size_t, size_t);
     void (*free)(void *);
+
+    size_t (*mark)(lpmemorypool_t *);
+    void (*reset)(lpmemorypool_t *, size_t);
+    size_t (*scope_begin)(lpmemorypool_t *);
+    void (*scope_end)(lpmemorypool_t *, size_t);
+    void (*thread_release)(void);
+    lpmemorypool_stats_t (*stats)(lpmemorypool_t *);
 } lpmemorypool_factory_t;
 
 typedef struct lpinterpolation_factory_t {
@@ -180,8 +371,20 @@ typedef struct lpwindow_factory_t {
     void (*destroy)(lpbuffer_t*);
 } lpwindow_factory_t;
 
+/* Shared, read only generated tables: see the table 
+ * cache notes in pippicore.c. Give tables back with 
+ * LPBuffer.destroy. */
+typedef struct lptablecache_factory_t {
+    lpbuffer_t * (*get)(int kind, int name, size_t length);
+    lpbuffer_t * (*get_stack)(int kind, int numtables, size_t * onsets, size_t * lengths, ...);
+    int (*share)(const char * prefix);
+    size_t (*count)(void);
+    void (*flush)(void);
+} lptablecache_factory_t;
+
 typedef struct lpfx_factory_t {
     lpfloat_t (*read_skewed_buffer)(lpfloat_t freq, lpbuffer_t * buf, lpfloat_t phase, lpfloat_t skew);
+    lpfloat_t (*read_skewed_samples)(lpfloat_t freq, lpsamples_t samples, lpfloat_t phase, lpfloat_t skew);
     lpfloat_t (*lpf1)(lpfloat_t x, lpfloat_t * y, lpfloat_t cutoff, lpfloat_t samplerate);
     void (*convolve)(lpbuffer_t * a, lpbuffer_t * b, lpbuffer_t * out);
     void (*norm)(lpbuffer_t * buf, lpfloat_t ceiling);
@@ -191,13 +394,17 @@ typedef struct lpfx_factory_t {
 /* Interfaces */
 extern const lparray_factory_t LPArray;
 extern const lpbuffer_factory_t LPBuffer;
+extern const lpbufferview_factory_t LPBufferView;
 extern const lpringbuffer_factory_t LPRingBuffer;
+extern const lpspscring_factory_t LPSPSCRing;
 
 extern const lpwavetable_factory_t LPWavetable;
 extern const lpwindow_factory_t LPWindow;
+extern const lptablecache_factory_t LPTableCache;
 extern const lpfx_factory_t LPFX;
 
 extern lprand_t LPRand;
+extern lpkernels_t LPKernels;
 extern const lpparam_factory_t LPParam;
 extern lpmemorypool_factory_t LPMemoryPool;
 extern const lpinterpolation_factory_t LPInterpolation;
@@ -230,9 +437,17 @@ lpfloat_t lpfmin(lpfloat_t a, lpfloat_t b);
 lpfloat_t lpfabs(lpfloat_t value);
 lpfloat_t lpfpow(lpfloat_t value, int exp);
 
+/* lpfastsin and lpfastcos take the phase in cycles rather 
+ * than radians: lpfastsin(p) ~= sin(2pi * p). Cheap enough 
+ * to replace libm sin() in per-sample loops. */
+lpfloat_t lpfastsin(lpfloat_t phase);
+lpfloat_t lpfastcos(lpfloat_t phase);
+void lpfastsin_block(lpfloat_t * out, const lpfloat_t * phases, size_t n);
+
 lpfloat_t lpphaseinc(lpfloat_t freq, lpfloat_t samplerate);
 
 lpbuffer_t * lpbuffer_create_stack(lpbuffer_t * (*table_creator)(int name, size_t length), int numtables, size_t * onsets, size_t * lengths, va_list vl);
+lpbuffer_t * lptablecache_stack(int kind, int numtables, size_t * onsets, size_t * lengths, va_list vl);
 
 void pan_stereo_constant(lpfloat_t pos, lpfloat_t left_in, lpfloat_t right_in, lpfloat_t * left_out, lpfloat_t * right_out);
 
@@ -19,11 +19,78 @@ typedef struct lpbuffer_t {
     size_t pos;
     size_t onset;
     int is_looping;
+
+    /* Owner plus views: zero is treated as one, 
+     * so buffers built by hand still work */
+    int refcount;
 } lpbuffer_t;
 
+/* A window onto another buffer's frames. Reading 
+ * frame i, channel c of the view reads 
+ *
+ *     data[(i - before) * framestride + c * channelstride]
+ *
+ * for the frames between before and before+frames, 
+ * and silence outside them. Strides are in samples 
+ * and framestride is negative when reversed. */
+typedef struct lpbufferview_t {
+    lpbuffer_t * buf;
+    lpfloat_t * data;
+    size_t length;
+    size_t before;
+    size_t frames;
+    ptrdiff_t framestride;
+    ptrdiff_t channelstride;
+    int channels;
+    int samplerate;
+} lpbufferview_t;
+
+/* The samples of one channel of a buffer or a view, 
+ * read in place: sample i is data[i * stride] for i 
+ * below length. A view's padding is left out, since 
+ * it is only silence. Read only code written against 
+ * this works for buffers and views alike. */
+typedef struct lpsamples_t {
+    const lpfloat_t * data;
+    size_t length;
+    ptrdiff_t stride;
+} lpsamples_t;
+
+/* A ring buffer for handing frames from one thread to 
+ * exactly one other, without locks. The positions count 
+ * frames written and read since creation and are masked 
+ * into the ring, so the whole capacity can be used. 
+ * Each is written by one side only: it publishes with a 
+ * release store and the other side loads it with an 
+ * acquire. They are padded onto their own cache lines 
+ * so the two threads don't fight over them. */
+typedef struct lpspscring_t {
+    lpfloat_t * data;
+    size_t capacity;
+    size_t mask;
+    int channels;
+    int samplerate;
+
+    char pad0[64];
+    size_t writepos;
+    char pad1[64 - sizeof(size_t)];
+    size_t readpos;
+    char pad2[64 - sizeof(size_t)];
+} lpspscring_t;
+
 // Used for messaging between astrid instruments,
 // but included in pippicore for embedded use and 
 // external messaging support.
+/* Per-voice output routing. Entry k sends buffer 
+ * channel (k % channels) to output channel channels[k] 
+ * scaled by gains[k]. An empty route (count == 0) maps 
+ * output channels onto buffer channels round-robin. */
+typedef struct lproute_t {
+    uint32_t count;
+    uint16_t channels[LPMAXROUTE];
+    float gains[LPMAXROUTE];
+} lproute_t;
+
 typedef struct lpmsg_t {
     /* Timestamp when the message was initiated. 
      *
@@ -82,6 +149,7 @@ typedef struct lpmsg_t {
 
     uint16_t flags;
     uint16_t type;
+    lproute_t route;
     char msg[LPMAXMSG];
     char instrument_name[LPMAXNAME];
 } lpmsg_t;
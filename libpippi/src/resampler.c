@@ -0,0 +1,428 @@
+#include "resampler.h"
+
+typedef lpfloat_t lpresampler_vec_t __attribute__((vector_size(LPRESAMPLER_LANES * sizeof(lpfloat_t))));
+
+lpresampler_t * create_resampler(lpfloat_t ratio, int channels, int quality);
+size_t process_resampler(lpresampler_t * rs, lpfloat_t * in, size_t * inframes, lpfloat_t * out, size_t outframes);
+void set_ratio_resampler(lpresampler_t * rs, lpfloat_t ratio);
+lpbuffer_t * resample_resampler(lpbuffer_t * buf, lpfloat_t ratio, int quality);
+lpbuffer_t * varispeed_resampler(lpbuffer_t * buf, lpbuffer_t * speed, int quality);
+lpbuffer_t * resample_parallel_resampler(lpbuffer_t * buf, lpfloat_t ratio, int quality, lpjobs_t * jobs);
+lpbuffer_t * varispeed_parallel_resampler(lpbuffer_t * buf, lpbuffer_t * speed, int quality, lpjobs_t * jobs);
+void destroy_resampler(lpresampler_t * rs);
+
+const lpresampler_factory_t LPResampler = { create_resampler, process_resampler, set_ratio_resampler, resample_resampler, varispeed_resampler, resample_parallel_resampler, varispeed_parallel_resampler, destroy_resampler };
+
+/* Zero crossings, table points per zero crossing,
+ * kaiser beta and cutoff for each quality. The cutoff
+ * is placed so the transition band ends at nyquist. */
+static const struct {
+    int zerocrossings;
+    int resolution;
+    double beta;
+    double cutoff;
+} resampler_qualities[NUM_LPRESAMPLER_QUALITIES] = {
+    { 16, 128, 5.65, 0.86 },
+    { 32, 512, 8.6, 0.90 },
+    { 64, 2048, 12.26, 0.93 },
+};
+
+/* Larger polyphase banks than this use the table instead */
+#define LPRESAMPLER_MAXBANK (1 << 20)
+
+/* Zeroth order modified bessel function of the first kind */
+static double resampler_bessel_i0(double x) {
+    double sum = 1, term = 1, q = x * x / 4;
+    int k;
+
+    for(k=1; k < 64; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+        if(term < sum * 1e-17) break;
+    }
+
+    return sum;
+}
+
+/* The kaiser windowed sinc at x input frames from its center */
+static double resampler_kernel(lpresampler_t * rs, double x) {
+    double y, w;
+
+    x = fabs(x);
+    if(x >= rs->zerocrossings) return 0;
+
+    w = x / rs->zerocrossings;
+    w = resampler_bessel_i0(rs->beta * sqrt(1 - w * w)) / resampler_bessel_i0(rs->beta);
+
+    y = rs->cutoff * x;
+    if(y == 0) return rs->cutoff * w;
+    return rs->cutoff * sin(M_PI * y) / (M_PI * y) * w;
+}
+
+/* Returns L with ratio == L/M for the smallest L that
+ * works, or 0 if there isn't one */
+static int resampler_fraction(lpfloat_t ratio, int * step) {
+    long l, m;
+
+    for(l=1; l <= LPRESAMPLER_MAXPHASES; l++) {
+        m = lround(l / (double)ratio);
+        if(m < 1) continue;
+        if(fabs((double)l / m - ratio) <= ratio * 1e-7) {
+            *step = (int)m;
+            return (int)l;
+        }
+    }
+
+    return 0;
+}
+
+/* Sets up the filter length for ratio and, when
+ * withbank is set and the ratio is a small fraction,
+ * the polyphase bank. Any old bank is freed either way. */
+static void resampler_configure(lpresampler_t * rs, lpfloat_t ratio, int withbank) {
+    double frac;
+    int p, j, step, numphases;
+
+    if(ratio < LPRESAMPLER_MINRATIO) ratio = LPRESAMPLER_MINRATIO;
+
+    rs->ratio = ratio;
+    rs->scale = (ratio < 1) ? ratio : 1;
+    rs->half = (int)ceil(rs->zerocrossings / rs->scale);
+    rs->ntaps = 2 * rs->half;
+    rs->ntaps += (LPRESAMPLER_LANES - rs->ntaps % LPRESAMPLER_LANES) % LPRESAMPLER_LANES;
+    assert(rs->half <= rs->maxhalf);
+
+    if(rs->bank != NULL) {
+        LPMemoryPool.free(rs->bank);
+        rs->bank = NULL;
+    }
+
+    if(!withbank) return;
+
+    numphases = resampler_fraction(ratio, &step);
+    if(numphases == 0 || (size_t)numphases * rs->ntaps > LPRESAMPLER_MAXBANK) return;
+
+    /* Row p is the filter for output frames that fall
+     * p / numphases of the way between two input frames */
+    rs->bank = (lpfloat_t *)LPMemoryPool.alloc((size_t)numphases * rs->ntaps, sizeof(lpfloat_t));
+    for(p=0; p < numphases; p++) {
+        frac = (double)p / numphases;
+        for(j=0; j < rs->ntaps; j++) {
+            rs->bank[p * rs->ntaps + j] = (j < 2 * rs->half) ? rs->scale * resampler_kernel(rs, (frac + rs->half - 1 - j) * rs->scale) : 0;
+        }
+    }
+
+    rs->numphases = numphases;
+    rs->step = step;
+
+    /* Snap the read position onto the nearest phase */
+    p = (int)lround(rs->frac * numphases);
+    if(p == numphases) {
+        rs->base += 1;
+        p = 0;
+    }
+    rs->bankphase = p;
+    rs->frac = (double)p / numphases;
+}
+
+lpresampler_t * create_resampler(lpfloat_t ratio, int channels, int quality) {
+    lpresampler_t * rs;
+    size_t i, points;
+
+    if(quality < 0 || quality >= NUM_LPRESAMPLER_QUALITIES) quality = LPRESAMPLER_MEDIUM;
+
+    rs = (lpresampler_t *)LPMemoryPool.alloc(1, sizeof(lpresampler_t));
+    rs->channels = channels;
+    rs->quality = quality;
+    rs->zerocrossings = resampler_qualities[quality].zerocrossings;
+    rs->resolution = resampler_qualities[quality].resolution;
+    rs->beta = resampler_qualities[quality].beta;
+    rs->cutoff = resampler_qualities[quality].cutoff;
+    rs->maxhalf = (int)ceil(rs->zerocrossings / LPRESAMPLER_MINRATIO);
+
+    /* The table runs one point past the last zero
+     * crossing so every lookup can interpolate */
+    points = rs->zerocrossings * rs->resolution + 2;
+    rs->table = (lpfloat_t *)LPMemoryPool.alloc(points, sizeof(lpfloat_t));
+    rs->tablediff = (lpfloat_t *)LPMemoryPool.alloc(points, sizeof(lpfloat_t));
+    for(i=0; i < points; i++) {
+        rs->table[i] = resampler_kernel(rs, (double)i / rs->resolution);
+    }
+    for(i=0; i < points-1; i++) {
+        rs->tablediff[i] = rs->table[i+1] - rs->table[i];
+    }
+    rs->tablediff[points-1] = 0;
+
+    rs->coefs = (lpfloat_t *)LPMemoryPool.alloc(2 * rs->maxhalf + LPRESAMPLER_LANES, sizeof(lpfloat_t));
+
+    /* Start with maxhalf frames of silence behind the
+     * first input frame, which is where the first
+     * output frame falls */
+    rs->capacity = 2 * rs->maxhalf + LPRESAMPLER_LANES + LPRESAMPLER_CHUNKSIZE;
+    rs->history = (lpfloat_t *)LPMemoryPool.alloc(rs->capacity * channels, sizeof(lpfloat_t));
+    memset(rs->history, 0, sizeof(lpfloat_t) * rs->capacity * channels);
+    rs->length = rs->maxhalf;
+    rs->base = rs->maxhalf;
+    rs->frac = 0;
+
+    rs->bank = NULL;
+    resampler_configure(rs, ratio, 1);
+
+    return rs;
+}
+
+/* Ratio changes switch to the table: building a new
+ * bank of up to LPRESAMPLER_MAXPHASES filters on every
+ * block would cost far more than it saves */
+void set_ratio_resampler(lpresampler_t * rs, lpfloat_t ratio) {
+    if(ratio == rs->ratio) return;
+    resampler_configure(rs, ratio, 0);
+}
+
+/* Drop the frames that no filter can reach any more,
+ * then deinterleave as much of in as fits. Returns
+ * the number of frames taken from in. */
+static size_t resampler_refill(lpresampler_t * rs, lpfloat_t * in, size_t inframes) {
+    size_t i, n, discard;
+    lpfloat_t * plane;
+    int c;
+
+    discard = rs->base - rs->maxhalf;
+    if(discard > 0 && rs->length + LPRESAMPLER_CHUNKSIZE > rs->capacity) {
+        for(c=0; c < rs->channels; c++) {
+            plane = rs->history + c * rs->capacity;
+            memmove(plane, plane + discard, sizeof(lpfloat_t) * (rs->length - discard));
+        }
+        rs->length -= discard;
+        rs->base -= discard;
+    }
+
+    n = rs->capacity - rs->length;
+    if(n > LPRESAMPLER_CHUNKSIZE) n = LPRESAMPLER_CHUNKSIZE;
+    if(n > inframes) n = inframes;
+
+    for(c=0; c < rs->channels; c++) {
+        plane = rs->history + c * rs->capacity + rs->length;
+        for(i=0; i < n; i++) {
+            plane[i] = in[i * rs->channels + c];
+        }
+    }
+    rs->length += n;
+
+    return n;
+}
+
+/* Builds the filter for an output frame frac of the
+ * way past its input frame from the table */
+static void resampler_interpolate_coefs(lpresampler_t * rs, double frac) {
+    double x, pos, scale, resolution;
+    int j, idx, limit, taps;
+
+    scale = rs->scale;
+    resolution = rs->resolution * scale;
+    limit = rs->zerocrossings * rs->resolution;
+    taps = 2 * rs->half;
+
+    for(j=0; j < taps; j++) {
+        x = fabs(frac + rs->half - 1 - j) * resolution;
+        idx = (int)x;
+        if(idx > limit) idx = limit;
+        pos = x - idx;
+        rs->coefs[j] = scale * (rs->table[idx] + pos * rs->tablediff[idx]);
+    }
+
+    for(; j < rs->ntaps; j++) rs->coefs[j] = 0;
+}
+
+static lpfloat_t resampler_dot(const lpfloat_t * x, const lpfloat_t * coefs, int ntaps) {
+    lpresampler_vec_t acc = {0}, vx, vc;
+    lpfloat_t out;
+    int j;
+
+    for(j=0; j < ntaps; j += LPRESAMPLER_LANES) {
+        memcpy(&vx, x + j, sizeof(lpresampler_vec_t));
+        memcpy(&vc, coefs + j, sizeof(lpresampler_vec_t));
+        acc += vx * vc;
+    }
+
+    out = 0;
+    for(j=0; j < LPRESAMPLER_LANES; j++) out += acc[j];
+
+    return out;
+}
+
+size_t process_resampler(lpresampler_t * rs, lpfloat_t * in, size_t * inframes, lpfloat_t * out, size_t outframes) {
+    size_t used, written, start;
+    lpfloat_t * coefs;
+    double step;
+    int c;
+
+    used = 0;
+    written = 0;
+    step = 1.0 / rs->ratio;
+    while(written < outframes) {
+        start = rs->base - rs->half + 1;
+
+        if(start + rs->ntaps > rs->length) {
+            if(used >= *inframes) break;
+            used += resampler_refill(rs, in + used * rs->channels, *inframes - used);
+            continue;
+        }
+
+        if(rs->bank != NULL) {
+            coefs = rs->bank + rs->bankphase * rs->ntaps;
+        } else {
+            resampler_interpolate_coefs(rs, rs->frac);
+            coefs = rs->coefs;
+        }
+
+        for(c=0; c < rs->channels; c++) {
+            out[written * rs->channels + c] = resampler_dot(rs->history + c * rs->capacity + start, coefs, rs->ntaps);
+        }
+        written += 1;
+
+        if(rs->bank != NULL) {
+            rs->bankphase += rs->step;
+            rs->base += rs->bankphase / rs->numphases;
+            rs->bankphase %= rs->numphases;
+            rs->frac = (double)rs->bankphase / rs->numphases;
+        } else {
+            rs->frac += step;
+            rs->base += (size_t)rs->frac;
+            rs->frac -= (size_t)rs->frac;
+        }
+    }
+
+    *inframes = used;
+
+    return written;
+}
+
+lpbuffer_t * resample_resampler(lpbuffer_t * buf, lpfloat_t ratio, int quality) {
+    lpresampler_t * rs;
+    lpbuffer_t * out;
+    lpfloat_t * zeros;
+    size_t pos, n, written, length;
+
+    if(ratio < LPRESAMPLER_MINRATIO) ratio = LPRESAMPLER_MINRATIO;
+    length = (size_t)ceil(buf->length * (double)ratio);
+
+    rs = create_resampler(ratio, buf->channels, quality);
+    out = LPBuffer.create(length, buf->channels, (int)(buf->samplerate * ratio));
+    zeros = (lpfloat_t *)LPMemoryPool.alloc(LPRESAMPLER_CHUNKSIZE * buf->channels, sizeof(lpfloat_t));
+    memset(zeros, 0, sizeof(lpfloat_t) * LPRESAMPLER_CHUNKSIZE * buf->channels);
+
+    /* Silence after the end flushes the filter */
+    pos = 0;
+    written = 0;
+    while(written < length) {
+        if(pos < buf->length) {
+            n = buf->length - pos;
+            written += process_resampler(rs, buf->data + pos * buf->channels, &n, out->data + written * buf->channels, length - written);
+            pos += n;
+        } else {
+            n = LPRESAMPLER_CHUNKSIZE;
+            written += process_resampler(rs, zeros, &n, out->data + written * buf->channels, length - written);
+        }
+    }
+
+    LPMemoryPool.free(zeros);
+    destroy_resampler(rs);
+
+    return out;
+}
+
+/* Like LPBuffer.varispeed: speed is read across the
+ * length of buf and sets how many input frames each
+ * output frame moves forward, so 2 is an octave up.
+ * It's sampled once per block of output. */
+#define LPRESAMPLER_VARISPEED_BLOCKSIZE 64
+lpbuffer_t * varispeed_resampler(lpbuffer_t * buf, lpbuffer_t * speed, int quality) {
+    lpresampler_t * rs;
+    lpbuffer_t * out, * trimmed;
+    lpfloat_t * zeros, * src, minspeed, _speed;
+    size_t fed, n, written, maxlength, want;
+    double inputpos;
+
+    minspeed = LPBuffer.min(speed);
+    if(minspeed < LPVSPEED_MIN) minspeed = LPVSPEED_MIN;
+    if(minspeed > 1.f / LPRESAMPLER_MINRATIO) minspeed = 1.f / LPRESAMPLER_MINRATIO;
+    maxlength = (size_t)ceil(buf->length / (double)minspeed) + 1;
+
+    rs = create_resampler(1.f / LPInterpolation.linear_pos(speed, 0), buf->channels, quality);
+    out = LPBuffer.create(maxlength, buf->channels, buf->samplerate);
+    zeros = (lpfloat_t *)LPMemoryPool.alloc(LPRESAMPLER_CHUNKSIZE * buf->channels, sizeof(lpfloat_t));
+    memset(zeros, 0, sizeof(lpfloat_t) * LPRESAMPLER_CHUNKSIZE * buf->channels);
+
+    fed = 0;
+    written = 0;
+    while(written < maxlength) {
+        /* The input frame the next output frame falls on */
+        inputpos = fed - (rs->length - rs->base - rs->frac);
+        if(inputpos >= buf->length) break;
+
+        _speed = LPInterpolation.linear_pos(speed, inputpos / buf->length);
+        if(_speed < minspeed) _speed = minspeed;
+        set_ratio_resampler(rs, 1.f / _speed);
+
+        want = maxlength - written;
+        if(want > LPRESAMPLER_VARISPEED_BLOCKSIZE) want = LPRESAMPLER_VARISPEED_BLOCKSIZE;
+
+        if(fed < buf->length) {
+            src = buf->data + fed * buf->channels;
+            n = buf->length - fed;
+        } else {
+            src = zeros;
+            n = LPRESAMPLER_CHUNKSIZE;
+        }
+
+        written += process_resampler(rs, src, &n, out->data + written * buf->channels, want);
+        fed += n;
+    }
+
+    trimmed = LPBuffer.cut(out, 0, written);
+
+    LPBuffer.destroy(out);
+    LPMemoryPool.free(zeros);
+    destroy_resampler(rs);
+
+    return trimmed;
+}
+
+typedef struct resampler_channel_args_t {
+    lpfloat_t ratio;
+    lpbuffer_t * speed;
+    int quality;
+} resampler_channel_args_t;
+
+static lpbuffer_t * resampler_resample_channel(lpbuffer_t * channel, int c, void * arg) {
+    resampler_channel_args_t * args = (resampler_channel_args_t *)arg;
+    (void)c;
+    return resample_resampler(channel, args->ratio, args->quality);
+}
+
+static lpbuffer_t * resampler_varispeed_channel(lpbuffer_t * channel, int c, void * arg) {
+    resampler_channel_args_t * args = (resampler_channel_args_t *)arg;
+    (void)c;
+    return varispeed_resampler(channel, args->speed, args->quality);
+}
+
+lpbuffer_t * resample_parallel_resampler(lpbuffer_t * buf, lpfloat_t ratio, int quality, lpjobs_t * jobs) {
+    resampler_channel_args_t args = { ratio, NULL, quality };
+    return LPJobs.map_channels(jobs, buf, resampler_resample_channel, &args);
+}
+
+lpbuffer_t * varispeed_parallel_resampler(lpbuffer_t * buf, lpbuffer_t * speed, int quality, lpjobs_t * jobs) {
+    resampler_channel_args_t args = { 1.f, speed, quality };
+    return LPJobs.map_channels(jobs, buf, resampler_varispeed_channel, &args);
+}
+
+void destroy_resampler(lpresampler_t * rs) {
+    if(rs == NULL) return;
+    if(rs->bank != NULL) LPMemoryPool.free(rs->bank);
+    LPMemoryPool.free(rs->table);
+    LPMemoryPool.free(rs->tablediff);
+    LPMemoryPool.free(rs->coefs);
+    LPMemoryPool.free(rs->history);
+    LPMemoryPool.free(rs);
+}
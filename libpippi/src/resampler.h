@@ -0,0 +1,115 @@
+#ifndef LP_RESAMPLER_H
+#define LP_RESAMPLER_H
+
+#include "pippicore.h"
+#include "jobs.h"
+
+/* Taps are processed this many at a time */
+#define LPRESAMPLER_LANES 4
+
+/* Input frames copied into the history per refill */
+#define LPRESAMPLER_CHUNKSIZE 1024
+
+/* Ratios below this are clamped: the filter gets
+ * longer as the ratio falls, by 1 / ratio */
+#define LPRESAMPLER_MINRATIO (1.f/16.f)
+
+/* Ratios which are a fraction with a denominator up
+ * to this get a precomputed polyphase bank */
+#define LPRESAMPLER_MAXPHASES 1024
+
+enum LPRESAMPLER_QUALITIES {
+    LPRESAMPLER_FAST,   /* 16 zero crossings, ~60dB stopband */
+    LPRESAMPLER_MEDIUM, /* 32 zero crossings, ~90dB stopband */
+    LPRESAMPLER_BEST,   /* 64 zero crossings, ~120dB stopband */
+    NUM_LPRESAMPLER_QUALITIES
+};
+
+/* Windowed sinc sample rate conversion.
+ *
+ * ratio is output frames per input frame: 2 doubles
+ * the length of the input, 0.5 halves it. When it is
+ * below 1 the cutoff of the filter is lowered with it,
+ * so content above the new nyquist is removed instead
+ * of folding back down.
+ *
+ * There are two paths. If the ratio is a fraction L/M
+ * with L <= LPRESAMPLER_MAXPHASES -- 44100 to 48000 is
+ * 160/147 -- the L filters needed are computed up front
+ * and the output is a dot product of each one with the
+ * input in turn. Otherwise, or after set_ratio changes
+ * the ratio, every output frame builds its filter from
+ * a finely sampled table of the kaiser windowed sinc,
+ * which lets the ratio change from one block to the
+ * next for varispeed.
+ *
+ * process() is streaming: it takes as much input as
+ * it needs from in to write up to outframes frames,
+ * sets *inframes to the number of input frames used
+ * and returns the number of frames written. Input is
+ * copied into an internal history, so the caller only
+ * has to keep track of where it is in its own input.
+ * The output lags the input by half the filter length;
+ * feed it zeros at the end of a stream to flush it.
+ *
+ * The channels never mix, so the parallel versions of
+ * resample and varispeed run one resampler per channel
+ * on a job pool and get the same output. */
+typedef struct lpresampler_t {
+    int channels;
+    int quality;
+    lpfloat_t ratio;
+    lpfloat_t scale; /* min(1, ratio): the relative cutoff */
+
+    /* The filter is zerocrossings wide on each side,
+     * scaled out by 1 / scale when downsampling */
+    int zerocrossings;
+    lpfloat_t cutoff;
+    lpfloat_t beta;
+    int half;
+    int ntaps; /* 2 * half padded to a multiple of LPRESAMPLER_LANES */
+    int maxhalf;
+
+    /* One side of the windowed sinc with resolution
+     * points per zero crossing, and the difference to
+     * the next point for interpolation */
+    int resolution;
+    lpfloat_t * table;
+    lpfloat_t * tablediff;
+    lpfloat_t * coefs;
+
+    /* The polyphase bank: numphases filters of ntaps,
+     * or NULL when the ratio isn't a small fraction */
+    lpfloat_t * bank;
+    int numphases;
+    int step;
+    int bankphase;
+
+    /* Planar input history, one run of capacity
+     * frames per channel */
+    lpfloat_t * history;
+    size_t capacity;
+    size_t length;
+
+    /* The next output frame falls frac of the way
+     * past frame base of the history. frac is kept
+     * apart from base so moving the history along
+     * doesn't change its rounding. */
+    size_t base;
+    double frac;
+} lpresampler_t;
+
+typedef struct lpresampler_factory_t {
+    lpresampler_t * (*create)(lpfloat_t ratio, int channels, int quality);
+    size_t (*process)(lpresampler_t *, lpfloat_t * in, size_t * inframes, lpfloat_t * out, size_t outframes);
+    void (*set_ratio)(lpresampler_t *, lpfloat_t ratio);
+    lpbuffer_t * (*resample)(lpbuffer_t * buf, lpfloat_t ratio, int quality);
+    lpbuffer_t * (*varispeed)(lpbuffer_t * buf, lpbuffer_t * speed, int quality);
+    lpbuffer_t * (*resample_parallel)(lpbuffer_t * buf, lpfloat_t ratio, int quality, lpjobs_t * jobs);
+    lpbuffer_t * (*varispeed_parallel)(lpbuffer_t * buf, lpbuffer_t * speed, int quality, lpjobs_t * jobs);
+    void (*destroy)(lpresampler_t *);
+} lpresampler_factory_t;
+
+extern const lpresampler_factory_t LPResampler;
+
+#endif
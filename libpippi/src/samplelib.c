@@ -0,0 +1,259 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "samplelib.h"
+
+#define LP_FNV_OFFSET 14695981039346656037ULL
+#define LP_FNV_PRIME 1099511628211ULL
+
+_Static_assert(sizeof(lpsampleheader_t) <= LPSAMPLELIB_DATAOFFSET, "lpsampleheader_t must fit before the frames");
+
+int write_samplelib(const char * path, lpbuffer_t * buf);
+int convert_samplelib(const char * srcpath, const char * path);
+lpbuffer_t * open_samplelib(const char * path);
+int prefetch_samplelib(lpbuffer_t * buf, size_t start, size_t length);
+int verify_samplelib(lpbuffer_t * buf);
+void close_samplelib(lpbuffer_t * buf);
+
+const lpsamplelib_factory_t LPSampleLib = { write_samplelib, convert_samplelib, open_samplelib, prefetch_samplelib, verify_samplelib, close_samplelib };
+
+static uint64_t samplelib_checksum(uint64_t hash, const void * bytes, size_t count) {
+    const unsigned char * b = (const unsigned char *)bytes;
+    size_t i;
+
+    for(i=0; i < count; i++) {
+        hash ^= b[i];
+        hash *= LP_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static size_t samplelib_mapsize(lpbuffer_t * buf) {
+    return LPSAMPLELIB_DATAOFFSET + buf->length * buf->channels * sizeof(lpfloat_t);
+}
+
+static lpsampleheader_t * samplelib_header(lpbuffer_t * buf) {
+    return (lpsampleheader_t *)((unsigned char *)buf->data - LPSAMPLELIB_DATAOFFSET);
+}
+
+/* Opens a temporary file next to path and skips
+ * past the header, which is written last */
+static FILE * samplelib_begin(const char * path, char * tmppath) {
+    FILE * fp;
+
+    if(snprintf(tmppath, PATH_MAX, "%s.tmp%d", path, (int)getpid()) >= PATH_MAX) {
+        fprintf(stderr, "LPSampleLib: path too long %s\n", path);
+        return NULL;
+    }
+
+    if((fp = fopen(tmppath, "wb")) == NULL) {
+        fprintf(stderr, "LPSampleLib: could not open %s for writing\n", tmppath);
+        return NULL;
+    }
+
+    if(fseek(fp, LPSAMPLELIB_DATAOFFSET, SEEK_SET) != 0) {
+        fprintf(stderr, "LPSampleLib: could not seek in %s\n", tmppath);
+        fclose(fp);
+        unlink(tmppath);
+        return NULL;
+    }
+
+    return fp;
+}
+
+static int samplelib_finish(FILE * fp, const char * tmppath, const char * path, lpsampleheader_t * header) {
+    memcpy(header->magic, LPSAMPLELIB_MAGIC, sizeof(LPSAMPLELIB_MAGIC));
+    header->version = LPSAMPLELIB_VERSION;
+    header->samplesize = sizeof(lpfloat_t);
+
+    if(fseek(fp, 0, SEEK_SET) != 0
+        || fwrite(header, sizeof(lpsampleheader_t), 1, fp) != 1
+    ) {
+        fprintf(stderr, "LPSampleLib: could not write header to %s\n", tmppath);
+        fclose(fp);
+        unlink(tmppath);
+        return -1;
+    }
+
+    if(fclose(fp) != 0 || rename(tmppath, path) != 0) {
+        fprintf(stderr, "LPSampleLib: could not write %s\n", path);
+        unlink(tmppath);
+        return -1;
+    }
+
+    return 0;
+}
+
+int write_samplelib(const char * path, lpbuffer_t * buf) {
+    char tmppath[PATH_MAX];
+    lpsampleheader_t header = {0};
+    size_t count;
+    FILE * fp;
+
+    if((fp = samplelib_begin(path, tmppath)) == NULL) return -1;
+
+    count = buf->length * buf->channels;
+    if(fwrite(buf->data, sizeof(lpfloat_t), count, fp) != count) {
+        fprintf(stderr, "LPSampleLib: could not write frames to %s\n", tmppath);
+        fclose(fp);
+        unlink(tmppath);
+        return -1;
+    }
+
+    header.channels = buf->channels;
+    header.samplerate = buf->samplerate;
+    header.length = buf->length;
+    header.checksum = samplelib_checksum(LP_FNV_OFFSET, buf->data, count * sizeof(lpfloat_t));
+
+    return samplelib_finish(fp, tmppath, path, &header);
+}
+
+/* Decode any file LPSoundStream can read a chunk at a
+ * time, so long files never have to fit in memory */
+int convert_samplelib(const char * srcpath, const char * path) {
+    char tmppath[PATH_MAX];
+    lpsampleheader_t header = {0};
+    lpsoundstream_t * stream;
+    lpfloat_t * chunk;
+    size_t got;
+    FILE * fp;
+
+    if((stream = LPSoundStream.open(srcpath)) == NULL) return -1;
+
+    if((fp = samplelib_begin(path, tmppath)) == NULL) {
+        LPSoundStream.close(stream);
+        return -1;
+    }
+
+    chunk = (lpfloat_t *)LPMemoryPool.alloc(LPSOUNDSTREAM_CHUNKSIZE * stream->channels, sizeof(lpfloat_t));
+    header.checksum = LP_FNV_OFFSET;
+
+    while((got = LPSoundStream.read(stream, chunk, LPSOUNDSTREAM_CHUNKSIZE)) > 0) {
+        if(fwrite(chunk, sizeof(lpfloat_t) * stream->channels, got, fp) != got) {
+            fprintf(stderr, "LPSampleLib: could not write frames to %s\n", tmppath);
+            LPMemoryPool.free(chunk);
+            LPSoundStream.close(stream);
+            fclose(fp);
+            unlink(tmppath);
+            return -1;
+        }
+        header.checksum = samplelib_checksum(header.checksum, chunk, got * stream->channels * sizeof(lpfloat_t));
+        header.length += got;
+    }
+
+    header.channels = stream->channels;
+    header.samplerate = stream->samplerate;
+
+    LPMemoryPool.free(chunk);
+    LPSoundStream.close(stream);
+
+    return samplelib_finish(fp, tmppath, path, &header);
+}
+
+/* Returns NULL if the file can't be mapped or isn't
+ * a sample library file for this build */
+lpbuffer_t * open_samplelib(const char * path) {
+    lpsampleheader_t * header;
+    lpbuffer_t * buf;
+    struct stat st;
+    unsigned char * map;
+    int fd;
+
+    if((fd = open(path, O_RDONLY)) < 0) {
+        fprintf(stderr, "LPSampleLib: could not open %s\n", path);
+        return NULL;
+    }
+
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < LPSAMPLELIB_DATAOFFSET) {
+        fprintf(stderr, "LPSampleLib: %s is too short\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    /* The mapping keeps the file open */
+    map = (unsigned char *)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        fprintf(stderr, "LPSampleLib: could not map %s\n", path);
+        return NULL;
+    }
+
+    header = (lpsampleheader_t *)map;
+    if(memcmp(header->magic, LPSAMPLELIB_MAGIC, sizeof(LPSAMPLELIB_MAGIC)) != 0
+        || header->version != LPSAMPLELIB_VERSION
+        || header->channels == 0
+    ) {
+        fprintf(stderr, "LPSampleLib: %s is not a sample library file\n", path);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    if(header->samplesize != sizeof(lpfloat_t)) {
+        fprintf(stderr, "LPSampleLib: %s has %d byte samples, this build uses %d\n", path, (int)header->samplesize, (int)sizeof(lpfloat_t));
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    if((size_t)st.st_size != LPSAMPLELIB_DATAOFFSET + header->length * header->channels * sizeof(lpfloat_t)) {
+        fprintf(stderr, "LPSampleLib: %s is truncated\n", path);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    if((buf = (lpbuffer_t *)LPMemoryPool.alloc(1, sizeof(lpbuffer_t))) == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    buf->data = (lpfloat_t *)(map + LPSAMPLELIB_DATAOFFSET);
+    buf->length = header->length;
+    buf->channels = header->channels;
+    buf->samplerate = header->samplerate;
+    buf->range = buf->length;
+    buf->boundry = buf->length - 1;
+    buf->refcount = 1;
+
+    return buf;
+}
+
+/* Hint that the frames from start to start+length will
+ * be read soon. On linux this starts readahead of the
+ * pages that aren't already in the page cache. */
+int prefetch_samplelib(lpbuffer_t * buf, size_t start, size_t length) {
+    uintptr_t from, to, pagesize;
+
+    if(start >= buf->length) return 0;
+    if(length > buf->length - start) length = buf->length - start;
+
+    pagesize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    from = (uintptr_t)(buf->data + start * buf->channels);
+    to = (uintptr_t)(buf->data + (start + length) * buf->channels);
+    from -= from % pagesize;
+
+    if(posix_madvise((void *)from, to - from, POSIX_MADV_WILLNEED) != 0) {
+        fprintf(stderr, "LPSampleLib: prefetch failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Returns 0 if the frames match the checksum in the header */
+int verify_samplelib(lpbuffer_t * buf) {
+    lpsampleheader_t * header = samplelib_header(buf);
+    uint64_t checksum;
+
+    checksum = samplelib_checksum(LP_FNV_OFFSET, buf->data, buf->length * buf->channels * sizeof(lpfloat_t));
+    return (checksum == header->checksum) ? 0 : -1;
+}
+
+void close_samplelib(lpbuffer_t * buf) {
+    if(buf == NULL) return;
+    assert(buf->refcount <= 1);
+    munmap(samplelib_header(buf), samplelib_mapsize(buf));
+    LPMemoryPool.free(buf);
+}
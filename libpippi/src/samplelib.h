@@ -0,0 +1,62 @@
+#ifndef LP_SAMPLELIB_H
+#define LP_SAMPLELIB_H
+
+#include <stdint.h>
+#include "pippicore.h"
+#include "soundfile.h"
+
+#define LPSAMPLELIB_MAGIC "LPSAMPL"
+#define LPSAMPLELIB_VERSION 1
+
+/* Frames start this far into the file, so they are
+ * page aligned in the mapping */
+#define LPSAMPLELIB_DATAOFFSET 4096
+
+/* Sample library files hold raw interleaved lpfloat_t
+ * frames after a small header, so they can be used
+ * straight from a read-only mmap of the file: loading
+ * costs a page table update instead of a decode and a
+ * copy, and every process that opens the same file
+ * shares one copy of it in the page cache.
+ *
+ * Samples are stored at the width of lpfloat_t in the
+ * build that wrote them, and open() refuses files of
+ * the other width. The checksum is an FNV-1a hash of
+ * the frame bytes. It isn't checked by open(), which
+ * would mean reading the whole file; verify() does it.
+ *
+ * The buffers returned by open() are read only: writing
+ * to their data will crash. Release them with close(),
+ * never LPBuffer.destroy().
+ *
+ * prefetch() asks the kernel to start reading a region
+ * of the file in the background, eg the frames around
+ * an onset that will be played soon, so the first
+ * reads don't have to wait on the disk.
+ *
+ * write() and convert() write to a temporary file and
+ * rename it into place, so processes that have the old
+ * file mapped keep reading the old frames.
+ */
+typedef struct lpsampleheader_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t samplesize;    /* bytes per sample */
+    uint32_t channels;
+    uint32_t samplerate;
+    uint64_t length;        /* in frames */
+    uint64_t checksum;
+} lpsampleheader_t;
+
+typedef struct lpsamplelib_factory_t {
+    int (*write)(const char * path, lpbuffer_t * buf);
+    int (*convert)(const char * srcpath, const char * path);
+    lpbuffer_t * (*open)(const char * path);
+    int (*prefetch)(lpbuffer_t * buf, size_t start, size_t length);
+    int (*verify)(lpbuffer_t * buf);
+    void (*close)(lpbuffer_t * buf);
+} lpsamplelib_factory_t;
+
+extern const lpsamplelib_factory_t LPSampleLib;
+
+#endif
@@ -1,75 +1,430 @@
 #include "soundfile.h"
 
+/* dr_mp3 mixes float and double arithmetic, which
+ * LP_FLOAT builds warn about. The decoders are kept
+ * private to this file, so they don't clash between
+ * the float32 and double builds, or with a program's
+ * own copy of dr_libs. */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdouble-promotion"
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+#define DRWAV_API static
+#define DRWAV_PRIVATE static
+#define DRFLAC_API static
+#define DRFLAC_PRIVATE static
+#define DRMP3_API static
+#define DRMP3_PRIVATE static
+
 #define DR_WAV_IMPLEMENTATION
 #include "dr_libs/dr_wav.h"
 
-#define LP_SOUNDFILE_BUFSIZE 1024
+#define DR_FLAC_IMPLEMENTATION
+#include "dr_libs/dr_flac.h"
 
-lpbuffer_t * read_soundfile(const char * path) {
-    unsigned int channels;
-    unsigned int samplerate;
-    lpbuffer_t * out;
-    drwav_uint64 frames;
-    float * data;
-    drwav_uint64 i;
-    unsigned int c;
+#define DR_MP3_IMPLEMENTATION
+#include "dr_libs/dr_mp3.h"
+
+#pragma GCC diagnostic pop
+
+#define LP_SOUNDSTREAM_NOSEEK ((size_t)-1)
+
+lpsoundstream_t * open_soundstream(const char * path);
+lpsoundstream_t * create_soundstream(const char * path, int channels, int samplerate, int bitdepth);
+int seek_soundstream(lpsoundstream_t * stream, size_t frame);
+size_t read_soundstream(lpsoundstream_t * stream, lpfloat_t * out, size_t nframes);
+size_t write_soundstream(lpsoundstream_t * stream, lpfloat_t * in, size_t nframes);
+int prefetch_soundstream(lpsoundstream_t * stream, size_t nframes);
+void close_soundstream(lpsoundstream_t * stream);
 
-    data = (float *)drwav_open_file_and_read_pcm_frames_f32(path, &channels, &samplerate, &frames, NULL);
-    if (data == NULL) {
-        printf("Error: could not open file: %s", path);
-        exit(EXIT_FAILURE);
+const lpsoundstream_factory_t LPSoundStream = { open_soundstream, create_soundstream, seek_soundstream, read_soundstream, write_soundstream, prefetch_soundstream, close_soundstream };
+
+/* Try each decoder in turn */
+lpsoundstream_t * open_soundstream(const char * path) {
+    lpsoundstream_t * stream;
+    drwav * wav;
+    drflac * flac;
+    drmp3 * mp3;
+
+    stream = (lpsoundstream_t *)LPMemoryPool.alloc(1, sizeof(lpsoundstream_t));
+
+    wav = (drwav *)LPMemoryPool.alloc(1, sizeof(drwav));
+    if(drwav_init_file(wav, path, NULL)) {
+        stream->format = LPSOUNDSTREAM_WAV;
+        stream->decoder = wav;
+        stream->channels = wav->channels;
+        stream->samplerate = wav->sampleRate;
+        stream->bitdepth = wav->bitsPerSample;
+        stream->length = wav->totalPCMFrameCount;
+    } else {
+        LPMemoryPool.free(wav);
     }
 
-    out = LPBuffer.create(frames, channels, samplerate);
-    for(i=0; i < frames; i++) {
-        for(c=0; c < channels; c++) {
-            out->data[i * channels + c] = data[i * channels + c];
+    if(stream->decoder == NULL && (flac = drflac_open_file(path, NULL)) != NULL) {
+        stream->format = LPSOUNDSTREAM_FLAC;
+        stream->decoder = flac;
+        stream->channels = flac->channels;
+        stream->samplerate = flac->sampleRate;
+        stream->bitdepth = flac->bitsPerSample;
+        stream->length = flac->totalPCMFrameCount;
+    }
+
+    if(stream->decoder == NULL) {
+        mp3 = (drmp3 *)LPMemoryPool.alloc(1, sizeof(drmp3));
+        if(drmp3_init_file(mp3, path, NULL)) {
+            stream->format = LPSOUNDSTREAM_MP3;
+            stream->decoder = mp3;
+            stream->channels = mp3->channels;
+            stream->samplerate = mp3->sampleRate;
+            stream->bitdepth = 32;
+            /* This scans the frame headers of the whole file */
+            stream->length = drmp3_get_pcm_frame_count(mp3);
+        } else {
+            LPMemoryPool.free(mp3);
         }
     }
-    drwav_free(data, NULL);
-    return out;
+
+    if(stream->decoder == NULL) {
+        fprintf(stderr, "Error: could not open soundfile %s\n", path);
+        LPMemoryPool.free(stream);
+        return NULL;
+    }
+
+    stream->scratch = (float *)LPMemoryPool.alloc(LPSOUNDSTREAM_CHUNKSIZE * stream->channels, sizeof(float));
+    stream->seekto = LP_SOUNDSTREAM_NOSEEK;
+
+    return stream;
 }
 
-void write_soundfile(const char * path, lpbuffer_t * buf) {
-    int count;
-    float * tmpbuf;
-    drwav wav;
+/* bitdepth 16 or 24 writes integer PCM, 32 writes floats */
+lpsoundstream_t * create_soundstream(const char * path, int channels, int samplerate, int bitdepth) {
+    lpsoundstream_t * stream;
     drwav_data_format format;
-    size_t i;
-    int c;
+    drwav * wav;
 
-    int channels = buf->channels;
-    tmpbuf = (float *)LPMemoryPool.alloc(LP_SOUNDFILE_BUFSIZE * buf->channels, sizeof(float));
+    if(bitdepth != 16 && bitdepth != 24 && bitdepth != 32) {
+        fprintf(stderr, "Error: unsupported bit depth %d for %s\n", bitdepth, path);
+        return NULL;
+    }
 
     format.container = drwav_container_riff;
-    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
-    format.channels = buf->channels;
-    format.sampleRate = buf->samplerate;
-    format.bitsPerSample = 32;
+    format.format = (bitdepth == 32) ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels = channels;
+    format.sampleRate = samplerate;
+    format.bitsPerSample = bitdepth;
+
+    wav = (drwav *)LPMemoryPool.alloc(1, sizeof(drwav));
+    if(!drwav_init_file_write(wav, path, &format, NULL)) {
+        fprintf(stderr, "Error: could not open soundfile %s for writing\n", path);
+        LPMemoryPool.free(wav);
+        return NULL;
+    }
+
+    stream = (lpsoundstream_t *)LPMemoryPool.alloc(1, sizeof(lpsoundstream_t));
+    stream->format = LPSOUNDSTREAM_WAV;
+    stream->writing = 1;
+    stream->decoder = wav;
+    stream->channels = channels;
+    stream->samplerate = samplerate;
+    stream->bitdepth = bitdepth;
+    stream->pcm = (unsigned char *)LPMemoryPool.alloc(LPSOUNDSTREAM_CHUNKSIZE * channels, bitdepth / 8);
+    stream->seekto = LP_SOUNDSTREAM_NOSEEK;
+
+    return stream;
+}
+
+/* Decode up to nframes into out, returning the number of
+ * frames decoded. Only one thread at a time may decode:
+ * the prefetch thread once it is running. */
+static size_t soundstream_decode(lpsoundstream_t * stream, float * out, size_t nframes) {
+    switch(stream->format) {
+        case LPSOUNDSTREAM_WAV:
+            return drwav_read_pcm_frames_f32((drwav *)stream->decoder, nframes, out);
+        case LPSOUNDSTREAM_FLAC:
+            return drflac_read_pcm_frames_f32((drflac *)stream->decoder, nframes, out);
+        case LPSOUNDSTREAM_MP3:
+            return drmp3_read_pcm_frames_f32((drmp3 *)stream->decoder, nframes, out);
+    }
+    return 0;
+}
+
+static int soundstream_decoder_seek(lpsoundstream_t * stream, size_t frame) {
+    int ok = 0;
+
+    switch(stream->format) {
+        case LPSOUNDSTREAM_WAV:
+            ok = drwav_seek_to_pcm_frame((drwav *)stream->decoder, frame);
+            break;
+        case LPSOUNDSTREAM_FLAC:
+            ok = drflac_seek_to_pcm_frame((drflac *)stream->decoder, frame);
+            break;
+        case LPSOUNDSTREAM_MP3:
+            ok = drmp3_seek_to_pcm_frame((drmp3 *)stream->decoder, frame);
+            break;
+    }
+
+    return ok ? 0 : -1;
+}
+
+/* How long the prefetch thread sleeps when the ring
+ * is full: the reader never signals it, so it polls */
+#define LP_SOUNDSTREAM_POLLNS 1000000
+
+/* The prefetch thread keeps the ring as full as it can,
+ * and does seeks on behalf of the reader so the decoder
+ * is only ever touched from here. The lock and cond
+ * are only shared with seek and close; the ring itself
+ * is single producer, single consumer. */
+static void * soundstream_prefetch_thread(void * arg) {
+    lpsoundstream_t * stream = (lpsoundstream_t *)arg;
+    struct timespec ts;
+    size_t n, got, f, start, space;
+    int c;
+
+    pthread_mutex_lock(&stream->lock);
+    while(!stream->stop) {
+        if(stream->seekto != LP_SOUNDSTREAM_NOSEEK) {
+            if(soundstream_decoder_seek(stream, stream->seekto) == 0) {
+                stream->pos = stream->seekto;
+            }
+            __atomic_store_n(&stream->head, 0, __ATOMIC_RELEASE);
+            __atomic_store_n(&stream->tail, 0, __ATOMIC_RELEASE);
+            __atomic_store_n(&stream->eof, 0, __ATOMIC_RELEASE);
+            stream->seekto = LP_SOUNDSTREAM_NOSEEK;
+            pthread_cond_broadcast(&stream->cond);
+            continue;
+        }
+
+        start = stream->head;
+        space = stream->ringsize - (start - __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE));
+        if(stream->eof || space == 0) {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += LP_SOUNDSTREAM_POLLNS;
+            if(ts.tv_nsec >= 1000000000) {
+                ts.tv_sec += 1;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&stream->cond, &stream->lock, &ts);
+            continue;
+        }
+
+        n = (space > LPSOUNDSTREAM_CHUNKSIZE) ? LPSOUNDSTREAM_CHUNKSIZE : space;
+
+        pthread_mutex_unlock(&stream->lock);
+        got = soundstream_decode(stream, stream->scratch, n);
+        pthread_mutex_lock(&stream->lock);
+
+        /* A seek arrived while decoding: drop the chunk */
+        if(stream->seekto != LP_SOUNDSTREAM_NOSEEK) continue;
+
+        for(f=0; f < got; f++) {
+            for(c=0; c < stream->channels; c++) {
+                stream->ring[((start + f) % stream->ringsize) * stream->channels + c] = stream->scratch[f * stream->channels + c];
+            }
+        }
+        __atomic_store_n(&stream->head, start + got, __ATOMIC_RELEASE);
+        if(got < n) __atomic_store_n(&stream->eof, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    return NULL;
+}
 
-    drwav_init_file_write(&wav, path, &format, NULL);
+int prefetch_soundstream(lpsoundstream_t * stream, size_t nframes) {
+    if(stream->writing || stream->prefetching || nframes == 0) return -1;
 
-    count = 0;
+    stream->ring = (float *)LPMemoryPool.alloc(nframes * stream->channels, sizeof(float));
+    stream->ringsize = nframes;
+    stream->head = stream->tail = 0;
+    stream->eof = 0;
+    stream->stop = 0;
 
-    for(i=0; i < buf->length; i++) {
-        for(c=0; c < channels; c++) {
-            tmpbuf[count * channels + c] = (float)buf->data[i * channels + c];
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+
+    if(pthread_create(&stream->thread, NULL, soundstream_prefetch_thread, stream) != 0) {
+        fprintf(stderr, "Error: could not start soundstream prefetch thread. %s (%d)\n", strerror(errno), errno);
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->cond);
+        LPMemoryPool.free(stream->ring);
+        stream->ring = NULL;
+        return -1;
+    }
+
+    stream->prefetching = 1;
+    return 0;
+}
+
+int seek_soundstream(lpsoundstream_t * stream, size_t frame) {
+    if(stream->writing) return -1;
+    if(stream->length > 0 && frame > stream->length) return -1;
+
+    if(!stream->prefetching) {
+        if(soundstream_decoder_seek(stream, frame) < 0) return -1;
+        stream->pos = frame;
+        return 0;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    stream->seekto = frame;
+    pthread_cond_broadcast(&stream->cond);
+    while(stream->seekto != LP_SOUNDSTREAM_NOSEEK) {
+        pthread_cond_wait(&stream->cond, &stream->lock);
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    return (stream->pos == frame) ? 0 : -1;
+}
+
+/* Read up to nframes interleaved frames into out.
+ * Returns the number of frames read, which is less
+ * than nframes at the end of the file, or when a
+ * prefetched stream underruns. */
+size_t read_soundstream(lpsoundstream_t * stream, lpfloat_t * out, size_t nframes) {
+    size_t done, n, got, f, tail, available;
+    int c, eof;
+
+    if(stream->writing) return 0;
+
+    done = 0;
+    if(!stream->prefetching) {
+        while(done < nframes) {
+            n = nframes - done;
+            if(n > LPSOUNDSTREAM_CHUNKSIZE) n = LPSOUNDSTREAM_CHUNKSIZE;
+            got = soundstream_decode(stream, stream->scratch, n);
+            for(f=0; f < got * stream->channels; f++) {
+                out[done * stream->channels + f] = (lpfloat_t)stream->scratch[f];
+            }
+            done += got;
+            if(got < n) break;
         }
+        stream->pos += done;
+        return done;
+    }
 
-        count++;
+    /* eof first: once it is seen, so is the last head */
+    eof = __atomic_load_n(&stream->eof, __ATOMIC_ACQUIRE);
+    tail = stream->tail;
+    available = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE) - tail;
 
-        if (count >= LP_SOUNDFILE_BUFSIZE) {
-            drwav_write_pcm_frames(&wav, LP_SOUNDFILE_BUFSIZE, tmpbuf);
-            count = 0;
+    done = (nframes < available) ? nframes : available;
+    for(f=0; f < done; f++) {
+        for(c=0; c < stream->channels; c++) {
+            out[f * stream->channels + c] = (lpfloat_t)stream->ring[((tail + f) % stream->ringsize) * stream->channels + c];
         }
     }
+    __atomic_store_n(&stream->tail, tail + done, __ATOMIC_RELEASE);
+    stream->pos += done;
+
+    if(done < nframes && !eof) {
+        memset(out + done * stream->channels, 0, sizeof(lpfloat_t) * (nframes - done) * stream->channels);
+        stream->underruns += 1;
+    }
+
+    return done;
+}
 
-    if (count != 0) {
-        drwav_write_pcm_frames(&wav, count, tmpbuf);
+/* Clip to -1..1 and convert to the stream's sample format */
+static void soundstream_encode(lpsoundstream_t * stream, lpfloat_t * in, size_t nsamples) {
+    size_t i;
+    int32_t v;
+    float s;
+
+    for(i=0; i < nsamples; i++) {
+        s = (float)in[i];
+        if(stream->bitdepth == 32) {
+            memcpy(stream->pcm + i * 4, &s, 4);
+            continue;
+        }
+
+        s = (s > 1.f) ? 1.f : (s < -1.f) ? -1.f : s;
+        if(stream->bitdepth == 16) {
+            v = (int32_t)lrintf(s * 32767.f);
+            stream->pcm[i * 2] = (unsigned char)(v & 0xff);
+            stream->pcm[i * 2 + 1] = (unsigned char)((v >> 8) & 0xff);
+        } else {
+            v = (int32_t)lrintf(s * 8388607.f);
+            stream->pcm[i * 3] = (unsigned char)(v & 0xff);
+            stream->pcm[i * 3 + 1] = (unsigned char)((v >> 8) & 0xff);
+            stream->pcm[i * 3 + 2] = (unsigned char)((v >> 16) & 0xff);
+        }
     }
+}
+
+size_t write_soundstream(lpsoundstream_t * stream, lpfloat_t * in, size_t nframes) {
+    size_t done, n, got;
+
+    if(!stream->writing) return 0;
+
+    for(done=0; done < nframes; done += got) {
+        n = nframes - done;
+        if(n > LPSOUNDSTREAM_CHUNKSIZE) n = LPSOUNDSTREAM_CHUNKSIZE;
+        soundstream_encode(stream, in + done * stream->channels, n * stream->channels);
+        got = drwav_write_pcm_frames((drwav *)stream->decoder, n, stream->pcm);
+        if(got < n) {
+            done += got;
+            break;
+        }
+    }
+
+    stream->length += done;
+    return done;
+}
+
+void close_soundstream(lpsoundstream_t * stream) {
+    if(stream == NULL) return;
+
+    if(stream->prefetching) {
+        pthread_mutex_lock(&stream->lock);
+        stream->stop = 1;
+        pthread_cond_broadcast(&stream->cond);
+        pthread_mutex_unlock(&stream->lock);
+        pthread_join(stream->thread, NULL);
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->cond);
+        LPMemoryPool.free(stream->ring);
+    }
+
+    switch(stream->format) {
+        case LPSOUNDSTREAM_WAV:
+            drwav_uninit((drwav *)stream->decoder);
+            LPMemoryPool.free(stream->decoder);
+            break;
+        case LPSOUNDSTREAM_FLAC:
+            drflac_close((drflac *)stream->decoder);
+            break;
+        case LPSOUNDSTREAM_MP3:
+            drmp3_uninit((drmp3 *)stream->decoder);
+            LPMemoryPool.free(stream->decoder);
+            break;
+    }
+
+    LPMemoryPool.free(stream->scratch);
+    LPMemoryPool.free(stream->pcm);
+    LPMemoryPool.free(stream);
+}
+
+/* Exits if the file can't be read: open a stream 
+ * to handle that instead */
+lpbuffer_t * read_soundfile(const char * path) {
+    lpsoundstream_t * stream;
+    lpbuffer_t * out;
+
+    if((stream = LPSoundStream.open(path)) == NULL) exit(EXIT_FAILURE);
+
+    out = LPBuffer.create(stream->length, stream->channels, stream->samplerate);
+    out->length = LPSoundStream.read(stream, out->data, stream->length);
+    LPSoundStream.close(stream);
+
+    return out;
+}
+
+void write_soundfile(const char * path, lpbuffer_t * buf) {
+    lpsoundstream_t * stream;
 
-    drwav_uninit(&wav);
-    LPMemoryPool.free(tmpbuf);
+    if((stream = LPSoundStream.create(path, buf->channels, buf->samplerate, 32)) == NULL) return;
+    LPSoundStream.write(stream, buf->data, buf->length);
+    LPSoundStream.close(stream);
 }
 
 
@@ -1,13 +1,80 @@
 #ifndef LP_SOUNDFILE_H
 #define LP_SOUNDFILE_H
 
+#include <pthread.h>
 #include "pippicore.h"
 
+/* Frames decoded or encoded per call into dr_libs */
+#define LPSOUNDSTREAM_CHUNKSIZE 4096
+
+enum LPSoundStreamFormats {
+    LPSOUNDSTREAM_WAV,
+    LPSOUNDSTREAM_FLAC,
+    LPSOUNDSTREAM_MP3
+};
+
+/* A soundfile opened for reading or writing a chunk
+ * at a time, so long files never have to fit in memory.
+ *
+ * open() reads WAV, FLAC and MP3 files, always as
+ * interleaved lpfloat_t frames. create() writes WAV
+ * files with 16 or 24 bit integer or 32 bit float
+ * samples. Both return NULL if the file can't be used.
+ *
+ * prefetch() starts a thread that decodes ahead into
+ * a ring of the given number of frames. Reads then
+ * never lock or wait: they copy what the ring holds,
+ * and if it runs dry before the end of the file they
+ * zero the rest of out, count an underrun and return
+ * short. The missing frames are still read next time.
+ * seek() waits for the prefetch thread, so keep it off
+ * the audio thread. A stream is still only safe to use
+ * from one thread at a time: the prefetch thread is
+ * internal.
+ */
+typedef struct lpsoundstream_t {
+    int format;
+    int writing;
+    int channels;
+    int samplerate;
+    int bitdepth;
+    size_t length;      /* in frames: the file length when reading, frames written so far when writing */
+    size_t pos;         /* the next frame to be read */
+
+    void * decoder;     /* drwav, drflac or drmp3 */
+    float * scratch;
+    unsigned char * pcm;
+
+    int prefetching;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    float * ring;
+    size_t ringsize;
+    size_t head;        /* written by the prefetch thread, read with __atomic loads */
+    size_t tail;        /* written by the reader, read with __atomic loads */
+    size_t seekto;
+    size_t underruns;
+    int eof;
+    int stop;
+} lpsoundstream_t;
+
+typedef struct lpsoundstream_factory_t {
+    lpsoundstream_t * (*open)(const char * path);
+    lpsoundstream_t * (*create)(const char * path, int channels, int samplerate, int bitdepth);
+    int (*seek)(lpsoundstream_t *, size_t frame);
+    size_t (*read)(lpsoundstream_t *, lpfloat_t * out, size_t nframes);
+    size_t (*write)(lpsoundstream_t *, lpfloat_t * in, size_t nframes);
+    int (*prefetch)(lpsoundstream_t *, size_t nframes);
+    void (*close)(lpsoundstream_t *);
+} lpsoundstream_factory_t;
+
 typedef struct lpsoundfile_factory_t {
     lpbuffer_t * (*read)(const char *);
     void (*write)(const char *, lpbuffer_t *);
 } lpsoundfile_factory_t;
 
+extern const lpsoundstream_factory_t LPSoundStream;
 extern const lpsoundfile_factory_t LPSoundFile;
 
 #endif
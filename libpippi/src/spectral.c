@@ -1,59 +1,380 @@
 #include "spectral.h"
 
-/* FIXME: handle multichannel audio */
+typedef lpfloat_t lpfft_vec_t __attribute__((vector_size(LPFFT_LANES * sizeof(lpfloat_t))));
+
+lpfft_t * create_fft(size_t length);
+size_t size_fft(size_t minlength);
+void forward_fft(lpfft_t * fft, lpfloat_t * in, lpfloat_t * real, lpfloat_t * imag);
+void inverse_fft(lpfft_t * fft, lpfloat_t * real, lpfloat_t * imag, lpfloat_t * out);
+void destroy_fft(lpfft_t * fft);
+
+const lpfft_factory_t LPFFT = { create_fft, size_fft, forward_fft, inverse_fft, destroy_fft };
+
+/* Smallest power of two plan length >= minlength */
+size_t size_fft(size_t minlength) {
+    size_t length = 2;
+    while(length < minlength) length <<= 1;
+    return length;
+}
+
+lpfft_t * create_fft(size_t length) {
+    lpfft_t * fft;
+    size_t k, half;
+
+    assert(length >= 2 && (length & (length - 1)) == 0);
+
+    half = length / 2;
+
+    fft = (lpfft_t *)LPMemoryPool.alloc(1, sizeof(lpfft_t));
+    fft->length = length;
+    fft->twre = (lpfloat_t *)LPMemoryPool.alloc(length, sizeof(lpfloat_t));
+    fft->twim = (lpfloat_t *)LPMemoryPool.alloc(length, sizeof(lpfloat_t));
+    fft->are = (lpfloat_t *)LPMemoryPool.alloc(half, sizeof(lpfloat_t));
+    fft->aim = (lpfloat_t *)LPMemoryPool.alloc(half, sizeof(lpfloat_t));
+    fft->bre = (lpfloat_t *)LPMemoryPool.alloc(half, sizeof(lpfloat_t));
+    fft->bim = (lpfloat_t *)LPMemoryPool.alloc(half, sizeof(lpfloat_t));
+
+    /* exp(-2 pi i k / length) computed in double precision 
+     * in either build. The complex passes use every other 
+     * entry, up to 3/4 of the way around the circle. */
+    for(k=0; k < length; k++) {
+        fft->twre[k] = (lpfloat_t)cos(PI2 * (double)k / (double)length);
+        fft->twim[k] = (lpfloat_t)-sin(PI2 * (double)k / (double)length);
+    }
+
+    return fft;
+}
+
+/* One radix-4 pass: n point transforms with stride s
+ * become n/4 point transforms with stride 4s.
+ *
+ * The q loop runs over contiguous memory, so once s is
+ * at least a vector wide the butterflies are done a
+ * vector at a time. sign is 1 for the forward transform
+ * and -1 for the inverse, which conjugates the twiddles. */
+static void fft_pass4(lpfft_t * fft, size_t n, size_t s, lpfloat_t sign, lpfloat_t * xre, lpfloat_t * xim, lpfloat_t * yre, lpfloat_t * yim) {
+    lpfloat_t ar, ai, br, bi, cr, ci, dr, di;
+    lpfloat_t w1r, w1i, w2r, w2i, w3r, w3i;
+    lpfloat_t apcr, apci, amcr, amci, bpdr, bpdi, jbdr, jbdi, tr, ti;
+    lpfft_vec_t var, vai, vbr, vbi, vcr, vci, vdr, vdi;
+    lpfft_vec_t vw1r, vw1i, vw2r, vw2i, vw3r, vw3i;
+    lpfft_vec_t vapcr, vapci, vamcr, vamci, vbpdr, vbpdi, vjbdr, vjbdi, vtr, vti;
+    size_t m, p, q, i0, i1, i2, i3, o0, o1, o2, o3;
+
+    m = n / 4;
+    for(p=0; p < m; p++) {
+        /* exp(-2 pi i k p / n) is entry 2 k p s of the table */
+        w1r = fft->twre[2 * p * s];
+        w1i = sign * fft->twim[2 * p * s];
+        w2r = fft->twre[4 * p * s];
+        w2i = sign * fft->twim[4 * p * s];
+        w3r = fft->twre[6 * p * s];
+        w3i = sign * fft->twim[6 * p * s];
+
+        i0 = s * p;
+        i1 = s * (p + m);
+        i2 = s * (p + 2 * m);
+        i3 = s * (p + 3 * m);
+        o0 = s * 4 * p;
+        o1 = s * (4 * p + 1);
+        o2 = s * (4 * p + 2);
+        o3 = s * (4 * p + 3);
+
+        if(s >= LPFFT_LANES) {
+            vw1r = (lpfft_vec_t){0} + w1r; vw1i = (lpfft_vec_t){0} + w1i;
+            vw2r = (lpfft_vec_t){0} + w2r; vw2i = (lpfft_vec_t){0} + w2i;
+            vw3r = (lpfft_vec_t){0} + w3r; vw3i = (lpfft_vec_t){0} + w3i;
+
+            for(q=0; q < s; q += LPFFT_LANES) {
+                memcpy(&var, xre + q + i0, sizeof(lpfft_vec_t));
+                memcpy(&vai, xim + q + i0, sizeof(lpfft_vec_t));
+                memcpy(&vbr, xre + q + i1, sizeof(lpfft_vec_t));
+                memcpy(&vbi, xim + q + i1, sizeof(lpfft_vec_t));
+                memcpy(&vcr, xre + q + i2, sizeof(lpfft_vec_t));
+                memcpy(&vci, xim + q + i2, sizeof(lpfft_vec_t));
+                memcpy(&vdr, xre + q + i3, sizeof(lpfft_vec_t));
+                memcpy(&vdi, xim + q + i3, sizeof(lpfft_vec_t));
+
+                vapcr = var + vcr; vapci = vai + vci;
+                vamcr = var - vcr; vamci = vai - vci;
+                vbpdr = vbr + vdr; vbpdi = vbi + vdi;
+                /* -i * sign * (b - d) */
+                vjbdr = sign * (vbi - vdi);
+                vjbdi = sign * (vdr - vbr);
+
+                var = vapcr + vbpdr;
+                vai = vapci + vbpdi;
+                memcpy(yre + q + o0, &var, sizeof(lpfft_vec_t));
+                memcpy(yim + q + o0, &vai, sizeof(lpfft_vec_t));
+
+                vtr = vamcr + vjbdr; vti = vamci + vjbdi;
+                var = vtr * vw1r - vti * vw1i;
+                vai = vtr * vw1i + vti * vw1r;
+                memcpy(yre + q + o1, &var, sizeof(lpfft_vec_t));
+                memcpy(yim + q + o1, &vai, sizeof(lpfft_vec_t));
+
+                vtr = vapcr - vbpdr; vti = vapci - vbpdi;
+                var = vtr * vw2r - vti * vw2i;
+                vai = vtr * vw2i + vti * vw2r;
+                memcpy(yre + q + o2, &var, sizeof(lpfft_vec_t));
+                memcpy(yim + q + o2, &vai, sizeof(lpfft_vec_t));
+
+                vtr = vamcr - vjbdr; vti = vamci - vjbdi;
+                var = vtr * vw3r - vti * vw3i;
+                vai = vtr * vw3i + vti * vw3r;
+                memcpy(yre + q + o3, &var, sizeof(lpfft_vec_t));
+                memcpy(yim + q + o3, &vai, sizeof(lpfft_vec_t));
+            }
+        } else {
+            for(q=0; q < s; q++) {
+                ar = xre[q + i0]; ai = xim[q + i0];
+                br = xre[q + i1]; bi = xim[q + i1];
+                cr = xre[q + i2]; ci = xim[q + i2];
+                dr = xre[q + i3]; di = xim[q + i3];
+
+                apcr = ar + cr; apci = ai + ci;
+                amcr = ar - cr; amci = ai - ci;
+                bpdr = br + dr; bpdi = bi + di;
+                jbdr = sign * (bi - di);
+                jbdi = sign * (dr - br);
+
+                yre[q + o0] = apcr + bpdr;
+                yim[q + o0] = apci + bpdi;
+
+                tr = amcr + jbdr; ti = amci + jbdi;
+                yre[q + o1] = tr * w1r - ti * w1i;
+                yim[q + o1] = tr * w1i + ti * w1r;
+
+                tr = apcr - bpdr; ti = apci - bpdi;
+                yre[q + o2] = tr * w2r - ti * w2i;
+                yim[q + o2] = tr * w2i + ti * w2r;
+
+                tr = amcr - jbdr; ti = amci - jbdi;
+                yre[q + o3] = tr * w3r - ti * w3i;
+                yim[q + o3] = tr * w3i + ti * w3r;
+            }
+        }
+    }
+}
+
+/* The last pass when log2(n) is odd: n is 2, so there
+ * are no twiddles, just s butterflies. */
+static void fft_pass2(size_t s, lpfloat_t * xre, lpfloat_t * xim, lpfloat_t * yre, lpfloat_t * yim) {
+    lpfft_vec_t var, vai, vbr, vbi, vtr, vti;
+    size_t q;
+
+    if(s >= LPFFT_LANES) {
+        for(q=0; q < s; q += LPFFT_LANES) {
+            memcpy(&var, xre + q, sizeof(lpfft_vec_t));
+            memcpy(&vai, xim + q, sizeof(lpfft_vec_t));
+            memcpy(&vbr, xre + q + s, sizeof(lpfft_vec_t));
+            memcpy(&vbi, xim + q + s, sizeof(lpfft_vec_t));
+            vtr = var + vbr; vti = vai + vbi;
+            memcpy(yre + q, &vtr, sizeof(lpfft_vec_t));
+            memcpy(yim + q, &vti, sizeof(lpfft_vec_t));
+            vtr = var - vbr; vti = vai - vbi;
+            memcpy(yre + q + s, &vtr, sizeof(lpfft_vec_t));
+            memcpy(yim + q + s, &vti, sizeof(lpfft_vec_t));
+        }
+    } else {
+        for(q=0; q < s; q++) {
+            yre[q] = xre[q] + xre[q + s];
+            yim[q] = xim[q] + xim[q + s];
+            yre[q + s] = xre[q] - xre[q + s];
+            yim[q + s] = xim[q] - xim[q + s];
+        }
+    }
+}
+
+/* Complex FFT of length/2 points from (are, aim), using
+ * (bre, bim) as the other half of the ping pong. Returns
+ * the pair holding the result in (outre, outim). */
+static void fft_complex(lpfft_t * fft, lpfloat_t sign, lpfloat_t ** outre, lpfloat_t ** outim) {
+    lpfloat_t * xre, * xim, * yre, * yim, * tmp;
+    size_t n, s;
+
+    xre = fft->are; xim = fft->aim;
+    yre = fft->bre; yim = fft->bim;
+
+    for(n=fft->length / 2, s=1; n > 1; s *= (n == 2) ? 2 : 4, n /= (n == 2) ? 2 : 4) {
+        if(n == 2) {
+            fft_pass2(s, xre, xim, yre, yim);
+        } else {
+            fft_pass4(fft, n, s, sign, xre, xim, yre, yim);
+        }
+
+        tmp = xre; xre = yre; yre = tmp;
+        tmp = xim; xim = yim; yim = tmp;
+    }
+
+    *outre = xre;
+    *outim = xim;
+}
+
+/* The even samples go in the real part and the odd
+ * samples in the imaginary part of a half length
+ * complex FFT, then the two interleaved spectra are
+ * pulled apart and combined with one more butterfly. */
+void forward_fft(lpfft_t * fft, lpfloat_t * in, lpfloat_t * real, lpfloat_t * imag) {
+    lpfloat_t * zre, * zim;
+    lpfloat_t ar, ai, br, bi, er, ei, odr, odi, wr, wi, tr, ti;
+    size_t k, k1, k2, half;
+
+    half = fft->length / 2;
+
+    for(k=0; k < half; k++) {
+        fft->are[k] = in[2 * k];
+        fft->aim[k] = in[2 * k + 1];
+    }
+
+    fft_complex(fft, 1.f, &zre, &zim);
+
+    for(k=0; k <= half; k++) {
+        /* Z[k] and conj(Z[half-k]), wrapping at half */
+        k1 = (k == half) ? 0 : k;
+        k2 = (k == 0) ? 0 : half - k;
+        ar = zre[k1];
+        ai = zim[k1];
+        br = zre[k2];
+        bi = -zim[k2];
+
+        er = 0.5f * (ar + br);
+        ei = 0.5f * (ai + bi);
+        odr = 0.5f * (ar - br);
+        odi = 0.5f * (ai - bi);
+
+        if(k < half) {
+            wr = fft->twre[k];
+            wi = fft->twim[k];
+        } else {
+            wr = -1.f;
+            wi = 0.f;
+        }
+
+        /* X[k] = even - i * W^k * odd */
+        tr = odr * wr - odi * wi;
+        ti = odr * wi + odi * wr;
+        real[k] = er + ti;
+        imag[k] = ei - tr;
+    }
+}
+
+void inverse_fft(lpfft_t * fft, lpfloat_t * real, lpfloat_t * imag, lpfloat_t * out) {
+    lpfloat_t * zre, * zim;
+    lpfloat_t ar, ai, br, bi, er, ei, dr, di, odr, odi, wr, wi, scale;
+    size_t k, half;
+
+    half = fft->length / 2;
+
+    for(k=0; k < half; k++) {
+        ar = real[k];
+        ai = (k == 0) ? 0.f : imag[k];
+        br = real[half - k];
+        bi = (k == 0) ? 0.f : -imag[half - k];
+
+        er = 0.5f * (ar + br);
+        ei = 0.5f * (ai + bi);
+        dr = 0.5f * (ar - br);
+        di = 0.5f * (ai - bi);
+
+        /* odd = (X[k] - conj(X[half-k])) / 2 * conj(W^k) */
+        wr = fft->twre[k];
+        wi = fft->twim[k];
+        odr = dr * wr + di * wi;
+        odi = di * wr - dr * wi;
+
+        /* Z[k] = even + i * odd */
+        fft->are[k] = er - odi;
+        fft->aim[k] = ei + odr;
+    }
+
+    fft_complex(fft, -1.f, &zre, &zim);
+
+    scale = 1.f / half;
+    for(k=0; k < half; k++) {
+        out[2 * k] = zre[k] * scale;
+        out[2 * k + 1] = zim[k] * scale;
+    }
+}
+
+void destroy_fft(lpfft_t * fft) {
+    if(fft == NULL) return;
+    LPMemoryPool.free(fft->twre);
+    LPMemoryPool.free(fft->twim);
+    LPMemoryPool.free(fft->are);
+    LPMemoryPool.free(fft->aim);
+    LPMemoryPool.free(fft->bre);
+    LPMemoryPool.free(fft->bim);
+    LPMemoryPool.free(fft);
+}
+
+/* Linear convolution of every channel of src with the
+ * matching channel of impulse (or its only channel,
+ * if it is mono), normalized to the peak of src. */
 lpbuffer_t * convolve_spectral(lpbuffer_t * src, lpbuffer_t * impulse) {
-    size_t length, i;
-    int c;
-    lpfloat_t mag;
+    size_t length, fftlength, numbins, i, k;
+    int c, ic;
+    lpfloat_t mag, re, im;
+    lpfloat_t * block, * srcre, * srcim, * irre, * irim;
     lpbuffer_t * out;
-    lpbuffer_t * outa;
-    lpbuffer_t * outb;
-    lpbuffer_t * srca;
-    lpbuffer_t * srcb;
-    lpbuffer_t * impulsea;
-    lpbuffer_t * impulseb;
+    lpfft_t * fft;
 
-    assert(src->channels == 1 || src->channels == 2);
-    assert(impulse->channels == 1 || impulse->channels == 2);
-    assert(impulse->channels == src->channels);
+    assert(impulse->channels == src->channels || impulse->channels == 1);
 
     length = src->length + impulse->length + 1;
     out = LPBuffer.create(length, src->channels, src->samplerate);
 
     mag = LPBuffer.mag(src);
 
-    if(src->channels == 2) {
-        outa = LPBuffer.create(length, src->channels, src->samplerate);
-        outb = LPBuffer.create(length, src->channels, src->samplerate);
-
-        srca = LPBuffer.create(src->length, 1, src->samplerate);
-        srcb = LPBuffer.create(src->length, 1, src->samplerate);
-        LPBuffer.split2(src, srca, srcb);
+    fftlength = LPFFT.size(src->length + impulse->length - 1);
+    numbins = fftlength / 2 + 1;
+    fft = LPFFT.create(fftlength);
 
-        impulsea = LPBuffer.create(impulse->length, 1, src->samplerate);
-        impulseb = LPBuffer.create(impulse->length, 1, src->samplerate);
-        LPBuffer.split2(impulse, impulsea, impulseb);
+    block = (lpfloat_t *)LPMemoryPool.alloc(fftlength, sizeof(lpfloat_t));
+    srcre = (lpfloat_t *)LPMemoryPool.alloc(numbins, sizeof(lpfloat_t));
+    srcim = (lpfloat_t *)LPMemoryPool.alloc(numbins, sizeof(lpfloat_t));
+    irre = (lpfloat_t *)LPMemoryPool.alloc(numbins, sizeof(lpfloat_t));
+    irim = (lpfloat_t *)LPMemoryPool.alloc(numbins, sizeof(lpfloat_t));
 
-        Fft_convolveReal(srca->data, impulsea->data, outa->data, length);
-        Fft_convolveReal(srcb->data, impulseb->data, outb->data, length);
+    for(c=0; c < src->channels; c++) {
+        ic = (impulse->channels == 1) ? 0 : c;
 
-        for(i=0; i < length; i++) {
-            for(c=0; c < out->channels; c++) {
-                out->data[i * out->channels] = outa->data[i];
-                out->data[i * out->channels + 1] = outb->data[i];
+        /* The impulse spectrum is shared by every channel of a mono impulse */
+        if(c == 0 || impulse->channels > 1) {
+            memset(block, 0, sizeof(lpfloat_t) * fftlength);
+            for(i=0; i < impulse->length; i++) {
+                block[i] = impulse->data[i * impulse->channels + ic];
             }
+            LPFFT.forward(fft, block, irre, irim);
         }
 
-        LPBuffer.destroy(outa);
-        LPBuffer.destroy(outb);
-        LPBuffer.destroy(srca);
-        LPBuffer.destroy(srcb);
-        LPBuffer.destroy(impulsea);
-        LPBuffer.destroy(impulseb);
-    } else {
-        Fft_convolveReal(src->data, impulse->data, out->data, length);
+        memset(block, 0, sizeof(lpfloat_t) * fftlength);
+        for(i=0; i < src->length; i++) {
+            block[i] = src->data[i * src->channels + c];
+        }
+        LPFFT.forward(fft, block, srcre, srcim);
+
+        for(k=0; k < numbins; k++) {
+            re = srcre[k] * irre[k] - srcim[k] * irim[k];
+            im = srcre[k] * irim[k] + srcim[k] * irre[k];
+            srcre[k] = re;
+            srcim[k] = im;
+        }
+
+        LPFFT.inverse(fft, srcre, srcim, block);
+
+        for(i=0; i < length && i < fftlength; i++) {
+            out->data[i * out->channels + c] = block[i];
+        }
     }
 
+    LPMemoryPool.free(block);
+    LPMemoryPool.free(srcre);
+    LPMemoryPool.free(srcim);
+    LPMemoryPool.free(irre);
+    LPMemoryPool.free(irim);
+    LPFFT.destroy(fft);
+
     LPFX.norm(out, mag);
 
     return out;
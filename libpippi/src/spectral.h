@@ -2,12 +2,55 @@
 #define LP_SPECTRAL_H
 
 #include "pippicore.h"
-#include "fft/fft.h"
+
+/* Butterflies are computed this many at a time */
+#define LPFFT_LANES 4
+
+/* A planned real FFT.
+ *
+ * Plans are for a fixed power of two length and own
+ * their twiddle table and scratch space, so once a
+ * plan is created forward and inverse never allocate
+ * and never call cos or sin. Reuse one plan for every
+ * transform of its size. A plan may only be used by
+ * one thread at a time.
+ *
+ * forward takes length real samples and writes the
+ * length/2+1 non-negative frequency bins as separate
+ * real and imaginary arrays. It is unnormalized.
+ *
+ * inverse takes the same length/2+1 bins (the imaginary
+ * parts of the DC and nyquist bins are ignored) and
+ * writes length real samples, scaled by 1/length so a
+ * forward/inverse round trip returns the input.
+ *
+ * Internally the real input is packed into a complex
+ * FFT of half the length, which is a radix-4 Stockham
+ * (autosort) FFT on split real/imaginary arrays.
+ */
+typedef struct lpfft_t {
+    size_t length;
+    lpfloat_t * twre;
+    lpfloat_t * twim;
+    lpfloat_t * are;
+    lpfloat_t * aim;
+    lpfloat_t * bre;
+    lpfloat_t * bim;
+} lpfft_t;
+
+typedef struct lpfft_factory_t {
+    lpfft_t * (*create)(size_t length);
+    size_t (*size)(size_t minlength);
+    void (*forward)(lpfft_t *, lpfloat_t * in, lpfloat_t * real, lpfloat_t * imag);
+    void (*inverse)(lpfft_t *, lpfloat_t * real, lpfloat_t * imag, lpfloat_t * out);
+    void (*destroy)(lpfft_t *);
+} lpfft_factory_t;
 
 typedef struct lpspectral_factory_t {
     lpbuffer_t * (*convolve)(lpbuffer_t *, lpbuffer_t *);
 } lpspectral_factory_t;
 
+extern const lpfft_factory_t LPFFT;
 extern const lpspectral_factory_t LPSpectral;
 
 #endif
@@ -0,0 +1,354 @@
+#include "ugens.graph.h"
+
+lpugengraph_t * create_ugengraph(size_t blocksize);
+int add_node_ugengraph(lpugengraph_t * graph, ugen_t * u);
+int connect_ugengraph(lpugengraph_t * graph, int source, int output, int dest, int input, lpfloat_t mult, lpfloat_t add, int rate);
+int compile_ugengraph(lpugengraph_t * graph);
+lpfloat_t * process_ugengraph(lpugengraph_t * graph, size_t nframes);
+int render_ugengraph(lpugengraph_t * graph, lpfloat_t * out, size_t nframes, int channels);
+void destroy_ugengraph(lpugengraph_t * graph);
+
+const lpugengraph_factory_t LPUgenGraph = { create_ugengraph, add_node_ugengraph, connect_ugengraph, compile_ugengraph, process_ugengraph, render_ugengraph, destroy_ugengraph };
+
+/* Double the capacity of an array of items */
+static void * ugengraph_grow(void * items, int count, int * capacity, size_t itemsize) {
+    void * grown;
+
+    *capacity = (*capacity > 0) ? *capacity * 2 : 8;
+    grown = LPMemoryPool.alloc(*capacity, itemsize);
+    if(items != NULL) {
+        memcpy(grown, items, itemsize * count);
+        LPMemoryPool.free(items);
+    }
+
+    return grown;
+}
+
+/* Free the blocks and connection lists compile made */
+static void ugengraph_release(lpugengraph_t * graph) {
+    lpugennode_t * node;
+    int n, p;
+
+    for(n=0; n < graph->numnodes; n++) {
+        node = &graph->nodes[n];
+        if(node->outputs != NULL) {
+            for(p=0; p < node->u->num_outputs; p++) LPMemoryPool.free(node->outputs[p]);
+            LPMemoryPool.free(node->outputs);
+        }
+        if(node->inputs != NULL) LPMemoryPool.free(node->inputs);
+        if(node->inputblocks != NULL) LPMemoryPool.free(node->inputblocks);
+        if(node->blockvalues != NULL) LPMemoryPool.free(node->blockvalues);
+        if(node->incoming != NULL) LPMemoryPool.free(node->incoming);
+
+        node->outputs = NULL;
+        node->inputs = NULL;
+        node->inputblocks = NULL;
+        node->blockvalues = NULL;
+        node->incoming = NULL;
+        node->numincoming = 0;
+    }
+
+    if(graph->order != NULL) LPMemoryPool.free(graph->order);
+    if(graph->mix != NULL) LPMemoryPool.free(graph->mix);
+    graph->order = NULL;
+    graph->mix = NULL;
+    graph->compiled = 0;
+}
+
+lpugengraph_t * create_ugengraph(size_t blocksize) {
+    lpugengraph_t * graph;
+
+    graph = (lpugengraph_t *)LPMemoryPool.alloc(1, sizeof(lpugengraph_t));
+    graph->blocksize = (blocksize > 0) ? blocksize : LPUGENGRAPH_BLOCKSIZE;
+    graph->nodes = NULL;
+    graph->numnodes = 0;
+    graph->maxnodes = 0;
+    graph->connections = NULL;
+    graph->numconnections = 0;
+    graph->maxconnections = 0;
+    graph->order = NULL;
+    graph->mix = NULL;
+    graph->compiled = 0;
+
+    return graph;
+}
+
+/* Returns the index of the new node */
+int add_node_ugengraph(lpugengraph_t * graph, ugen_t * u) {
+    lpugennode_t * node;
+
+    if(u == NULL || u->num_outputs <= 0) {
+        fprintf(stderr, "LPUgenGraph: ugen has no outputs\n");
+        return -1;
+    }
+
+    ugengraph_release(graph);
+    if(graph->numnodes >= graph->maxnodes) {
+        graph->nodes = (lpugennode_t *)ugengraph_grow(graph->nodes, graph->numnodes, &graph->maxnodes, sizeof(lpugennode_t));
+    }
+
+    node = &graph->nodes[graph->numnodes];
+    memset(node, 0, sizeof(lpugennode_t));
+    node->u = u;
+
+    return graph->numnodes++;
+}
+
+int connect_ugengraph(lpugengraph_t * graph, int source, int output, int dest, int input, lpfloat_t mult, lpfloat_t add, int rate) {
+    lpugenconnection_t * c;
+
+    if(source < 0 || source >= graph->numnodes || output < 0 || output >= graph->nodes[source].u->num_outputs) {
+        fprintf(stderr, "LPUgenGraph: no output %d on node %d\n", output, source);
+        return -1;
+    }
+
+    if(dest != LPUGENGRAPH_OUTPUT && (dest < 0 || dest >= graph->numnodes || input < 0 || input >= graph->nodes[dest].u->num_inputs)) {
+        fprintf(stderr, "LPUgenGraph: no input %d on node %d\n", input, dest);
+        return -1;
+    }
+
+    if(rate < 0 || rate >= NUM_LPUGENGRAPH_RATES) {
+        fprintf(stderr, "LPUgenGraph: invalid rate %d\n", rate);
+        return -1;
+    }
+
+    ugengraph_release(graph);
+    if(graph->numconnections >= graph->maxconnections) {
+        graph->connections = (lpugenconnection_t *)ugengraph_grow(graph->connections, graph->numconnections, &graph->maxconnections, sizeof(lpugenconnection_t));
+    }
+
+    c = &graph->connections[graph->numconnections++];
+    c->source = source;
+    c->output = output;
+    c->dest = dest;
+    c->input = input;
+    c->mult = mult;
+    c->add = add;
+    c->rate = rate;
+
+    return 0;
+}
+
+/* Sort the nodes so every node comes after the ones
+ * connected to it, in the order they were added where
+ * that is free, and allocate the blocks. When the rest
+ * of the nodes all wait on each other the first one
+ * added goes next anyway: the connections into it from
+ * nodes not run yet become feedback, and read what
+ * their source wrote the block before. */
+int compile_ugengraph(lpugengraph_t * graph) {
+    lpugennode_t * node;
+    lpugenconnection_t * c;
+    int * pending, * ready, * placed;
+    int i, n, p, head, tail, next;
+
+    ugengraph_release(graph);
+
+    pending = (int *)LPMemoryPool.alloc(graph->numnodes + 1, sizeof(int));
+    ready = (int *)LPMemoryPool.alloc(graph->numnodes + 1, sizeof(int));
+    placed = (int *)LPMemoryPool.alloc(graph->numnodes + 1, sizeof(int));
+    graph->order = (int *)LPMemoryPool.alloc(graph->numnodes + 1, sizeof(int));
+
+    /* A node feeding itself always reads its last block */
+    for(i=0; i < graph->numconnections; i++) {
+        c = &graph->connections[i];
+        if(c->dest == LPUGENGRAPH_OUTPUT) continue;
+        graph->nodes[c->dest].numincoming += 1;
+        if(c->dest != c->source) pending[c->dest] += 1;
+    }
+
+    /* Kahn's algorithm, taking ready nodes in index order */
+    head = tail = 0;
+    for(n=0; n < graph->numnodes; n++) {
+        if(pending[n] == 0) ready[tail++] = n;
+    }
+
+    i = 0;
+    next = 0;
+    while(i < graph->numnodes) {
+        if(head == tail) {
+            /* Only cycles left: break one at the first node */
+            while(placed[next]) next++;
+            ready[tail++] = next;
+        }
+
+        n = ready[head++];
+        if(placed[n]) continue;
+        placed[n] = 1;
+        graph->order[i++] = n;
+        for(p=0; p < graph->numconnections; p++) {
+            c = &graph->connections[p];
+            if(c->source != n || c->dest == LPUGENGRAPH_OUTPUT || placed[c->dest]) continue;
+            if(--pending[c->dest] == 0) ready[tail++] = c->dest;
+        }
+    }
+
+    LPMemoryPool.free(pending);
+    LPMemoryPool.free(ready);
+    LPMemoryPool.free(placed);
+
+    for(n=0; n < graph->numnodes; n++) {
+        node = &graph->nodes[n];
+        node->outputs = (lpfloat_t **)LPMemoryPool.alloc(node->u->num_outputs, sizeof(lpfloat_t *));
+        for(p=0; p < node->u->num_outputs; p++) {
+            node->outputs[p] = (lpfloat_t *)LPMemoryPool.alloc(graph->blocksize, sizeof(lpfloat_t));
+        }
+
+        node->inputs = (lpfloat_t **)LPMemoryPool.alloc(node->u->num_inputs + 1, sizeof(lpfloat_t *));
+        node->inputblocks = (lpfloat_t *)LPMemoryPool.alloc(graph->blocksize * (node->u->num_inputs + 1), sizeof(lpfloat_t));
+        node->blockvalues = (lpfloat_t *)LPMemoryPool.alloc(node->u->num_inputs + 1, sizeof(lpfloat_t));
+        node->incoming = (int *)LPMemoryPool.alloc(node->numincoming + 1, sizeof(int));
+        node->numincoming = 0;
+    }
+
+    for(i=0; i < graph->numconnections; i++) {
+        c = &graph->connections[i];
+        if(c->dest == LPUGENGRAPH_OUTPUT) continue;
+        node = &graph->nodes[c->dest];
+        node->incoming[node->numincoming++] = i;
+    }
+
+    graph->mix = (lpfloat_t *)LPMemoryPool.alloc(graph->blocksize, sizeof(lpfloat_t));
+    graph->compiled = 1;
+
+    return 0;
+}
+
+/* Fill in the inputs of a node from the blocks of the
+ * nodes feeding it. Block rate inputs are summed and
+ * set once, sample rate inputs are summed into a block
+ * of their own. */
+static void ugengraph_gather(lpugengraph_t * graph, lpugennode_t * node, size_t nframes) {
+    lpugenconnection_t * c;
+    lpfloat_t * src, * block;
+    int i, input, isset;
+    size_t f;
+
+    for(i=0; i < node->u->num_inputs; i++) node->inputs[i] = NULL;
+
+    for(i=0; i < node->numincoming; i++) {
+        c = &graph->connections[node->incoming[i]];
+        if(c->rate == LPUGENGRAPH_RATE_BLOCK) continue;
+
+        src = graph->nodes[c->source].outputs[c->output];
+        input = c->input;
+        block = node->inputblocks + input * graph->blocksize;
+        if(node->inputs[input] == NULL) {
+            for(f=0; f < nframes; f++) block[f] = src[f] * c->mult + c->add;
+            node->inputs[input] = block;
+        } else {
+            for(f=0; f < nframes; f++) block[f] += src[f] * c->mult + c->add;
+        }
+    }
+
+    /* An input with both kinds of connection gets the 
+     * block value added to its block */
+    for(input=0; input < node->u->num_inputs; input++) {
+        isset = 0;
+        for(i=0; i < node->numincoming; i++) {
+            c = &graph->connections[node->incoming[i]];
+            if(c->rate != LPUGENGRAPH_RATE_BLOCK || c->input != input) continue;
+            src = graph->nodes[c->source].outputs[c->output];
+            if(!isset) node->blockvalues[input] = 0;
+            node->blockvalues[input] += src[0] * c->mult + c->add;
+            isset = 1;
+        }
+
+        if(!isset) continue;
+        if(node->inputs[input] != NULL) {
+            block = node->inputs[input];
+            for(f=0; f < nframes; f++) block[f] += node->blockvalues[input];
+        } else {
+            node->u->set_param(node->u, input, (void *)&node->blockvalues[input]);
+        }
+    }
+}
+
+/* Run a ugen with no block form a frame at a time */
+static void ugengraph_run_frames(lpugennode_t * node, size_t nframes) {
+    ugen_t * u = node->u;
+    lpfloat_t value;
+    size_t f;
+    int i, p;
+
+    for(f=0; f < nframes; f++) {
+        for(i=0; i < u->num_inputs; i++) {
+            if(node->inputs[i] == NULL) continue;
+            value = node->inputs[i][f];
+            u->set_param(u, i, (void *)&value);
+        }
+
+        u->process(u);
+
+        for(p=0; p < u->num_outputs; p++) {
+            node->outputs[p][f] = u->get_output(u, p);
+        }
+    }
+}
+
+/* Run one block of up to blocksize frames and return
+ * the mix of everything connected to the output */
+lpfloat_t * process_ugengraph(lpugengraph_t * graph, size_t nframes) {
+    lpugennode_t * node;
+    lpugenconnection_t * c;
+    lpfloat_t * src;
+    size_t f;
+    int i;
+
+    if(!graph->compiled && compile_ugengraph(graph) < 0) return NULL;
+    assert(nframes <= graph->blocksize);
+
+    for(i=0; i < graph->numnodes; i++) {
+        node = &graph->nodes[graph->order[i]];
+        ugengraph_gather(graph, node, nframes);
+
+        if(node->u->process_block != NULL) {
+            node->u->process_block(node->u, node->inputs, node->outputs, nframes);
+        } else {
+            ugengraph_run_frames(node, nframes);
+        }
+    }
+
+    memset(graph->mix, 0, sizeof(lpfloat_t) * graph->blocksize);
+    for(i=0; i < graph->numconnections; i++) {
+        c = &graph->connections[i];
+        if(c->dest != LPUGENGRAPH_OUTPUT) continue;
+        src = graph->nodes[c->source].outputs[c->output];
+        for(f=0; f < nframes; f++) graph->mix[f] += src[f] * c->mult + c->add;
+    }
+
+    return graph->mix;
+}
+
+int render_ugengraph(lpugengraph_t * graph, lpfloat_t * out, size_t nframes, int channels) {
+    lpfloat_t * mix;
+    size_t pos, n, f;
+    int c;
+
+    for(pos=0; pos < nframes; pos += n) {
+        n = nframes - pos;
+        if(n > graph->blocksize) n = graph->blocksize;
+        if((mix = process_ugengraph(graph, n)) == NULL) return -1;
+
+        for(f=0; f < n; f++) {
+            for(c=0; c < channels; c++) {
+                out[(pos + f) * channels + c] = mix[f];
+            }
+        }
+    }
+
+    return 0;
+}
+
+void destroy_ugengraph(lpugengraph_t * graph) {
+    int n;
+
+    ugengraph_release(graph);
+    for(n=0; n < graph->numnodes; n++) {
+        graph->nodes[n].u->destroy(graph->nodes[n].u);
+    }
+
+    if(graph->nodes != NULL) LPMemoryPool.free(graph->nodes);
+    if(graph->connections != NULL) LPMemoryPool.free(graph->connections);
+    LPMemoryPool.free(graph);
+}
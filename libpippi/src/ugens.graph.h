@@ -0,0 +1,89 @@
+#ifndef LP_UGEN_GRAPH_H
+#define LP_UGEN_GRAPH_H
+
+#include "pippicore.h"
+
+/* Frames processed per pass through the graph */
+#define LPUGENGRAPH_BLOCKSIZE 256
+
+/* The node index to connect to for the graph's output */
+#define LPUGENGRAPH_OUTPUT -1
+
+enum LPUGENGRAPH_RATES {
+    LPUGENGRAPH_RATE_SAMPLE, /* the input follows the output frame by frame */
+    LPUGENGRAPH_RATE_BLOCK,  /* the input is set once a block, from its first frame */
+    NUM_LPUGENGRAPH_RATES
+};
+
+/* The value of output on node source, times mult plus
+ * add, goes to input on node dest. Connections to the
+ * same input are summed. */
+typedef struct lpugenconnection_t {
+    int source;
+    int output;
+    int dest;
+    int input;
+    int rate;
+    lpfloat_t mult;
+    lpfloat_t add;
+} lpugenconnection_t;
+
+typedef struct lpugennode_t {
+    ugen_t * u;
+
+    /* A block per output port, and a block per input
+     * for sample rate connections, which is in inputs
+     * on the blocks it has any */
+    lpfloat_t ** outputs;
+    lpfloat_t ** inputs;
+    lpfloat_t * inputblocks;
+    lpfloat_t * blockvalues;
+
+    /* The connections into this node, set by compile */
+    int * incoming;
+    int numincoming;
+} lpugennode_t;
+
+/* A graph of ugens run a block at a time.
+ *
+ * Nodes and connections are added, then compile sorts
+ * the nodes so each one runs after everything feeding
+ * it and allocates the blocks. Where connections loop
+ * back the loop is cut at the first node added, which
+ * reads the block its sources wrote last time round: a
+ * feedback delay of one block. Adding to the graph after
+ * that means compiling again. process runs one block and
+ * returns the mono mix of the connections to the output;
+ * render runs as many blocks as it takes to fill an
+ * interleaved buffer, with the mix on every channel.
+ *
+ * The graph owns its ugens and destroys them with it. */
+typedef struct lpugengraph_t {
+    lpugennode_t * nodes;
+    int numnodes;
+    int maxnodes;
+
+    lpugenconnection_t * connections;
+    int numconnections;
+    int maxconnections;
+
+    int * order;
+    int compiled;
+
+    size_t blocksize;
+    lpfloat_t * mix;
+} lpugengraph_t;
+
+typedef struct lpugengraph_factory_t {
+    lpugengraph_t * (*create)(size_t blocksize);
+    int (*add_node)(lpugengraph_t * graph, ugen_t * u);
+    int (*connect)(lpugengraph_t * graph, int source, int output, int dest, int input, lpfloat_t mult, lpfloat_t add, int rate);
+    int (*compile)(lpugengraph_t * graph);
+    lpfloat_t * (*process)(lpugengraph_t * graph, size_t nframes);
+    int (*render)(lpugengraph_t * graph, lpfloat_t * out, size_t nframes, int channels);
+    void (*destroy)(lpugengraph_t * graph);
+} lpugengraph_factory_t;
+
+extern const lpugengraph_factory_t LPUgenGraph;
+
+#endif
@@ -17,9 +17,9 @@ void process_pulsar_ugen(ugen_t * u) {
 void destroy_pulsar_ugen(ugen_t * u) {
     lpugenpulsar_t * params;
     params = (lpugenpulsar_t *)u->params;
-    free(params->osc);
-    free(params);
-    free(u);
+    LPPulsarOsc.destroy(params->osc);
+    LPMemoryPool.free(params);
+    LPMemoryPool.free(u);
 }
 
 void set_pulsar_ugen_param(ugen_t * u, int index, void * value) {
@@ -147,6 +147,9 @@ ugen_t * create_pulsar_ugen(void) {
     u->destroy = destroy_pulsar_ugen;
     u->get_output = get_pulsar_ugen_output;
     u->set_param = set_pulsar_ugen_param;
+    u->process_block = NULL;
+    u->num_inputs = UPULSAR_NUMINPUTS;
+    u->num_outputs = UPULSAR_NUMOUTPUTS;
 
     return u;
 }
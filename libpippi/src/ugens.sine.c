@@ -11,12 +11,34 @@ void process_sine_ugen(ugen_t * u) {
     params->outputs[USINEOUT_PHASE] = params->osc->phase;
 }
 
+void process_block_sine_ugen(ugen_t * u, lpfloat_t ** inputs, lpfloat_t ** outputs, size_t nframes) {
+    lpugensine_t * params;
+    lpsineosc_t * osc;
+    size_t i;
+
+    params = (lpugensine_t *)u->params;
+    osc = params->osc;
+    for(i=0; i < nframes; i++) {
+        if(inputs[USINEIN_FREQ] != NULL) osc->freq = inputs[USINEIN_FREQ][i];
+        if(inputs[USINEIN_PHASE] != NULL) osc->phase = inputs[USINEIN_PHASE][i];
+        outputs[USINEOUT_MAIN][i] = LPSineOsc.process(osc);
+        outputs[USINEOUT_FREQ][i] = osc->freq;
+        outputs[USINEOUT_PHASE][i] = osc->phase;
+    }
+
+    if(nframes > 0) {
+        params->outputs[USINEOUT_MAIN] = outputs[USINEOUT_MAIN][nframes-1];
+        params->outputs[USINEOUT_FREQ] = osc->freq;
+        params->outputs[USINEOUT_PHASE] = osc->phase;
+    }
+}
+
 void destroy_sine_ugen(ugen_t * u) {
     lpugensine_t * params;
     params = (lpugensine_t *)u->params;
-    free(params->osc);
-    free(params);
-    free(u);
+    LPMemoryPool.free(params->osc);
+    LPMemoryPool.free(params);
+    LPMemoryPool.free(u);
 }
 
 void set_sine_ugen_param(ugen_t * u, int index, void * value) {
@@ -47,6 +69,9 @@ ugen_t * create_sine_ugen(void) {
     u->destroy = destroy_sine_ugen;
     u->get_output = get_sine_ugen_output;
     u->set_param = set_sine_ugen_param;
+    u->process_block = process_block_sine_ugen;
+    u->num_inputs = USINE_NUMINPUTS;
+    u->num_outputs = USINE_NUMOUTPUTS;
 
     return u;
 }
@@ -8,18 +8,20 @@
 
 enum UgenSineParams {
     USINEIN_FREQ,
-    USINEIN_PHASE
+    USINEIN_PHASE,
+    USINE_NUMINPUTS
 };
 
 enum UgenSineOutputs {
     USINEOUT_MAIN,
     USINEOUT_FREQ,
-    USINEOUT_PHASE
+    USINEOUT_PHASE,
+    USINE_NUMOUTPUTS
 };
 
 typedef struct lpugensine_t {
     lpsineosc_t * osc;
-    lpfloat_t outputs[3];
+    lpfloat_t outputs[USINE_NUMOUTPUTS];
 } lpugensine_t;
 
 
@@ -16,13 +16,36 @@ void process_tape_ugen(ugen_t * u) {
     params->outputs[UTAPEOUT_PHASE] = params->osc->phase;
 }
 
+void process_block_tape_ugen(ugen_t * u, lpfloat_t ** inputs, lpfloat_t ** outputs, size_t nframes) {
+    lpugentape_t * params;
+    lptapeosc_t * osc;
+    size_t i;
+
+    params = (lpugentape_t *)u->params;
+    osc = params->osc;
+    for(i=0; i < nframes; i++) {
+        if(inputs[UTAPEIN_SPEED] != NULL) osc->speed = inputs[UTAPEIN_SPEED][i];
+        if(inputs[UTAPEIN_PHASE] != NULL) osc->phase = inputs[UTAPEIN_PHASE][i];
+        LPTapeOsc.process(osc);
+        outputs[UTAPEOUT_MAIN][i] = osc->current_frame->data[0];
+        outputs[UTAPEOUT_SPEED][i] = osc->speed;
+        outputs[UTAPEOUT_PHASE][i] = osc->phase;
+    }
+
+    if(nframes > 0) {
+        params->outputs[UTAPEOUT_MAIN] = outputs[UTAPEOUT_MAIN][nframes-1];
+        params->outputs[UTAPEOUT_SPEED] = osc->speed;
+        params->outputs[UTAPEOUT_PHASE] = osc->phase;
+    }
+}
+
 void destroy_tape_ugen(ugen_t * u) {
     lpugentape_t * params;
     params = (lpugentape_t *)u->params;
-    free(params->osc->current_frame);
-    free(params->osc);
-    free(params);
-    free(u);
+    LPBuffer.destroy(params->osc->current_frame);
+    LPMemoryPool.free(params->osc);
+    LPMemoryPool.free(params);
+    LPMemoryPool.free(u);
 }
 
 void set_tape_ugen_param(ugen_t * u, int index, void * value) {
@@ -48,7 +71,7 @@ void set_tape_ugen_param(ugen_t * u, int index, void * value) {
             params->osc->buf = buf;
             params->osc->samplerate = buf->samplerate;
             if(params->osc->current_frame != NULL) {
-                free(params->osc->current_frame);
+                LPBuffer.destroy(params->osc->current_frame);
                 params->osc->current_frame = LPBuffer.create(1, buf->channels, buf->samplerate);
             }
             params->osc->range = buf->length-1;
@@ -79,6 +102,9 @@ ugen_t * create_tape_ugen(void) {
     u->destroy = destroy_tape_ugen;
     u->get_output = get_tape_ugen_output;
     u->set_param = set_tape_ugen_param;
+    u->process_block = process_block_tape_ugen;
+    u->num_inputs = UTAPE_NUMINPUTS;
+    u->num_outputs = UTAPE_NUMOUTPUTS;
 
     return u;
 }
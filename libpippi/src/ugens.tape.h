@@ -9,18 +9,20 @@
 enum UgenTapeParams {
     UTAPEIN_SPEED,
     UTAPEIN_PHASE,
-    UTAPEIN_BUF
+    UTAPEIN_BUF,
+    UTAPE_NUMINPUTS
 };
 
 enum UgenTapeOutputs {
     UTAPEOUT_MAIN,
     UTAPEOUT_SPEED,
-    UTAPEOUT_PHASE
+    UTAPEOUT_PHASE,
+    UTAPE_NUMOUTPUTS
 };
 
 typedef struct lpugentape_t {
     lptapeosc_t * osc;
-    lpfloat_t outputs[3];
+    lpfloat_t outputs[UTAPE_NUMOUTPUTS];
 } lpugentape_t;
 
 ugen_t * create_tape_ugen(void);
@@ -10,11 +10,34 @@ void process_mult_ugen(ugen_t * u) {
     params->outputs[UMULTOUT_B] = params->b;
 }
 
+void process_block_mult_ugen(ugen_t * u, lpfloat_t ** inputs, lpfloat_t ** outputs, size_t nframes) {
+    lpugenmult_t * params;
+    size_t i;
+
+    params = (lpugenmult_t *)u->params;
+    for(i=0; i < nframes; i++) {
+        outputs[UMULTOUT_A][i] = (inputs[UMULTIN_A] != NULL) ? inputs[UMULTIN_A][i] : params->a;
+        outputs[UMULTOUT_B][i] = (inputs[UMULTIN_B] != NULL) ? inputs[UMULTIN_B][i] : params->b;
+    }
+
+    for(i=0; i < nframes; i++) {
+        outputs[UMULTOUT_MAIN][i] = outputs[UMULTOUT_A][i] * outputs[UMULTOUT_B][i];
+    }
+
+    if(nframes > 0) {
+        params->a = outputs[UMULTOUT_A][nframes-1];
+        params->b = outputs[UMULTOUT_B][nframes-1];
+        params->outputs[UMULTOUT_MAIN] = outputs[UMULTOUT_MAIN][nframes-1];
+        params->outputs[UMULTOUT_A] = params->a;
+        params->outputs[UMULTOUT_B] = params->b;
+    }
+}
+
 void destroy_mult_ugen(ugen_t * u) {
     lpugenmult_t * params;
     params = (lpugenmult_t *)u->params;
-    free(params);
-    free(u);
+    LPMemoryPool.free(params);
+    LPMemoryPool.free(u);
 }
 
 void set_mult_ugen_param(ugen_t * u, int index, void * value) {
@@ -46,6 +69,9 @@ ugen_t * create_mult_ugen(void) {
     u->destroy = destroy_mult_ugen;
     u->get_output = get_mult_ugen_output;
     u->set_param = set_mult_ugen_param;
+    u->process_block = process_block_mult_ugen;
+    u->num_inputs = UMULT_NUMINPUTS;
+    u->num_outputs = UMULT_NUMOUTPUTS;
 
     return u;
 }
@@ -6,19 +6,21 @@
 
 enum UgenUtilsParams {
     UMULTIN_A,
-    UMULTIN_B
+    UMULTIN_B,
+    UMULT_NUMINPUTS
 };
 
 enum UgenUtilsOutputs {
     UMULTOUT_MAIN,
     UMULTOUT_A,
-    UMULTOUT_B
+    UMULTOUT_B,
+    UMULT_NUMOUTPUTS
 };
 
 typedef struct lpugenmult_t {
     lpfloat_t a;
     lpfloat_t b;
-    lpfloat_t outputs[3];
+    lpfloat_t outputs[UMULT_NUMOUTPUTS];
 } lpugenmult_t;
 
 ugen_t * create_mult_ugen(void);
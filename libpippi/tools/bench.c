@@ -0,0 +1,656 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "pippi.h"
+#include "ugens.sine.h"
+#include "ugens.utils.h"
+
+#define BENCH_SR 48000
+#define BENCH_CHANNELS 2
+#define BENCH_BLOCKSIZE 256
+#define BENCH_FRAMES 48000
+#define BENCH_REPS 20
+#define BENCH_WARMUP 3
+#define BENCH_MAXEVENTS 4096
+
+/* Micro benchmarks for the block processors.
+ *
+ * Every bench processes the same number of frames per
+ * rep, a block at a time where the processor has a
+ * block form, after a few warm up reps to settle the
+ * caches and any lazily built tables. The median and
+ * fastest reps are reported as ns per frame and frames
+ * per second, and written as json for scripts/bench_compare.py
+ * to check against a stored baseline. */
+
+typedef struct benchctx_t {
+    size_t frames;
+    void * obj;             /* the thing under test */
+    void * aux;
+    lpbuffer_t * src;       /* interleaved noise and sines, BENCH_CHANNELS wide */
+    lpbuffer_t * table;     /* a wavetable, or anything else the bench reads from */
+    lpfloat_t * mono;       /* the first channel of src */
+    lpfloat_t * out;        /* room for frames * BENCH_CHANNELS */
+    lpfloat_t * freqs;      /* per frame params, a block long */
+    lpfloat_t * amps;
+    lpfloat_t * delays;
+    size_t * events;
+    lpfloat_t sink;         /* results land here so nothing is optimized away */
+} benchctx_t;
+
+typedef struct bench_t {
+    const char * name;
+    const char * group;
+    void (*setup)(benchctx_t * ctx);
+    void (*run)(benchctx_t * ctx);
+    void (*teardown)(benchctx_t * ctx);
+} bench_t;
+
+typedef struct benchresult_t {
+    const char * name;
+    const char * group;
+    double median;          /* ns per rep */
+    double min;
+} benchresult_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void * a, const void * b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Oscillators */
+static void sineosc_setup(benchctx_t * ctx) { ctx->obj = LPSineOsc.create(); }
+static void sineosc_teardown(benchctx_t * ctx) { LPSineOsc.destroy((lpsineosc_t *)ctx->obj); }
+
+static void sineosc_block_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPSineOsc.process_block((lpsineosc_t *)ctx->obj, ctx->out + pos, n, ctx->freqs, ctx->amps);
+    }
+}
+
+static void sineosc_frame_run(benchctx_t * ctx) {
+    lpsineosc_t * osc = (lpsineosc_t *)ctx->obj;
+    size_t i;
+    for(i=0; i < ctx->frames; i++) {
+        osc->freq = ctx->freqs[i % BENCH_BLOCKSIZE];
+        ctx->out[i] = LPSineOsc.process(osc) * ctx->amps[i % BENCH_BLOCKSIZE];
+    }
+}
+
+static void sinebank_setup(benchctx_t * ctx) {
+    lpsinebank_t * bank = LPSineBank.create(16, BENCH_SR);
+    size_t p;
+    for(p=0; p < 16; p++) LPSineBank.set_partial(bank, p, 110.f * (p + 1), 1.f / (p + 1));
+    ctx->obj = bank;
+}
+
+static void sinebank_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPSineBank.process_block((lpsinebank_t *)ctx->obj, ctx->out + pos, n);
+    }
+}
+
+static void sinebank_teardown(benchctx_t * ctx) { LPSineBank.destroy((lpsinebank_t *)ctx->obj); }
+
+static void tableosc_setup(benchctx_t * ctx) { ctx->obj = LPTableOsc.create(ctx->table); }
+static void tableosc_teardown(benchctx_t * ctx) { LPTableOsc.destroy((lptableosc_t *)ctx->obj); }
+
+static void tableosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPTableOsc.process_block((lptableosc_t *)ctx->obj, ctx->out + pos, n, ctx->freqs, ctx->amps);
+    }
+}
+
+static void blnosc_setup(benchctx_t * ctx) { ctx->obj = LPBLNOsc.create(ctx->table, 50.f, 2000.f); }
+static void blnosc_teardown(benchctx_t * ctx) { LPBLNOsc.destroy((lpblnosc_t *)ctx->obj); }
+
+static void blnosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPBLNOsc.process_block((lpblnosc_t *)ctx->obj, ctx->out + pos, n, NULL, ctx->amps);
+    }
+}
+
+static void phasorosc_setup(benchctx_t * ctx) { ctx->obj = LPPhasorOsc.create(); }
+static void phasorosc_teardown(benchctx_t * ctx) { LPPhasorOsc.destroy((lpphasorosc_t *)ctx->obj); }
+
+static void phasorosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPPhasorOsc.process_block((lpphasorosc_t *)ctx->obj, ctx->out + pos, n, ctx->freqs, ctx->amps);
+    }
+}
+
+static void tukeyosc_setup(benchctx_t * ctx) { ctx->obj = LPTukeyOsc.create(); }
+static void tukeyosc_teardown(benchctx_t * ctx) { LPTukeyOsc.destroy((lptukeyosc_t *)ctx->obj); }
+
+static void tukeyosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPTukeyOsc.process_block((lptukeyosc_t *)ctx->obj, ctx->out + pos, n, ctx->freqs, ctx->amps);
+    }
+}
+
+static void shapeosc_setup(benchctx_t * ctx) { ctx->obj = LPShapeOsc.create(ctx->table); }
+static void shapeosc_teardown(benchctx_t * ctx) { LPShapeOsc.destroy((lpshapeosc_t *)ctx->obj); }
+
+static void shapeosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPShapeOsc.process_block((lpshapeosc_t *)ctx->obj, ctx->out + pos, n, NULL, ctx->amps);
+    }
+}
+
+static void pulsarosc_setup(benchctx_t * ctx) {
+    ctx->obj = LPPulsarOsc.create(2, 2, WT_SINE, 4096, WT_TRI2, 4096, WIN_SINE, 4096, WIN_HANN, 4096);
+}
+
+static void pulsarosc_teardown(benchctx_t * ctx) { LPPulsarOsc.destroy((lppulsarosc_t *)ctx->obj); }
+
+static void pulsarosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPPulsarOsc.process_block((lppulsarosc_t *)ctx->obj, ctx->out + pos, n, ctx->freqs, ctx->amps);
+    }
+}
+
+static void tapeosc_setup(benchctx_t * ctx) { ctx->obj = LPTapeOsc.create(ctx->src, 1.f); }
+static void tapeosc_teardown(benchctx_t * ctx) { LPTapeOsc.destroy((lptapeosc_t *)ctx->obj); }
+
+static void tapeosc_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPTapeOsc.process_block((lptapeosc_t *)ctx->obj, ctx->out + pos * BENCH_CHANNELS, n, ctx->amps, NULL);
+    }
+}
+
+/* Interpolation */
+static void interp_linear_run(benchctx_t * ctx) {
+    lpfloat_t pos = 0, inc = (lpfloat_t)ctx->table->length / 109.f;
+    size_t i;
+    for(i=0; i < ctx->frames; i++) {
+        ctx->out[i] = LPInterpolation.linear_pos(ctx->table, pos / ctx->table->length);
+        pos += inc;
+        while(pos >= ctx->table->length) pos -= ctx->table->length;
+    }
+}
+
+static void interp_hermite_run(benchctx_t * ctx) {
+    lpfloat_t pos = 0, inc = (lpfloat_t)ctx->table->length / 109.f;
+    size_t i;
+    for(i=0; i < ctx->frames; i++) {
+        ctx->out[i] = LPInterpolation.hermite_pos(ctx->table, pos / ctx->table->length);
+        pos += inc;
+        while(pos >= ctx->table->length) pos -= ctx->table->length;
+    }
+}
+
+/* Buffer math, on every channel */
+static void kernels_add_run(benchctx_t * ctx) {
+    LPKernels.add(ctx->out, ctx->src->data, ctx->frames * BENCH_CHANNELS);
+}
+
+static void kernels_multiply_run(benchctx_t * ctx) {
+    memcpy(ctx->out, ctx->src->data, sizeof(lpfloat_t) * ctx->frames * BENCH_CHANNELS);
+    LPKernels.multiply(ctx->out, ctx->src->data, ctx->frames * BENCH_CHANNELS);
+}
+
+static void kernels_scale_run(benchctx_t * ctx) {
+    memcpy(ctx->out, ctx->src->data, sizeof(lpfloat_t) * ctx->frames * BENCH_CHANNELS);
+    LPKernels.scale(ctx->out, ctx->frames * BENCH_CHANNELS, -1.f, 2.f, 1.f, 0.f);
+}
+
+static void kernels_clip_run(benchctx_t * ctx) {
+    memcpy(ctx->out, ctx->src->data, sizeof(lpfloat_t) * ctx->frames * BENCH_CHANNELS);
+    LPKernels.clip(ctx->out, ctx->frames * BENCH_CHANNELS, -0.5f, 0.5f);
+}
+
+static void kernels_mag_run(benchctx_t * ctx) {
+    ctx->sink += LPKernels.mag(ctx->src->data, ctx->frames * BENCH_CHANNELS);
+}
+
+static void buffer_setup(benchctx_t * ctx) {
+    ctx->obj = LPBuffer.create(ctx->frames, BENCH_CHANNELS, BENCH_SR);
+    ctx->aux = LPWindow.create(WIN_HANN, 4096);
+}
+
+static void buffer_teardown(benchctx_t * ctx) {
+    LPBuffer.destroy((lpbuffer_t *)ctx->obj);
+    LPBuffer.destroy((lpbuffer_t *)ctx->aux);
+}
+
+static void buffer_multiply_run(benchctx_t * ctx) {
+    LPBuffer.copy(ctx->src, (lpbuffer_t *)ctx->obj);
+    LPBuffer.multiply((lpbuffer_t *)ctx->obj, ctx->src);
+}
+
+static void buffer_env_run(benchctx_t * ctx) {
+    LPBuffer.copy(ctx->src, (lpbuffer_t *)ctx->obj);
+    LPBuffer.env((lpbuffer_t *)ctx->obj, (lpbuffer_t *)ctx->aux);
+}
+
+static void buffer_dub_run(benchctx_t * ctx) {
+    LPBuffer.dub((lpbuffer_t *)ctx->obj, ctx->src, 0);
+}
+
+/* Ring buffers */
+static void ringbuffer_setup(benchctx_t * ctx) { ctx->obj = LPRingBuffer.create(BENCH_SR, BENCH_CHANNELS, BENCH_SR); }
+static void ringbuffer_teardown(benchctx_t * ctx) { LPRingBuffer.destroy((lpbuffer_t *)ctx->obj); }
+
+static void ringbuffer_write_read_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPRingBuffer.writefrom((lpbuffer_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, n, BENCH_CHANNELS);
+        LPRingBuffer.readinto((lpbuffer_t *)ctx->obj, ctx->out + pos * BENCH_CHANNELS, n, BENCH_CHANNELS);
+    }
+}
+
+static void ringbuffer_tapinto_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPRingBuffer.writefrom((lpbuffer_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, n, BENCH_CHANNELS);
+        LPRingBuffer.tapinto((lpbuffer_t *)ctx->obj, ctx->delays, ctx->out + pos * BENCH_CHANNELS, n);
+    }
+}
+
+static void spscring_setup(benchctx_t * ctx) { ctx->obj = LPSPSCRing.create(4096, BENCH_CHANNELS, BENCH_SR); }
+static void spscring_teardown(benchctx_t * ctx) { LPSPSCRing.destroy((lpspscring_t *)ctx->obj); }
+
+static void spscring_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPSPSCRing.write((lpspscring_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, n);
+        LPSPSCRing.read((lpspscring_t *)ctx->obj, ctx->out + pos * BENCH_CHANNELS, n);
+    }
+}
+
+/* Effects */
+static void softclip_setup(benchctx_t * ctx) { ctx->obj = LPSoftClip.create(); }
+static void softclip_teardown(benchctx_t * ctx) { LPSoftClip.destroy((lpfxsoftclip_t *)ctx->obj); }
+
+static void softclip_run(benchctx_t * ctx) {
+    size_t i;
+    for(i=0; i < ctx->frames; i++) ctx->out[i] = LPSoftClip.process((lpfxsoftclip_t *)ctx->obj, ctx->mono[i] * 2.f);
+}
+
+static void lpf1_run(benchctx_t * ctx) {
+    lpfloat_t y = 0;
+    size_t i;
+    for(i=0; i < ctx->frames; i++) ctx->out[i] = LPFX.lpf1(ctx->mono[i], &y, 1000.f, BENCH_SR);
+}
+
+static void crush_run(benchctx_t * ctx) {
+    size_t i;
+    for(i=0; i < ctx->frames; i++) ctx->out[i] = LPFX.crush(ctx->mono[i], 8);
+}
+
+static void norm_run(benchctx_t * ctx) {
+    LPBuffer.copy(ctx->src, (lpbuffer_t *)ctx->obj);
+    LPFX.norm((lpbuffer_t *)ctx->obj, 0.8f);
+}
+
+static void convolver_setup(benchctx_t * ctx) {
+    lpbuffer_t * impulse;
+    size_t i;
+    int c;
+
+    /* A second of decaying noise */
+    impulse = LPBuffer.create(BENCH_SR, BENCH_CHANNELS, BENCH_SR);
+    for(i=0; i < impulse->length; i++) {
+        for(c=0; c < BENCH_CHANNELS; c++) {
+            impulse->data[i * BENCH_CHANNELS + c] = LPRand.rand(-1.f, 1.f) * (1.f - (lpfloat_t)i / impulse->length) * 0.1f;
+        }
+    }
+
+    ctx->obj = LPConvolver.create(impulse, BENCH_CHANNELS, BENCH_CHANNELS, 64, 4096);
+    LPBuffer.destroy(impulse);
+}
+
+static void convolver_teardown(benchctx_t * ctx) { LPConvolver.destroy((lpconvolver_t *)ctx->obj); }
+
+static void convolver_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPConvolver.process_block((lpconvolver_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, ctx->out + pos * BENCH_CHANNELS, n);
+    }
+}
+
+/* Resamples frames of input at 44.1k to 48k */
+static void resampler_setup(benchctx_t * ctx) { ctx->obj = LPResampler.create(48000.f / 44100.f, BENCH_CHANNELS, LPRESAMPLER_MEDIUM); }
+static void resampler_teardown(benchctx_t * ctx) { LPResampler.destroy((lpresampler_t *)ctx->obj); }
+
+static void resampler_run(benchctx_t * ctx) {
+    size_t pos, n, written;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        written = LPResampler.process((lpresampler_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, &n, ctx->out, BENCH_BLOCKSIZE * 2);
+        if(n == 0 && written == 0) break;
+    }
+}
+
+/* Analysis */
+static void yin_setup(benchctx_t * ctx) { ctx->obj = LPPitchTracker.yin_create(4096, BENCH_SR); }
+static void yin_teardown(benchctx_t * ctx) { LPPitchTracker.yin_destroy((lpyin_t *)ctx->obj); }
+
+static void yin_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        ctx->sink += LPPitchTracker.yin_process_block((lpyin_t *)ctx->obj, ctx->mono + pos, n);
+    }
+}
+
+static void coyote_setup(benchctx_t * ctx) { ctx->obj = LPOnsetDetector.coyote_create(BENCH_SR); }
+static void coyote_teardown(benchctx_t * ctx) { LPOnsetDetector.coyote_destory((lpcoyote_t *)ctx->obj); }
+
+static void coyote_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPOnsetDetector.coyote_process_block((lpcoyote_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, BENCH_CHANNELS, n, ctx->events, BENCH_MAXEVENTS);
+    }
+}
+
+static void envelope_setup(benchctx_t * ctx) { ctx->obj = LPEnvelopeFollower.create(0.015f); }
+static void envelope_teardown(benchctx_t * ctx) { LPEnvelopeFollower.destroy((lpenvelopefollower_t *)ctx->obj); }
+
+static void envelope_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPEnvelopeFollower.process_block((lpenvelopefollower_t *)ctx->obj, ctx->src->data + pos * BENCH_CHANNELS, BENCH_CHANNELS, n, ctx->out, BENCH_BLOCKSIZE);
+    }
+}
+
+/* Microsound */
+static void formation_setup(benchctx_t * ctx) {
+    lpformation_t * formation = LPFormation.create(WIN_HANN, 10, 4096, ctx->src->length, BENCH_CHANNELS, BENCH_SR, NULL, 256);
+    LPRingBuffer.write(formation->rb, ctx->src);
+    ctx->obj = formation;
+}
+
+static void formation_teardown(benchctx_t * ctx) { LPFormation.destroy((lpformation_t *)ctx->obj); }
+
+static void formation_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPFormation.process_block((lpformation_t *)ctx->obj, ctx->out + pos * BENCH_CHANNELS, n);
+    }
+}
+
+/* Generators and graphs */
+static void rand_uniform_run(benchctx_t * ctx) {
+    LPRand.fill_uniform(NULL, ctx->out, ctx->frames, -1.f, 1.f);
+}
+
+static void rand_gaussian_run(benchctx_t * ctx) {
+    LPRand.fill_gaussian(NULL, ctx->out, ctx->frames, 0.f, 1.f);
+}
+
+static void ugengraph_setup(benchctx_t * ctx) {
+    lpugengraph_t * graph = LPUgenGraph.create(BENCH_BLOCKSIZE);
+    int lfo, carrier, amp;
+
+    lfo = LPUgenGraph.add_node(graph, create_sine_ugen());
+    carrier = LPUgenGraph.add_node(graph, create_sine_ugen());
+    amp = LPUgenGraph.add_node(graph, create_mult_ugen());
+    LPUgenGraph.connect(graph, lfo, USINEOUT_MAIN, carrier, USINEIN_FREQ, 100.f, 440.f, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, carrier, USINEOUT_MAIN, amp, UMULTIN_A, 1.f, 0.f, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.connect(graph, amp, UMULTOUT_MAIN, LPUGENGRAPH_OUTPUT, 0, 0.5f, 0.f, LPUGENGRAPH_RATE_SAMPLE);
+    LPUgenGraph.compile(graph);
+    ctx->obj = graph;
+}
+
+static void ugengraph_teardown(benchctx_t * ctx) { LPUgenGraph.destroy((lpugengraph_t *)ctx->obj); }
+
+static void ugengraph_run(benchctx_t * ctx) {
+    size_t pos, n;
+    for(pos=0; pos < ctx->frames; pos += n) {
+        n = ctx->frames - pos < BENCH_BLOCKSIZE ? ctx->frames - pos : BENCH_BLOCKSIZE;
+        LPUgenGraph.process((lpugengraph_t *)ctx->obj, n);
+    }
+}
+
+static const bench_t benches[] = {
+    { "sineosc_block", "oscs", sineosc_setup, sineosc_block_run, sineosc_teardown },
+    { "sineosc_frame", "oscs", sineosc_setup, sineosc_frame_run, sineosc_teardown },
+    { "sinebank_16", "oscs", sinebank_setup, sinebank_run, sinebank_teardown },
+    { "tableosc", "oscs", tableosc_setup, tableosc_run, tableosc_teardown },
+    { "blnosc", "oscs", blnosc_setup, blnosc_run, blnosc_teardown },
+    { "phasorosc", "oscs", phasorosc_setup, phasorosc_run, phasorosc_teardown },
+    { "tukeyosc", "oscs", tukeyosc_setup, tukeyosc_run, tukeyosc_teardown },
+    { "shapeosc", "oscs", shapeosc_setup, shapeosc_run, shapeosc_teardown },
+    { "pulsarosc", "oscs", pulsarosc_setup, pulsarosc_run, pulsarosc_teardown },
+    { "tapeosc", "oscs", tapeosc_setup, tapeosc_run, tapeosc_teardown },
+
+    { "interp_linear", "interpolation", NULL, interp_linear_run, NULL },
+    { "interp_hermite", "interpolation", NULL, interp_hermite_run, NULL },
+
+    { "kernels_add", "buffers", NULL, kernels_add_run, NULL },
+    { "kernels_multiply", "buffers", NULL, kernels_multiply_run, NULL },
+    { "kernels_scale", "buffers", NULL, kernels_scale_run, NULL },
+    { "kernels_clip", "buffers", NULL, kernels_clip_run, NULL },
+    { "kernels_mag", "buffers", NULL, kernels_mag_run, NULL },
+    { "buffer_multiply", "buffers", buffer_setup, buffer_multiply_run, buffer_teardown },
+    { "buffer_env", "buffers", buffer_setup, buffer_env_run, buffer_teardown },
+    { "buffer_dub", "buffers", buffer_setup, buffer_dub_run, buffer_teardown },
+
+    { "ringbuffer_write_read", "ringbuffers", ringbuffer_setup, ringbuffer_write_read_run, ringbuffer_teardown },
+    { "ringbuffer_tapinto", "ringbuffers", ringbuffer_setup, ringbuffer_tapinto_run, ringbuffer_teardown },
+    { "spscring", "ringbuffers", spscring_setup, spscring_run, spscring_teardown },
+
+    { "softclip", "fx", softclip_setup, softclip_run, softclip_teardown },
+    { "lpf1", "fx", NULL, lpf1_run, NULL },
+    { "crush", "fx", NULL, crush_run, NULL },
+    { "norm", "fx", buffer_setup, norm_run, buffer_teardown },
+    { "convolver", "fx", convolver_setup, convolver_run, convolver_teardown },
+    { "resampler", "fx", resampler_setup, resampler_run, resampler_teardown },
+
+    { "yin", "mir", yin_setup, yin_run, yin_teardown },
+    { "coyote", "mir", coyote_setup, coyote_run, coyote_teardown },
+    { "envelope", "mir", envelope_setup, envelope_run, envelope_teardown },
+
+    { "formation", "microsound", formation_setup, formation_run, formation_teardown },
+
+    { "rand_uniform", "rand", NULL, rand_uniform_run, NULL },
+    { "rand_gaussian", "rand", NULL, rand_gaussian_run, NULL },
+    { "ugengraph", "ugens", ugengraph_setup, ugengraph_run, ugengraph_teardown },
+};
+
+#define NUMBENCHES (sizeof(benches) / sizeof(bench_t))
+
+static int pin_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if(sched_setaffinity(0, sizeof(set), &set) < 0) {
+        fprintf(stderr, "Could not pin to cpu %d: (%d) %s\n", cpu, errno, strerror(errno));
+        return -1;
+    }
+    return 0;
+#else
+    (void)cpu;
+    fprintf(stderr, "Pinning to a cpu is only supported on linux\n");
+    return -1;
+#endif
+}
+
+static void ctx_init(benchctx_t * ctx, size_t frames) {
+    size_t i;
+    int c;
+
+    memset(ctx, 0, sizeof(benchctx_t));
+    ctx->frames = frames;
+
+    /* Seeded so every run sees the same input */
+    LPRand.seed(1);
+    ctx->src = LPBuffer.create(frames, BENCH_CHANNELS, BENCH_SR);
+    for(i=0; i < frames; i++) {
+        for(c=0; c < BENCH_CHANNELS; c++) {
+            ctx->src->data[i * BENCH_CHANNELS + c] = sin((lpfloat_t)i * 0.05f * (c + 1)) * 0.5f + LPRand.rand(-0.25f, 0.25f);
+        }
+    }
+
+    ctx->table = LPWavetable.create(WT_SINE, 4096);
+    ctx->mono = (lpfloat_t *)LPMemoryPool.alloc(frames, sizeof(lpfloat_t));
+    for(i=0; i < frames; i++) ctx->mono[i] = ctx->src->data[i * BENCH_CHANNELS];
+
+    ctx->out = (lpfloat_t *)LPMemoryPool.alloc(frames * BENCH_CHANNELS + BENCH_BLOCKSIZE * 4, sizeof(lpfloat_t));
+    ctx->freqs = (lpfloat_t *)LPMemoryPool.alloc(BENCH_BLOCKSIZE, sizeof(lpfloat_t));
+    ctx->amps = (lpfloat_t *)LPMemoryPool.alloc(BENCH_BLOCKSIZE, sizeof(lpfloat_t));
+    ctx->delays = (lpfloat_t *)LPMemoryPool.alloc(BENCH_BLOCKSIZE, sizeof(lpfloat_t));
+    for(i=0; i < BENCH_BLOCKSIZE; i++) {
+        ctx->freqs[i] = 220.f + i;
+        ctx->amps[i] = 0.5f;
+        ctx->delays[i] = 100.f + i * 10.25f;
+    }
+    ctx->events = (size_t *)LPMemoryPool.alloc(BENCH_MAXEVENTS, sizeof(size_t));
+}
+
+static void ctx_destroy(benchctx_t * ctx) {
+    LPBuffer.destroy(ctx->src);
+    LPBuffer.destroy(ctx->table);
+    LPMemoryPool.free(ctx->mono);
+    LPMemoryPool.free(ctx->out);
+    LPMemoryPool.free(ctx->freqs);
+    LPMemoryPool.free(ctx->amps);
+    LPMemoryPool.free(ctx->delays);
+    LPMemoryPool.free(ctx->events);
+}
+
+static void run_bench(const bench_t * bench, benchctx_t * ctx, int warmup, int reps, double * times, benchresult_t * result) {
+    double start;
+    int r;
+
+    if(bench->setup != NULL) bench->setup(ctx);
+
+    for(r=0; r < warmup; r++) bench->run(ctx);
+
+    for(r=0; r < reps; r++) {
+        start = now_ns();
+        bench->run(ctx);
+        times[r] = now_ns() - start;
+    }
+
+    if(bench->teardown != NULL) bench->teardown(ctx);
+
+    qsort(times, reps, sizeof(double), compare_doubles);
+    result->name = bench->name;
+    result->group = bench->group;
+    result->median = (reps % 2) ? times[reps / 2] : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+    result->min = times[0];
+}
+
+static int write_json(const char * path, benchresult_t * results, int numresults, int cpu, int warmup, int reps, size_t frames) {
+    FILE * fp;
+    int i;
+
+    if((fp = fopen(path, "w")) == NULL) {
+        fprintf(stderr, "Could not open %s for writing: (%d) %s\n", path, errno, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"float\": \"%s\",\n", sizeof(lpfloat_t) == sizeof(float) ? "float" : "double");
+    fprintf(fp, "  \"kernels\": \"%s\",\n", LPKernels.name);
+    fprintf(fp, "  \"cpu\": %d,\n", cpu);
+    fprintf(fp, "  \"warmup\": %d,\n", warmup);
+    fprintf(fp, "  \"reps\": %d,\n", reps);
+    fprintf(fp, "  \"frames\": %d,\n", (int)frames);
+    fprintf(fp, "  \"benchmarks\": [\n");
+    for(i=0; i < numresults; i++) {
+        fprintf(fp, "    {\"name\": \"%s\", \"group\": \"%s\", \"median_ns\": %.1f, \"min_ns\": %.1f, \"ns_per_frame\": %.4f, \"frames_per_sec\": %.1f}%s\n",
+                results[i].name, results[i].group, results[i].median, results[i].min,
+                results[i].median / frames, frames / (results[i].median * 1e-9),
+                (i < numresults - 1) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+
+    fclose(fp);
+    return 0;
+}
+
+static void print_usage(char * program_name) {
+    printf("Usage: %s [-c cpu] [-r reps] [-w warmup] [-n frames] [-f filter] [-o out.json]\n", program_name);
+    printf("Runs every bench whose name contains filter, pinned to cpu if given.\n");
+}
+
+int main(int argc, char * argv[]) {
+    benchresult_t results[NUMBENCHES];
+    benchctx_t ctx;
+    double * times;
+    char * filter = NULL, * outpath = NULL;
+    size_t frames = BENCH_FRAMES, b;
+    int opt, cpu = -1, reps = BENCH_REPS, warmup = BENCH_WARMUP, numresults = 0;
+
+    while((opt = getopt(argc, argv, "c:r:w:n:f:o:h")) != -1) {
+        switch(opt) {
+            case 'c': cpu = atoi(optarg); break;
+            case 'r': reps = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'n': frames = (size_t)atol(optarg); break;
+            case 'f': filter = optarg; break;
+            case 'o': outpath = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if(reps < 1 || warmup < 0 || frames < BENCH_BLOCKSIZE) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if(cpu >= 0 && pin_cpu(cpu) < 0) return 1;
+
+    times = (double *)LPMemoryPool.alloc(reps, sizeof(double));
+    ctx_init(&ctx, frames);
+
+    printf("%d frames, %d reps after %d warm up, %s samples, %s kernels\n\n", (int)frames, reps, warmup,
+            sizeof(lpfloat_t) == sizeof(float) ? "float" : "double", LPKernels.name);
+    printf("%-24s %-14s %12s %12s %14s\n", "bench", "group", "ns/frame", "min ns/frame", "frames/sec");
+
+    for(b=0; b < NUMBENCHES; b++) {
+        if(filter != NULL && strstr(benches[b].name, filter) == NULL) continue;
+        run_bench(&benches[b], &ctx, warmup, reps, times, &results[numresults]);
+        printf("%-24s %-14s %12.3f %12.3f %14.0f\n", results[numresults].name, results[numresults].group,
+                results[numresults].median / frames, results[numresults].min / frames,
+                frames / (results[numresults].median * 1e-9));
+        numresults += 1;
+    }
+
+    if(outpath != NULL && write_json(outpath, results, numresults, cpu, warmup, reps, frames) < 0) return 1;
+
+    ctx_destroy(&ctx);
+    LPMemoryPool.free(times);
+
+    /* Keeps the sink alive */
+    return ctx.sink != ctx.sink;
+}
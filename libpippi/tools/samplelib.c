@@ -0,0 +1,58 @@
+#include "pippi.h"
+
+void print_usage(char * program_name) {
+    printf("Usage:\n%s c </path/to/in.wav:str> </path/to/out.lps:str>\n", program_name);
+    printf("%s <i|v> </path/to/sample.lps:str>\n", program_name);
+}
+
+int main(int argc, char * argv[]) {
+    lpbuffer_t * buf;
+    char cmd;
+
+    if(argc < 3 || argc > 4) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    cmd = argv[1][0];
+
+    switch(cmd) {
+        case 'c':
+            if(argc < 4) {
+                print_usage(argv[0]);
+                return 1;
+            }
+
+            if(LPSampleLib.convert(argv[2], argv[3]) < 0) {
+                fprintf(stderr, "Could not convert %s\n", argv[2]);
+                return 1;
+            }
+
+            printf("Converted %s to %s\n", argv[2], argv[3]);
+            break;
+
+        case 'i':
+        case 'v':
+            if((buf = LPSampleLib.open(argv[2])) == NULL) return 1;
+
+            printf("%s: %d frames, %d channels at %d\n", argv[2], (int)buf->length, buf->channels, buf->samplerate);
+
+            if(cmd == 'v') {
+                if(LPSampleLib.verify(buf) < 0) {
+                    fprintf(stderr, "Checksum mismatch in %s\n", argv[2]);
+                    LPSampleLib.close(buf);
+                    return 1;
+                }
+                printf("Checksum ok\n");
+            }
+
+            LPSampleLib.close(buf);
+            break;
+
+        default:
+            print_usage(argv[0]);
+            return 1;
+    }
+
+    return 0;
+}
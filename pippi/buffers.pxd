@@ -52,21 +52,31 @@ cdef extern from "pippicore.h":
         lpbuffer_t * (*create)(int name, size_t length)
         void (*destroy)(lpbuffer_t *)
 
+    ctypedef struct lpmemorypool_stats_t:
+        size_t live
+        size_t highwater
+        size_t allocs
+        size_t frees
+        size_t failed
+
     ctypedef struct lpmemorypool_t:
         unsigned char * pool
         size_t poolsize
         size_t pos
+        lpmemorypool_stats_t stats
 
     ctypedef struct lpmemorypool_factory_t:
-        unsigned char * pool
-        size_t poolsize
-        size_t pos
-
         void (*init)(unsigned char *, size_t)
         lpmemorypool_t * (*custom_init)(unsigned char *, size_t)
         void * (*alloc)(size_t, size_t)
         void * (*custom_alloc)(lpmemorypool_t *, size_t, size_t)
         void (*free)(void *)
+        size_t (*mark)(lpmemorypool_t *)
+        void (*reset)(lpmemorypool_t *, size_t)
+        size_t (*scope_begin)(lpmemorypool_t *)
+        void (*scope_end)(lpmemorypool_t *, size_t)
+        void (*thread_release)()
+        lpmemorypool_stats_t (*stats)(lpmemorypool_t *)
 
     ctypedef struct lpinterpolation_factory_t:
         lpfloat_t (*linear_pos)(lpbuffer_t *, lpfloat_t)
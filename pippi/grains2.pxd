@@ -99,29 +99,8 @@ cdef extern from "oscs.tape.h":
         int gate
 
 cdef extern from "microsound.h":
-    ctypedef struct lpgrain_t:
-        size_t length
-        int channels
-        lpfloat_t pulsewidth
-
-        size_t range
-        size_t start
-        size_t offset
-
-        lpfloat_t phase_offset
-        lpfloat_t phase
-        lpfloat_t pan
-        lpfloat_t amp
-        lpfloat_t speed
-        lpfloat_t skew
-
-        int unused
-        int gate
-
-        lpbuffer_t * buf
-        lpbuffer_t * window
-
     ctypedef struct lpformation_t:
+        int maxgrains
         int num_active_grains
         size_t numlayers
         size_t grainlength
@@ -147,8 +126,9 @@ cdef extern from "microsound.h":
         lpbuffer_t * rb
 
     ctypedef struct lpformation_factory_t:
-        lpformation_t * (*create)(int, int, size_t, size_t, int, int, lpbuffer_t *)
+        lpformation_t * (*create)(int, int, size_t, size_t, int, int, lpbuffer_t *, int)
         void (*process)(lpformation_t *)
+        void (*process_block)(lpformation_t *, lpfloat_t *, size_t)
         void (*destroy)(lpformation_t *)
 
     extern const lpformation_factory_t LPFormation
@@ -110,6 +110,7 @@ cdef class Cloud2:
             object phase=None,
             int numgrains=2,
             unsigned int wtsize=4096,
+            int maxgrains=0,
         ):
         """ TODO:
             [ ] position
@@ -164,7 +165,8 @@ cdef class Cloud2:
                 sndlength, 
                 self.channels, 
                 self.samplerate,
-                win
+                win,
+                maxgrains
         )
 
         LPRingBuffer.write(self.formation.rb, srcbuf)
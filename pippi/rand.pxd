@@ -32,6 +32,8 @@ cdef extern from "pippicore.h":
         int (*randbool)()
         int (*choice)(int)
 
+        lpfloat_t (*xoshiro)(lpfloat_t, lpfloat_t)
+
     extern lprand_t LPRand
 
 
@@ -25,8 +25,10 @@ cpdef void randmethod(str method='normal'):
         LPRand.rand_base = LPRand.lorenzY
     elif method == 'lorenzZ':
         LPRand.rand_base = LPRand.lorenzZ
-    else:
+    elif method == 'stdlib':
         LPRand.rand_base = LPRand.stdlib
+    else:
+        LPRand.rand_base = LPRand.xoshiro
 
 cpdef dict randdump():
     return dict(
@@ -1,6 +1,6 @@
 #cython: language_level=3
 
-from libc.stdint cimport uint16_t
+from libc.stdint cimport uint16_t, uint32_t
 from pippi.soundbuffer cimport SoundBuffer
 
 cdef extern from "pippicore.h":
@@ -41,6 +41,7 @@ cdef extern from "pippicore.h":
 
 cdef extern from "astrid.h":
     cdef const int LPMAXMSG
+    cdef const int LPMAXROUTE
     cdef const int LPMAXNAME
     cdef const int NOTE_ON
     cdef const int NOTE_OFF
@@ -72,6 +73,11 @@ cdef extern from "astrid.h":
         LPMSG_SET_COUNTER,
         NUM_LPMESSAGETYPES
 
+    ctypedef struct lproute_t:
+        uint32_t count
+        uint16_t channels[LPMAXROUTE]
+        float gains[LPMAXROUTE]
+
     ctypedef struct lpmsg_t:
         double initiated;     
         double scheduled;     
@@ -82,6 +88,7 @@ cdef extern from "astrid.h":
         size_t count
         uint16_t flags
         uint16_t type
+        lproute_t route
         char msg[LPMAXMSG]
         char instrument_name[LPMAXNAME]
 
@@ -690,10 +690,11 @@ def _wait_on_commands_forever(str instrument_name, stop_event):
             logger.info('Console has signaled stop, shutting down command loop...')
             break
 
-def _run_forever(str script_path, str instrument_name, int channels, stop_event):
+def _run_forever(str script_path, str instrument_name, int channels, stop_event, bint hosted=False):
     cdef Instrument instrument = None
     cdef lpinstrument_t * i = NULL
     cdef lpmsg_t msg
+    cdef int exmsgq = -1
     instrument_byte_string = instrument_name.encode('UTF-8')
     cdef char * _instrument_ascii_name = instrument_byte_string
 
@@ -704,16 +705,27 @@ def _run_forever(str script_path, str instrument_name, int channels, stop_event)
     instrument = _load_instrument(instrument_name, script_path)
     logger.info(f'loaded instrument {instrument=}')
 
-    # Start the stream and setup the instrument
-    logger.info(f'starting instrument... {script_path=} {instrument_name=}')
-    i = astrid_instrument_start(_instrument_ascii_name, channels, NULL, NULL, NULL, NULL)
-    if i == NULL:
-        logger.error('Error trying to start instrument. Shutting down...')
-        return
+    if hosted:
+        # astrid-host owns the stream and the message queues for 
+        # this instrument, so just attach to its external relay
+        logger.info(f'attaching to hosted instrument... {script_path=} {instrument_name=}')
+        relay_byte_string = f'/{instrument_name}-extrelay-msgq'.encode('UTF-8')
+        exmsgq = astrid_msgq_open(relay_byte_string)
+        if exmsgq < 0:
+            logger.error('Error trying to attach to hosted instrument. Shutting down...')
+            return
+    else:
+        # Start the stream and setup the instrument
+        logger.info(f'starting instrument... {script_path=} {instrument_name=}')
+        i = astrid_instrument_start(_instrument_ascii_name, channels, NULL, NULL, NULL, NULL)
+        if i == NULL:
+            logger.error('Error trying to start instrument. Shutting down...')
+            return
+        exmsgq = i.exmsgq
 
     while True:
         logger.info('reading messages...')
-        if astrid_msgq_read(i.exmsgq, &msg) < 0:
+        if astrid_msgq_read(exmsgq, &msg) < 0:
             print('There was a problem reading from the msg q. Maybe try turning it off and on again?')
             continue
 
@@ -743,10 +755,10 @@ def _run_forever(str script_path, str instrument_name, int channels, stop_event)
 
     logger.info('python instrument shutting down...')
 
-def run_forever(str script_path, str instrument_name=None, channels=2):
+def run_forever(str script_path, str instrument_name=None, channels=2, hosted=False):
     instrument_name = instrument_name if instrument_name is not None else Path(script_path).stem
     stop_event = Event()
-    render_process = Process(target=_run_forever, args=(script_path, instrument_name, channels, stop_event))
+    render_process = Process(target=_run_forever, args=(script_path, instrument_name, channels, stop_event, hosted))
     render_process.start()
 
     try:
@@ -24,6 +24,8 @@ cdef extern from "pippicore.h":
         void (*set_param)(ugen_t * u, int index, void * value)
         void (*process)(ugen_t * u)
         void (*destroy)(ugen_t * u)
+        int num_inputs
+        int num_outputs
 
 cdef extern from "oscs.sine.h":
     ctypedef struct lpsineosc_t:
@@ -188,6 +190,30 @@ cdef extern from "ugens.pulsar.h":
     cdef ugen_t * create_pulsar_ugen()
 
 
+cdef extern from "ugens.graph.h":
+    cdef int LPUGENGRAPH_OUTPUT
+
+    cdef enum LPUGENGRAPH_RATES:
+        LPUGENGRAPH_RATE_SAMPLE,
+        LPUGENGRAPH_RATE_BLOCK
+
+    ctypedef struct lpugengraph_t:
+        int numnodes
+        int numconnections
+        size_t blocksize
+
+    ctypedef struct lpugengraph_factory_t:
+        lpugengraph_t * (*create)(size_t blocksize)
+        int (*add_node)(lpugengraph_t * graph, ugen_t * u)
+        int (*connect)(lpugengraph_t * graph, int source, int output, int dest, int input, lpfloat_t mult, lpfloat_t add, int rate)
+        int (*compile)(lpugengraph_t * graph)
+        lpfloat_t * (*process)(lpugengraph_t * graph, size_t nframes)
+        int (*render)(lpugengraph_t * graph, lpfloat_t * out, size_t nframes, int channels)
+        void (*destroy)(lpugengraph_t * graph)
+
+    extern const lpugengraph_factory_t LPUgenGraph
+
+
 cdef class Node:
     cdef ugen_t * u
     cdef str ugen_name
@@ -195,7 +221,10 @@ cdef class Node:
     cdef public object connections
     cdef double mult
     cdef double add
+    cdef bint in_graph
 
 cdef class Graph:
+    cdef lpugengraph_t * graph
     cdef dict nodes
+    cdef dict indexes
     cdef object outputs
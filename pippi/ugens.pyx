@@ -1,6 +1,7 @@
 from collections import defaultdict
 import warnings
 
+cimport cython
 cimport numpy as np
 import numpy as np
 
@@ -53,6 +54,7 @@ cdef dict UGEN_OUTPUTNAME_MAP = {
     'tape.speed': UTAPEOUT_SPEED,
     'tape.phase': UTAPEOUT_PHASE,
     'pulsar.main': UPULSAROUT_MAIN,
+    'pulsar.output': UPULSAROUT_MAIN,
     'pulsar.wavetable_morph': UPULSAROUT_WTMORPH,
     'pulsar.wavetable_morph_freq': UPULSAROUT_WTMORPHFREQ,
     'pulsar.window_morph': UPULSAROUT_WINMORPH,
@@ -66,6 +68,23 @@ cdef dict UGEN_OUTPUTNAME_MAP = {
     'pulsar.freq': UPULSAROUT_FREQ,
 }
 
+cdef int _input_port(str ugen, str name) except -1:
+    try:
+        return UGEN_INPUTNAME_MAP['%s.%s' % (ugen, name)]
+    except KeyError:
+        raise ValueError('Unknown input "%s" on a %s ugen' % (name, ugen))
+
+cdef int _output_port(str ugen, str name) except -1:
+    try:
+        return UGEN_OUTPUTNAME_MAP['%s.%s' % (ugen, name)]
+    except KeyError:
+        raise ValueError('Unknown output "%s" on a %s ugen' % (name, ugen))
+
+cdef ugen_t * _node_ugen(Node node) except NULL:
+    if node.u == NULL:
+        raise ValueError('Node "%s" was freed with its graph' % node.name)
+    return node.u
+
 
 cdef class Node:
     def __cinit__(self, str name, str ugen, *args, **kwargs):
@@ -87,13 +106,17 @@ cdef class Node:
             self.set_param(k, v)
 
     def __dealloc__(self):
-        if self.u != NULL:
+        # Once added to a graph the graph owns the ugen
+        if self.u != NULL and not self.in_graph:
             self.u.destroy(self.u)
 
     def get_output(self, str name):
-        return self.u.get_output(self.u, UGEN_OUTPUTNAME_MAP.get('.'.join([self.ugen_name, name]), 0))
+        cdef ugen_t * u = _node_ugen(self)
+        return u.get_output(u, _output_port(self.ugen_name, name))
 
     def set_param(self, str name, object value):
+        cdef ugen_t * u = _node_ugen(self)
+        cdef int port = _input_port(self.ugen_name, name)
         cdef lpbuffer_t * out
         cdef void * vp
         cdef double d
@@ -122,13 +145,13 @@ cdef class Node:
             vp = <void *>out
 
             # set wavetable stack total length
-            self.u.set_param(self.u, UGEN_INPUTNAME_MAP.get('.'.join([self.ugen_name, 'wavetable_length']), 0), vp)
+            u.set_param(u, _input_port(self.ugen_name, 'wavetable_length'), vp)
 
             # set wavetable stack offsets
-            self.u.set_param(self.u, UGEN_INPUTNAME_MAP.get('.'.join([self.ugen_name, 'wavetable_offsets']), 0), vp)
+            u.set_param(u, _input_port(self.ugen_name, 'wavetable_offsets'), vp)
 
             # set wavetable stack lengths
-            self.u.set_param(self.u, UGEN_INPUTNAME_MAP.get('.'.join([self.ugen_name, 'wavetable_lengths']), 0), vp)
+            u.set_param(u, _input_port(self.ugen_name, 'wavetable_lengths'), vp)
 
         elif 'windows' in name:
             stack = []
@@ -148,23 +171,53 @@ cdef class Node:
             dp = &d
             vp = <void *>dp
 
-        self.u.set_param(self.u, UGEN_INPUTNAME_MAP.get('.'.join([self.ugen_name, name]), 0), vp)
+        u.set_param(u, port, vp)
 
     def process(self):
-        self.u.process(self.u)
+        cdef ugen_t * u = _node_ugen(self)
+        u.process(u)
 
 
+# The nodes dict must survive until __dealloc__ to unhook them
+@cython.no_gc_clear
 cdef class Graph:
+    """ A thin builder over LPUgenGraph: the nodes and
+        connections are handed to libpippi, which sorts
+        and renders them a block at a time in C. Loops
+        in the connections hear their source a block late.
+    """
     def __cinit__(self):
         self.nodes = {}
+        self.indexes = {}
         self.outputs = defaultdict(float)
+        self.graph = LPUgenGraph.create(0)
+
+    def __dealloc__(self):
+        # The graph destroys the ugens, so nodes outliving it let go
+        if self.nodes is not None:
+            for node in self.nodes.values():
+                (<Node>node).u = NULL
+
+        if self.graph != NULL:
+            LPUgenGraph.destroy(self.graph)
 
     def add_node(self, str name, str ugen, *args, **kwargs):
-        self.nodes[name] = Node(name, ugen, *args, **kwargs)
+        cdef Node node = Node(name, ugen, *args, **kwargs)
+        cdef int index = LPUgenGraph.add_node(self.graph, node.u)
+
+        if index < 0:
+            raise ValueError('Could not add node "%s"' % name)
 
-    def connect(self, str a, str b, object outmin=None, object outmax=None, double inmin=-1, double inmax=1, object mult=None, object add=None):
+        node.in_graph = True
+        self.nodes[name] = node
+        self.indexes[name] = index
+
+    def connect(self, str a, str b, object outmin=None, object outmax=None, double inmin=-1, double inmax=1, object mult=None, object add=None, str rate='sample'):
         cdef double _mult = 1
         cdef double _add = 0
+        cdef int dest, port
+        cdef int _rate = LPUGENGRAPH_RATE_BLOCK if rate == 'block' else LPUGENGRAPH_RATE_SAMPLE
+        cdef Node anode
 
         anodename, aportname = tuple(a.split('.'))
         bnodename, bportname = tuple(b.split('.'))
@@ -179,35 +232,29 @@ cdef class Graph:
         if add is not None:
             _add = add
 
-        self.nodes[anodename].connections[aportname] += [(bnodename, bportname, _mult, _add)]
-
-    def render(self, double length, int samplerate=DEFAULT_SAMPLERATE, int channels=DEFAULT_CHANNELS):
-        cdef size_t framelength = <size_t>(length * samplerate)
-        cdef double sample = 0
-        cdef size_t i
-        cdef int c
-
-        cdef double[:,:] out = np.zeros((framelength, channels))
+        anode = self.nodes[anodename]
+        if bnodename == 'main' and bportname == 'output':
+            dest = LPUGENGRAPH_OUTPUT
+            port = 0
+        else:
+            dest = self.indexes[bnodename]
+            port = _input_port((<Node>self.nodes[bnodename]).ugen_name, bportname)
 
-        for i in range(framelength):
-            sample = 0
+        if LPUgenGraph.connect(self.graph,
+                self.indexes[anodename],
+                _output_port(anode.ugen_name, aportname),
+                dest, port, _mult, _add, _rate
+            ) < 0:
+            raise ValueError('Could not connect %s to %s' % (a, b))
 
-            # first process all the nodes
-            for _, node in self.nodes.items():
-                node.process()
+        anode.connections[aportname] += [(bnodename, bportname, _mult, _add)]
 
-                # connect the outputs to the inputs
-                for portname, connections in node.connections.items():
-                    port = node.get_output(portname)
-                    for connode, conport, mult, add in connections:
-                        value = port * mult + add
-                        if connode == 'main' and conport == 'output':
-                            sample += value
-                        else:
-                            self.nodes[connode].set_param(conport, value)
+    def render(self, double length, int samplerate=DEFAULT_SAMPLERATE, int channels=DEFAULT_CHANNELS):
+        cdef size_t framelength = <size_t>(length * samplerate)
+        out = np.zeros((framelength, channels))
+        cdef double[:,::1] _out = out
 
-            for c in range(channels):
-                out[i,c] = sample
+        if framelength > 0 and LPUgenGraph.render(self.graph, &_out[0,0], framelength, channels) < 0:
+            raise ValueError('Could not render the ugen graph')
 
         return SoundBuffer(out, samplerate=samplerate, channels=channels)
-
@@ -21,21 +21,31 @@ cdef extern from "pippicore.h":
         lpbuffer_t * (*create)(const char * name, size_t length)
         void (*destroy)(lpbuffer_t *)
 
+    ctypedef struct lpmemorypool_stats_t:
+        size_t live
+        size_t highwater
+        size_t allocs
+        size_t frees
+        size_t failed
+
     ctypedef struct lpmemorypool_t:
         unsigned char * pool
         size_t poolsize
         size_t pos
+        lpmemorypool_stats_t stats
 
     ctypedef struct lpmemorypool_factory_t:
-        unsigned char * pool
-        size_t poolsize
-        size_t pos
-
         void (*init)(unsigned char *, size_t)
         lpmemorypool_t * (*custom_init)(unsigned char *, size_t)
         void * (*alloc)(size_t, size_t)
         void * (*custom_alloc)(lpmemorypool_t *, size_t, size_t)
         void (*free)(void *)
+        size_t (*mark)(lpmemorypool_t *)
+        void (*reset)(lpmemorypool_t *, size_t)
+        size_t (*scope_begin)(lpmemorypool_t *)
+        void (*scope_end)(lpmemorypool_t *, size_t)
+        void (*thread_release)()
+        lpmemorypool_stats_t (*stats)(lpmemorypool_t *)
 
     extern const lpwavetable_factory_t LPWavetable 
     extern const lpwindow_factory_t LPWindow
@@ -138,10 +148,13 @@ cpdef double[:] to_wavetable(object w=?, int wtsize=?)
 cpdef list to_stack(list wavetables, int wtsize=?)
 cdef int to_flag(str value)
 cpdef Wavetable _randline(int numpoints, double lowvalue=?, double highvalue=?, int wtsize=?)
+cdef double[:] _named_table(str kind, int table_type, int length)
 cdef double[:] _window(int window_type, int length)
+cdef double[:] _generate_window(int window_type, int length)
 cdef double[:] _adsr(int framelength, int attack, int decay, double sustain, int release)
 cpdef double[:] adsr(int length, int attack, int decay, double sustain, int release)
 cdef double[:] _wavetable(int wavetable_type, int length)
+cdef double[:] _generate_wavetable(int wavetable_type, int length)
 cpdef double[:] wavetable(int wavetable_type, int length, double[:] data)
 cdef double[:] _seesaw(double[:] wt, int length, double tip=*)
 cpdef Wavetable seesaw(object wt, int length, double tip=*)
@@ -1012,14 +1012,44 @@ cpdef Wavetable _randline(int numpoints, double lowvalue=0, double highvalue=1,
     cdef double[:] points = np.array([ rand.rand(lowvalue, highvalue) for _ in range(numpoints) ], dtype='d')
     return Wavetable(points, wtsize=wtsize)
 
-cdef double[:] _window(int window_type, int length):
-    cdef double[:] wt
+# Named tables are generated once per (kind, type, length) 
+# and copied out from here, so callers can still write to them. 
+# Like the libpippi table cache, only power of two lengths up 
+# to _NAMED_TABLE_MAXLENGTH are kept: other lengths are usually 
+# sized to a buffer and are generated directly.
+cdef dict _NAMED_TABLES = {}
+cdef int _NAMED_TABLE_MAXLENGTH = 65536
+
+cdef double[:] _named_table(str kind, int table_type, int length):
+    cdef tuple key = (kind, table_type, length)
+    cdef bint cacheable = length > 0 and length <= _NAMED_TABLE_MAXLENGTH and (length & (length - 1)) == 0
+
+    table = _NAMED_TABLES.get(key) if cacheable else None
+    if table is None:
+        if kind == 'window':
+            table = np.array(_generate_window(table_type, length), dtype='d')
+        else:
+            table = np.array(_generate_wavetable(table_type, length), dtype='d')
+
+        if not cacheable:
+            return table
 
+        table.flags.writeable = False
+        _NAMED_TABLES[key] = table
+
+    return table.copy()
+
+cdef double[:] _window(int window_type, int length):
     if window_type == RND:
         window_type = ALL_WINDOWS[rand.randint(0, LEN_WINDOWS-1)]
-        wt = _window(window_type, length)
+        return _window(window_type, length)
+
+    return _named_table('window', window_type, length)
 
-    elif window_type == SINE:
+cdef double[:] _generate_window(int window_type, int length):
+    cdef double[:] wt
+
+    if window_type == SINE:
         wt = np.sin(np.linspace(0, PI, length, dtype='d'))
 
     elif window_type == SINEIN:
@@ -1080,7 +1110,7 @@ cdef double[:] _window(int window_type, int length):
         wt = _pluck_out(length)
 
     else:
-        wt = _window(SINE, length)
+        wt = _generate_window(SINE, length)
 
     return wt
 
@@ -1118,15 +1148,16 @@ cpdef double[:] adsr(int length, int attack, int decay, double sustain, int rele
     return _adsr(length, attack, decay, sustain, release)
 
 cdef double[:] _wavetable(int wavetable_type, int length):
-    cdef double[:] wt
-    cdef lpbuffer_t * lpbuf
-    cdef lpfloat_t * lpwt
-
     if wavetable_type == RND:
         wavetable_type = ALL_WAVETABLES[rand.randint(0, LEN_WAVETABLES-1)]
-        wt = _wavetable(wavetable_type, length)
+        return _wavetable(wavetable_type, length)
+
+    return _named_table('wavetable', wavetable_type, length)
+
+cdef double[:] _generate_wavetable(int wavetable_type, int length):
+    cdef double[:] wt
 
-    elif wavetable_type == SINE:
+    if wavetable_type == SINE:
         wt = np.sin(np.linspace(-np.pi, np.pi, length, dtype='d', endpoint=False))
 
     elif wavetable_type == COS:
@@ -1149,7 +1180,7 @@ cdef double[:] _wavetable(int wavetable_type, int length):
         wt = tmp
 
     else:
-        wt = _wavetable(SINE, length)
+        wt = _generate_wavetable(SINE, length)
 
     return wt
 
@@ -76,6 +76,7 @@ ext_modules = cythonize([
         Extension('pippi.grains2', [
                 'libpippi/src/pippicore.c',
                 'libpippi/src/oscs.tape.c',
+                'libpippi/src/jobs.c',
                 'libpippi/src/microsound.c',
                 'pippi/grains2.pyx'
             ],
@@ -129,6 +130,7 @@ ext_modules = cythonize([
         ), 
         Extension('pippi.mir', [
                 'libpippi/src/pippicore.c', 
+                'libpippi/src/spectral.c', 
                 'libpippi/src/mir.c', 
                 'pippi/mir.pyx'
             ],
@@ -231,14 +233,13 @@ ext_modules = cythonize([
             define_macros=MACROS
         ), 
         Extension('pippi.buffers', [
-                'libpippi/vendor/fft/fft.c',
                 'libpippi/src/pippicore.c',
                 'libpippi/src/spectral.c',
                 'libpippi/src/soundfile.c',
                 'libpippi/src/fx.softclip.c',
                 'pippi/buffers.pyx',
             ],
-            include_dirs=INCLUDES + ['libpippi/vendor/fft'],
+            include_dirs=INCLUDES + ['modules/fft'],
             define_macros=MACROS,
             extra_compile_args=['-g3'],
         ),
@@ -288,6 +289,7 @@ ext_modules = cythonize([
                 'libpippi/src/ugens.tape.c',
                 'libpippi/src/oscs.pulsar.c',
                 'libpippi/src/ugens.pulsar.c',
+                'libpippi/src/ugens.graph.c',
                 'pippi/ugens.pyx'
             ],
             include_dirs=INCLUDES, 